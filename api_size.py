@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Compare JSON, MessagePack and gzip response sizes of a controller's REST API.
+
+Every GET endpoint is fetched three times: plain, with
+"Accept: application/msgpack" and with "Accept-Encoding: gzip". The body
+sizes on the wire are printed side by side with the saving against plain
+JSON. Endpoints that answer in JSON whatever is asked (chunked lists such
+as /api/runs) show no MessagePack saving, and bodies under 1 KB are never
+gzipped. The device's own running totals from /api/metrics follow,
+including the encoder's CPU time.
+
+Usage:
+    python3 api_size.py 192.168.1.50
+Only the standard library is needed.
+"""
+import argparse
+import json
+import sys
+import urllib.error
+import urllib.request
+
+ENDPOINTS = [
+    "/api/schedules",
+    "/api/schedules/forecast",
+    "/api/channels/status",
+    "/api/channels/available",
+    "/api/groups",
+    "/api/sensors",
+    "/api/channel/moisture",
+    "/api/pressure",
+    "/api/rules",
+    "/api/runs",
+    "/api/nodes/pending",
+    "/api/nodes/health",
+    "/api/config",
+    "/api/metrics",
+]
+
+
+def fetch(base, path, headers=None, timeout=10):
+    """Returns (status, content type, body bytes as sent)."""
+    req = urllib.request.Request(base + path, headers=headers or {})
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as resp:
+            return resp.status, resp.headers.get("Content-Type", ""), resp.read()
+    except urllib.error.HTTPError as e:
+        return e.code, e.headers.get("Content-Type", ""), e.read()
+    except (urllib.error.URLError, OSError):
+        return None, "", b""
+
+
+def saving(plain, other):
+    return 100.0 * (plain - other) / plain if plain else 0.0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("host", help="controller IP or hostname")
+    args = ap.parse_args()
+    base = "http://" + args.host
+
+    print("%-28s %8s %8s %7s %8s %7s" % ("endpoint", "json", "msgpack", "saved", "gzip", "saved"))
+    totals = [0, 0, 0]
+    for path in ENDPOINTS:
+        status, _, body = fetch(base, path)
+        if status != 200:
+            print("%-28s %8s" % (path, status or "-"))
+            continue
+        _, ctype, packed = fetch(base, path, {"Accept": "application/msgpack"})
+        _, _, zipped = fetch(base, path, {"Accept-Encoding": "gzip"})
+
+        note = "" if ctype.startswith("application/msgpack") else "  (msgpack sent as JSON)"
+        print("%-28s %8d %8d %6.1f%% %8d %6.1f%%%s" % (
+            path, len(body), len(packed), saving(len(body), len(packed)),
+            len(zipped), saving(len(body), len(zipped)), note))
+        for i, size in enumerate((len(body), len(packed), len(zipped))):
+            totals[i] += size
+
+    if totals[0]:
+        print("%-28s %8d %8d %6.1f%% %8d %6.1f%%" % (
+            "total", totals[0], totals[1], saving(totals[0], totals[1]),
+            totals[2], saving(totals[0], totals[2])))
+
+    status, _, body = fetch(base, "/api/metrics")
+    if status == 200:
+        metrics = json.loads(body)
+        stats = metrics.get("msgpack")
+        if stats and stats["json_bytes"]:
+            print("device msgpack: %d responses, %d bytes instead of %d (%.1f%% saved)" % (
+                stats["responses"], stats["bytes"], stats["json_bytes"],
+                saving(stats["json_bytes"], stats["bytes"])))
+        stats = metrics.get("gzip")
+        if stats and stats["in_bytes"]:
+            print("device gzip: %d responses, %d bytes to %d (ratio %.2f), %d us encoding (%.0f KB/s)" % (
+                stats["responses"], stats["in_bytes"], stats["out_bytes"],
+                stats["in_bytes"] / max(stats["out_bytes"], 1), stats["cpu_us"],
+                stats["in_bytes"] / 1.024 / max(stats["cpu_us"], 1) * 1000))
+    elif totals[0] == 0:
+        print("Error: %s not reachable" % args.host)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Collect and decode crash reports from one controller or a whole fleet.
+
+For each host, /api/crash is read: reset reason, boots since power-on,
+crashes, the serial tail of the boot that crashed and the core dump summary
+(crashed task, PC and backtrace). With --elf the PC and backtrace are
+resolved to functions and source lines with addr2line; the ELF must be the
+build that crashed (compare app_sha with the first 16 hex digits of
+`sha256sum firmware.elf`). With --save the raw core dump is downloaded and,
+if espcoredump.py is on the PATH, decoded in full (registers, all tasks).
+
+With several hosts a fleet summary follows: hosts per reset reason and
+crashes grouped by signature (task and PC), most frequent first.
+
+Usage:
+    python3 crash_decode.py 192.168.1.50 --elf .pio/build/board_a/firmware.elf
+    python3 crash_decode.py $(cat fleet.txt) --save dumps/ --clear
+Only the standard library is needed (plus the ESP32 toolchain for --elf).
+"""
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import urllib.error
+import urllib.request
+from collections import defaultdict
+
+CRASH_REASONS = ("panic", "int_wdt", "task_wdt", "wdt", "brownout")
+
+
+def fetch(host, path, method="GET", timeout=10):
+    req = urllib.request.Request("http://%s%s" % (host, path), method=method)
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as resp:
+            return resp.status, resp.read()
+    except urllib.error.HTTPError as e:
+        return e.code, e.read()
+    except (urllib.error.URLError, OSError):
+        return None, None
+
+
+def addr2line(tool, elf, addresses):
+    """Returns {address: "function at file:line"}."""
+    if not addresses:
+        return {}
+    try:
+        out = subprocess.run([tool, "-pfiaC", "-e", elf] + addresses,
+                             capture_output=True, text=True, check=True).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        print("  addr2line failed: %s" % e)
+        return {}
+
+    # One block per address: "0x400d1234: func at file:line" plus inlined frames
+    resolved, current = {}, None
+    for line in out.splitlines():
+        head, sep, rest = line.partition(": ")
+        if sep and head.startswith("0x"):
+            current = "0x%08x" % int(head, 16)
+            resolved[current] = rest
+        elif current:
+            resolved[current] += "\n" + " " * 16 + line.strip()
+    return resolved
+
+
+def report(host, crash, args):
+    last = crash.get("last") or {}
+    print("=" * 72)
+    print("%s  %s  v%s" % (host, crash.get("node_id", "?"), crash.get("version", "?")))
+    print("reset %-9s boots since power-on %d  crashes %d  up %d s" % (
+        crash["reset_reason"], crash["boots"], crash["crashes"], crash["uptime_s"]))
+
+    if last:
+        print("last crash: %s after %d s" % (last["reason"], last["uptime_s"]))
+        tail = last.get("log", "").rstrip().splitlines()[-args.tail:]
+        for line in tail:
+            print("  | " + line)
+
+    dump = crash.get("coredump")
+    if not dump:
+        return
+    print("core dump: %d bytes, task '%s', app %s%s" % (
+        dump["size"], dump["task"], dump["app_sha"],
+        "  (backtrace corrupted)" if dump.get("corrupted") else ""))
+    frames = [dump["pc"]] + [a for a in dump["backtrace"] if a != dump["pc"]]
+    names = addr2line(args.addr2line, args.elf, frames) if args.elf else {}
+    for addr in frames:
+        print("  %s  %s" % (addr, names.get(addr, "")))
+
+
+def save_dump(host, crash, args):
+    dump = crash.get("coredump")
+    if not dump:
+        return
+    status, body = fetch(host, "/api/crash/coredump", timeout=60)
+    if status != 200:
+        print("  core dump download failed (%s)" % status)
+        return
+    os.makedirs(args.save, exist_ok=True)
+    path = os.path.join(args.save, "%s-%s.bin" % (crash.get("node_id", host), dump["app_sha"] or "unknown"))
+    with open(path, "wb") as f:
+        f.write(body)
+    print("  saved %s" % path)
+
+    tool = shutil.which("espcoredump.py")
+    if args.elf and tool:
+        subprocess.run([tool, "info_corefile", "-t", "raw", "-c", path, args.elf])
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("hosts", nargs="+", help="controller IPs or hostnames")
+    ap.add_argument("--elf", help="firmware.elf of the build that crashed")
+    ap.add_argument("--addr2line", default="xtensa-esp32-elf-addr2line",
+                    help="addr2line of the target toolchain (riscv32-esp-elf-addr2line for the C3)")
+    ap.add_argument("--tail", type=int, default=20, help="log lines to show")
+    ap.add_argument("--save", metavar="DIR", help="download core dumps into DIR")
+    ap.add_argument("--clear", action="store_true",
+                    help="erase the core dump and log on the device afterwards")
+    args = ap.parse_args()
+
+    by_reason = defaultdict(list)
+    by_signature = defaultdict(list)
+    unreachable = []
+
+    for host in args.hosts:
+        status, body = fetch(host, "/api/crash")
+        if status != 200:
+            unreachable.append(host)
+            continue
+        crash = json.loads(body)
+        report(host, crash, args)
+        if args.save:
+            save_dump(host, crash, args)
+        if args.clear and (crash.get("coredump") or crash.get("last")):
+            fetch(host, "/api/crash", "DELETE")
+            print("  cleared")
+
+        by_reason[crash["reset_reason"]].append(host)
+        dump = crash.get("coredump")
+        if dump:
+            by_signature["%s @ %s" % (dump["task"], dump["pc"])].append(host)
+
+    if len(args.hosts) > 1:
+        print("=" * 72)
+        print("fleet: %d host(s), %d unreachable %s" % (
+            len(args.hosts), len(unreachable), " ".join(unreachable)))
+        crashed = sum(len(h) for r, h in by_reason.items() if r in CRASH_REASONS)
+        print("last reset was a crash on %d host(s)" % crashed)
+        for reason, hosts in sorted(by_reason.items(), key=lambda kv: -len(kv[1])):
+            print("  %-9s %3d  %s" % (reason, len(hosts), " ".join(hosts)))
+        if by_signature:
+            print("core dumps by signature:")
+            for sig, hosts in sorted(by_signature.items(), key=lambda kv: -len(kv[1])):
+                print("  %3d  %s  (%s)" % (len(hosts), sig, " ".join(hosts)))
+
+    if unreachable and len(args.hosts) == 1:
+        print("Error: %s/api/crash not reachable (firmware too old?)" % args.hosts[0])
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
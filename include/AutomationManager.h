@@ -0,0 +1,59 @@
+#ifndef AUTOMATION_MANAGER_H
+#define AUTOMATION_MANAGER_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include "JsonArena.h"
+#include "Config.h"
+#include "RuleEngine.h"
+
+// Forward declarations
+class IrrigationController;
+class HomeAssistantIntegration;
+class PressureMonitor;
+
+// On-device automation rules (see RuleEngine).
+//
+// Keeps working without WiFi or Home Assistant: rules are stored in
+// RULES_FILE and evaluated locally. Every RULE_CHECK_INTERVAL the inputs
+// rules can read are folded into a signature; when it changes the engine
+// is marked dirty and the next passes run within RULE_TICK_BUDGET
+// instructions per loop().
+class AutomationManager {
+public:
+    AutomationManager(IrrigationController* controller);
+
+    // Component lifecycle
+    bool begin();
+    void update();
+
+    void setHomeAssistant(HomeAssistantIntegration* ha) { _ha = ha; }
+    void setPressureMonitor(PressureMonitor* pm) { _pressure = pm; }
+
+    // Rule management (persisted on success)
+    int8_t addRule(const char* name, const char* when, const char* then, bool enabled, char* error);
+    bool replaceRule(uint8_t index, const char* name, const char* when, const char* then,
+                     bool enabled, char* error);
+    bool removeRule(uint8_t index);
+    const RuleEngine& getEngine() const { return _engine; }
+    uint32_t getGeneration() const { return _generation; }  // Rule set edits
+
+    bool saveRules();
+    bool loadRules();
+
+private:
+    static float readInput(void* ctx, uint8_t input, float arg);
+    static void runAction(void* ctx, const Rule& rule);
+    uint32_t inputSignature() const;
+
+    IrrigationController* _controller;
+    HomeAssistantIntegration* _ha;
+    PressureMonitor* _pressure;
+    RuleEngine _engine;
+    uint32_t _signature;
+    uint32_t _generation;
+    unsigned long _lastCheck;
+};
+
+#endif // AUTOMATION_MANAGER_H
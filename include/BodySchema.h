@@ -0,0 +1,83 @@
+#ifndef BODY_SCHEMA_H
+#define BODY_SCHEMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Field types
+#define BODY_INT   0           // JSON integer into a 1, 2 or 4 byte member
+#define BODY_BOOL  1           // true/false into a bool member
+#define BODY_STR   2           // JSON string into a char[] member (NUL-terminated)
+
+// Parse results
+#define BODY_OK           0
+#define BODY_ERR_SYNTAX   1    // Not a JSON object
+#define BODY_ERR_MISSING  2    // Required field absent
+#define BODY_ERR_TYPE     3    // Wrong JSON type for the field
+#define BODY_ERR_RANGE    4    // Integer outside [min, max]
+#define BODY_ERR_LENGTH   5    // String shorter than min or longer than the member
+
+#define BODY_MAX_FIELDS   32   // Presence is tracked in a 32-bit mask
+
+// One field of a request body schema. Schemas are static const arrays built
+// with the macros below, next to the struct they fill:
+//
+//   struct StartBody { uint8_t channel; uint16_t duration; };
+//   static const BodyField START_FIELDS[] = {
+//       BODY_FIELD_INT("channel", StartBody, channel, true, 1, MAX_CHANNELS),
+//       BODY_FIELD_INT("duration", StartBody, duration, false, 1, 1440),
+//   };
+struct BodyField {
+    const char* key;
+    uint8_t type;              // BODY_INT, BODY_BOOL or BODY_STR
+    uint8_t size;              // sizeof the member
+    uint16_t offset;           // offsetof the member
+    bool required;
+    int32_t min;               // INT: inclusive range; STR: minimum length
+    int32_t max;               // INT only; STR is bounded by the member size
+};
+
+#define BODY_FIELD_INT(key, S, member, required, lo, hi) \
+    { key, BODY_INT, sizeof(((S*)0)->member), offsetof(S, member), required, lo, hi }
+#define BODY_FIELD_BOOL(key, S, member, required) \
+    { key, BODY_BOOL, sizeof(((S*)0)->member), offsetof(S, member), required, 0, 1 }
+#define BODY_FIELD_STR(key, S, member, required, minLen) \
+    { key, BODY_STR, sizeof(((S*)0)->member), offsetof(S, member), required, minLen, 0 }
+
+// A body with a single field, parsed straight into a variable of type T
+// (uint8_t, bool, char[12], ...); min/max as in BodyField
+#define BODY_FIELD_SCALAR(key, type, T, required, min, max) \
+    { key, type, sizeof(T), 0, required, min, max }
+
+struct BodyResult {
+    uint8_t status;            // BODY_OK or BODY_ERR_*
+    uint8_t field;             // Schema index the error is about
+    uint32_t present;          // Bit per schema field found in the body
+};
+
+// Single-pass parser for flat JSON request bodies.
+//
+// Walks the body once, in place: each key is matched against the schema
+// and its value is type- and range-checked and stored straight into the
+// caller's struct, so there is no intermediate document and no allocation.
+// Fields the body leaves out keep whatever the caller initialised them to,
+// which is how defaults are expressed; null counts as absent. Keys not in
+// the schema are skipped, nested values included.
+class BodySchema {
+public:
+    static BodyResult parse(const char* body, size_t length,
+                            const BodyField* fields, uint8_t count, void* out);
+
+    template <size_t N>
+    static BodyResult parse(const char* body, size_t length,
+                            const BodyField (&fields)[N], void* out) {
+        static_assert(N <= BODY_MAX_FIELDS, "too many fields in a body schema");
+        return parse(body, length, fields, (uint8_t)N, out);
+    }
+
+    // "<key> must be 1-32" and friends, for the 400 response
+    static void formatError(const BodyResult& result, const BodyField* fields,
+                            char* buffer, size_t size);
+};
+
+#endif // BODY_SCHEMA_H
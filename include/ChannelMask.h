@@ -0,0 +1,91 @@
+#ifndef CHANNEL_MASK_H
+#define CHANNEL_MASK_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Per-channel flags packed into 32-bit words (bit n = channel n+1), for up
+// to 64 channels.
+//
+// Each word is a std::atomic<uint32_t>, which is lock-free on both ESP32
+// cores (a 64-bit atomic is not: it falls back to a libatomic lock). Writers
+// use fetch_or/fetch_and with release ordering, readers load with acquire,
+// so other tasks can poll state without taking a lock. With 32 channels or
+// fewer every query is one word; above that a multi-word snapshot is
+// per-word consistent only, which is fine for flags owned by one writer.
+//
+// Copying loads every word, so structs holding a mask can still be returned
+// by value.
+template <uint8_t N>
+class ChannelMask {
+    static_assert(N >= 1 && N <= 64, "ChannelMask supports 1..64 channels");
+
+public:
+    static const uint8_t WORDS = (N + 31) / 32;
+
+    ChannelMask() { clear(); }
+    ChannelMask(const ChannelMask& other) { assign(other.bits()); }
+    ChannelMask& operator=(const ChannelMask& other) {
+        assign(other.bits());
+        return *this;
+    }
+
+    // Single flags (0-based index)
+    bool test(uint8_t idx) const {
+        if (idx >= N) return false;
+        return (_words[idx >> 5].load(std::memory_order_acquire) >> (idx & 31)) & 1;
+    }
+    bool operator[](uint8_t idx) const { return test(idx); }
+
+    // Returns the previous value
+    bool set(uint8_t idx, bool value = true) {
+        if (idx >= N) return false;
+        uint32_t bit = 1UL << (idx & 31);
+        uint32_t prev = value ? _words[idx >> 5].fetch_or(bit, std::memory_order_acq_rel)
+                              : _words[idx >> 5].fetch_and(~bit, std::memory_order_acq_rel);
+        return (prev & bit) != 0;
+    }
+    bool reset(uint8_t idx) { return set(idx, false); }
+
+    // Whole-set queries
+    bool any() const {
+        for (uint8_t w = 0; w < WORDS; w++) {
+            if (_words[w].load(std::memory_order_acquire)) return true;
+        }
+        return false;
+    }
+    bool none() const { return !any(); }
+    uint8_t count() const {
+        uint8_t n = 0;
+        for (uint8_t w = 0; w < WORDS; w++) {
+            n += __builtin_popcount(_words[w].load(std::memory_order_acquire));
+        }
+        return n;
+    }
+
+    // 64-bit snapshot (bit n = channel n+1)
+    uint64_t bits() const {
+        uint64_t v = 0;
+        for (uint8_t w = 0; w < WORDS; w++) {
+            v |= (uint64_t)_words[w].load(std::memory_order_acquire) << (32 * w);
+        }
+        return v;
+    }
+    bool intersects(uint64_t mask) const { return (bits() & mask) != 0; }
+
+    void assign(uint64_t mask) {
+        mask &= all();
+        for (uint8_t w = 0; w < WORDS; w++) {
+            _words[w].store((uint32_t)(mask >> (32 * w)), std::memory_order_release);
+        }
+    }
+    void clear() { assign(0); }
+
+    // Mask with every channel bit set
+    static uint64_t all() { return ~0ULL >> (64 - N); }
+
+private:
+    std::atomic<uint32_t> _words[WORDS];
+};
+
+#endif // CHANNEL_MASK_H
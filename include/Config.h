@@ -2,6 +2,7 @@
 #define CONFIG_H
 
 #include <Arduino.h>
+#include "ChannelMask.h"
 
 // ============================================================================
 // FIRMWARE VERSION
@@ -88,6 +89,17 @@
 // Safety timeout - automatically stop if irrigation runs too long
 #define SAFETY_TIMEOUT_MINUTES 300   // 5 hours maximum
 
+// Cycle-and-soak: a schedule may split its run into several cycles with
+// soak gaps; other zones' cycles fill the gaps on the same supply.
+#define MAX_CYCLES 6                 // Maximum cycles per schedule
+#define MAX_SOAK_MINUTES 120         // Maximum soak gap between cycles
+#define CYCLE_SOAK_CONCURRENCY 1     // Cycles running at once from the interleaver
+#define CYCLE_PRESTAGE_MS 10000      // Send remote cycle starts this far ahead
+
+// Channel groups: named sets of local and remote channels started together
+#define MAX_GROUPS 8
+#define GROUP_NAME_LEN 16
+
 // ============================================================================
 // WIFI SETTINGS
 // ============================================================================
@@ -118,6 +130,20 @@
 #define MQTT_CLIENT_ID "irrigation_esp32"
 #define MQTT_BASE_TOPIC "homeassistant/switch/irrigation"
 #define MQTT_RECONNECT_INTERVAL 5000   // Retry every 5 seconds
+#define MQTT_BUFFER_SIZE 1024          // PubSubClient packet buffer (largest message in or out)
+#define MQTT_CMD_QUEUE_LEN 16          // Commands applied per update() batch
+#define MQTT_CMD_TOPIC_LEN 96
+#define MQTT_CMD_PAYLOAD_LEN 192       // Fits a schedule/set JSON body
+#define MQTT_RECONNECT_MAX 300000      // Backoff cap after repeated failures (5 min)
+#define MQTT_KEEPALIVE 60              // Seconds; long-lived sessions avoid handshakes
+
+// MQTT over TLS (enabled per broker in MQTT_CREDENTIALS_FILE)
+#define MQTT_TLS_PORT 8883
+#define MQTT_CA_FILE "/mqtt_ca.pem"    // Pinned broker CA, PEM
+#define MQTT_CA_MAX_SIZE 4096
+#define MQTT_TLS_MIN_BLOCK 40000       // Largest free heap block needed to start a handshake (no pool)
+#define MQTT_TLS_POOL_SIZE 49152       // mbedTLS pool: 16 KB in + 4 KB out records, contexts, handshake
+#define MQTT_TLS_HANDSHAKE_TIMEOUT 10  // Seconds
 
 // Home Assistant MQTT Discovery
 #define HA_DISCOVERY_PREFIX "homeassistant"
@@ -130,8 +156,7 @@
 
 #define NTP_SERVER "za.pool.ntp.org"
 #define NTP_UPDATE_INTERVAL 3600000    // Update every hour (milliseconds)
-#define TIMEZONE_OFFSET 2              // SAST = UTC+2 (South Africa Standard Time)
-#define DAYLIGHT_OFFSET 0              // South Africa doesn't use DST
+#define DEFAULT_TIMEZONE "SAST-2"      // POSIX TZ; e.g. "CET-1CEST,M3.5.0,M10.5.0/3" for DST zones
 
 // ============================================================================
 // OTA UPDATE SETTINGS
@@ -158,10 +183,22 @@
 
 #define CONFIG_FILE "/config.json"
 #define SCHEDULE_FILE "/schedule.json"
+#define GROUPS_FILE "/groups.json"
 #define LOG_FILE "/irrigation.log"
 #define MAX_LOG_ENTRIES 100
 #define PAIRED_SLAVES_FILE "/paired_slaves.json"
 #define PAIRED_MASTER_FILE "/paired_master.json"
+#define PAIRED_SENSORS_FILE "/paired_sensors.json"
+#define SOIL_CALIBRATION_FILE "/soil_calibration.json"
+#define MOISTURE_LOOPS_FILE "/moisture_loops.json"
+#define PRESSURE_BASELINE_FILE "/pressure_baseline.json"
+#define STORED_COMMANDS_FILE "/stored_commands.json"
+#define RULES_FILE "/rules.json"
+#define RUN_JOURNAL_FILE "/run_journal.json"    // Slave: runs not yet merged by the master
+#define RUN_HISTORY_FILE "/run_history.json"    // Master: fleet run history
+#define CRASH_FILE "/crash.json"                // Last crash: reason, uptime, serial tail
+#define OTA_CACHE_FILE "/ota.json"              // Version check validators and the version they named
+#define ROLLOUT_FILE "/rollout.json"            // Master: outcome of the last rollout
 
 // ============================================================================
 // TIMING CONSTANTS
@@ -171,6 +208,11 @@
 #define DISPLAY_UPDATE_INTERVAL 1000   // Update display every second
 #define STATUS_UPDATE_INTERVAL 60000   // Update status every minute
 #define SCHEDULE_CHECK_INTERVAL 30000  // Check schedule every 30 seconds
+#define FORECAST_DEFAULT_DAYS 7        // Schedule forecast horizon (API default, MQTT topic)
+#define FORECAST_MAX_DAYS 31
+#define FORECAST_PUBLISH_INTERVAL 3600000  // Republish the MQTT forecast hourly (and on changes)
+#define RULE_CHECK_INTERVAL 250       // Poll rule inputs for changes
+#define RULE_TICK_BUDGET 256          // Rule VM instructions per loop() pass
 
 // ============================================================================
 // DEBUG SETTINGS
@@ -179,11 +221,13 @@
 #define ENABLE_SERIAL_DEBUG true
 #define SERIAL_BAUD_RATE 115200
 
-// Debug macros
+// Debug macros. Output is teed into an RTC RAM ring that survives a crash
+// reset, so /api/crash can show what the controller was doing (CrashLog).
 #if ENABLE_SERIAL_DEBUG
-    #define DEBUG_PRINT(x) Serial.print(x)
-    #define DEBUG_PRINTLN(x) Serial.println(x)
-    #define DEBUG_PRINTF(...) Serial.printf(__VA_ARGS__)
+    #include "CrashLog.h"
+    #define DEBUG_PRINT(x) crashLog.print(x)
+    #define DEBUG_PRINTLN(x) crashLog.println(x)
+    #define DEBUG_PRINTF(...) crashLog.printf(__VA_ARGS__)
 #else
     #define DEBUG_PRINT(x)
     #define DEBUG_PRINTLN(x)
@@ -225,6 +269,15 @@ struct IrrigationSchedule {
     uint8_t minute;            // 0-59
     uint16_t durationMinutes;  // Duration in minutes
     uint8_t weekdays;          // Bitmask: bit 0=Sunday, bit 1=Monday, etc.
+    uint8_t cycles;            // 1 = single run, >1 = cycle-and-soak
+    uint16_t soakMinutes;      // Gap between cycles (cycle-and-soak only)
+};
+
+// Named channel group
+struct ChannelGroup {
+    bool enabled;
+    char name[GROUP_NAME_LEN];
+    uint64_t members;          // Bitmask: bit 0=channel 1, bit 1=channel 2, etc.
 };
 
 // System status structure
@@ -232,8 +285,8 @@ struct SystemStatus {
     bool wifiConnected;
     bool mqttConnected;
     bool irrigating;           // True if any channel is irrigating
-    bool channelIrrigating[MAX_CHANNELS];  // Per-channel irrigation status
-    bool channelInverted[MAX_CHANNELS];    // Per-channel invert setting (for active-low relays)
+    ChannelMask<MAX_CHANNELS> channelIrrigating;  // Per-channel irrigation status
+    ChannelMask<MAX_CHANNELS> channelInverted;    // Per-channel invert setting (for active-low relays)
     bool manualMode;
     unsigned long irrigationStartTime;
     unsigned long channelStartTime[MAX_CHANNELS];  // Per-channel start times
@@ -261,13 +314,68 @@ const uint8_t CHANNEL_PINS[NUM_LOCAL_CHANNELS] = {
 // ============================================================================
 
 #define NODE_UDP_PORT             4210    // UDP port for node communication
-#define NODE_HEARTBEAT_INTERVAL   30000   // Send heartbeat every 30s
-#define NODE_STATUS_INTERVAL      10000   // Slave sends status every 10s
-#define NODE_PEER_TIMEOUT         90000   // Mark peer offline after 90s silence
+// Heartbeat/status intervals and offline deadlines: LinkTiming.h
 #define NODE_MAX_RETRIES          3       // Retry count for ACK-requiring commands
 #define NODE_DEDUP_WINDOW         60000   // Dedup seq numbers for 60s
 #define NODE_MDNS_RETRY_INTERVAL  30000   // Retry mDNS discovery every 30s
 #define NODE_PAIR_RETRY_INTERVAL  30000   // Slave retries PAIR_REQUEST every 30s
 #define NODE_PAIR_REQUEST_TIMEOUT 60000   // Master auto-rejects pending pair after 60s
+#define STORE_FWD_START_TTL       300000  // Queued start for an unreachable slave expires after 5 min
+#define STORE_FWD_STOP_TTL        3600000 // Queued stop expires after 1 h
+#define NODE_RECONCILE_GRACE      45000   // Leave a channel alone this long after it changed
+#define NODE_RECONCILE_TOLERANCE  90      // Seconds of end-time disagreement ignored
+
+// ============================================================================
+// SENSOR NODE (capacitive soil moisture)
+// ============================================================================
+
+#define MAX_SENSOR_NODES          4       // Sensor nodes a master can track
+#define SENSOR_MAX_PROBES         4       // Probes per sensor node
+
+#ifdef BOARD_B
+    // ESP32-C3: ADC1 is GPIO0-4
+    #define SOIL_PROBE_COUNT 2
+    const int8_t SOIL_PROBE_PINS[SENSOR_MAX_PROBES] = {0, 1, -1, -1};
+    #define SOIL_NTC_PIN 2                // 10k NTC to GND, 10k to 3V3 (-1 = none)
+#else
+    // ESP32: ADC1 input-only pins (ADC2 is unusable while WiFi is on)
+    #define SOIL_PROBE_COUNT 3
+    const int8_t SOIL_PROBE_PINS[SENSOR_MAX_PROBES] = {34, 35, 36, -1};
+    #define SOIL_NTC_PIN 39
+#endif
+
+#define SOIL_OVERSAMPLE           32      // ADC reads per sample (middle half averaged)
+#define SOIL_SAMPLE_INTERVAL      5000    // Sample probes every 5s
+#define SOIL_REPORT_DEADBAND      2.0f    // Report when moisture moves this many %-points
+#define SOIL_KEEPALIVE_INTERVAL   900000  // Report anyway every 15 min
+#define SOIL_DRY_MV               2600    // Default calibration: probe in air
+#define SOIL_WET_MV               1100    // Default calibration: probe in water
+#define SOIL_TEMP_COEFF_MV        2.5f    // Probe output drift per degC away from 25 degC
+#define SOIL_NTC_BETA             3950.0f
+#define SOIL_NTC_NOMINAL_OHMS     10000.0f
+#define SOIL_NTC_SERIES_OHMS      10000.0f
+
+// Closed-loop zones (master)
+#define SOIL_READING_STALE_MS     (SOIL_KEEPALIVE_INTERVAL * 2 + 60000)  // Older readings fall back to timed runs
+#define SOIL_LOOP_CHECK_INTERVAL  10000   // Check running closed-loop zones every 10s
+
+// ============================================================================
+// PRESSURE MONITORING (mainline burst / leak detection, valve nodes)
+// ============================================================================
+
+#ifdef BOARD_B
+    #define PRESSURE_SENSOR_PIN 4         // ADC1_CH4
+#else
+    #define PRESSURE_SENSOR_PIN 36        // ADC1_CH0 (soil probe 3 on sensor nodes)
+#endif
+
+#define PRESSURE_SAMPLE_HZ        1000    // Sampler task rate
+#define PRESSURE_BLOCK_SIZE       20      // Samples averaged per block (50 Hz to the detector)
+#define PRESSURE_QUEUE_LEN        64      // Blocks buffered while the loop is busy (~1.3s)
+#define PRESSURE_MV_ZERO          333     // 0.5V transducer output through a 2:3 divider
+#define PRESSURE_MV_FULL          3000    // 4.5V through the divider
+#define PRESSURE_KPA_FULL         1200.0f // Transducer full scale (kPa)
+#define PRESSURE_MV_FAULT_MARGIN  150     // This far outside the span = wiring fault
+#define PRESSURE_SAVE_INTERVAL    900000  // Persist learned baselines at most every 15 min
 
 #endif // CONFIG_H
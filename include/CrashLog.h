@@ -0,0 +1,65 @@
+#ifndef CRASH_LOG_H
+#define CRASH_LOG_H
+
+#include <Arduino.h>
+
+#define CRASH_LOG_SIZE       1536   // Serial tail kept per boot in RTC RAM (two are kept)
+#define CRASH_BACKTRACE_MAX  16
+
+// What the core dump partition says about the last crash
+struct CoreDumpSummary {
+    bool present;
+    uint32_t size;                          // Image bytes in flash
+    char task[16];                          // Task that crashed
+    uint32_t pc;
+    uint32_t backtrace[CRASH_BACKTRACE_MAX];  // Xtensa only; empty on RISC-V
+    uint8_t depth;
+    bool corrupted;                         // Backtrace ran into a bad frame
+    char appSha[17];                        // ELF SHA-256 prefix of the crashed build
+};
+
+// Post-mortem support: reset reason, the serial tail of the boot that
+// crashed, and the ESP-IDF core dump.
+//
+// All DEBUG_* output goes through this Print. It is copied to Serial and into
+// a ring in RTC RAM, which survives panics, watchdog and brownout resets
+// (not power loss). Two rings alternate between boots, so the crashed boot's
+// tail is still intact when begin() runs after LittleFS is mounted; only then
+// is it written to CRASH_FILE, keeping flash writes out of the crash path.
+// The core dump itself is written by ESP-IDF's panic handler to the coredump
+// partition and is only read and summarised here.
+class CrashLog : public Print {
+public:
+    CrashLog();
+
+    // After LittleFS is mounted: save the previous tail if the last reset was a crash
+    void begin();
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    const char* getResetReason() const;
+    bool wasCrash() const { return _wasCrash; }
+    uint32_t getBootCount() const;          // Since power-on
+    uint32_t getCrashCount() const { return _crashCount; }   // Since the log was created
+    const CoreDumpSummary& getCoreDump() const { return _coreDump; }
+
+    // Raw core dump image, for espcoredump.py; false past the end or on a read error
+    bool readCoreDump(uint32_t offset, uint8_t* buffer, size_t size) const;
+
+    // Erase the core dump and the saved tail (the crash count is kept)
+    void clear();
+
+private:
+    void loadCoreDump();
+    void saveCrash();
+
+    bool _wasCrash;
+    uint32_t _crashCount;
+    CoreDumpSummary _coreDump;
+    uint32_t _coreDumpAddr;                 // Flash address of the image
+};
+
+extern CrashLog crashLog;
+
+#endif // CRASH_LOG_H
@@ -0,0 +1,82 @@
+#ifndef FIRMWARE_UPDATER_H
+#define FIRMWARE_UPDATER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include <Update.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include "Config.h"
+
+// Update job states
+#define OTA_IDLE          0    // Nothing checked since boot
+#define OTA_CHECKING      1
+#define OTA_UP_TO_DATE    2
+#define OTA_AVAILABLE     3    // Newer version found, not installed
+#define OTA_DOWNLOADING   4
+#define OTA_REBOOTING     5    // Image written and verified; restart pending
+#define OTA_FAILED        6
+
+#define OTA_TASK_STACK     8192    // TLS handshake plus the 1 KB copy buffer
+#define OTA_RESTART_DELAY  3000    // ms for the final status to reach the UI and MQTT
+
+struct OtaStatus {
+    uint8_t state;             // OTA_*
+    uint8_t progress;          // %, while downloading
+    bool install;              // The job installs what it finds
+    bool notModified;          // Last check was answered 304
+    char latest[16];           // Latest version seen, "" if never
+    char error[48];            // Why the last job failed
+    unsigned long checkedAt;   // millis() of the last completed check, 0 = never
+    uint32_t generation;       // Bumped on every change
+};
+
+// Firmware update check and install, off the loop.
+//
+// A job runs in its own short-lived task: the HTTPS version check, and the
+// download and flash write if a newer version is found and the job was
+// started to install. The loop only reads the status (the web UI polls
+// /api/ota, Home Assistant gets it over MQTT) and restarts the node once an
+// install has finished. The version check sends the ETag and Last-Modified
+// of the previous answer, cached in OTA_CACHE_FILE, so the daily check is a
+// 304 with no body while nothing has been released.
+class FirmwareUpdater {
+public:
+    FirmwareUpdater();
+
+    void begin();                       // Loads the cached validators
+    void update();                      // Restarts after a finished install
+
+    // false if a job is already running. With expect, the job only installs
+    // if the latest release is still that version (a rollout's target).
+    bool start(bool install, const char* expect = nullptr);
+    bool isBusy() const { return _busy; }
+    OtaStatus getStatus() const;        // Consistent copy
+    uint32_t getGeneration() const { return _status.generation; }
+
+    static const char* stateName(uint8_t state);
+
+private:
+    static void jobTask(void* arg);
+    void runJob();
+    bool checkVersion(String& latest, bool& notModified, String& error);
+    bool download(String& error);
+    void setState(uint8_t state, const char* error = nullptr);
+    void setProgress(uint8_t progress);
+    bool loadCache();
+    bool saveCache();
+
+    mutable portMUX_TYPE _lock;
+    OtaStatus _status;
+    volatile bool _busy;                // Set by start(), cleared as the job task exits
+    unsigned long _rebootAt;
+    char _expect[16];                   // Version the running job may install, "" = any
+
+    // Job task only (and begin(), before any job)
+    String _etag;
+    String _lastModified;
+};
+
+#endif // FIRMWARE_UPDATER_H
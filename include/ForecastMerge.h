@@ -0,0 +1,35 @@
+#ifndef FORECAST_MERGE_H
+#define FORECAST_MERGE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "TimeZone.h"
+
+#define FORECAST_MAX_SLOTS 16   // At least MAX_SCHEDULES
+
+// One schedule's trigger: local hour:minute on the weekdays in the mask
+struct ForecastSlot {
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t weekdays;          // Bit 0 = Sunday; 0 = never runs
+};
+
+// Forecast position: the pending occurrence of every schedule. Runs are
+// merged from it on demand, so any horizon expands in constant memory.
+// Plain data, so a copy is an independent second pass.
+struct ForecastCursor {
+    ForecastSlot slot[FORECAST_MAX_SLOTS];
+    time_t next[FORECAST_MAX_SLOTS];  // 0 = no further occurrence
+    time_t until;
+    uint8_t count;
+
+    // Pending occurrences after now, for days ahead
+    void begin(const TimeZone& zone, const ForecastSlot* slots, uint8_t slotCount,
+               time_t now, uint16_t days);
+
+    // The earliest pending occurrence (ties by slot index) within the
+    // window; only that slot advances. Returns the slot, or -1 when done.
+    int8_t advance(const TimeZone& zone, time_t& start);
+};
+
+#endif // FORECAST_MERGE_H
@@ -0,0 +1,64 @@
+#ifndef GZIP_STREAM_H
+#define GZIP_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GZIP_WINDOW      1024    // Match distance; the buffer holds two windows
+#define GZIP_HASH_BITS   9       // 512 match heads
+#define GZIP_OUT_SIZE    512     // Compressed bytes per sink call
+#define GZIP_MIN_MATCH   3
+#define GZIP_MAX_MATCH   258
+
+// Receives compressed output as it is produced
+typedef void (*GzipSink)(void* context, const uint8_t* data, size_t length);
+
+// Streaming gzip (RFC 1952) encoder with a fixed footprint.
+//
+// Input is written in any number of pieces and compressed output is handed
+// to the sink in GZIP_OUT_SIZE pieces, so a response never has to exist in
+// full. The LZ77 search keeps one candidate per hash head over a 1 KB
+// window and codes everything as a single fixed-Huffman block. That loses
+// some ratio to zlib, but needs no tables built per block and about 3 KB in
+// total, and API JSON repeats its keys well within a kilobyte.
+class GzipStream {
+public:
+    GzipStream();
+
+    void begin(GzipSink sink, void* context);
+    void write(const uint8_t* data, size_t length);
+    void finish();                      // Flushes and writes the trailer
+
+    uint32_t getInputBytes() const { return _inputBytes; }
+    uint32_t getOutputBytes() const { return _outputBytes; }
+
+private:
+    void compress(bool flush);
+    void slide();
+    void putBits(uint32_t value, uint8_t count);
+    void putCode(uint16_t code, uint8_t length);   // Huffman code, MSB first
+    void putLiteral(uint8_t value);
+    void putMatch(uint16_t length, uint16_t distance);
+    void putByte(uint8_t value);
+    void flushOutput();
+    static uint16_t hash(const uint8_t* p);
+
+    GzipSink _sink;
+    void* _context;
+
+    uint8_t _buffer[2 * GZIP_WINDOW];
+    uint16_t _heads[1 << GZIP_HASH_BITS];   // Last position + 1 per hash, 0 = none
+    uint16_t _fill;                         // Bytes in _buffer
+    uint16_t _pos;                          // Next byte to encode
+
+    uint8_t _out[GZIP_OUT_SIZE];
+    uint16_t _outLength;
+    uint32_t _bits;
+    uint8_t _bitCount;
+
+    uint32_t _crc;
+    uint32_t _inputBytes;
+    uint32_t _outputBytes;
+};
+
+#endif // GZIP_STREAM_H
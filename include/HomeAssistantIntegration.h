@@ -4,12 +4,44 @@
 #include <Arduino.h>
 #include <PubSubClient.h>
 #include <WiFi.h>
+#include "TlsClient.h"
 #include <ArduinoJson.h>
+#include "JsonArena.h"
 #include <LittleFS.h>
 #include "Config.h"
 #include "IrrigationController.h"
+#include "LatencyStats.h"
 
 class NodeManager;
+struct NodePeer;
+class PressureMonitor;
+class FirmwareUpdater;
+
+// A command from the broker, held until update() applies the batch
+struct MqttCommand {
+    char topic[MQTT_CMD_TOPIC_LEN];
+    char payload[MQTT_CMD_PAYLOAD_LEN];
+    uint16_t length;
+    unsigned long receivedAt;       // micros()
+};
+
+struct MqttCommandStats {
+    uint32_t received;
+    uint32_t coalesced;             // Superseded by a newer command on the same topic
+    uint32_t dropped;               // Topic or payload too long, or queue full
+    uint32_t processed;
+    uint32_t stateFlushes;          // Batched channel state publishes
+};
+
+struct MqttConnectionStats {
+    uint32_t connects;
+    uint32_t failures;
+    uint32_t lastConnectMs;         // TCP + TLS + MQTT CONNECT
+    uint32_t lastHandshakeMs;       // TCP + TLS only
+    uint32_t resumed;               // TLS connects that resumed the cached session
+    uint32_t tlsHeap;               // Heap and pool held by the open TLS session
+    uint32_t tlsPoolPeak;           // High-water mark of the TLS memory pool
+};
 
 class HomeAssistantIntegration {
 public:
@@ -23,13 +55,19 @@ public:
 
     // MQTT credentials management
     bool loadCredentials();
-    static bool saveCredentials(const String& broker, uint16_t port, const String& user, const String& password);
-    static bool testConnection(const String& broker, uint16_t port, const String& user, const String& password);
+    static bool saveCredentials(const String& broker, uint16_t port, const String& user, const String& password,
+                                bool tls = false, const String& fingerprint = "");
+    // An empty ca tests against the CA pinned in flash
+    static bool testConnection(const String& broker, uint16_t port, const String& user, const String& password,
+                               bool tls = false, const String& fingerprint = "", const String& ca = "");
+    static bool saveCaCert(const String& pem);      // Empty removes the pinned CA
 
     // Get current config
     String getMqttBroker() const { return _broker; }
     uint16_t getMqttPort() const { return _port; }
     String getMqttUser() const { return _user; }
+    bool getMqttTls() const { return _tls; }
+    String getMqttFingerprint() const { return _fingerprint; }
 
     // Main update loop
     void update();
@@ -43,6 +81,11 @@ public:
     void publishSchedule();
     void publishChannelStates();
     void publishIndividualStatus();
+    void publishGroupStates();
+    void publishPressure();
+    void publishNodeHealth();
+    void publishForecast();
+    void publishUpdate();
 
     // Home Assistant Discovery
     void publishDiscovery();
@@ -51,13 +94,33 @@ public:
     // NodeManager integration (for slave forwarding)
     void setNodeManager(NodeManager* nm) { _nodeManager = nm; }
 
+    // Mainline pressure sensor and burst/leak alert
+    void setPressureMonitor(PressureMonitor* pm) { _pressureMonitor = pm; }
+
+    // Firmware update entity: version, install progress, install command
+    void setFirmwareUpdater(FirmwareUpdater* fu) { _updater = fu; }
+    // Slaves install only through the master's rollout: no install command
+    void setManualInstall(bool allowed) { _manualInstall = allowed; }
+
     // System state
     bool isSystemEnabled() const { return _systemEnabled; }
 
+    // Command handling metrics (for /api/metrics)
+    const MqttCommandStats& getCommandStats() const { return _cmdStats; }
+    const LatencyStats& getCommandLatency() const { return _cmdLatency; }
+    const MqttConnectionStats& getConnectionStats() const { return _connStats; }
+    void resetCommandStats();
+
 private:
     // Internal methods
     void connectMQTT();
+    bool openTransport();
+    static bool openTls(TlsClient& client, const String& broker, uint16_t port,
+                        const char* caCert, const String& fingerprint);
+    static char* loadCaCert();
     void handleMQTTMessage(char* topic, byte* payload, unsigned int length);
+    void queueCommand(const char* topic, const byte* payload, unsigned int length);
+    void processCommands();
     String buildTopic(const char* suffix);
     void subscribe();
 
@@ -66,13 +129,19 @@ private:
     void publishChannelSwitchDiscovery(uint8_t channel);
     void publishChannelDurationDiscovery(uint8_t channel);
     void publishChannelRuntimeDiscovery(uint8_t channel);
+    void publishGroupSwitchDiscovery(uint8_t group);
     void publishGlobalSensorDiscovery();
     void publishModeSelectDiscovery();
+    void publishPressureDiscovery();
+    void publishUpdateDiscovery();
+    void publishNodeHealthDiscovery(const NodePeer* peer);
+    void removeNodeHealthDiscovery(const char* nodeId);
     void removeStaleDiscovery();
 
     // Message handlers
     void handleChannelCommand(uint8_t channel, const String& message);
     void handleChannelDurationSet(uint8_t channel, const String& message);
+    void handleGroupCommand(uint8_t group, const String& message);
     void handleModeSet(const String& message);
 
     // Utility
@@ -80,6 +149,7 @@ private:
     String toISO8601(time_t t);
     String weekdaysToDaysArray(uint8_t weekdays);
     void publishModeState();
+    void fillForecastRun(JsonDocument& doc, const ForecastRun& run);
     unsigned long getChannelTimeRemaining(uint8_t channel);
     bool isChannelActive(uint8_t channel);
 
@@ -90,18 +160,28 @@ private:
     // Member variables
     IrrigationController* _controller;
     NodeManager* _nodeManager;
-    WiFiClient* _wifiClient;
+    PressureMonitor* _pressureMonitor;
+    FirmwareUpdater* _updater;
+    bool _manualInstall;
+    Client* _netClient;                 // WiFiClient, or TlsClient when _tls
     PubSubClient* _mqttClient;
     String _broker;
     uint16_t _port;
     String _user;
     String _password;
+    bool _tls;
+    String _fingerprint;                // SHA-256 of the broker certificate, hex
+    char* _caCert;                      // Must outlive the client (not copied)
     unsigned long _lastReconnectAttempt;
+    unsigned long _reconnectInterval;   // Doubles per failure up to MQTT_RECONNECT_MAX
+    MqttConnectionStats _connStats;
     unsigned long _lastStatusUpdate;
 
     // Per-channel state
     uint16_t _channelDuration[MAX_CHANNELS];
     bool _discoveredChannels[MAX_CHANNELS];
+    bool _discoveredGroups[MAX_GROUPS];
+    char _discoveredNodes[MAX_SLAVES][12];  // Slaves with link diagnostics, "" = free
     uint8_t _lastDiscoveredCount;
 
     // System/mode state
@@ -111,6 +191,9 @@ private:
     // Change detection
     bool _lastIrrigatingState;
     unsigned long _lastFastStatusUpdate;
+    uint32_t _forecastGeneration;       // Schedule generation last published
+    unsigned long _lastForecastPublish;
+    uint32_t _updateGeneration;         // Update job generation last published
 
     // Discovery management
     bool _needsDiscoveryPublish;
@@ -119,6 +202,13 @@ private:
     // Reconciliation
     bool _retryPending[MAX_CHANNELS];
     unsigned long _commandSentTime[MAX_CHANNELS];
+
+    // Command queue: filled by the callback, drained once per update()
+    MqttCommand _cmdQueue[MQTT_CMD_QUEUE_LEN];
+    uint8_t _cmdCount;
+    bool _statePublishPending;          // A handler changed channel state
+    MqttCommandStats _cmdStats;
+    LatencyStats _cmdLatency;           // Receive to state publish
 };
 
 #endif // HOME_ASSISTANT_INTEGRATION_H
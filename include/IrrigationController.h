@@ -4,12 +4,69 @@
 #include <Arduino.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include "JsonArena.h"
 #include "Config.h"
 #include "Valve.h"
+#include "NodeProtocol.h"
+#include "ForecastMerge.h"
 
 // Callback for routing valve commands to remote nodes
 typedef void (*RemoteValveCallback)(uint8_t channel, bool state, uint16_t duration);
 
+// Callback for pre-staging a remote start: the node opens the valve delayMs after receipt
+typedef void (*RemoteStageCallback)(uint8_t channel, uint16_t duration, uint16_t delayMs);
+
+// Callback for a group start/stop: remoteMembers holds only the remote channels
+typedef void (*RemoteGroupCallback)(uint8_t groupIndex, uint64_t remoteMembers, bool state, uint16_t duration);
+
+// Callback when a local channel's run ends (start epoch is 0 without valid time)
+typedef void (*RunEndCallback)(uint8_t channel, uint32_t start, uint16_t durationSec, uint8_t reason);
+
+// Callback for reading a sensor node's probe; false if unknown or stale
+typedef bool (*MoistureProvider)(const char* sensorId, uint8_t probe, float& moisture);
+
+// Closed-loop zone: scheduled runs only start below startBelow and stop once
+// the soil reaches stopAt; the schedule duration remains the upper bound
+struct MoistureLoop {
+    bool enabled;
+    char sensorId[12];         // Sensor node_id
+    uint8_t probe;             // 1-based probe on that node
+    uint8_t startBelow;        // %
+    uint8_t stopAt;            // %, above startBelow (hysteresis band)
+};
+
+// Cycle-and-soak run states
+#define CYCLE_IDLE    0  // Soaking or waiting for a supply slot
+#define CYCLE_STAGED  1  // Start committed for startAt (remote, pre-staged)
+#define CYCLE_RUNNING 2  // Cycle in progress until startAt + cycleMinutes
+
+// One triggered cycle-and-soak schedule working through its cycles
+struct CycleRun {
+    bool active;
+    uint8_t channel;
+    uint8_t state;             // CYCLE_*
+    uint8_t cyclesLeft;
+    uint16_t minutesLeft;      // Watering time still owed across remaining cycles
+    uint16_t cycleMinutes;     // Length of the next (or current) cycle
+    uint16_t soakMinutes;
+    unsigned long readyAt;     // millis() when the soak ends
+    unsigned long startAt;     // millis() of the committed cycle start
+};
+
+// One expanded schedule occurrence
+struct ForecastRun {
+    time_t start;
+    uint8_t scheduleIndex;
+    uint8_t channel;
+    uint16_t durationMinutes;
+    uint8_t cycles;
+    uint16_t soakMinutes;
+    bool skipped;              // Consumed by a user skip
+    bool closedLoop;           // May be skipped on soil moisture
+};
+
+static_assert(MAX_SCHEDULES <= FORECAST_MAX_SLOTS, "ForecastCursor holds every schedule");
+
 class IrrigationController {
 public:
     IrrigationController();
@@ -23,9 +80,10 @@ public:
 
     // Manual control
     void startIrrigation(uint8_t channel = 1, uint16_t durationMinutes = DEFAULT_DURATION_MINUTES, bool manual = true);
-    void stopIrrigation(uint8_t channel = 0);  // 0 = stop all channels
-    bool isIrrigating() const { return _status.irrigating; }
+    void stopIrrigation(uint8_t channel = 0, uint8_t reason = RUN_END_STOPPED);  // 0 = stop all channels
+    bool isIrrigating() const { return _status.channelIrrigating.any(); }
     bool isChannelIrrigating(uint8_t channel) const;
+    uint64_t getIrrigatingMask() const { return _status.channelIrrigating.bits(); }  // Bit n = channel n+1
     bool isManualMode() const { return _status.manualMode; }
     void setManualMode(bool manual) { _status.manualMode = manual; }
     void setSystemEnabled(bool enabled);
@@ -33,15 +91,36 @@ public:
 
     // Schedule management - CRUD operations
     int8_t addSchedule(uint8_t channel, uint8_t hour, uint8_t minute,
-                       uint16_t durationMinutes, uint8_t weekdays);  // Returns schedule index or -1
+                       uint16_t durationMinutes, uint8_t weekdays,
+                       uint8_t cycles = 1, uint16_t soakMinutes = 0);  // Returns schedule index or -1
     bool updateSchedule(uint8_t index, uint8_t channel, uint8_t hour, uint8_t minute,
-                        uint16_t durationMinutes, uint8_t weekdays);
+                        uint16_t durationMinutes, uint8_t weekdays,
+                        uint8_t cycles = 1, uint16_t soakMinutes = 0);
     bool removeSchedule(uint8_t index);
     bool enableSchedule(uint8_t index, bool enabled);
     IrrigationSchedule getSchedule(uint8_t index) const;
     void getSchedules(IrrigationSchedule* schedules, uint8_t& count) const;
     uint8_t getScheduleCount() const;  // Get number of active schedules
 
+    // Channel groups
+    int8_t addGroup(const char* name, uint64_t members);  // Returns group index or -1
+    bool updateGroup(uint8_t index, const char* name, uint64_t members);
+    bool removeGroup(uint8_t index);
+    ChannelGroup getGroup(uint8_t index) const;
+    void startGroup(uint8_t index, uint16_t durationMinutes = DEFAULT_DURATION_MINUTES);
+    void stopGroup(uint8_t index);
+    bool isGroupRunning(uint8_t index) const;  // True if any member is irrigating
+    bool saveGroups();
+    bool loadGroups();
+
+    // Closed-loop zones (soil moisture)
+    bool setMoistureLoop(uint8_t channel, const MoistureLoop& loop);
+    MoistureLoop getMoistureLoop(uint8_t channel) const;
+    bool getChannelMoisture(uint8_t channel, float& moisture) const;  // false if no fresh reading
+    void setMoistureProvider(MoistureProvider cb) { _moistureProvider = cb; }
+    bool saveMoistureLoops();
+    bool loadMoistureLoops();
+
     // Storage
     bool saveSchedules();
     bool loadSchedules();
@@ -50,23 +129,46 @@ public:
     SystemStatus getStatus() const { return _status; }
     unsigned long getTimeRemaining() const;
     unsigned long getNextScheduledTime(uint8_t* nextChannel = nullptr, uint8_t* nextIndex = nullptr) const;
+    bool isChannelSoaking(uint8_t channel) const;  // Between cycle-and-soak cycles
+    unsigned long getChannelRemaining(uint8_t channel) const;  // Seconds left in the channel's run
+    unsigned long getChannelChangedAt(uint8_t channel) const;  // millis() of the last start/stop
     void skipSchedule(uint8_t index);    // Skip the next run of a specific schedule
     void unskipSchedule(uint8_t index);  // Cancel a skip
     bool isScheduleSkipped(uint8_t index) const;
     uint8_t getChannelPin(uint8_t channel) const;
 
+    // Forecast: every schedule occurrence over the next days in time order
+    bool beginForecast(ForecastCursor& cursor, uint16_t days) const;  // false without valid time
+    bool nextForecastRun(ForecastCursor& cursor, ForecastRun& run) const;
+
+    // Change counters (bumped on every visible change, used as HTTP ETags)
+    uint32_t getChannelGeneration() const { return _channelGeneration; }    // Run/soak state, channel settings
+    uint32_t getScheduleGeneration() const { return _scheduleGeneration; }  // Schedules, skips, enabled channels
+
     // Channel settings
     bool isChannelInverted(uint8_t channel) const;
     void setChannelInverted(uint8_t channel, bool inverted);
     bool isChannelEnabled(uint8_t channel) const;
     void setChannelEnabled(uint8_t channel, bool enabled);
+    bool enabledChannelsIdle() const {                      // No enabled channel is running
+        return (_channelEnabled.bits() & _status.channelIrrigating.bits()) == 0;
+    }
     bool saveChannelSettings();
     bool loadChannelSettings();
 
+    // Fault hold: a faulted channel is stopped and refuses starts until cleared
+    void setChannelFault(uint8_t channel, bool fault);
+    bool isChannelFaulted(uint8_t channel) const;
+
     // Valve access (for setting remote callbacks after construction)
     Valve* getValve(uint8_t channel) const;
     void setRemoteValveCallback(RemoteValveCallback cb);
+    void setRemoteStageCallback(RemoteStageCallback cb) { _remoteStageCallback = cb; }
+    void setRemoteGroupCallback(RemoteGroupCallback cb) { _remoteGroupCallback = cb; }
+    void setRunEndCallback(RunEndCallback cb) { _runEndCallback = cb; }
     void setRemoteChannelStatus(uint8_t channel, bool irrigating, uint16_t remainingSec);
+    void reportRemoteChannel(uint8_t channel, uint8_t state, uint16_t remainingSec,
+                             uint16_t elapsedSec);  // Slave MSG_STATUS
 
     // Time management
     void setCurrentTime(time_t time);
@@ -76,12 +178,29 @@ public:
 private:
     // Internal methods
     void checkSchedules();
+    void expireSkips();
     void updateIrrigationState();
+    void stopChannel(uint8_t channel, uint8_t reason = RUN_END_STOPPED);
+    void markChannelRunning(uint8_t idx, uint16_t durationMinutes);
+    void clearChannelRunning(uint8_t idx, uint8_t reason = RUN_END_STOPPED);
+    void reportRunEnd(uint8_t idx, uint8_t reason);
+    void refreshIrrigatingFlag();
     void safetyCheck();
     bool shouldRunSchedule(const IrrigationSchedule& schedule, time_t currentTime);
+    time_t nextOccurrence(const IrrigationSchedule& schedule, time_t after) const;
     void activateValve(uint8_t channel, bool state, bool manual = true);
     int8_t findFreeScheduleSlot() const;
 
+    // Cycle-and-soak interleaver
+    void queueCycleRun(uint8_t scheduleIndex);
+    void processCycleRuns();
+    long nextCycleSlot(long earliest, long lengthMs, unsigned long now) const;
+    void cancelCycleRuns(uint8_t channel);  // 0 = all
+    bool hasCycleRun(uint8_t channel) const;
+
+    // Closed-loop zones
+    void checkMoistureLoops();
+
     // Member variables
     IrrigationSchedule _schedules[MAX_SCHEDULES];
     SystemStatus _status;
@@ -91,9 +210,22 @@ private:
     unsigned long _irrigationStartMillis;
     uint16_t _currentDurationMinutes;
     Valve* _valves[MAX_CHANNELS];
-    bool _channelEnabled[MAX_CHANNELS];
+    ChannelMask<MAX_CHANNELS> _channelEnabled;
     bool _systemEnabled;
     time_t _skipUntil[MAX_SCHEDULES];  // RAM-only: skip schedule until this time
+    CycleRun _cycleRuns[MAX_SCHEDULES];
+    RemoteStageCallback _remoteStageCallback;
+    ChannelGroup _groups[MAX_GROUPS];
+    RemoteGroupCallback _remoteGroupCallback;
+    RunEndCallback _runEndCallback;
+    MoistureLoop _moistureLoops[MAX_CHANNELS];
+    bool _moistureRun[MAX_CHANNELS];   // Scheduled closed-loop run in progress
+    MoistureProvider _moistureProvider;
+    unsigned long _lastMoistureCheck;
+    bool _channelFault[MAX_CHANNELS];
+    unsigned long _channelChangedAt[MAX_CHANNELS];
+    uint32_t _channelGeneration;
+    uint32_t _scheduleGeneration;
 };
 
 #endif // IRRIGATION_CONTROLLER_H
@@ -0,0 +1,67 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoJson.h>
+
+#define JSON_ARENA_SIZE  12288   // Largest nesting: request doc + run history save
+
+// Stack arena backing every ArduinoJson document.
+//
+// Handlers build a document, serialise it and drop it, often with a second
+// one alive (a request body while the schedule file is rewritten). Taking
+// those pools from the heap one after the other fragments it; here they are
+// carved from one fixed buffer in last-in first-out order, which is how
+// scoped documents are released anyway. A block freed out of order is only
+// marked, and reclaimed once everything above it is gone. A request that
+// does not fit falls back to malloc and is counted, so JSON_ARENA_SIZE can
+// be tuned from the high-water mark.
+//
+// Loop task only: there is no locking.
+class JsonArena {
+public:
+    JsonArena();
+
+    void* allocate(size_t size);
+    void deallocate(void* ptr);
+    void* reallocate(void* ptr, size_t size);
+
+    size_t getCapacity() const { return JSON_ARENA_SIZE; }
+    size_t getUsed() const { return _top; }
+    size_t getHighWater() const { return _highWater; }
+    uint32_t getAllocations() const { return _allocations; }
+    uint32_t getFallbacks() const { return _fallbacks; }   // Served by malloc
+    void resetStats();                                      // High-water drops to current use
+
+private:
+    struct Block {
+        uint32_t prev;          // Offset of the block below, NO_BLOCK for the first
+        uint32_t size;          // Payload bytes, FREE_FLAG once released
+    };
+
+    bool owns(const void* ptr) const;
+    Block* blockOf(void* ptr) { return (Block*)((uint8_t*)ptr - sizeof(Block)); }
+
+    alignas(8) uint8_t _buffer[JSON_ARENA_SIZE];
+    uint32_t _top;              // First free byte
+    uint32_t _last;             // Offset of the topmost block
+    size_t _highWater;
+    uint32_t _allocations;
+    uint32_t _fallbacks;
+};
+
+extern JsonArena jsonArena;
+
+// ArduinoJson allocator over the shared arena
+struct JsonArenaAllocator {
+    void* allocate(size_t size) { return jsonArena.allocate(size); }
+    void deallocate(void* ptr) { jsonArena.deallocate(ptr); }
+    void* reallocate(void* ptr, size_t size) { return jsonArena.reallocate(ptr, size); }
+};
+
+// Use in place of DynamicJsonDocument (and of large StaticJsonDocuments,
+// which would otherwise sit on the loop task's stack)
+typedef BasicJsonDocument<JsonArenaAllocator> ArenaJsonDocument;
+
+#endif // JSON_ARENA_H
@@ -0,0 +1,40 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+
+#define LATENCY_SUB_BUCKETS  4      // Per power of two: ~19% resolution
+#define LATENCY_OCTAVES      25     // 1 us .. ~67 s
+#define LATENCY_BUCKETS      (LATENCY_OCTAVES * LATENCY_SUB_BUCKETS)
+
+// Latency histogram in microseconds.
+//
+// Log-linear buckets (four per power of two) keep recording O(1) and the
+// footprint fixed at a few hundred bytes however many samples arrive, at
+// the price of percentiles being bucket upper bounds.
+class LatencyStats {
+public:
+    LatencyStats() { reset(); }
+
+    void reset();
+    void record(uint32_t micros);
+
+    uint32_t getCount() const { return _count; }
+    uint32_t getMax() const { return _max; }
+    uint32_t getMean() const { return _count ? (uint32_t)(_sum / _count) : 0; }
+    uint32_t percentile(float p) const;         // p in 0..100; 0 if empty
+
+private:
+    static uint8_t bucketOf(uint32_t micros);
+    static uint32_t upperBound(uint8_t bucket);
+
+    uint32_t _buckets[LATENCY_BUCKETS];
+    uint32_t _count;
+    uint32_t _max;
+    uint64_t _sum;
+};
+
+// main loop() pass times (defined in main.cpp)
+extern LatencyStats loopLatency;
+
+#endif // LATENCY_STATS_H
@@ -0,0 +1,86 @@
+#ifndef LINK_TIMING_H
+#define LINK_TIMING_H
+
+#include <stdint.h>
+
+// Heartbeat and status intervals (ms)
+#define NODE_HEARTBEAT_FAST       10000   // Heartbeat while a valve runs or a command is pending
+#define NODE_HEARTBEAT_IDLE       40000   // Heartbeat when idle
+#define NODE_HEARTBEAT_MIN        5000    // Floor when a lossy link shortens the interval
+#define NODE_STATUS_FAST          10000   // Slave status while a valve runs (else with the heartbeat)
+
+// Offline deadlines
+#define NODE_TIMEOUT_MISSES       3       // Offline after this many missed heartbeats on a clean link
+#define NODE_TIMEOUT_MAX_MISSES   8       // ...and at most this many on a lossy one
+#define NODE_TIMEOUT_FALSE_RATE   0.001f  // Accepted chance of a false offline per deadline
+#define NODE_TIMEOUT_MARGIN       2000    // Jitter allowance on every deadline
+
+static_assert(NODE_HEARTBEAT_IDLE / NODE_TIMEOUT_MAX_MISSES * NODE_TIMEOUT_MISSES > NODE_HEARTBEAT_FAST,
+              "Shortened idle intervals must stay longer than fast ones");
+
+#define LINK_RTT_SAMPLES 16     // Command round trips kept per slave
+#define LINK_RSSI_SAMPLES 16    // RSSI readings kept per slave (one per status round)
+#define LINK_LOSS_WINDOW 100    // Frames per loss-rate bucket (two buckets kept)
+#define LINK_SEQ_RESYNC 1000    // Bigger sequence jumps are a restart, not loss
+#define LINK_SEQ_REORDER 64     // Sequence steps back that count as late frames
+
+// Rolling link statistics (master-side, per slave)
+struct LinkStats {
+    uint16_t last_seq;         // Newest sequence number heard from the slave
+    bool seq_valid;
+    uint16_t win_rx;           // Current loss bucket
+    uint16_t win_lost;
+    uint16_t prev_rx;          // Previous (complete) loss bucket
+    uint16_t prev_lost;
+    uint32_t rx_total;
+    uint32_t lost_total;       // Sequence gaps
+    uint32_t cmds_sent;        // Reliable frames sent (first transmissions)
+    uint32_t retransmits;
+    uint32_t cmds_dropped;     // Given up after NODE_MAX_RETRIES
+    uint16_t rtt_ms[LINK_RTT_SAMPLES];   // Ring of unambiguous round trips
+    uint8_t rtt_count;
+    uint8_t rtt_idx;
+    int8_t rssi[LINK_RSSI_SAMPLES];     // Ring of reported RSSI (dBm)
+    uint8_t rssi_count;
+    uint8_t rssi_idx;
+    uint32_t uptime;           // Seconds, from the last heartbeat
+    uint16_t reboots;          // Heartbeat uptime went backwards
+};
+
+// Loss accounting and adaptive heartbeat timing for one master-slave link.
+//
+// Slaves never retransmit and send everything to the master from one
+// sequence counter, so a gap in the sequence numbers heard is exactly the
+// number of frames lost on the way.
+//
+// Heartbeats run at NODE_HEARTBEAT_FAST while a slave has a valve open or
+// a command waiting for it, and at NODE_HEARTBEAT_IDLE otherwise. The
+// master picks the interval and hands it to the slave in every
+// HEARTBEAT_ACK, then expects the next frame within NODE_TIMEOUT_MISSES
+// intervals. On a lossy link that many misses in a row happen by chance,
+// so the allowance grows with the measured loss and the interval shrinks
+// by the same factor: the deadline stays where a clean link would put it.
+//
+// NodeManager owns the peers and the clock; this is only the arithmetic.
+class LinkTiming {
+public:
+    // Counts one frame heard with this sequence number
+    static void trackRx(LinkStats& link, uint16_t seq);
+
+    // Fraction of frames lost over the last one to two buckets
+    static float loss(const LinkStats& link);
+
+    // Misses allowed before offline: smallest k >= NODE_TIMEOUT_MISSES with
+    // loss^k below NODE_TIMEOUT_FALSE_RATE
+    static uint8_t timeoutMisses(const LinkStats& link);
+
+    // Heartbeat interval to assign (ms)
+    static uint32_t interval(bool active, const LinkStats& link);
+
+    // Time after a frame until the slave counts as offline (ms). Covers the
+    // previous interval as well, since the slave may not have received the
+    // newest one.
+    static uint32_t deadline(uint32_t interval, uint32_t prevInterval, const LinkStats& link);
+};
+
+#endif // LINK_TIMING_H
@@ -7,12 +7,44 @@
 #include <ESPmDNS.h>
 #include "Config.h"
 #include "NodeProtocol.h"
+#include "RunJournal.h"
+#include "RolloutPlanner.h"
+#include "LinkTiming.h"
 
-// Forward declaration
+// Forward declarations
 class IrrigationController;
+class SoilSensor;
+class FirmwareUpdater;
 
 #define OUTBOX_SIZE 8
 #define DEDUP_SIZE 16
+#define STAGED_SIZE 4
+#define GROUP_TRACK_SIZE 4
+#define STORE_FWD_SIZE 16       // Commands held for unreachable slaves (all peers)
+#define STORE_FWD_PER_PEER 8
+#define RUN_BATCH_RETRY 5000    // Slave: resend unacknowledged runs (ms)
+#define OTA_STATUS_MIN_GAP 1000 // Slave: update job reports between status rounds (ms)
+#define ROLLOUT_SETTLE (2 * NODE_HEARTBEAT_IDLE)  // Master: boot time for slaves to report firmware
+
+// Group ACK state (per master group index)
+#define GROUP_ACK_NONE      0
+#define GROUP_ACK_PENDING   1
+#define GROUP_ACK_CONFIRMED 2
+#define GROUP_ACK_FAILED    3
+
+// Derived view of LinkStats for the API and Home Assistant
+struct LinkHealth {
+    float loss_pct;            // Over the last one to two loss buckets
+    float retransmit_pct;      // Retransmits per reliable frame sent
+    uint8_t rtt_samples;
+    uint16_t rtt_min;          // ms
+    uint16_t rtt_p50;
+    uint16_t rtt_p90;
+    uint16_t rtt_max;
+    uint8_t rssi_samples;
+    int8_t rssi_min;           // dBm
+    float rssi_avg;
+};
 
 // Peer state (master-side bookkeeping for each slave)
 struct NodePeer {
@@ -27,6 +59,36 @@ struct NodePeer {
     bool irrigating;
     uint16_t time_remaining;   // seconds
     int8_t rssi;
+    uint8_t actual_mask;       // Valves the slave last reported open
+    uint16_t actual_end[HEARTBEAT_END_SLOTS];  // ...and their seconds left as of actual_at
+    unsigned long actual_at;   // millis() of that report, 0 = none yet
+    uint16_t divergences;      // Heartbeats that had to correct the slave
+    LinkStats link;
+    unsigned long hb_interval;   // Heartbeat interval last assigned (ms)
+    unsigned long hb_prev;       // ...and the one before, in case that ACK was lost
+    unsigned long last_hb_sent;  // millis() of our last heartbeat to it
+    unsigned long heard_by;      // Deadline for the next frame; offline after it
+    uint16_t run_seq;            // Newest journal seq merged into the run history
+    char version[16];            // Firmware it reported, "" = not since its last restart
+    uint8_t ota_state;           // OTA_* of its update job
+    uint8_t ota_progress;
+    uint16_t crashes;            // Crash resets it reported
+    uint8_t fault_mask;          // Channels it reported held closed
+};
+
+// Sensor node state (master-side bookkeeping for each sensor node)
+struct SensorPeer {
+    char node_id[12];
+    char name[16];
+    IPAddress ip;
+    uint16_t port;
+    uint8_t num_probes;
+    bool online;
+    unsigned long last_seen;                        // millis() of last message
+    float moisture[SENSOR_MAX_PROBES];              // %, as reported
+    unsigned long reading_at[SENSOR_MAX_PROBES];    // millis() of last report, 0 = none
+    float temperature;                              // degC
+    bool has_temperature;
 };
 
 // Pending pair request (master holds one at a time)
@@ -34,6 +96,7 @@ struct PendingPairRequest {
     char node_id[12];
     char name[16];
     uint8_t num_channels;
+    uint8_t role;              // NODE_ROLE_SLAVE or NODE_ROLE_SENSOR
     IPAddress ip;
     uint16_t port;
     unsigned long received_at;
@@ -48,11 +111,45 @@ struct OutboxEntry {
     IrrigationMsg msg;
     IPAddress dst_ip;
     uint16_t dst_port;
+    unsigned long first_send;  // For shrinking a pre-staged delay on retry
     unsigned long last_send;
     uint8_t retries;
     bool active;
 };
 
+// Slave: start received ahead of time, fired locally when due
+struct StagedStart {
+    uint8_t channel;
+    uint16_t duration;
+    unsigned long due_at;      // millis()
+    bool active;
+};
+
+// Master: aggregates the per-node ACKs of one group command
+struct GroupAckTracker {
+    bool active;
+    uint8_t group_id;
+    bool start;
+    uint8_t frames;            // Frames sent (one per node)
+    uint16_t pending;          // Bit per frame still awaiting ACK
+    bool failed;               // A node rejected, was offline or never answered
+    uint16_t seqs[MAX_SLAVES];
+};
+
+// Master: command held for a slave until its next heartbeat
+struct StoredCommand {
+    char node_id[12];
+    uint8_t type;              // MSG_CMD_START or MSG_CMD_STOP
+    uint8_t channel;           // Slave-local channel
+    uint16_t duration;         // minutes (start)
+    uint16_t delay_ms;         // Pre-staged start delay, shrinks while queued
+    unsigned long queued_at;   // millis()
+    unsigned long ttl;         // ms until the command is discarded
+};
+
+// Callback when every node of a group command has answered
+typedef void (*GroupAckCallback)(uint8_t groupId, bool start, bool confirmed);
+
 // Dedup entry to ignore duplicate messages
 struct DedupEntry {
     uint16_t seq;
@@ -77,9 +174,14 @@ public:
     bool addSlave(const char* nodeId, uint8_t baseVirtualCh);
 
     // Master: send command to a virtual channel
-    bool sendStart(uint8_t virtualChannel, uint16_t durationMinutes);
+    bool sendStart(uint8_t virtualChannel, uint16_t durationMinutes, uint16_t delayMs = 0);
     bool sendStop(uint8_t virtualChannel);
 
+    // Master: group command — one multi-channel frame per node
+    uint8_t sendGroupCommand(uint8_t groupId, uint64_t members, bool start, uint16_t durationMinutes);
+    void setGroupAckCallback(GroupAckCallback cb) { _groupAckCallback = cb; }
+    uint8_t getGroupAckState(uint8_t groupId) const;
+
     // Master: schedule sync — push schedules to slave
     void sendScheduleSync(const char* slaveNodeId);
     void sendSkipToSlave(uint8_t virtualChannel, uint8_t scheduleIndex);
@@ -89,8 +191,43 @@ public:
     const NodePeer* getSlave(uint8_t index) const;
     uint8_t getSlaveCount() const { return _slaveCount; }
 
+    // Sensor peer info (for master)
+    const SensorPeer* getSensor(uint8_t index) const;
+    uint8_t getSensorCount() const { return _sensorCount; }
+    bool getSensorMoisture(const char* nodeId, uint8_t probe, float& moisture) const;  // false if unknown or stale
+
+    // Link quality of a slave (master); false if the index is out of range
+    bool getLinkHealth(uint8_t index, LinkHealth& health) const;
+
+    // Store-and-forward queue depth for a slave (master)
+    uint8_t getStoredCommandCount(const char* nodeId) const;
+
+    // Bumped whenever the peer table, peer online/RSSI state, the pending pair
+    // or a store-and-forward queue changes
+    uint32_t getPeerGeneration() const { return _peerGeneration; }
+
+    // Completed run of a local channel: journaled for the master on a slave,
+    // merged straight into the fleet history on the master
+    void recordRun(const RunRecord& run);
+    const RunHistory& getRunHistory() const { return _runHistory; }
+
+    // Sensor node: probes to report to the master
+    void setSoilSensor(SoilSensor* sensor) { _soilSensor = sensor; }
+
+    // This node's own updater: a slave installs through it when the master
+    // orders, the master checks through it and updates itself last
+    void setFirmwareUpdater(FirmwareUpdater* updater) { _updater = updater; }
+
+    // Master: staged rollout of target over the slaves (see RolloutPlanner).
+    // Started automatically when a check finds a release, unless that
+    // release's rollout halted before.
+    bool startRollout(const char* target, const char* canary = nullptr);
+    void abortRollout();
+    const RolloutPlanner& getRollout() const { return _rollout; }
+
     // Auto-pairing (slave)
     bool isPaired() const { return _paired; }
+    uint16_t getReconcileCount() const { return _reconciled; }  // Channels corrected from master heartbeats
 
     // Auto-pairing (master)
     void setPairRequestCallback(PairRequestCallback cb) { _pairRequestCallback = cb; }
@@ -99,10 +236,10 @@ public:
     void acceptPendingPair();
     void rejectPendingPair(uint8_t reason);
 
-    // Unpair a slave by node_id (master)
+    // Unpair a slave or sensor node by node_id (master)
     bool unpairSlave(const char* nodeId);
 
-    // Rename a paired slave (master)
+    // Rename a paired slave or sensor node (master)
     bool renameSlave(const char* nodeId, const char* newName);
 
 private:
@@ -121,6 +258,52 @@ private:
     bool isDuplicate(const char* srcId, uint16_t seq);
     void addDedup(const char* srcId, uint16_t seq);
 
+    // Master: link statistics
+    void recordRtt(LinkStats& link, unsigned long ms);
+    void recordRssi(LinkStats& link, int8_t rssi);
+    void recordUptime(NodePeer* peer, uint32_t uptime);
+
+    // Adaptive intervals
+    bool isPeerActive(const NodePeer& peer) const;
+    unsigned long peerInterval(const NodePeer& peer) const;
+    bool isLocallyActive() const;
+    void refreshDeadline(NodePeer& peer);
+
+    // Slave: pre-staged starts
+    void processStagedStarts();
+    void cancelStagedStart(uint8_t channel);  // 0 = all
+    bool hasStagedStart(uint8_t channel) const;
+
+    // Anti-entropy: valve state vector carried by heartbeats
+    void fillStateVector(IrrigationMsg& msg, uint8_t firstCh, uint8_t count);
+    bool isPeerDiverged(const NodePeer& peer, const IrrigationMsg& desired);
+    void reconcileState(const IrrigationMsg& msg);
+
+    // Master: store-and-forward for unreachable slaves
+    void transmitCommand(NodePeer* peer, uint8_t type, uint8_t localCh,
+                         uint16_t duration, uint16_t delayMs);
+    bool storeCommand(const char* nodeId, uint8_t type, uint8_t localCh,
+                      uint16_t duration, uint16_t delayMs);
+    bool dropStoredCommands(const char* nodeId, uint8_t localCh);  // 0 = all channels
+    void removeStoredAt(uint8_t index);
+    void flushStoredCommands(NodePeer* peer);
+    void expireStoredCommands();
+    void requeueDropped(const IrrigationMsg& msg);
+    void saveStoredCommands();
+    void loadStoredCommands();
+
+    // Firmware rollout
+    void processRollout();                 // Master
+    void sendOtaStart(const NodePeer& peer);
+    void processOtaOrder();                // Slave
+    void sendOtaStatus();
+    void saveRolloutState();
+    void loadRolloutState();
+
+    // Master: group ACK aggregation
+    void resolveGroupFrame(uint16_t seq, bool ok);
+    void finishGroupTracker(GroupAckTracker& tracker);
+
     // Message handlers
     void handleMessage(IPAddress senderIp, uint16_t senderPort,
                        const uint8_t* data, int len);
@@ -128,11 +311,21 @@ private:
                         const IrrigationMsg& msg);
     void handleCmdStop(IPAddress senderIp, uint16_t senderPort,
                        const IrrigationMsg& msg);
+    void handleCmdGroup(IPAddress senderIp, uint16_t senderPort,
+                        const IrrigationMsg& msg);
     void handleCmdAck(const IrrigationMsg& msg);
     void handleStatus(IPAddress senderIp, const IrrigationMsg& msg);
     void handleHeartbeat(IPAddress senderIp, uint16_t senderPort,
                          const IrrigationMsg& msg);
     void handleHeartbeatAck(const IrrigationMsg& msg);
+    void handleSensorReport(IPAddress senderIp, uint16_t senderPort,
+                            const IrrigationMsg& msg);
+    void handleRunBatch(IPAddress senderIp, uint16_t senderPort,
+                        const uint8_t* data, int len);
+    void handleRunAck(const IrrigationMsg& msg);
+    void handleOtaStart(IPAddress senderIp, uint16_t senderPort,
+                        const IrrigationMsg& msg);
+    void handleOtaStatus(const IrrigationMsg& msg);
 
     // Schedule sync handlers
     void handleScheduleSet(IPAddress senderIp, uint16_t senderPort,
@@ -143,6 +336,7 @@ private:
     void handleCmdUnskip(IPAddress senderIp, uint16_t senderPort,
                          const IrrigationMsg& msg);
     void syncSchedulesForSlave(NodePeer* slave);
+    bool isMasterDriven(const IrrigationSchedule& schedule) const;
 
     // Pairing handlers
     void handlePairRequest(IPAddress senderIp, uint16_t senderPort,
@@ -158,16 +352,28 @@ private:
     void loadPairedSlaves();
     void savePairedMaster();
     void loadPairedMaster();
+    void savePairedSensors();
+    void loadPairedSensors();
+
+    // Run journal (slave) and fleet run history (master) persistence
+    void saveRunJournal();
+    void loadRunJournal();
+    void saveRunHistory();
+    void loadRunHistory();
 
     // Sending helpers
     void sendHeartbeat();
     void sendStatus();
+    void sendSensorReports();
+    void sendRunBatch();
     void sendAck(IPAddress ip, uint16_t port, uint8_t ackedType,
                  uint8_t result, uint16_t ackedSeq);
 
     // Peer lookup
     NodePeer* findSlaveByNodeId(const char* nodeId);
     NodePeer* findSlaveByVirtualCh(uint8_t virtualCh);
+    SensorPeer* findSensorByNodeId(const char* nodeId);
+    bool addSensor(const char* nodeId);
 
     // Timeout check
     void checkPeerTimeouts();
@@ -189,6 +395,14 @@ private:
     NodePeer _slaves[MAX_SLAVES];
     uint8_t _slaveCount;
 
+    // Master: sensor peers
+    SensorPeer _sensors[MAX_SENSOR_NODES];
+    uint8_t _sensorCount;
+    uint32_t _peerGeneration;
+
+    // Sensor node: local probes
+    SoilSensor* _soilSensor;
+
     // Slave: master info
     IPAddress _masterIp;
     uint16_t _masterPort;
@@ -203,6 +417,23 @@ private:
     uint8_t _assignedVirtualCh;            // Slave: my virtual channel
     unsigned long _lastPairAttempt;        // Slave: last PAIR_REQUEST send time
     char _nodeName[16];                    // Slave: human-readable name
+    uint16_t _reconciled;                  // Slave: channels corrected by state vectors
+
+    // Run records
+    RunJournal _runJournal;                // Slave: runs awaiting the master's ACK
+    RunHistory _runHistory;                // Master: merged fleet history
+    unsigned long _lastRunBatch;           // Slave: millis() of the last batch sent
+
+    // Firmware
+    FirmwareUpdater* _updater;
+    RolloutPlanner _rollout;               // Master
+    uint8_t _rolloutState;                 // Master: planner state last acted on
+    uint32_t _updaterSeen;                 // Master: updater generation last considered
+    char _haltedTarget[16];                // Master: not rolled out again automatically
+    bool _selfUpdate;                      // Master: update itself once the slaves are done
+    char _otaOrder[16];                    // Slave: ordered version, held until idle
+    uint32_t _otaReported;                 // Slave: updater generation last reported
+    unsigned long _lastOtaStatus;
 
     // mDNS state
     bool _mdnsStarted;
@@ -211,10 +442,18 @@ private:
     OutboxEntry _outbox[OUTBOX_SIZE];
     DedupEntry _dedup[DEDUP_SIZE];
     uint8_t _dedupIdx;
+    StagedStart _staged[STAGED_SIZE];
+    GroupAckTracker _groupTrackers[GROUP_TRACK_SIZE];
+    StoredCommand _stored[STORE_FWD_SIZE];  // In arrival order
+    uint8_t _storedCount;
+    uint16_t _lastCmdSeq[MAX_CHANNELS + 1];  // Newest frame per virtual channel
+    uint8_t _groupAckState[MAX_GROUPS];
+    GroupAckCallback _groupAckCallback;
 
     // Timing
     unsigned long _lastHeartbeat;
     unsigned long _lastStatusSend;
+    unsigned long _hbInterval;             // Slave/sensor: interval assigned by the master
     bool _initialized;
 };
 
@@ -17,12 +17,18 @@
 #define MSG_CMD_STOP        0x21
 #define MSG_CMD_SKIP        0x22
 #define MSG_CMD_UNSKIP      0x23
+#define MSG_CMD_GROUP_START 0x24  // Several channels on one node, one frame
+#define MSG_CMD_GROUP_STOP  0x25
 #define MSG_CMD_ACK         0x2F
 #define MSG_STATUS          0x30
 #define MSG_PAIR_REQUEST    0x40
 #define MSG_PAIR_ACCEPT     0x41
 #define MSG_PAIR_REJECT     0x42
-// 0x70-0x7F reserved for future sensor node payloads
+#define MSG_RUN_BATCH       0x50  // Slave -> master: completed runs (RunBatchMsg)
+#define MSG_RUN_ACK         0x51  // Master -> slave: journal merged up to seq
+#define MSG_OTA_START       0x60  // Master -> slave: install the rollout's version
+#define MSG_OTA_STATUS      0x61  // Slave -> master: firmware and update job state
+#define MSG_SENSOR_REPORT   0x70  // 0x70-0x7F reserved for sensor node payloads
 
 // ACK result codes
 #define ACK_OK            0x00
@@ -37,6 +43,24 @@
 // Node roles
 #define NODE_ROLE_MASTER  0x01
 #define NODE_ROLE_SLAVE   0x02
+#define NODE_ROLE_SENSOR  0x03  // No valves; reports soil moisture
+
+// Sensor report flags
+#define SENSOR_FLAG_KEEPALIVE 0x01  // Sent because the keepalive expired
+#define SENSOR_TEMP_NONE      INT16_MIN
+
+// Heartbeat state vector: channels with an end time (the rest carry on/off only)
+#define HEARTBEAT_END_SLOTS 4
+
+// Run end reasons (RunRecord.reason)
+#define RUN_END_COMPLETE  0x00  // Ran its full duration
+#define RUN_END_STOPPED   0x01  // Stopped by a user, rule, group or system disable
+#define RUN_END_SAFETY    0x02  // Safety timeout
+#define RUN_END_FAULT     0x03  // Channel fault hold (pressure alert, node fault)
+#define RUN_END_MOISTURE  0x04  // Closed-loop zone reached its target
+
+#define RUN_VOLUME_NONE   0xFFFF  // No flow meter on the channel
+#define RUN_BATCH_MAX     8
 
 // Broadcast destination
 #define NODE_BROADCAST_ID "*"
@@ -53,28 +77,49 @@ typedef struct __attribute__((packed)) {
 
     // Payload (max 20 bytes)
     union {
-        struct {                          // MSG_CMD_START (2 bytes)
+        struct {                          // MSG_CMD_START (4 bytes)
             uint16_t duration;           // minutes (0 = use schedule default)
+            uint16_t delay_ms;           // pre-staged: start this long after receipt
         } command;
 
-        struct {                          // MSG_STATUS (8 bytes)
+        struct {                          // MSG_CMD_GROUP_* (5 bytes)
+            uint16_t duration;           // minutes (start only)
+            uint16_t channel_mask;       // bit n = node-local channel n+1
+            uint8_t  group_id;           // master group index (for logging)
+        } group;
+
+        struct {                          // MSG_STATUS (10 bytes)
             uint8_t  state;              // 0=idle, 1=irrigating, 2=error
             uint16_t time_remaining;     // seconds
             uint16_t flow_litres;        // x10 for 0.1L resolution
             uint8_t  battery_pct;        // 0-100, 0xFF = mains
             uint8_t  tank_pct;           // 0-100, 0xFF = no sensor
             int8_t   rssi;               // WiFi signal dBm
+            uint16_t run_elapsed;        // seconds since the current run started
         } status;
 
-        struct {                          // MSG_HEARTBEAT (7 bytes)
+        struct {                          // MSG_SENSOR_REPORT (8 bytes)
+            uint16_t moisture_x10;       // 0.1 % (temperature compensated)
+            int16_t  temp_x10;           // 0.1 degC, SENSOR_TEMP_NONE = no thermistor
+            uint16_t raw_mv;             // uncompensated probe voltage
+            uint8_t  flags;              // SENSOR_FLAG_*
+            uint8_t  num_probes;         // probes on the node (channel = probe)
+        } sensor;
+
+        struct {                          // MSG_HEARTBEAT (20 bytes)
             uint8_t  num_channels;
             uint8_t  role;               // NODE_ROLE_*
             uint8_t  pending_cmds;       // queued commands count
             uint32_t uptime;             // seconds
+            // Valve state vector: desired (master -> slave) or actual (slave -> master)
+            uint8_t  valve_mask;         // bit n = node-local channel n+1 open
+            uint32_t epoch_time;         // sender clock; 0 = no vector
+            uint16_t end_sec[HEARTBEAT_END_SLOTS];  // channel n+1 ends at epoch_time + end_sec[n]
         } heartbeat;
 
-        struct {                          // MSG_HEARTBEAT_ACK (4 bytes)
+        struct {                          // MSG_HEARTBEAT_ACK (6 bytes)
             uint32_t epoch_time;         // current epoch from master (NTP)
+            uint16_t interval_s;         // heartbeat interval the master expects, 0 = keep
         } heartbeat_ack;
 
         struct {                          // MSG_CMD_ACK (4 bytes)
@@ -92,9 +137,25 @@ typedef struct __attribute__((packed)) {
             uint8_t  weekdays;
         } schedule;
 
-        struct {                          // MSG_PAIR_REQUEST (17 bytes)
+        struct {                          // MSG_RUN_ACK (2 bytes)
+            uint16_t seq;                // Newest journal seq merged
+        } run_ack;
+
+        struct {                          // MSG_OTA_START (16 bytes)
+            char     version[16];        // Install only if the release is still this one
+        } ota_start;
+
+        struct {                          // MSG_OTA_STATUS (20 bytes)
+            uint8_t  state;              // OTA_* of the node's update job
+            uint8_t  progress;           // %, while downloading
+            uint16_t crashes;            // Crash resets recorded by the node
+            char     version[16];        // Running firmware
+        } ota_status;
+
+        struct {                          // MSG_PAIR_REQUEST (18 bytes)
             uint8_t  num_channels;
             char     name[16];
+            uint8_t  role;               // NODE_ROLE_* (0 from older slaves)
         } pair;
 
         struct {                          // MSG_PAIR_ACCEPT (1 byte)
@@ -109,4 +170,27 @@ typedef struct __attribute__((packed)) {
     };
 } IrrigationMsg;
 
+// One completed run (12 bytes)
+typedef struct __attribute__((packed)) {
+    uint32_t start;          // Epoch (UTC) the valve opened, 0 = clock not set
+    uint16_t duration_s;     // Actual open time
+    uint16_t volume_dl;      // 0.1 L, RUN_VOLUME_NONE = not metered
+    uint16_t seq;            // Per-node journal sequence
+    uint8_t  channel;        // 1-based; node-local in a batch, fleet-wide on the master
+    uint8_t  reason;         // RUN_END_*
+} RunRecord;
+
+// MSG_RUN_BATCH is the one variable-length frame: the IrrigationMsg header,
+// a count, then that many records in journal order
+typedef struct __attribute__((packed)) {
+    uint8_t  version;
+    uint8_t  type;           // MSG_RUN_BATCH
+    uint16_t seq;
+    char     src_id[12];
+    char     dst_id[12];
+    uint8_t  channel;        // Unused (0)
+    uint8_t  count;
+    RunRecord runs[RUN_BATCH_MAX];
+} RunBatchMsg;
+
 #endif // NODE_PROTOCOL_H
@@ -0,0 +1,107 @@
+#ifndef PRESSURE_DETECTOR_H
+#define PRESSURE_DETECTOR_H
+
+#include <stdint.h>
+
+#define PRESSURE_MAX_ZONES     32      // Zones are 1-based channel numbers
+
+// Detector tuning (for ~50 Hz block means)
+#define PRESSURE_FILTER_ALPHA  0.3f    // EMA on block means (~50 ms time constant at 50 Hz)
+#define PRESSURE_SETTLE_MS     3000    // Ignore the transient after any valve change
+#define PRESSURE_CUSUM_SLACK   8.0f    // kPa of sag tolerated per sample
+#define PRESSURE_CUSUM_LIMIT   150.0f  // kPa*samples before a change point is declared
+#define PRESSURE_TRACK_ALPHA   0.002f  // Reference drift tracking (~10 s at 50 Hz)
+#define PRESSURE_DRIFT_BLOCK   3000    // Static drift: samples per block mean (~1 min at 50 Hz)
+#define PRESSURE_DRIFT_ALPHA   0.0167f // ...EMA on block means (~1 h time constant)
+#define PRESSURE_DRIFT_BAND    3.0f    // Below static by more than this: a sag, baseline frozen
+#define PRESSURE_SAG_STEP      1.0f    // A sag still deepening makes a new low by this much...
+#define PRESSURE_SAG_STEADY_MS 600000  // ...a sag without one this long was a supply change
+#define PRESSURE_SAVE_DELTA    1.0f    // Static baseline change (kPa) worth persisting
+#define PRESSURE_LEARN_WEIGHT  0.2f    // Weight of each clean run in a learned baseline
+#define PRESSURE_BURST_DROP    0.25f   // Burst: >25% below the zone's reference
+#define PRESSURE_LEAK_DROP     15.0f   // Leak: static pressure this many kPa low
+#define PRESSURE_LEAK_HOLD_MS  1500    // ...for this long with every valve closed
+
+// Detector events
+#define PRESSURE_EVENT_NONE    0
+#define PRESSURE_EVENT_BURST   1       // Pressure collapse while zones are open
+#define PRESSURE_EVENT_LEAK    2       // Pressure sag with every valve closed
+
+// Burst and leak detector for a mainline pressure signal.
+//
+// The caller feeds filtered block means (kPa) together with the set of open
+// zones. After every valve change the detector waits PRESSURE_SETTLE_MS,
+// then anchors a reference level. With one zone open the settled level is
+// compared against that zone's learned baseline; afterwards a one-sided
+// CUSUM watches for a downward change point. A change point that takes the
+// pressure more than PRESSURE_BURST_DROP below the reference is a burst; a
+// smaller one (a neighbour opening a tap) just re-anchors the reference.
+//
+// With every valve closed the line should sit at its learned static
+// pressure; a sustained sag below it is a leak. The static baseline
+// follows supply drift over hours and holds still while a sag is in
+// progress, so a line draining slowly still reaches the leak threshold.
+//
+// Baselines are learned only from runs that raised no alarm.
+class PressureDetector {
+public:
+    PressureDetector();
+
+    void reset();
+
+    // Valve state (bit n = zone n+1). Restarts settling when it changes.
+    void setOpenZones(uint32_t mask, uint32_t nowMs);
+    uint32_t getOpenZones() const { return _open; }
+
+    // Feed one sample; returns PRESSURE_EVENT_*
+    uint8_t addSample(float kPa, uint32_t nowMs);
+
+    // State
+    float getPressure() const { return _filtered; }
+    bool isSettled() const { return _settled; }
+    uint8_t getAlarm() const { return _alarm; }           // Latched until cleared
+    uint32_t getAlarmZones() const { return _alarmZones; }
+    void clearAlarm();
+
+    // Learned baselines (kPa, 0 = not learned yet)
+    float getZoneBaseline(uint8_t zone) const;
+    void setZoneBaseline(uint8_t zone, float kPa);
+    float getStaticBaseline() const { return _staticBaseline; }
+    void setStaticBaseline(float kPa);
+    bool takeBaselinesChanged();                            // True once per meaningful change
+
+private:
+    uint8_t raise(uint8_t event, uint32_t zones);
+    uint8_t singleZone() const;                             // 1-based, 0 = none or several
+    void learn(float& baseline, float value);
+    void trackStatic(uint32_t nowMs);
+    void moveStatic(float kPa);
+
+    float _zoneBaseline[PRESSURE_MAX_ZONES];
+    float _staticBaseline;
+    float _reportedStatic;                                  // Static baseline last flagged as changed
+    bool _baselinesChanged;
+
+    uint32_t _open;
+    uint32_t _settleUntil;
+    float _settleSum;
+    uint16_t _settleCount;
+    bool _settled;
+    bool _primed;                                           // _filtered holds a value
+
+    float _filtered;
+    float _reference;
+    float _cusum;
+    bool _runClean;                                         // No alarm since settling
+    uint32_t _leakSince;
+    bool _leakActive;
+    float _driftSum;                                        // Deviations from static, this block
+    uint16_t _driftCount;
+    float _sagLow;                                          // Lowest level of the sag in progress
+    uint32_t _sagSince;                                     // ms of its last new low, 0 = no sag
+
+    uint8_t _alarm;
+    uint32_t _alarmZones;
+};
+
+#endif // PRESSURE_DETECTOR_H
@@ -0,0 +1,66 @@
+#ifndef PRESSURE_MONITOR_H
+#define PRESSURE_MONITOR_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include "JsonArena.h"
+#include "Config.h"
+#include "PressureDetector.h"
+
+// Forward declaration
+class IrrigationController;
+
+// Callback when a burst or leak is detected (event = PRESSURE_EVENT_*)
+typedef void (*PressureAlertCallback)(uint8_t event, uint32_t zones, float pressureKpa);
+
+// One block mean from the sampler task
+struct PressureBlock {
+    uint16_t milliVolts;
+    uint32_t at;               // millis() when the block completed
+};
+
+// Mainline pressure monitoring for a valve node.
+//
+// A dedicated task samples the transducer at PRESSURE_SAMPLE_HZ and queues
+// PRESSURE_BLOCK_SIZE-sample means; update() drains the queue into the
+// PressureDetector alongside the node's open local valves. A burst faults
+// (shuts and holds) the open valves until the alarm is cleared; both
+// bursts and leaks go to the alert callback.
+class PressureMonitor {
+public:
+    PressureMonitor(IrrigationController* controller);
+
+    // Component lifecycle
+    bool begin();
+    void update();
+
+    // State
+    float getPressure() const { return _detector.getPressure(); }  // kPa, filtered
+    bool isSensorOk() const { return _sensorOk; }
+    uint8_t getAlarm() const { return _detector.getAlarm(); }
+    uint32_t getAlarmZones() const { return _detector.getAlarmZones(); }
+    void clearAlarm();
+    const PressureDetector& getDetector() const { return _detector; }
+
+    void setAlertCallback(PressureAlertCallback cb) { _alertCallback = cb; }
+
+    // Learned baselines
+    bool saveBaselines();
+    bool loadBaselines();
+
+private:
+    static void samplerTask(void* arg);
+    uint32_t openLocalZones() const;
+
+    IrrigationController* _controller;
+    PressureDetector _detector;
+    PressureAlertCallback _alertCallback;
+    QueueHandle_t _queue;
+    TaskHandle_t _task;
+    bool _sensorOk;
+    bool _baselinesDirty;
+    unsigned long _lastSave;
+};
+
+#endif // PRESSURE_MONITOR_H
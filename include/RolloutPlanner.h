@@ -0,0 +1,129 @@
+#ifndef ROLLOUT_PLANNER_H
+#define ROLLOUT_PLANNER_H
+
+#include <stdint.h>
+
+#define ROLLOUT_MAX_NODES       16
+
+// Gates (ms)
+#define ROLLOUT_CANARY_SOAK     1800000UL   // Canary must stay healthy this long
+#define ROLLOUT_WAVE_SOAK       600000UL    // ...and every later node this long
+#define ROLLOUT_START_TIMEOUT   120000UL    // Install ordered, no job seen on the node
+#define ROLLOUT_UPDATE_TIMEOUT  900000UL    // Job seen, node not back on the target
+#define ROLLOUT_OFFLINE_LIMIT   3600000UL   // Offline this long at its turn: skipped
+#define ROLLOUT_FIRST_WAVE      2           // Nodes in the first wave after the canary; doubles per wave
+
+// Rollout states
+#define ROLLOUT_IDLE            0
+#define ROLLOUT_CANARY          1
+#define ROLLOUT_WAVES           2
+#define ROLLOUT_DONE            3
+#define ROLLOUT_HALTED          4           // A node failed a gate, or aborted
+
+// Node states
+#define ROLLOUT_NODE_PENDING    0           // Waiting for its wave, or deferred
+#define ROLLOUT_NODE_ORDERED    1           // Install order sent
+#define ROLLOUT_NODE_UPDATING   2           // Downloading or restarting
+#define ROLLOUT_NODE_SOAKING    3           // Back on the target, health window running
+#define ROLLOUT_NODE_DONE       4
+#define ROLLOUT_NODE_SKIPPED    5           // Already on the target, offline, unpaired or too old
+#define ROLLOUT_NODE_FAILED     6
+
+#define ROLLOUT_WAVE_NONE       0xFF
+
+// What the master knows of a slave right now
+struct RolloutNode {
+    char nodeId[12];
+    char version[16];          // Reported firmware, "" = not reported (yet)
+    bool online;
+    bool busy;                 // Valve open, start staged or command queued
+    bool jobRunning;           // Downloading, or restarting into the new image
+    bool jobFailed;
+    uint16_t reboots;          // Seen by the master (uptime went backwards)
+    uint16_t crashes;          // Reported by the node
+    uint16_t divergences;      // Heartbeats that had to correct its valves
+    uint8_t faultMask;         // Channels the node holds closed on a fault
+    uint32_t valveReportAt;    // ms of the newest valve state report, 0 = none
+};
+
+// Planner bookkeeping per slave
+struct RolloutEntry {
+    char nodeId[12];
+    uint8_t state;             // ROLLOUT_NODE_*
+    uint8_t wave;              // 0 = canary, ROLLOUT_WAVE_NONE = not scheduled
+    bool deferred;             // Its wave is running, but the node is busy or offline
+    uint32_t since;            // ms the state was entered
+    uint32_t offlineSince;     // ms it was first seen offline at its turn, 0 = online
+    uint16_t reboots;          // Baselines: at the order, then at the start of the soak
+    uint16_t crashes;
+    uint16_t divergences;
+    char reason[32];           // Why it failed or was skipped
+};
+
+// Staged firmware rollout across the slaves of a master.
+//
+// One canary is updated first and has to pass the health gates for
+// ROLLOUT_CANARY_SOAK before anything else moves; then the rest follow in
+// waves of ROLLOUT_FIRST_WAVE, doubling each time, and each wave has to
+// pass before the next is ordered. A node gets its install order only
+// while it is online and idle; otherwise it is deferred within its wave.
+//
+// After the install a node must come back on the target version (the
+// heartbeat resumes) and then, through the soak window, stay online, not
+// restart or crash again, report its valve state with no fault and never
+// need a correction from the master's desired state. The first node to
+// fail a gate halts the rollout: nodes already ordered finish, nothing new
+// is ordered.
+//
+// The planner only decides; the caller feeds it a snapshot of the slaves
+// each step and sends the install orders it returns.
+class RolloutPlanner {
+public:
+    RolloutPlanner();
+
+    // Plans a rollout of target over the given slaves. canary picks the
+    // first node by id (nullptr or "" = first eligible). False if one is
+    // already running or the canary is unknown or ineligible.
+    bool start(const char* target, const RolloutNode* nodes, uint8_t count,
+               const char* canary, uint32_t nowMs);
+
+    // Advances the rollout; bit n set = order nodes[n] to install now
+    uint32_t step(const RolloutNode* nodes, uint8_t count, uint32_t nowMs);
+
+    void halt(const char* reason);
+
+    // State
+    uint8_t getState() const { return _state; }
+    bool isRunning() const { return _state == ROLLOUT_CANARY || _state == ROLLOUT_WAVES; }
+    const char* getTarget() const { return _target; }
+    uint8_t getWave() const { return _wave; }
+    uint8_t getWaveCount() const { return _waveCount; }
+    const char* getReason() const { return _reason; }      // Why it halted
+    uint8_t getEntryCount() const { return _count; }
+    const RolloutEntry& getEntry(uint8_t index) const { return _entries[index]; }
+    uint32_t getGeneration() const { return _generation; }  // Bumped on every change
+
+    static const char* stateName(uint8_t state);
+    static const char* nodeStateName(uint8_t state);
+
+private:
+    void stepEntry(RolloutEntry& entry, const RolloutNode* node, uint32_t nowMs, uint32_t& orders,
+                   uint8_t index);
+    void enter(RolloutEntry& entry, uint8_t state, uint32_t nowMs, const char* reason = nullptr);
+    void enterSoak(RolloutEntry& entry, const RolloutNode& node, uint32_t nowMs);
+    void fail(RolloutEntry& entry, uint32_t nowMs, const char* reason);
+    void advanceWave();
+    static int8_t findNode(const RolloutNode* nodes, uint8_t count, const char* nodeId);
+
+    uint8_t _state;
+    char _target[16];
+    uint8_t _wave;             // Wave being rolled out
+    uint8_t _waveCount;
+    char _reason[48];
+
+    RolloutEntry _entries[ROLLOUT_MAX_NODES];
+    uint8_t _count;
+    uint32_t _generation;
+};
+
+#endif // ROLLOUT_PLANNER_H
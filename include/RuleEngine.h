@@ -0,0 +1,134 @@
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <stdint.h>
+
+#define RULE_MAX_RULES      12
+#define RULE_NAME_LEN       24
+#define RULE_WHEN_LEN       96      // Condition source text
+#define RULE_THEN_LEN       24      // Action source text
+#define RULE_MAX_CODE       64      // Bytecode bytes per rule
+#define RULE_MAX_CONSTS     8       // Numeric literals per rule
+#define RULE_STACK_DEPTH    8
+#define RULE_ERROR_LEN      48
+
+// Inputs a condition can read. Variables take no argument; functions take
+// one (a channel number).
+#define RULE_IN_HOUR        0       // Local time
+#define RULE_IN_MINUTE      1
+#define RULE_IN_WEEKDAY     2       // 0 = Sunday
+#define RULE_IN_TOD         3       // Minutes since local midnight
+#define RULE_IN_IRRIGATING  4       // Any channel running
+#define RULE_IN_ENABLED     5       // System enabled
+#define RULE_IN_PRESSURE    6       // kPa (NaN without a sensor)
+#define RULE_IN_PRESSURE_ALARM 7    // PRESSURE_EVENT_* latched
+#define RULE_IN_WIFI        8
+#define RULE_IN_MQTT        9
+#define RULE_IN_RUNNING     10      // running(ch)
+#define RULE_IN_REMAINING   11      // remaining(ch), minutes
+#define RULE_IN_MOISTURE    12      // moisture(ch), % from the channel's loop sensor
+#define RULE_IN_COUNT       13
+
+// Actions
+#define RULE_ACT_START      1       // start <ch> <minutes>
+#define RULE_ACT_STOP       2       // stop [ch]   (no channel = all)
+#define RULE_ACT_SKIP       3       // skip <schedule>
+#define RULE_ACT_ENABLE     4       // enable
+#define RULE_ACT_DISABLE    5       // disable
+
+struct RuleAction {
+    uint8_t op;                // RULE_ACT_*
+    uint8_t target;            // Channel or schedule index (0 = all for stop)
+    uint16_t minutes;          // start only
+};
+
+struct Rule {
+    char name[RULE_NAME_LEN];
+    char when[RULE_WHEN_LEN];
+    char then[RULE_THEN_LEN];
+    bool enabled;
+
+    // Compiled form
+    uint8_t code[RULE_MAX_CODE];
+    uint8_t codeLen;
+    float consts[RULE_MAX_CONSTS];
+    RuleAction action;
+
+    // Runtime
+    bool active;               // Condition held at the last evaluation
+    uint8_t lastSteps;         // Instructions executed by the last evaluation
+    uint32_t evaluations;
+    uint32_t fired;
+};
+
+// Reads one input (argument ignored for variables); NaN = unknown
+typedef float (*RuleInputCallback)(void* ctx, uint8_t input, float arg);
+// Runs a rule's action
+typedef void (*RuleActionCallback)(void* ctx, const Rule& rule);
+
+// Local automation rules.
+//
+// A rule is a condition over controller, sensor and time inputs plus one
+// action, e.g.
+//     when: "moisture(2) > 60 && running(2)"    then: "stop 2"
+//     when: "pressure_alarm > 0 || !enabled"      then: "stop"
+//     when: "!mqtt && tod == 1080 && weekday != 0" then: "start 1 15"
+// The condition is compiled once into stack bytecode with its literals in
+// a per-rule constant table, so evaluation never touches the source text.
+// Jumps only go forward (&& and || short-circuit), which bounds a rule's
+// cost by its code length.
+//
+// The owner marks the engine dirty when an input changes and calls run()
+// every loop with an instruction budget. A pass evaluates rules in order
+// and stops before the rule that could overrun the budget, resuming there
+// on the next call. An action fires when its condition becomes true.
+// Comparisons with an unknown (NaN) input are false.
+class RuleEngine {
+public:
+    RuleEngine();
+
+    void setCallbacks(RuleInputCallback input, RuleActionCallback action, void* ctx);
+
+    // Rule table. add/replace compile first and leave the table unchanged
+    // on error (message in 'error', RULE_ERROR_LEN bytes).
+    int8_t addRule(const char* name, const char* when, const char* then, bool enabled, char* error);
+    bool replaceRule(uint8_t index, const char* name, const char* when, const char* then,
+                     bool enabled, char* error);
+    bool removeRule(uint8_t index);
+    void clear();
+    uint8_t getRuleCount() const { return _count; }
+    const Rule* getRule(uint8_t index) const { return index < _count ? &_rules[index] : nullptr; }
+
+    // Evaluation
+    void markDirty();
+    bool isPending() const { return _pending; }
+    uint16_t run(uint16_t budget);                          // Returns instructions executed
+    bool evaluate(uint8_t index, float& result);            // One rule, no action
+
+    // Statistics
+    uint32_t getPasses() const { return _passes; }
+    uint32_t getDeferrals() const { return _deferrals; }    // Passes split across calls
+
+    // Compile without touching the table (for validation)
+    static bool compile(const char* when, const char* then, Rule& out, char* error);
+
+private:
+    static bool parseAction(const char* then, RuleAction& action, char* error);
+    bool store(uint8_t index, const char* name, const char* when, const char* then,
+               bool enabled, char* error);
+    float execute(Rule& rule);
+
+    Rule _rules[RULE_MAX_RULES];
+    uint8_t _count;
+    uint8_t _cursor;           // Next rule of the current pass
+    bool _pending;             // A pass is in progress
+    bool _again;               // Inputs changed mid-pass: run another
+    uint32_t _passes;
+    uint32_t _deferrals;
+
+    RuleInputCallback _input;
+    RuleActionCallback _action;
+    void* _ctx;
+};
+
+#endif // RULE_ENGINE_H
@@ -0,0 +1,69 @@
+#ifndef RUN_JOURNAL_H
+#define RUN_JOURNAL_H
+
+#include <stdint.h>
+#include "NodeProtocol.h"
+
+#define RUN_JOURNAL_SIZE   32      // Slave: completed runs awaiting the master's ACK
+#define RUN_HISTORY_SIZE   96      // Master: fleet-wide run history
+
+// Outgoing run journal (slave side).
+//
+// Completed runs are appended with consecutive sequence numbers and stay
+// until the master acknowledges them, so runs made while the master or the
+// network is down are shipped once it is back. When the journal is full
+// the oldest unacknowledged run is overwritten; the gap in sequence numbers
+// tells the master how many were lost.
+class RunJournal {
+public:
+    RunJournal();
+
+    void clear();
+
+    // Assigns the next sequence number; returns it
+    uint16_t append(RunRecord record);
+
+    // Restore from storage (records in journal order, seq already set)
+    void restore(const RunRecord* records, uint8_t count, uint16_t nextSeq);
+
+    // Drop everything up to and including seq (cumulative ACK)
+    uint8_t acknowledge(uint16_t seq);
+
+    uint8_t getCount() const { return _count; }
+    const RunRecord& at(uint8_t i) const;       // 0 = oldest
+    uint16_t getNextSeq() const { return _nextSeq; }
+    uint32_t getOverwritten() const { return _overwritten; }
+
+private:
+    RunRecord _records[RUN_JOURNAL_SIZE];
+    uint8_t _head;              // Oldest record
+    uint8_t _count;
+    uint16_t _nextSeq;
+    uint32_t _overwritten;
+};
+
+// Fleet-wide run history (master side).
+//
+// Batches from different nodes arrive late and out of order, so records are
+// kept sorted by start time on insert; batches are mostly newer than what is
+// held, so the insertion point is searched from the newest end. When full
+// the oldest run is evicted, and a run older than everything held is
+// dropped.
+class RunHistory {
+public:
+    RunHistory();
+
+    void clear();
+    bool insert(const RunRecord& record);       // false if older than everything held when full
+
+    uint8_t getCount() const { return _count; }
+    const RunRecord& at(uint8_t i) const { return _records[i]; }   // 0 = oldest
+    uint32_t getGeneration() const { return _generation; }         // Bumped on every change
+
+private:
+    RunRecord _records[RUN_HISTORY_SIZE];
+    uint8_t _count;
+    uint32_t _generation;
+};
+
+#endif // RUN_JOURNAL_H
@@ -0,0 +1,71 @@
+#ifndef SCHEDULE_OPTIMIZER_H
+#define SCHEDULE_OPTIMIZER_H
+
+#include <stdint.h>
+
+#define SCHEDULE_OPT_MAX_ZONES    64   // Enough for a fully paired master with room to spare
+#define SCHEDULE_OPT_MAX_SUPPLIES 4    // Independent supply lines (mains, tank pump, ...)
+#define SCHEDULE_OPT_MINUTES_DAY  1440
+
+// One zone to be placed. Times are minutes since local midnight.
+struct OptZone {
+    uint8_t  channel;          // 1-based channel (passed through to the result)
+    uint8_t  supply;           // Supply line index (0..SCHEDULE_OPT_MAX_SUPPLIES-1)
+    uint8_t  weekdays;         // Bitmask: bit 0=Sunday ... bit 6=Saturday
+    uint16_t durationMinutes;  // Required run time
+    uint16_t windowStart;      // Earliest allowed start
+    uint16_t windowEnd;        // Run must finish by this time (exclusive, <= 1440)
+    uint16_t flow;             // Expected flow in 0.1 L/min (same x10 scale as MSG_STATUS)
+};
+
+// Packs zone runs into the shortest combined watering window.
+//
+// Zones are placed greedily, longest first (LPT list scheduling). Each zone
+// goes to the candidate start that keeps the overall window shortest; ties
+// are broken by the lowest resulting peak flow, then the earliest start.
+// Concurrency is enforced per supply and per weekday, so zones that never
+// share a day never compete for the same supply slot.
+//
+// Everything lives in fixed arrays; nothing is allocated.
+class ScheduleOptimizer {
+public:
+    ScheduleOptimizer();
+
+    void reset();
+
+    // Concurrency limit for a supply line (default 1 for every supply)
+    bool setSupplyLimit(uint8_t supply, uint8_t maxConcurrent);
+
+    // Returns the zone index or -1 if the zone is invalid or the table is full
+    int8_t addZone(const OptZone& zone);
+
+    // Places all zones. Returns true if every zone fitted inside its window.
+    bool solve();
+
+    // Results (valid after solve())
+    uint8_t getZoneCount() const { return _zoneCount; }
+    const OptZone& getZone(uint8_t index) const { return _zones[index]; }
+    bool isPlaced(uint8_t index) const;
+    uint16_t getStart(uint8_t index) const;
+    uint16_t getWindowStart() const { return _spanStart; }
+    uint16_t getWindowEnd() const { return _spanEnd; }
+    uint32_t getPeakFlow() const { return _peakFlow; }  // 0.1 L/min
+    uint8_t getPlacedCount() const { return _placedCount; }
+
+private:
+    bool evaluate(uint8_t zoneIdx, uint16_t start, uint32_t& peakFlow) const;
+    void sortByDuration();
+
+    OptZone  _zones[SCHEDULE_OPT_MAX_ZONES];
+    uint16_t _start[SCHEDULE_OPT_MAX_ZONES];
+    bool     _placed[SCHEDULE_OPT_MAX_ZONES];
+    uint8_t  _order[SCHEDULE_OPT_MAX_ZONES];
+    uint8_t  _supplyLimit[SCHEDULE_OPT_MAX_SUPPLIES];
+    uint8_t  _zoneCount;
+    uint8_t  _placedCount;
+    uint16_t _spanStart;
+    uint16_t _spanEnd;
+    uint32_t _peakFlow;
+};
+
+#endif // SCHEDULE_OPTIMIZER_H
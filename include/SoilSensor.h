@@ -0,0 +1,72 @@
+#ifndef SOIL_SENSOR_H
+#define SOIL_SENSOR_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include "JsonArena.h"
+#include "Config.h"
+
+// Per-probe state (probes are 1-based, like channels)
+struct SoilProbe {
+    uint16_t dryMv;            // Calibration: reading in air
+    uint16_t wetMv;            // Calibration: reading in water
+    uint16_t rawMv;            // Last oversampled reading (uncompensated)
+    float moisture;            // %, temperature compensated
+    float reportedMoisture;    // Value last sent to the master
+    unsigned long lastReport;  // millis() of last report
+    bool reported;             // At least one report sent
+    bool valid;                // At least one sample taken
+};
+
+// Capacitive soil-moisture probes on a sensor node.
+//
+// Every SOIL_SAMPLE_INTERVAL each probe is read SOIL_OVERSAMPLE times and
+// the middle half is averaged, which rejects the spikes WiFi bursts put on
+// the ADC. The probe voltage is corrected for temperature drift (optional
+// NTC on SOIL_NTC_PIN) and mapped to 0-100 % between the dry and wet
+// calibration points.
+//
+// A probe only asks to be reported when it leaves the deadband around the
+// last reported value or the keepalive expires.
+class SoilSensor {
+public:
+    SoilSensor();
+
+    // Component lifecycle
+    bool begin();
+    void update();
+
+    // Readings
+    uint8_t getProbeCount() const { return _probeCount; }
+    bool isValid(uint8_t probe) const;
+    float getMoisture(uint8_t probe) const;
+    uint16_t getRawMilliVolts(uint8_t probe) const;
+    bool hasTemperature() const { return _tempValid; }
+    float getTemperature() const { return _temperature; }
+
+    // Reporting (deadband + keepalive)
+    bool needsReport(uint8_t probe) const;
+    bool isKeepaliveDue(uint8_t probe) const;
+    void markReported(uint8_t probe);
+
+    // Calibration
+    bool setCalibration(uint8_t probe, uint16_t dryMv, uint16_t wetMv);
+    uint16_t getDryMilliVolts(uint8_t probe) const;
+    uint16_t getWetMilliVolts(uint8_t probe) const;
+    bool saveCalibration();
+    bool loadCalibration();
+
+private:
+    uint16_t sampleMilliVolts(uint8_t pin) const;
+    bool readTemperature(float& celsius) const;
+    float toMoisture(const SoilProbe& probe, float milliVolts) const;
+
+    SoilProbe _probes[SENSOR_MAX_PROBES];
+    uint8_t _probeCount;
+    float _temperature;
+    bool _tempValid;
+    unsigned long _lastSample;
+};
+
+#endif // SOIL_SENSOR_H
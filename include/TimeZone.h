@@ -0,0 +1,87 @@
+#ifndef TIME_ZONE_H
+#define TIME_ZONE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#define TZ_SPEC_LEN 48
+
+// Wall-clock fields of one instant
+struct LocalTime {
+    int16_t year;              // e.g. 2026
+    uint8_t month;             // 1-12
+    uint8_t day;               // 1-31
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint8_t weekday;           // 0 = Sunday
+    bool dst;
+};
+
+// POSIX TZ time zone ("SAST-2", "CET-1CEST,M3.5.0,M10.5.0/3",
+// "AEST-10AEDT,M10.1.0,M4.1.0/3", "<+0530>-5:30", Jn and n rules).
+//
+// The offset in force is cached together with the UTC interval it is valid
+// for, bounded by the neighbouring DST transitions. Conversions inside the
+// interval are two comparisons and integer date arithmetic; the transitions
+// are only recomputed when an instant falls outside it. Nothing here
+// touches the libc TZ state.
+//
+// Local -> UTC is deterministic across transitions:
+// - a wall time skipped by a spring-forward gap maps to the instant it
+//   would have been under the old offset, i.e. one gap later (02:30 -> 03:30)
+// - a wall time repeated by a fall-back fold maps to its first occurrence
+class TimeZone {
+public:
+    TimeZone();
+
+    bool set(const char* spec);            // false (zone unchanged) if it does not parse
+    const char* get() const { return _spec; }
+
+    int32_t offsetAt(time_t utc) const;    // Seconds east of UTC
+    void toLocal(time_t utc, LocalTime& out) const;
+    time_t toUtc(int16_t year, uint8_t month, uint8_t day,
+                 uint8_t hour, uint8_t minute, uint8_t second = 0) const;
+
+    // First instant strictly after 'after' whose local time is hour:minute
+    // on a weekday in the mask (bit 0 = Sunday); 0 if the mask is empty
+    time_t nextLocal(time_t after, uint8_t hour, uint8_t minute, uint8_t weekdays) const;
+
+    // Proleptic Gregorian calendar helpers (days since 1970-01-01)
+    static int32_t daysFromCivil(int16_t year, uint8_t month, uint8_t day);
+    static void civilFromDays(int32_t days, int16_t& year, uint8_t& month, uint8_t& day);
+    static uint8_t weekdayFromDays(int32_t days);
+
+private:
+    // Transition rule: Mm.w.d, Jn (1-365, no Feb 29) or n (0-365)
+    struct Rule {
+        char kind;             // 'M', 'J' or 'N'
+        uint8_t month;
+        uint8_t week;
+        uint8_t weekday;
+        uint16_t day;
+        int32_t time;          // Seconds after local midnight (may be negative or > 24 h)
+    };
+
+    bool parse(const char* spec);
+    time_t transition(const Rule& rule, int16_t year, int32_t offsetBefore) const;
+    void refresh(time_t utc) const;
+
+    char _spec[TZ_SPEC_LEN];
+    int32_t _stdOffset;        // Seconds east of UTC
+    int32_t _dstOffset;
+    bool _hasDst;
+    Rule _start;               // Into DST
+    Rule _end;                 // Back to standard time
+
+    // Offset cache: _offset holds for utc in [_validFrom, _validTo)
+    mutable time_t _validFrom;
+    mutable time_t _validTo;
+    mutable int32_t _offset;
+    mutable bool _dst;
+};
+
+// Zone used for schedules and displayed times (defined in main.cpp)
+extern TimeZone timeZone;
+
+#endif // TIME_ZONE_H
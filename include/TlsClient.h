@@ -0,0 +1,79 @@
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+
+// TLS client over a WiFiClient, driving mbedTLS directly.
+//
+// WiFiClientSecure sets up and handshakes in one call and forgets the
+// session on stop(). This client keeps the last session (ID or ticket,
+// whichever the broker issued) and offers it on the next connect() to the
+// same host and port, so a reconnect costs one round trip and no
+// certificate or key exchange work. A broker that declines the session
+// gets a full handshake as usual.
+class TlsClient : public Client {
+public:
+    TlsClient();
+    ~TlsClient();
+
+    void setCACert(const char* pem) { _caCert = pem; }     // Not copied; nullptr = no verification
+    void setHandshakeTimeout(unsigned long seconds) { _timeout = seconds * 1000; }
+    bool verify(const char* fingerprint);   // SHA-256 of the peer certificate, 64 hex digits
+    bool resumed() const { return _resumed; }
+    void forgetSession();
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    using Print::write;
+
+    // Dedicated memory for mbedTLS, reserved once while the heap is still
+    // whole. Every mbedTLS allocation is served from it first, so a
+    // handshake no longer needs a large free block at the time it runs;
+    // requests it cannot hold fall back to the heap.
+    static bool reservePool(size_t bytes);
+    static bool poolReserved();
+    static size_t poolUsed();
+    static size_t poolPeak();
+
+private:
+    static int sendCallback(void* ctx, const unsigned char* buf, size_t len);
+    static int recvCallback(void* ctx, unsigned char* buf, size_t len);
+    bool handshake();
+    void release();
+
+    WiFiClient _tcp;
+    mbedtls_ssl_context _ssl;
+    mbedtls_ssl_config _conf;
+    mbedtls_x509_crt _ca;
+    mbedtls_entropy_context _entropy;
+    mbedtls_ctr_drbg_context _drbg;
+    mbedtls_ssl_session _session;       // Last session, offered on reconnect
+    bool _hasSession;
+    String _sessionHost;
+    uint16_t _sessionPort;
+
+    const char* _caCert;
+    unsigned long _timeout;             // Handshake and stalled writes, ms
+    bool _active;                       // Contexts set up, freed by release()
+    bool _connected;
+    bool _resumed;
+    int _peeked;                        // -1 if none
+};
+
+#endif // TLS_CLIENT_H
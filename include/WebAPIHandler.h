@@ -4,14 +4,23 @@
 #include <Arduino.h>
 #include <WebServer.h>
 #include <ArduinoJson.h>
+#include "JsonArena.h"
 #include <LittleFS.h>
 #include "Config.h"
+#include "LatencyStats.h"
+#include "BodySchema.h"
+#include "GzipStream.h"
+
+#define GZIP_MIN_BYTES  1024    // Smaller responses are not worth compressing
 
 // Forward declarations
 class IrrigationController;
 class HomeAssistantIntegration;
 class NodeManager;
 class WiFiManager;
+class SoilSensor;
+class PressureMonitor;
+class AutomationManager;
 
 class WebAPIHandler {
 public:
@@ -23,6 +32,9 @@ public:
 
     void begin();  // Registers all /api/* routes on the server
     void setNodeManager(NodeManager* nm) { _nm = nm; }
+    void setSoilSensor(SoilSensor* sensor) { _soil = sensor; }
+    void setPressureMonitor(PressureMonitor* pm) { _pressure = pm; }
+    void setAutomation(AutomationManager* am) { _automation = am; }
 
 private:
     WebServer* _server;
@@ -30,11 +42,61 @@ private:
     HomeAssistantIntegration* _ha;
     NodeManager* _nm;
     WiFiManager* _wm;
+    SoilSensor* _soil;
+    PressureMonitor* _pressure;
+    AutomationManager* _automation;
+    uint32_t _bootId;  // ETag prefix so counters restarting after a reboot never match
+    LatencyStats _requestLatency;  // Handler time of every /api/* request
+    uint32_t _msgpackResponses;
+    uint32_t _msgpackBytes;        // Sent as MessagePack
+    uint32_t _msgpackJsonBytes;    // What the same responses would have been as JSON
+
+    // Chunked response in progress; one at a time, so one encoder serves all
+    GzipStream _gzip;
+    const char* _chunkType;
+    int _chunkCode;
+    bool _chunkStarted;            // Headers sent
+    bool _chunkGzip;
+    uint32_t _gzipResponses;
+    uint32_t _gzipInBytes;
+    uint32_t _gzipOutBytes;
+    uint32_t _gzipMicros;          // Encoder CPU time
+    uint32_t _gzipSendMicros;      // Socket time inside the current encoder call
+
+    // Registers a route whose handler time goes into _requestLatency
+    void route(const char* uri, HTTPMethod method, void (WebAPIHandler::*handler)());
+
+    // Conditional GET: sends the ETag and, on an If-None-Match hit, a 304
+    bool notModified(const char* kind, uint32_t genA, uint32_t genB);
+
+    // Sends doc as JSON, or as MessagePack when the client's Accept asks for it
+    bool wantsMsgPack();
+    void sendDocument(const JsonDocument& doc, int code = 200);
+
+    // Chunked writer, gzip-encoded when the body spans chunks and the
+    // client sends Accept-Encoding: gzip
+    bool acceptsGzip();
+    void beginChunked(const char* type, int code = 200);
+    void sendChunk(const char* data, size_t length, bool last = false);
+    void sendChunk(const String& chunk) { sendChunk(chunk.c_str(), chunk.length()); }
+    void endChunked(const String& tail = String());
+    static void gzipSink(void* context, const uint8_t* data, size_t length);
+
+    // Parses the POST body into out, which holds the defaults. On a missing
+    // or invalid body the 400 is sent and false returned.
+    bool parseBody(const BodyField* fields, uint8_t count, void* out, uint32_t* present = nullptr);
+    template <size_t N>
+    bool parseBody(const BodyField (&fields)[N], void* out, uint32_t* present = nullptr) {
+        static_assert(N <= BODY_MAX_FIELDS, "too many fields in a body schema");
+        return parseBody(fields, (uint8_t)N, out, present);
+    }
 
     // Route handlers
     void handleGetSchedules();
+    void handleGetScheduleForecast();
     void handlePostSchedule();
     void handleDeleteSchedule();
+    void handlePostScheduleOptimize();
     void handleGetChannelStatus();
     void handlePostChannelInvert();
     void handlePostChannelEnable();
@@ -43,7 +105,27 @@ private:
     void handlePostScheduleUnskip();
     void handlePostChannelStart();
     void handlePostChannelStop();
+    void handleGetGroups();
+    void handlePostGroup();
+    void handleDeleteGroup();
+    void handlePostGroupStart();
+    void handlePostGroupStop();
+    void handleGetSensors();
+    void handlePostSensorCalibrate();
+    void handleGetChannelMoisture();
+    void handlePostChannelMoisture();
+    void handleGetPressure();
+    void handlePostPressureClear();
+    void handleGetRules();
+    void handlePostRule();
+    void handleDeleteRule();
+    void handleGetMetrics();
+    void handleGetCrash();
+    void handleGetCrashCoreDump();
+    void handleDeleteCrash();
     void handleGetNodesPending();
+    void handleGetRuns();
+    void handleGetNodesHealth();
     void handlePostNodesAccept();
     void handlePostNodesReject();
     void handlePostNodesRename();
@@ -55,6 +137,11 @@ private:
     void handleGetConfig();
     void handlePostConfig();
     void handlePostSystemRestart();
+    void handleGetOta();
+    void handlePostOta();
+    void handleGetRollout();
+    void handlePostRollout();
+    void handlePostRolloutAbort();
 };
 
 #endif // WEB_API_HANDLER_H
@@ -13,7 +13,9 @@
 #include <DNSServer.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include "JsonArena.h"
 #include "Config.h"
+#include "FirmwareUpdater.h"
 
 class WiFiManager {
 public:
@@ -48,9 +50,14 @@ public:
     time_t getCurrentTime();
     bool isTimeSynced() const { return _timeSynced; }
 
-    // OTA Updates
+    // OTA Updates (run in the background; see FirmwareUpdater)
     void checkForUpdates();
-    void performOTA();
+    FirmwareUpdater& getUpdater() { return _updater; }
+
+    // Off on multi-node valve nodes: their checks only look, and the
+    // master's rollout decides when each node installs
+    void setAutoInstall(bool enabled) { _autoInstall = enabled; }
+    bool getAutoInstall() const { return _autoInstall; }
 
     // Callbacks
     typedef void (*TimeUpdateCallback)(time_t);
@@ -63,8 +70,6 @@ private:
     void connectWiFi();
     void setupOTA();
     void syncTime();
-    bool checkGitHubVersion(String& latestVersion);
-    bool downloadFirmware(const String& url);
     void handleOTAProgress(unsigned int progress, unsigned int total);
     void handleOTAError(ota_error_t error);
 
@@ -90,6 +95,8 @@ private:
     unsigned long _lastReconnectAttempt;
     unsigned long _lastTimeSync;
     unsigned long _lastUpdateCheck;
+    FirmwareUpdater _updater;
+    bool _autoInstall;
     int _reconnectRetries;
 
     WiFiUDP* _ntpUDP;
@@ -0,0 +1,290 @@
+#include "Arduino.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// ============================================================================
+// Timing
+// ============================================================================
+
+// Function statics: other globals' constructors may call these before this
+// file's globals are initialized
+static std::chrono::steady_clock::time_point startTime() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return start;
+}
+
+unsigned long millis() {
+    return (unsigned long)(uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime()).count();
+}
+
+unsigned long micros() {
+    return (unsigned long)(uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime()).count();
+}
+
+void delay(unsigned long ms) {
+    ESP.sampleHeap();
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+    ESP.sampleHeap();
+    std::this_thread::yield();
+}
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+static uint8_t pinLevel[256];
+static bool pinPulled[256];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    pinPulled[pin] = (mode == INPUT_PULLUP);
+    if (mode != OUTPUT) pinLevel[pin] = pinPulled[pin] ? HIGH : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    pinLevel[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) {
+    return pinLevel[pin];
+}
+
+uint16_t analogRead(uint8_t pin) {
+    (void)pin;
+    return 0;
+}
+
+uint32_t analogReadMilliVolts(uint8_t pin) {
+    (void)pin;
+    return 0;
+}
+
+void analogReadResolution(uint8_t bits) {
+    (void)bits;
+}
+
+// ============================================================================
+// Random
+// ============================================================================
+
+static std::mt19937& rng() {
+    static std::mt19937 engine(std::random_device{}());
+    return engine;
+}
+
+long random(long howBig) {
+    if (howBig <= 0) return 0;
+    return std::uniform_int_distribution<long>(0, howBig - 1)(rng());
+}
+
+long random(long howSmall, long howBig) {
+    if (howSmall >= howBig) return howSmall;
+    return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed) rng().seed(seed);
+}
+
+uint32_t esp_random() {
+    return (uint32_t)rng()();
+}
+
+// ============================================================================
+// Serial
+// ============================================================================
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+// ============================================================================
+// ESP
+// ============================================================================
+
+static size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// Allocations made before main() (the C++ runtime, static objects) don't count
+static size_t heapBaseline() {
+    static const size_t baseline = heapInUse();
+    return baseline;
+}
+
+static const size_t heapAtStart = heapBaseline();
+
+static uint32_t heapLowWater = SHIM_HEAP_SIZE;
+
+uint32_t EspClass::getFreeHeap() {
+    size_t used = heapInUse();
+    used = used > heapBaseline() ? used - heapBaseline() : 0;
+    uint32_t free = used < SHIM_HEAP_SIZE ? SHIM_HEAP_SIZE - used : 0;
+    if (free < heapLowWater) heapLowWater = free;
+    return free;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+    getFreeHeap();
+    return heapLowWater;
+}
+
+void EspClass::sampleHeap() {
+    getFreeHeap();
+}
+
+uint64_t EspClass::getEfuseMac() {
+    return 0x563412EFCDABULL;   // AB:CD:EF:12:34:56, byte 0 lowest like the eFuse
+}
+
+void EspClass::restart() {
+    fprintf(stdout, "ESP.restart(): exiting the host build\n");
+    fflush(stdout);
+    exit(0);
+}
+
+// ============================================================================
+// FreeRTOS
+// ============================================================================
+
+struct TaskStart {
+    void (*task)(void*);
+    void* arg;
+};
+
+static void* runTask(void* p) {
+    TaskStart start = *static_cast<TaskStart*>(p);
+    delete static_cast<TaskStart*>(p);
+    start.task(start.arg);
+    return nullptr;
+}
+
+BaseType_t xTaskCreate(void (*task)(void*), const char* name, uint32_t stackDepth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle) {
+    (void)name;
+    (void)stackDepth;
+    (void)priority;
+    pthread_t thread;
+    TaskStart* start = new TaskStart{task, arg};
+    if (pthread_create(&thread, nullptr, runTask, start) != 0) {
+        delete start;
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    if (handle) *handle = (TaskHandle_t)(uintptr_t)thread;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t handle) {
+    if (handle) {
+        fprintf(stderr, "vTaskDelete: deleting another task is not supported on the host\n");
+        return;
+    }
+    pthread_exit(nullptr);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment) {
+    *previousWake += increment;
+    int32_t wait = (int32_t)(*previousWake - xTaskGetTickCount());
+    if (wait > 0) vTaskDelay(wait);
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)millis();
+}
+
+struct ShimQueue {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+static std::chrono::steady_clock::time_point waitDeadline(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) return std::chrono::steady_clock::time_point::max();
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    ShimQueue* queue = new ShimQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void* item, TickType_t ticksToWait) {
+    ShimQueue* queue = static_cast<ShimQueue*>(handle);
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (!queue->changed.wait_until(guard, waitDeadline(ticksToWait),
+                                   [queue] { return queue->items.size() < queue->length; })) {
+        return pdFALSE;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t ticksToWait) {
+    ShimQueue* queue = static_cast<ShimQueue*>(handle);
+    std::unique_lock<std::mutex> guard(queue->lock);
+    if (!queue->changed.wait_until(guard, waitDeadline(ticksToWait),
+                                   [queue] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+// Statically initialized: CrashLog can print from other globals' constructors
+static pthread_mutex_t criticalLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void shimEnterCritical(portMUX_TYPE* mux) {
+    (void)mux;
+    pthread_mutex_lock(&criticalLock);
+}
+
+void shimExitCritical(portMUX_TYPE* mux) {
+    (void)mux;
+    pthread_mutex_unlock(&criticalLock);
+}
@@ -0,0 +1,156 @@
+#ifndef SHIM_ARDUINO_H
+#define SHIM_ARDUINO_H
+
+// Host stand-in for the Arduino-ESP32 core, used by the native_web env only.
+//
+// It provides what the firmware calls, backed by the build machine:
+// timing by the monotonic clock, Serial by stdout, WebServer and WiFiClient
+// by TCP sockets, LittleFS by a directory, FreeRTOS tasks and queues by
+// threads. GPIOs are a latch table (inputs read back HIGH, as with the
+// pull-ups), and radios without a host equivalent (mDNS, UDP peers, OTA,
+// the LCD) are no-ops. ESP heap figures come from malloc accounting, so the
+// load test can watch the same metrics it reads on a board.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <functional>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+using std::min;
+using std::max;
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define PROGMEM
+#define IRAM_ATTR
+#define F(x) (x)
+#define PSTR(x) (x)
+
+#define ESP_ARDUINO_VERSION_MAJOR 2
+
+// Timing: milliseconds since the process started
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// GPIO latches; analog inputs read 0
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+uint32_t analogReadMilliVolts(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+uint32_t esp_random();
+
+template <typename T>
+T constrain(T x, T low, T high) { return x < low ? low : (x > high ? high : x); }
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override;
+    operator bool() const { return true; }
+
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+// Heap figures against an ESP32-sized heap: free = SHIM_HEAP_SIZE minus what
+// the process allocated since start-up. The low-water mark is sampled (every
+// query, delay() and response sent), not tracked per allocation.
+#ifndef SHIM_HEAP_SIZE
+#define SHIM_HEAP_SIZE 327680
+#endif
+
+class EspClass {
+public:
+    uint32_t getHeapSize() { return SHIM_HEAP_SIZE; }
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap() { return getFreeHeap(); }   // No fragmentation model
+    uint64_t getEfuseMac();
+    const char* getSdkVersion() { return "host"; }
+    uint32_t getCycleCount() { return (uint32_t)micros(); }
+    void restart();
+
+    void sampleHeap();   // Host only: updates the low-water mark
+};
+
+extern EspClass ESP;
+
+// ============================================================================
+// FreeRTOS: tasks are detached threads, 1 tick = 1 ms
+// ============================================================================
+
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portMAX_DELAY 0xFFFFFFFF
+
+BaseType_t xTaskCreate(void (*task)(void*), const char* name, uint32_t stackDepth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle);
+void vTaskDelete(TaskHandle_t handle);   // nullptr (the calling task) only
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t increment);
+TickType_t xTaskGetTickCount();
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticksToWait);
+
+// Critical sections all share one recursive lock, like masking interrupts
+struct portMUX_TYPE {
+    uint32_t owner;
+};
+#define portMUX_INITIALIZER_UNLOCKED {0}
+void shimEnterCritical(portMUX_TYPE* mux);
+void shimExitCritical(portMUX_TYPE* mux);
+#define portENTER_CRITICAL(mux) shimEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) shimExitCritical(mux)
+
+#endif // SHIM_ARDUINO_H
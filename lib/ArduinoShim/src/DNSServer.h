@@ -0,0 +1,16 @@
+#ifndef SHIM_DNSSERVER_H
+#define SHIM_DNSSERVER_H
+
+#include "WiFi.h"
+
+class DNSServer {
+public:
+    bool start(uint16_t port, const String& domainName, IPAddress resolvedIP) {
+        (void)port; (void)domainName; (void)resolvedIP;
+        return true;
+    }
+    void processNextRequest() {}
+    void stop() {}
+};
+
+#endif // SHIM_DNSSERVER_H
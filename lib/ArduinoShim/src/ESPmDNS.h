@@ -0,0 +1,31 @@
+#ifndef SHIM_ESPMDNS_H
+#define SHIM_ESPMDNS_H
+
+#include "WiFi.h"
+
+// Advertises nothing and finds nothing
+class MDNSResponder {
+public:
+    bool begin(const char* hostname) { (void)hostname; return true; }
+    void end() {}
+    void addService(const char* service, const char* proto, uint16_t port) {
+        (void)service; (void)proto; (void)port;
+    }
+    void addServiceTxt(const char* service, const char* proto, const char* key, const char* value) {
+        (void)service; (void)proto; (void)key; (void)value;
+    }
+    void addServiceTxt(const char* service, const char* proto, const char* key, const String& value) {
+        addServiceTxt(service, proto, key, value.c_str());
+    }
+    int queryService(const char* service, const char* proto) { (void)service; (void)proto; return 0; }
+    IPAddress IP(int index) { (void)index; return IPAddress(); }
+    IPAddress address(int index) { return IP(index); }
+    uint16_t port(int index) { (void)index; return 0; }
+    int numTxt(int index) { (void)index; return 0; }
+    String txtKey(int index, int txtIndex) { (void)index; (void)txtIndex; return String(); }
+    String txt(int index, int txtIndex) { (void)index; (void)txtIndex; return String(); }
+};
+
+extern MDNSResponder MDNS;
+
+#endif // SHIM_ESPMDNS_H
@@ -0,0 +1,135 @@
+#include "FS.h"
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+namespace fs {
+
+struct File::Handle {
+    Handle(FILE* f, const char* n) : file(f), name(n) {}
+    ~Handle() { fclose(file); }
+    FILE* file;
+    std::string name;
+};
+
+File::File(FILE* handle, const char* name) : _handle(std::make_shared<Handle>(handle, name)) {}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    return _handle ? fwrite(buffer, 1, size, _handle->file) : 0;
+}
+
+int File::available() {
+    if (!_handle) return 0;
+    size_t total = size();
+    size_t pos = position();
+    return pos < total ? (int)(total - pos) : 0;
+}
+
+int File::read() {
+    if (!_handle) return -1;
+    int c = fgetc(_handle->file);
+    return c == EOF ? -1 : c;
+}
+
+int File::peek() {
+    if (!_handle) return -1;
+    int c = fgetc(_handle->file);
+    if (c == EOF) return -1;
+    ungetc(c, _handle->file);
+    return c;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    return _handle ? fread(buffer, 1, size, _handle->file) : 0;
+}
+
+void File::flush() {
+    if (_handle) fflush(_handle->file);
+}
+
+bool File::seek(uint32_t pos) {
+    return _handle && fseek(_handle->file, pos, SEEK_SET) == 0;
+}
+
+size_t File::position() const {
+    if (!_handle) return 0;
+    long pos = ftell(_handle->file);
+    return pos < 0 ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+    if (!_handle) return 0;
+    fflush(_handle->file);
+    struct stat st;
+    return fstat(fileno(_handle->file), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+const char* File::name() const {
+    return _handle ? _handle->name.c_str() : "";
+}
+
+// ============================================================================
+// FS
+// ============================================================================
+
+bool FS::begin(bool formatOnFail, const char* basePath, uint8_t maxOpenFiles,
+               const char* partitionLabel) {
+    (void)formatOnFail;
+    (void)basePath;
+    (void)maxOpenFiles;
+    (void)partitionLabel;
+    const char* root = getenv("SHIM_LITTLEFS_ROOT");
+    _root = (root && root[0]) ? root : "littlefs";
+    if (mkdir(_root.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    struct stat st;
+    return stat(_root.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+std::string FS::hostPath(const char* path) const {
+    std::string p = _root;
+    if (!path || path[0] != '/') p += '/';
+    if (path) p += path;
+    return p;
+}
+
+File FS::open(const char* path, const char* mode) {
+    if (_root.empty()) return File();
+    std::string host = hostPath(path);
+    // Binary and, for "w"/"a", created like LittleFS does
+    std::string m = mode ? mode : "r";
+    if (m.find('b') == std::string::npos) m += 'b';
+    FILE* f = fopen(host.c_str(), m.c_str());
+    if (!f) return File();
+    const char* slash = strrchr(path, '/');
+    return File(f, slash ? slash + 1 : path);
+}
+
+bool FS::exists(const char* path) {
+    if (_root.empty()) return false;
+    struct stat st;
+    return stat(hostPath(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return !_root.empty() && ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return !_root.empty() && ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+size_t FS::usedBytes() {
+    size_t used = 0;
+    DIR* dir = opendir(_root.c_str());
+    if (!dir) return 0;
+    while (struct dirent* entry = readdir(dir)) {
+        struct stat st;
+        if (stat((_root + "/" + entry->d_name).c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+            used += st.st_size;
+        }
+    }
+    closedir(dir);
+    return used;
+}
+
+} // namespace fs
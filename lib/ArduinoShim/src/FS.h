@@ -0,0 +1,69 @@
+#ifndef SHIM_FS_H
+#define SHIM_FS_H
+
+#include <memory>
+#include "Arduino.h"
+
+namespace fs {
+
+// A file on the host. Copies share the handle, as in the core.
+class File : public Stream {
+public:
+    File() {}
+    File(FILE* handle, const char* name);
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+    size_t readBytes(char* buffer, size_t length) override { return read((uint8_t*)buffer, length); }
+    void flush() override;
+
+    bool seek(uint32_t pos);
+    size_t position() const;
+    size_t size() const;
+    const char* name() const;
+    void close() { _handle.reset(); }
+    operator bool() const { return (bool)_handle; }
+
+    using Print::write;
+    using Stream::readBytes;
+
+private:
+    struct Handle;
+    std::shared_ptr<Handle> _handle;
+};
+
+// A directory standing in for the flash partition
+class FS {
+public:
+    // Root from SHIM_LITTLEFS_ROOT, else ./littlefs; created if missing
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs",
+               uint8_t maxOpenFiles = 10, const char* partitionLabel = nullptr);
+    void end() {}
+
+    File open(const char* path, const char* mode = "r");
+    File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+    bool exists(const char* path);
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path);
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to);
+
+    size_t totalBytes() { return 0x20000; }   // The spiffs partition in partitions.csv
+    size_t usedBytes();
+
+private:
+    std::string hostPath(const char* path) const;
+
+    std::string _root;
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+
+#endif // SHIM_FS_H
@@ -0,0 +1,38 @@
+#ifndef SHIM_HTTPCLIENT_H
+#define SHIM_HTTPCLIENT_H
+
+#include "WiFiClientSecure.h"
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_NOT_MODIFIED 304
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+
+typedef enum {
+    HTTPC_DISABLE_FOLLOW_REDIRECTS,
+    HTTPC_STRICT_FOLLOW_REDIRECTS,
+    HTTPC_FORCE_FOLLOW_REDIRECTS
+} followRedirects_t;
+
+// Offline: every request fails to connect (release checks report the error)
+class HTTPClient {
+public:
+    bool begin(WiFiClient& client, const String& url) { (void)client; (void)url; return true; }
+    void end() {}
+    void setFollowRedirects(followRedirects_t follow) { (void)follow; }
+    void setTimeout(uint16_t timeout) { (void)timeout; }
+    void setConnectTimeout(int32_t timeout) { (void)timeout; }
+    void setReuse(bool reuse) { (void)reuse; }
+    void addHeader(const String& name, const String& value) { (void)name; (void)value; }
+    void collectHeaders(const char* headerKeys[], size_t count) { (void)headerKeys; (void)count; }
+    int GET() { return HTTPC_ERROR_CONNECTION_REFUSED; }
+    int getSize() { return -1; }
+    String getString() { return String(); }
+    WiFiClient* getStreamPtr() { return nullptr; }
+    String header(const char* name) { (void)name; return String(); }
+    bool hasHeader(const char* name) { (void)name; return false; }
+    static String errorToString(int error) {
+        return error == HTTPC_ERROR_CONNECTION_REFUSED ? String("connection refused") : String();
+    }
+};
+
+#endif // SHIM_HTTPCLIENT_H
@@ -0,0 +1,17 @@
+#include "IPAddress.h"
+#include <stdio.h>
+
+bool IPAddress::fromString(const char* address) {
+    unsigned a, b, c, d;
+    char tail;
+    if (!address || sscanf(address, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4) return false;
+    if (a > 255 || b > 255 || c > 255 || d > 255) return false;
+    _bytes[0] = a; _bytes[1] = b; _bytes[2] = c; _bytes[3] = d;
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+    return String(buf);
+}
@@ -0,0 +1,33 @@
+#ifndef SHIM_IPADDRESS_H
+#define SHIM_IPADDRESS_H
+
+#include <stdint.h>
+#include "WString.h"
+
+// IPv4 only, like the firmware
+class IPAddress {
+public:
+    IPAddress() : _addr(0) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        _bytes[0] = a; _bytes[1] = b; _bytes[2] = c; _bytes[3] = d;
+    }
+    IPAddress(uint32_t addr) : _addr(addr) {}   // Network byte order, as in the core
+
+    operator uint32_t() const { return _addr; }
+    bool operator==(const IPAddress& other) const { return _addr == other._addr; }
+    bool operator!=(const IPAddress& other) const { return _addr != other._addr; }
+    uint8_t operator[](int index) const { return _bytes[index]; }
+    uint8_t& operator[](int index) { return _bytes[index]; }
+
+    bool fromString(const char* address);
+    bool fromString(const String& address) { return fromString(address.c_str()); }
+    String toString() const;
+
+private:
+    union {
+        uint8_t _bytes[4];
+        uint32_t _addr;
+    };
+};
+
+#endif // SHIM_IPADDRESS_H
@@ -0,0 +1,26 @@
+#ifndef SHIM_NTPCLIENT_H
+#define SHIM_NTPCLIENT_H
+
+#include "WiFiUdp.h"
+
+// Always in sync with the host clock
+class NTPClient {
+public:
+    NTPClient(WiFiUDP& udp, const char* poolServerName, long timeOffset = 0,
+              unsigned long updateInterval = 60000)
+        : _timeOffset(timeOffset) {
+        (void)udp; (void)poolServerName; (void)updateInterval;
+    }
+    void begin() {}
+    void end() {}
+    bool update() { return true; }
+    bool forceUpdate() { return true; }
+    bool isTimeSet() const { return true; }
+    void setTimeOffset(int timeOffset) { _timeOffset = timeOffset; }
+    unsigned long getEpochTime() const { return (unsigned long)time(nullptr) + _timeOffset; }
+
+private:
+    long _timeOffset;
+};
+
+#endif // SHIM_NTPCLIENT_H
@@ -0,0 +1,9 @@
+#include "ArduinoOTA.h"
+#include "ESPmDNS.h"
+#include "Update.h"
+#include "Wire.h"
+
+ArduinoOTAClass ArduinoOTA;
+MDNSResponder MDNS;
+UpdateClass Update;
+TwoWire Wire;
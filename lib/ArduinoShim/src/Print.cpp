@@ -0,0 +1,42 @@
+#include "Print.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        if (!write(*buffer++)) break;
+        n++;
+    }
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char local[64];
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(local, sizeof(local), format, copy);
+    va_end(copy);
+    if (len < 0) {
+        va_end(args);
+        return 0;
+    }
+
+    char* buf = local;
+    if ((size_t)len >= sizeof(local)) {
+        buf = (char*)malloc(len + 1);
+        if (!buf) {
+            va_end(args);
+            return 0;
+        }
+        vsnprintf(buf, len + 1, format, args);
+    }
+    va_end(args);
+
+    size_t n = write((const uint8_t*)buf, len);
+    if (buf != local) free(buf);
+    return n;
+}
@@ -0,0 +1,21 @@
+#ifndef SHIM_UPDATE_H
+#define SHIM_UPDATE_H
+
+#include "Arduino.h"
+
+// No flash to write on the host: every update is refused at begin()
+class UpdateClass {
+public:
+    bool begin(size_t size) { (void)size; return false; }
+    size_t write(uint8_t* data, size_t len) { (void)data; (void)len; return 0; }
+    bool end(bool evenIfRemaining = false) { (void)evenIfRemaining; return false; }
+    bool isFinished() { return false; }
+    void abort() {}
+    const char* errorString() { return "No flash on the host"; }
+    size_t progress() { return 0; }
+    size_t size() { return 0; }
+};
+
+extern UpdateClass Update;
+
+#endif // SHIM_UPDATE_H
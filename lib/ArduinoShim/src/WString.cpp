@@ -0,0 +1,125 @@
+#include "WString.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static std::string formatUnsigned(unsigned long long value, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char buf[66];
+    char* p = buf + sizeof(buf) - 1;
+    *p = '\0';
+    do {
+        unsigned digit = value % base;
+        *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value);
+    return p;
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+    // Like the core's ltoa: a sign only in base 10
+    if (base == 10 && value < 0) return "-" + formatUnsigned(-(unsigned long long)value, base);
+    return formatUnsigned((unsigned long long)value, base);
+}
+
+static std::string formatFloat(double value, unsigned char decimalPlaces) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+    return buf;
+}
+
+String::String(unsigned char value, unsigned char base) : _buf(formatUnsigned(value, base)) {}
+String::String(int value, unsigned char base)
+    : _buf(base == 10 ? formatSigned(value, base) : formatUnsigned((unsigned int)value, base)) {}
+String::String(unsigned int value, unsigned char base) : _buf(formatUnsigned(value, base)) {}
+String::String(long value, unsigned char base) : _buf(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _buf(formatUnsigned(value, base)) {}
+String::String(long long value, unsigned char base) : _buf(formatSigned(value, base)) {}
+String::String(unsigned long long value, unsigned char base) : _buf(formatUnsigned(value, base)) {}
+String::String(float value, unsigned char decimalPlaces) : _buf(formatFloat(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces) : _buf(formatFloat(value, decimalPlaces)) {}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    if (_buf.size() != s._buf.size()) return false;
+    for (size_t i = 0; i < _buf.size(); i++) {
+        if (tolower((unsigned char)_buf[i]) != tolower((unsigned char)s._buf[i])) return false;
+    }
+    return true;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return _buf.size() >= suffix._buf.size() &&
+           _buf.compare(_buf.size() - suffix._buf.size(), suffix._buf.size(), suffix._buf) == 0;
+}
+
+void String::getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index) const {
+    if (!buf || bufsize == 0) return;
+    if (index >= _buf.size()) {
+        buf[0] = 0;
+        return;
+    }
+    size_t n = _buf.size() - index;
+    if (n > bufsize - 1) n = bufsize - 1;
+    memcpy(buf, _buf.data() + index, n);
+    buf[n] = 0;
+}
+
+// Out-of-order or out-of-range bounds behave as in the core: swapped, clamped
+String String::substring(unsigned int beginIndex) const {
+    return substring(beginIndex, _buf.size());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        unsigned int t = beginIndex;
+        beginIndex = endIndex;
+        endIndex = t;
+    }
+    if (beginIndex >= _buf.size()) return String();
+    if (endIndex > _buf.size()) endIndex = _buf.size();
+    return String(_buf.substr(beginIndex, endIndex - beginIndex));
+}
+
+void String::replace(char find, char replace) {
+    for (char& c : _buf) {
+        if (c == find) c = replace;
+    }
+}
+
+void String::replace(const String& find, const String& replace) {
+    if (find._buf.empty()) return;
+    size_t pos = 0;
+    while ((pos = _buf.find(find._buf, pos)) != std::string::npos) {
+        _buf.replace(pos, find._buf.size(), replace._buf);
+        pos += replace._buf.size();
+    }
+}
+
+void String::toLowerCase() {
+    for (char& c : _buf) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : _buf) c = toupper((unsigned char)c);
+}
+
+void String::trim() {
+    size_t begin = 0;
+    while (begin < _buf.size() && isspace((unsigned char)_buf[begin])) begin++;
+    size_t end = _buf.size();
+    while (end > begin && isspace((unsigned char)_buf[end - 1])) end--;
+    _buf = _buf.substr(begin, end - begin);
+}
+
+long String::toInt() const {
+    return atol(_buf.c_str());
+}
+
+float String::toFloat() const {
+    return (float)atof(_buf.c_str());
+}
+
+double String::toDouble() const {
+    return atof(_buf.c_str());
+}
@@ -0,0 +1,131 @@
+#ifndef SHIM_WSTRING_H
+#define SHIM_WSTRING_H
+
+#include <stddef.h>
+#include <string>
+
+class __FlashStringHelper;
+
+// Arduino String over std::string. Only the members the firmware and its
+// libraries (ArduinoJson, PubSubClient) call are provided.
+class String {
+public:
+    String() {}
+    String(const char* cstr) { if (cstr) _buf = cstr; }
+    String(const char* cstr, unsigned int length) { if (cstr) _buf.assign(cstr, length); }
+    String(const std::string& str) : _buf(str) {}
+    explicit String(char c) : _buf(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimalPlaces = 2);
+    explicit String(double value, unsigned char decimalPlaces = 2);
+
+    const char* c_str() const { return _buf.c_str(); }
+    unsigned int length() const { return _buf.size(); }
+    bool isEmpty() const { return _buf.empty(); }
+    bool reserve(unsigned int size) { _buf.reserve(size); return true; }
+    explicit operator bool() const { return true; }   // Never a failed allocation here
+
+    // Concatenation
+    bool concat(const String& str) { _buf += str._buf; return true; }
+    bool concat(const char* cstr) { if (cstr) _buf += cstr; return cstr != nullptr; }
+    bool concat(const char* cstr, unsigned int length) { if (cstr) _buf.append(cstr, length); return cstr != nullptr; }
+    bool concat(char c) { _buf += c; return true; }
+    bool concat(unsigned char value) { return concat(String(value)); }
+    bool concat(int value) { return concat(String(value)); }
+    bool concat(unsigned int value) { return concat(String(value)); }
+    bool concat(long value) { return concat(String(value)); }
+    bool concat(unsigned long value) { return concat(String(value)); }
+    bool concat(long long value) { return concat(String(value)); }
+    bool concat(unsigned long long value) { return concat(String(value)); }
+    bool concat(float value) { return concat(String(value)); }
+    bool concat(double value) { return concat(String(value)); }
+
+    template <typename T>
+    String& operator+=(const T& value) { concat(value); return *this; }
+
+    // Comparison
+    int compareTo(const String& s) const { return _buf.compare(s._buf); }
+    bool equals(const String& s) const { return _buf == s._buf; }
+    bool equals(const char* cstr) const { return _buf == (cstr ? cstr : ""); }
+    bool equalsIgnoreCase(const String& s) const;
+    bool operator==(const String& s) const { return equals(s); }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& s) const { return !equals(s); }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+    bool operator<(const String& s) const { return compareTo(s) < 0; }
+    bool startsWith(const String& prefix) const { return _buf.compare(0, prefix._buf.size(), prefix._buf) == 0; }
+    bool endsWith(const String& suffix) const;
+
+    // Characters
+    char charAt(unsigned int index) const { return index < _buf.size() ? _buf[index] : 0; }
+    void setCharAt(unsigned int index, char c) { if (index < _buf.size()) _buf[index] = c; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return _buf[index]; }
+    void getBytes(unsigned char* buf, unsigned int bufsize, unsigned int index = 0) const;
+    void toCharArray(char* buf, unsigned int bufsize, unsigned int index = 0) const {
+        getBytes((unsigned char*)buf, bufsize, index);
+    }
+
+    // Search
+    int indexOf(char c, unsigned int fromIndex = 0) const { return found(_buf.find(c, fromIndex)); }
+    int indexOf(const String& s, unsigned int fromIndex = 0) const { return found(_buf.find(s._buf, fromIndex)); }
+    int lastIndexOf(char c) const { return found(_buf.rfind(c)); }
+    int lastIndexOf(const String& s) const { return found(_buf.rfind(s._buf)); }
+    String substring(unsigned int beginIndex) const;
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+    // Modification
+    void replace(char find, char replace);
+    void replace(const String& find, const String& replace);
+    void remove(unsigned int index) { if (index < _buf.size()) _buf.erase(index); }
+    void remove(unsigned int index, unsigned int count) { if (index < _buf.size()) _buf.erase(index, count); }
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    // Conversion
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+private:
+    static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+
+    std::string _buf;
+};
+
+// Result type of String + ..., as in the core (ArduinoJson adapts it too)
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& s) : String(s) {}
+    StringSumHelper(const char* p) : String(p) {}
+};
+
+template <typename T>
+StringSumHelper operator+(const StringSumHelper& lhs, const T& rhs) {
+    StringSumHelper sum(lhs);
+    sum.concat(rhs);
+    return sum;
+}
+
+inline StringSumHelper operator+(const String& lhs, const String& rhs) { return StringSumHelper(lhs) + rhs; }
+inline StringSumHelper operator+(const String& lhs, const char* rhs) { return StringSumHelper(lhs) + rhs; }
+inline StringSumHelper operator+(const String& lhs, char rhs) { return StringSumHelper(lhs) + rhs; }
+inline StringSumHelper operator+(const String& lhs, int rhs) { return StringSumHelper(lhs) + rhs; }
+inline StringSumHelper operator+(const String& lhs, unsigned int rhs) { return StringSumHelper(lhs) + rhs; }
+inline StringSumHelper operator+(const String& lhs, long rhs) { return StringSumHelper(lhs) + rhs; }
+inline StringSumHelper operator+(const String& lhs, unsigned long rhs) { return StringSumHelper(lhs) + rhs; }
+inline StringSumHelper operator+(const String& lhs, float rhs) { return StringSumHelper(lhs) + rhs; }
+inline StringSumHelper operator+(const String& lhs, double rhs) { return StringSumHelper(lhs) + rhs; }
+inline StringSumHelper operator+(const char* lhs, const String& rhs) { return StringSumHelper(lhs) + rhs; }
+
+inline bool operator==(const char* lhs, const String& rhs) { return rhs == lhs; }
+inline bool operator!=(const char* lhs, const String& rhs) { return rhs != lhs; }
+
+#endif // SHIM_WSTRING_H
@@ -0,0 +1,351 @@
+#include "WebServer.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define HTTP_MAX_HEADER_SIZE 8192
+#define HTTP_MAX_BODY_SIZE   (1024 * 1024)
+#define HTTP_MAX_DATA_WAIT   5000    // ms, as in the core
+
+static const char* statusText(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 406: return "Not Acceptable";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 415: return "Unsupported Media Type";
+        case 422: return "Unprocessable Entity";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "";
+    }
+}
+
+WebServer::WebServer(int port)
+    : _port(port),
+      _listenFd(-1),
+      _method(HTTP_ANY),
+      _contentLength(CONTENT_LENGTH_NOT_SET),
+      _chunked(false) {
+    const char* override = getenv("SHIM_HTTP_PORT");
+    if (override && override[0]) _port = atoi(override);
+    _headerKeys.push_back("Authorization");
+}
+
+WebServer::~WebServer() {
+    stop();
+}
+
+void WebServer::begin() {
+    stop();
+    _listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_listenFd < 0) return;
+
+    int on = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(_port);
+    if (bind(_listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(_listenFd, 16) != 0) {
+        fprintf(stderr, "WebServer: cannot listen on 127.0.0.1:%d: %s\n", _port, strerror(errno));
+        close(_listenFd);
+        _listenFd = -1;
+        return;
+    }
+    fcntl(_listenFd, F_SETFL, fcntl(_listenFd, F_GETFL) | O_NONBLOCK);
+}
+
+void WebServer::stop() {
+    if (_listenFd >= 0) {
+        close(_listenFd);
+        _listenFd = -1;
+    }
+}
+
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction handler) {
+    _routes.push_back({uri, method, handler});
+}
+
+// File uploads (multipart) are not parsed; the request handler still runs
+void WebServer::on(const String& uri, HTTPMethod method, THandlerFunction handler,
+                   THandlerFunction upload) {
+    (void)upload;
+    on(uri, method, handler);
+}
+
+void WebServer::handleClient() {
+    if (_listenFd < 0) return;
+    int fd = accept(_listenFd, nullptr, nullptr);
+    if (fd < 0) return;
+
+    _client = WiFiClient(fd);
+    resetRequest();
+    if (readRequest()) {
+        const Route* match = nullptr;
+        for (const Route& r : _routes) {
+            if ((r.method == HTTP_ANY || r.method == _method) && r.uri == _uri) {
+                match = &r;
+                break;
+            }
+        }
+        if (match) {
+            match->handler();
+        } else if (_notFound) {
+            _notFound();
+        } else {
+            send(404, "text/plain", String("Not found: ") + _uri);
+        }
+        if (_chunked) sendContent("", 0);
+    }
+    _client.stop();
+    ESP.sampleHeap();
+}
+
+void WebServer::resetRequest() {
+    _uri = String();
+    _method = HTTP_ANY;
+    _args.clear();
+    _headers.clear();
+    _responseHeaders = String();
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _chunked = false;
+}
+
+// Reads until the full body has arrived or HTTP_MAX_DATA_WAIT passes
+static bool readUntil(int fd, std::string& buf, size_t want, unsigned long start) {
+    char chunk[1024];
+    while (buf.size() < want) {
+        int left = HTTP_MAX_DATA_WAIT - (int)(millis() - start);
+        if (left <= 0) return false;
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, left) <= 0) return false;
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buf.append(chunk, n);
+    }
+    return true;
+}
+
+bool WebServer::readRequest() {
+    int fd = _client.fd();
+    unsigned long start = millis();
+    std::string buf;
+    size_t headerEnd;
+    while ((headerEnd = buf.find("\r\n\r\n")) == std::string::npos) {
+        if (buf.size() > HTTP_MAX_HEADER_SIZE || !readUntil(fd, buf, buf.size() + 1, start)) return false;
+    }
+
+    // Request line
+    size_t lineEnd = buf.find("\r\n");
+    std::string line = buf.substr(0, lineEnd);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = line.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) return false;
+    std::string method = line.substr(0, sp1);
+    std::string target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    if (method == "GET") _method = HTTP_GET;
+    else if (method == "HEAD") _method = HTTP_HEAD;
+    else if (method == "POST") _method = HTTP_POST;
+    else if (method == "PUT") _method = HTTP_PUT;
+    else if (method == "PATCH") _method = HTTP_PATCH;
+    else if (method == "DELETE") _method = HTTP_DELETE;
+    else if (method == "OPTIONS") _method = HTTP_OPTIONS;
+    else return false;
+
+    size_t q = target.find('?');
+    _uri = urlDecode(String(target.substr(0, q)));
+    String query = (q == std::string::npos) ? String() : String(target.substr(q + 1));
+
+    // Headers: only the collected ones are kept, as in the core
+    size_t contentLength = 0;
+    String contentType;
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+        size_t end = buf.find("\r\n", pos);
+        std::string h = buf.substr(pos, end - pos);
+        pos = end + 2;
+        size_t colon = h.find(':');
+        if (colon == std::string::npos) continue;
+        String name(h.substr(0, colon));
+        String value(h.substr(colon + 1));
+        value.trim();
+        if (name.equalsIgnoreCase("Content-Length")) contentLength = strtoul(value.c_str(), nullptr, 10);
+        if (name.equalsIgnoreCase("Content-Type")) contentType = value;
+        for (const String& key : _headerKeys) {
+            if (name.equalsIgnoreCase(key)) {
+                _headers.push_back({key, value});
+                break;
+            }
+        }
+    }
+    if (contentLength > HTTP_MAX_BODY_SIZE) return false;
+
+    std::string body = buf.substr(headerEnd + 4);
+    if (!readUntil(fd, body, contentLength, start)) return false;
+    body.resize(contentLength);
+
+    parseArguments(query);
+    if (contentLength > 0) {
+        if (contentType.startsWith("application/x-www-form-urlencoded")) {
+            parseArguments(String(body));
+        } else {
+            _args.push_back({"plain", String(body)});
+        }
+    }
+    return true;
+}
+
+void WebServer::parseArguments(const String& query) {
+    int start = 0;
+    while (start < (int)query.length()) {
+        int amp = query.indexOf('&', start);
+        if (amp < 0) amp = query.length();
+        String pair = query.substring(start, amp);
+        start = amp + 1;
+        if (pair.length() == 0) continue;
+        int eq = pair.indexOf('=');
+        if (eq < 0) {
+            _args.push_back({urlDecode(pair), String()});
+        } else {
+            _args.push_back({urlDecode(pair.substring(0, eq)), urlDecode(pair.substring(eq + 1))});
+        }
+    }
+}
+
+String WebServer::urlDecode(const String& text) {
+    String decoded;
+    decoded.reserve(text.length());
+    for (unsigned int i = 0; i < text.length(); i++) {
+        char c = text[i];
+        if (c == '+') {
+            decoded += ' ';
+        } else if (c == '%' && i + 2 < text.length() && isxdigit((unsigned char)text[i + 1]) &&
+                   isxdigit((unsigned char)text[i + 2])) {
+            char hex[3] = {text[i + 1], text[i + 2], 0};
+            decoded += (char)strtol(hex, nullptr, 16);
+            i += 2;
+        } else {
+            decoded += c;
+        }
+    }
+    return decoded;
+}
+
+String WebServer::arg(int index) const {
+    return index >= 0 && index < (int)_args.size() ? _args[index].value : String();
+}
+
+String WebServer::arg(const String& name) const {
+    for (const Pair& a : _args) {
+        if (a.name == name) return a.value;
+    }
+    return String();
+}
+
+String WebServer::argName(int index) const {
+    return index >= 0 && index < (int)_args.size() ? _args[index].name : String();
+}
+
+bool WebServer::hasArg(const String& name) const {
+    for (const Pair& a : _args) {
+        if (a.name == name) return true;
+    }
+    return false;
+}
+
+void WebServer::collectHeaders(const char* headerKeys[], size_t count) {
+    _headerKeys.clear();
+    _headerKeys.push_back("Authorization");
+    for (size_t i = 0; i < count; i++) _headerKeys.push_back(headerKeys[i]);
+}
+
+String WebServer::header(const String& name) const {
+    for (const Pair& h : _headers) {
+        if (h.name.equalsIgnoreCase(name)) return h.value;
+    }
+    return String();
+}
+
+bool WebServer::hasHeader(const String& name) const {
+    for (const Pair& h : _headers) {
+        if (h.name.equalsIgnoreCase(name)) return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// Response
+// ============================================================================
+
+void WebServer::sendHeader(const String& name, const String& value, bool first) {
+    String line = name + ": " + value + "\r\n";
+    _responseHeaders = first ? line + _responseHeaders : _responseHeaders + line;
+}
+
+void WebServer::sendHeaders(int code, const char* contentType, size_t contentLength) {
+    String head = String("HTTP/1.1 ") + String(code) + " " + statusText(code) + "\r\n";
+    head += "Content-Type: ";
+    head += (contentType && contentType[0]) ? contentType : "text/html";
+    head += "\r\n";
+    if (_contentLength == CONTENT_LENGTH_UNKNOWN) {
+        head += "Transfer-Encoding: chunked\r\n";
+        _chunked = true;
+    } else {
+        size_t length = (_contentLength == CONTENT_LENGTH_NOT_SET) ? contentLength : _contentLength;
+        head += "Content-Length: " + String((unsigned long)length) + "\r\n";
+    }
+    head += _responseHeaders;
+    head += "Connection: close\r\n\r\n";
+    _client.write((const uint8_t*)head.c_str(), head.length());
+    _responseHeaders = String();
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+}
+
+void WebServer::send(int code, const char* contentType, const String& content) {
+    sendHeaders(code, contentType, content.length());
+    if (content.length()) sendContent(content.c_str(), content.length());
+    ESP.sampleHeap();
+}
+
+void WebServer::send_P(int code, const char* contentType, const char* content) {
+    send_P(code, contentType, content, strlen(content));
+}
+
+void WebServer::send_P(int code, const char* contentType, const char* content, size_t length) {
+    sendHeaders(code, contentType, length);
+    if (length) sendContent(content, length);
+    ESP.sampleHeap();
+}
+
+void WebServer::sendContent(const char* content, size_t length) {
+    if (!_chunked) {
+        _client.write((const uint8_t*)content, length);
+        return;
+    }
+    char size[12];
+    snprintf(size, sizeof(size), "%zx\r\n", length);
+    _client.write((const uint8_t*)size, strlen(size));
+    if (length) _client.write((const uint8_t*)content, length);
+    _client.write((const uint8_t*)"\r\n", 2);
+    if (length == 0) _chunked = false;
+}
@@ -0,0 +1,99 @@
+#ifndef SHIM_WEBSERVER_H
+#define SHIM_WEBSERVER_H
+
+#include <functional>
+#include <vector>
+#include "WiFi.h"
+#include "FS.h"
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+// The core's WebServer on a host socket: one request per handleClient(),
+// answered with "Connection: close". Arguments, collected headers, "plain"
+// bodies, sendHeader(), setContentLength() and chunked sendContent() behave
+// as in the ESP32 core. The listening port is SHIM_HTTP_PORT when that is
+// set (80 needs root), and only the loopback interface is bound.
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit WebServer(int port = 80);
+    ~WebServer();
+
+    void begin();
+    void stop();
+    void handleClient();
+
+    void on(const String& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler);
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler, THandlerFunction upload);
+    void onNotFound(THandlerFunction handler) { _notFound = handler; }
+
+    // Request
+    String uri() const { return _uri; }
+    HTTPMethod method() const { return _method; }
+    WiFiClient client() { return _client; }
+    int args() const { return _args.size(); }
+    String arg(int index) const;
+    String arg(const String& name) const;
+    String argName(int index) const;
+    bool hasArg(const String& name) const;
+    void collectHeaders(const char* headerKeys[], size_t count);
+    String header(const String& name) const;
+    bool hasHeader(const String& name) const;
+
+    // Response
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t length) { _contentLength = length; }
+    void send(int code, const char* contentType = nullptr, const String& content = String());
+    void send(int code, const String& contentType, const String& content) {
+        send(code, contentType.c_str(), content);
+    }
+    void send(int code, const char* contentType, const char* content) {
+        send(code, contentType, String(content));
+    }
+    void send_P(int code, const char* contentType, const char* content);
+    void send_P(int code, const char* contentType, const char* content, size_t length);
+    void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+    void sendContent(const char* content, size_t length);
+    void sendContent_P(const char* content) { sendContent(content, strlen(content)); }
+    void sendContent_P(const char* content, size_t length) { sendContent(content, length); }
+
+private:
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+    struct Pair {
+        String name;
+        String value;
+    };
+
+    bool readRequest();
+    void parseArguments(const String& query);
+    void sendHeaders(int code, const char* contentType, size_t contentLength);
+    void resetRequest();
+    static String urlDecode(const String& text);
+
+    int _port;
+    int _listenFd;
+    std::vector<Route> _routes;
+    THandlerFunction _notFound;
+
+    WiFiClient _client;
+    String _uri;
+    HTTPMethod _method;
+    std::vector<Pair> _args;
+    std::vector<String> _headerKeys;
+    std::vector<Pair> _headers;
+
+    String _responseHeaders;
+    size_t _contentLength;
+    bool _chunked;
+};
+
+#endif // SHIM_WEBSERVER_H
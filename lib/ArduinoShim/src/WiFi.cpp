@@ -0,0 +1,160 @@
+#include "WiFi.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiClass WiFi;
+
+String WiFiClass::macAddress() {
+    uint64_t mac = ESP.getEfuseMac();
+    char buf[18];
+    snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
+             (unsigned)(mac & 0xFF), (unsigned)((mac >> 8) & 0xFF), (unsigned)((mac >> 16) & 0xFF),
+             (unsigned)((mac >> 24) & 0xFF), (unsigned)((mac >> 32) & 0xFF), (unsigned)((mac >> 40) & 0xFF));
+    return String(buf);
+}
+
+// ============================================================================
+// WiFiClient
+// ============================================================================
+
+struct WiFiClient::Socket {
+    explicit Socket(int f) : fd(f) {}
+    ~Socket() { if (fd >= 0) close(fd); }
+    int fd;
+};
+
+WiFiClient::WiFiClient() {}
+
+WiFiClient::WiFiClient(int fd) : _socket(std::make_shared<Socket>(fd)) {
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+}
+
+int WiFiClient::fd() const {
+    return _socket ? _socket->fd : -1;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+}
+
+// Blocking connect bounded by the stream timeout, like the core's
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(host, service, &hints, &result) != 0 || !result) return 0;
+
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd < 0) {
+        freeaddrinfo(result);
+        return 0;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    int rc = ::connect(fd, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    if (rc < 0 && errno == EINPROGRESS) {
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (poll(&pfd, 1, (int)_timeout) == 1 &&
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) {
+            rc = 0;
+        }
+    }
+    if (rc < 0) {
+        close(fd);
+        return 0;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+    _socket = std::make_shared<Socket>(fd);
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    if (!_socket) return 0;
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = send(_socket->fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            stop();
+            break;
+        }
+        sent += n;
+    }
+    return sent;
+}
+
+int WiFiClient::available() {
+    if (!_socket) return 0;
+    int pending = 0;
+    if (ioctl(_socket->fd, FIONREAD, &pending) < 0) return 0;
+    return pending;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+// Non-blocking, like the core: -1 when nothing has arrived
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    if (!_socket) return -1;
+    ssize_t n = recv(_socket->fd, buffer, size, MSG_DONTWAIT);
+    if (n == 0) {
+        stop();
+        return -1;
+    }
+    return n < 0 ? -1 : (int)n;
+}
+
+int WiFiClient::peek() {
+    if (!_socket) return -1;
+    uint8_t c;
+    return recv(_socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? c : -1;
+}
+
+void WiFiClient::stop() {
+    _socket.reset();
+}
+
+uint8_t WiFiClient::connected() {
+    if (!_socket) return 0;
+    uint8_t c;
+    ssize_t n = recv(_socket->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+    if (!_socket) return;
+    int on = noDelay ? 1 : 0;
+    setsockopt(_socket->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+IPAddress WiFiClient::remoteIP() const {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    if (!_socket || getpeername(_socket->fd, (struct sockaddr*)&addr, &len) != 0) return IPAddress();
+    return IPAddress((uint32_t)addr.sin_addr.s_addr);
+}
@@ -0,0 +1,80 @@
+#ifndef SHIM_WIFI_H
+#define SHIM_WIFI_H
+
+#include <memory>
+#include "Arduino.h"
+#include "Client.h"
+#include "IPAddress.h"
+
+#define WL_IDLE_STATUS 0
+#define WL_NO_SSID_AVAIL 1
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+
+#define WIFI_OFF 0
+#define WIFI_STA 1
+#define WIFI_AP 2
+#define WIFI_AP_STA 3
+
+#define WIFI_AUTH_OPEN 0
+#define WIFI_AUTH_WPA2_PSK 3
+
+// TCP client on a host socket. Copies share the socket, as in the core.
+class WiFiClient : public Client {
+public:
+    WiFiClient();
+    explicit WiFiClient(int fd);   // Takes over an accepted socket
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int peek() override;
+    void flush() override {}
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override { return connected(); }
+
+    void setNoDelay(bool noDelay);
+    IPAddress remoteIP() const;
+    int fd() const;
+
+    using Print::write;
+
+private:
+    struct Socket;
+    std::shared_ptr<Socket> _socket;
+};
+
+// Station always up on the loopback address; scans find nothing
+class WiFiClass {
+public:
+    int status() { return WL_CONNECTED; }
+    bool isConnected() { return true; }
+    void mode(int m) { (void)m; }
+    void begin(const char* ssid, const char* password) { (void)ssid; (void)password; }
+    void disconnect(bool wifiOff = false) { (void)wifiOff; }
+    void setHostname(const char* name) { (void)name; }
+    void setSleep(bool enable) { (void)enable; }
+
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+    String macAddress();
+    String SSID() { return String("host"); }
+    String SSID(int index) { (void)index; return String(); }
+    int32_t RSSI() { return -50; }
+    int32_t RSSI(int index) { (void)index; return 0; }
+    int encryptionType(int index) { (void)index; return WIFI_AUTH_OPEN; }
+    int scanNetworks() { return 0; }
+    void scanDelete() {}
+
+    void softAP(const char* ssid, const char* password = nullptr) { (void)ssid; (void)password; }
+    IPAddress softAPIP() { return IPAddress(127, 0, 0, 1); }
+    void softAPdisconnect(bool wifiOff = false) { (void)wifiOff; }
+};
+
+extern WiFiClass WiFi;
+
+#endif // SHIM_WIFI_H
@@ -0,0 +1,17 @@
+#ifndef SHIM_WIFICLIENTSECURE_H
+#define SHIM_WIFICLIENTSECURE_H
+
+#include "WiFi.h"
+
+// No TLS on the host: connections fail, as with an unreachable broker
+class WiFiClientSecure : public WiFiClient {
+public:
+    int connect(IPAddress ip, uint16_t port) override { (void)ip; (void)port; return 0; }
+    int connect(const char* host, uint16_t port) override { (void)host; (void)port; return 0; }
+    void setInsecure() {}
+    void setCACert(const char* rootCA) { (void)rootCA; }
+    void setHandshakeTimeout(unsigned long seconds) { (void)seconds; }
+    bool verify(const char* fingerprint, const char* domain) { (void)fingerprint; (void)domain; return false; }
+};
+
+#endif // SHIM_WIFICLIENTSECURE_H
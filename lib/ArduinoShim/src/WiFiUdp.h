@@ -0,0 +1,28 @@
+#ifndef SHIM_WIFIUDP_H
+#define SHIM_WIFIUDP_H
+
+#include "WiFi.h"
+
+// No peers on the host: packets are dropped and none arrive
+class WiFiUDP : public Stream {
+public:
+    uint8_t begin(uint16_t port) { (void)port; return 1; }
+    void stop() {}
+    int beginPacket(IPAddress ip, uint16_t port) { (void)ip; (void)port; return 1; }
+    int beginPacket(const char* host, uint16_t port) { (void)host; (void)port; return 1; }
+    int endPacket() { return 1; }
+    size_t write(uint8_t c) override { (void)c; return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { (void)buffer; return size; }
+    int parsePacket() { return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int read(uint8_t* buffer, size_t size) { (void)buffer; (void)size; return 0; }
+    int read(char* buffer, size_t size) { (void)buffer; (void)size; return 0; }
+    int peek() override { return -1; }
+    IPAddress remoteIP() { return IPAddress(); }
+    uint16_t remotePort() { return 0; }
+
+    using Print::write;
+};
+
+#endif // SHIM_WIFIUDP_H
@@ -0,0 +1,11 @@
+#ifndef SHIM_ESP_ATTR_H
+#define SHIM_ESP_ATTR_H
+
+// Plain RAM: the "RTC" tail starts empty on every run
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#endif // SHIM_ESP_ATTR_H
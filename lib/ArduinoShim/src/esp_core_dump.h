@@ -0,0 +1,32 @@
+#ifndef SHIM_ESP_CORE_DUMP_H
+#define SHIM_ESP_CORE_DUMP_H
+
+#include "esp_partition.h"
+
+typedef struct {
+    uint32_t bt[16];
+    uint32_t depth;
+    bool corrupted;
+} esp_core_dump_bt_info_t;
+
+typedef struct {
+    uint32_t exc_tcb;
+    char exc_task[16];
+    uint32_t exc_pc;
+    esp_core_dump_bt_info_t exc_bt_info;
+    uint32_t core_dump_version;
+    uint8_t app_elf_sha256[65];
+} esp_core_dump_summary_t;
+
+// Never a core dump
+inline esp_err_t esp_core_dump_image_get(size_t* outAddr, size_t* outSize) {
+    (void)outAddr; (void)outSize;
+    return ESP_ERR_NOT_FOUND;
+}
+
+inline esp_err_t esp_core_dump_get_summary(esp_core_dump_summary_t* summary) {
+    (void)summary;
+    return ESP_ERR_NOT_FOUND;
+}
+
+#endif // SHIM_ESP_CORE_DUMP_H
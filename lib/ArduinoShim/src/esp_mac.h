@@ -0,0 +1,14 @@
+#ifndef SHIM_ESP_MAC_H
+#define SHIM_ESP_MAC_H
+
+#include <stdint.h>
+#include "esp_partition.h"
+
+// The same fixed address as ESP.getEfuseMac() and WiFi.macAddress()
+inline esp_err_t esp_efuse_mac_get_default(uint8_t* mac) {
+    static const uint8_t host[6] = {0xAB, 0xCD, 0xEF, 0x12, 0x34, 0x56};
+    for (int i = 0; i < 6; i++) mac[i] = host[i];
+    return ESP_OK;
+}
+
+#endif // SHIM_ESP_MAC_H
@@ -0,0 +1,41 @@
+#ifndef SHIM_ESP_PARTITION_H
+#define SHIM_ESP_PARTITION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NOT_FOUND 0x105
+
+typedef enum { ESP_PARTITION_TYPE_APP = 0, ESP_PARTITION_TYPE_DATA = 1 } esp_partition_type_t;
+typedef enum { ESP_PARTITION_SUBTYPE_DATA_COREDUMP = 3 } esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+
+// No flash partitions on the host
+inline const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                       esp_partition_subtype_t subtype,
+                                                       const char* label) {
+    (void)type; (void)subtype; (void)label;
+    return nullptr;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* dst, size_t size) {
+    (void)partition; (void)offset; (void)dst; (void)size;
+    return ESP_ERR_NOT_FOUND;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+    (void)partition; (void)offset; (void)size;
+    return ESP_ERR_NOT_FOUND;
+}
+
+#endif // SHIM_ESP_PARTITION_H
@@ -0,0 +1,6 @@
+#ifndef SHIM_MBEDTLS_CTR_DRBG_H
+#define SHIM_MBEDTLS_CTR_DRBG_H
+
+#include "ssl.h"
+
+#endif // SHIM_MBEDTLS_CTR_DRBG_H
@@ -0,0 +1,6 @@
+#ifndef SHIM_MBEDTLS_ENTROPY_H
+#define SHIM_MBEDTLS_ENTROPY_H
+
+#include "ssl.h"
+
+#endif // SHIM_MBEDTLS_ENTROPY_H
@@ -0,0 +1,6 @@
+#ifndef SHIM_MBEDTLS_SHA256_H
+#define SHIM_MBEDTLS_SHA256_H
+
+#include "ssl.h"
+
+#endif // SHIM_MBEDTLS_SHA256_H
@@ -0,0 +1,118 @@
+#ifndef SHIM_MBEDTLS_SSL_H
+#define SHIM_MBEDTLS_SSL_H
+
+#include <stddef.h>
+#include <string.h>
+
+// No TLS on the host: contexts set up, but every handshake fails, as with
+// a broker that is unreachable. Only what TlsClient uses is declared; the
+// other mbedtls/ headers include this one.
+
+#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_SSL_SESSION_TICKETS
+
+#define MBEDTLS_SSL_IS_CLIENT 0
+#define MBEDTLS_SSL_TRANSPORT_STREAM 0
+#define MBEDTLS_SSL_PRESET_DEFAULT 0
+#define MBEDTLS_SSL_VERIFY_NONE 0
+#define MBEDTLS_SSL_VERIFY_REQUIRED 2
+#define MBEDTLS_SSL_SESSION_TICKETS_ENABLED 1
+
+#define MBEDTLS_ERR_SSL_WANT_READ -0x6900
+#define MBEDTLS_ERR_SSL_WANT_WRITE -0x6880
+#define MBEDTLS_ERR_SSL_INTERNAL_ERROR -0x6C00
+#define MBEDTLS_ERR_NET_CONN_RESET -0x0050
+#define MBEDTLS_ERR_SHA256_BAD_INPUT_DATA -0x0074
+
+typedef struct { int tag; size_t len; unsigned char* p; } mbedtls_x509_buf;
+typedef struct { mbedtls_x509_buf raw; } mbedtls_x509_crt;
+typedef struct { int unused; } mbedtls_entropy_context;
+typedef struct { int unused; } mbedtls_ctr_drbg_context;
+typedef struct { int unused; } mbedtls_ssl_config;
+typedef struct { unsigned char id[32]; size_t id_len; } mbedtls_ssl_session;
+typedef struct { mbedtls_ssl_session* session; } mbedtls_ssl_context;
+
+typedef int mbedtls_ssl_send_t(void* ctx, const unsigned char* buf, size_t len);
+typedef int mbedtls_ssl_recv_t(void* ctx, unsigned char* buf, size_t len);
+typedef int mbedtls_ssl_recv_timeout_t(void* ctx, unsigned char* buf, size_t len, unsigned int timeout);
+
+inline void mbedtls_x509_crt_init(mbedtls_x509_crt* crt) { memset(crt, 0, sizeof(*crt)); }
+inline void mbedtls_x509_crt_free(mbedtls_x509_crt* crt) { (void)crt; }
+inline int mbedtls_x509_crt_parse(mbedtls_x509_crt* crt, const unsigned char* buf, size_t len) {
+    (void)crt; (void)buf; (void)len; return 0;
+}
+
+inline void mbedtls_entropy_init(mbedtls_entropy_context* ctx) { (void)ctx; }
+inline void mbedtls_entropy_free(mbedtls_entropy_context* ctx) { (void)ctx; }
+inline int mbedtls_entropy_func(void* data, unsigned char* output, size_t len) {
+    (void)data; memset(output, 0, len); return 0;
+}
+inline void mbedtls_ctr_drbg_init(mbedtls_ctr_drbg_context* ctx) { (void)ctx; }
+inline void mbedtls_ctr_drbg_free(mbedtls_ctr_drbg_context* ctx) { (void)ctx; }
+inline int mbedtls_ctr_drbg_seed(mbedtls_ctr_drbg_context* ctx, int (*entropy)(void*, unsigned char*, size_t),
+                                 void* entropyCtx, const unsigned char* custom, size_t len) {
+    (void)ctx; (void)entropy; (void)entropyCtx; (void)custom; (void)len; return 0;
+}
+inline int mbedtls_ctr_drbg_random(void* ctx, unsigned char* output, size_t len) {
+    (void)ctx; memset(output, 0, len); return 0;
+}
+
+inline void mbedtls_ssl_config_init(mbedtls_ssl_config* conf) { (void)conf; }
+inline void mbedtls_ssl_config_free(mbedtls_ssl_config* conf) { (void)conf; }
+inline int mbedtls_ssl_config_defaults(mbedtls_ssl_config* conf, int endpoint, int transport, int preset) {
+    (void)conf; (void)endpoint; (void)transport; (void)preset; return 0;
+}
+inline void mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int authmode) { (void)conf; (void)authmode; }
+inline void mbedtls_ssl_conf_ca_chain(mbedtls_ssl_config* conf, mbedtls_x509_crt* ca, void* crl) {
+    (void)conf; (void)ca; (void)crl;
+}
+inline void mbedtls_ssl_conf_rng(mbedtls_ssl_config* conf, int (*rng)(void*, unsigned char*, size_t), void* ctx) {
+    (void)conf; (void)rng; (void)ctx;
+}
+inline void mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config* conf, int useTickets) {
+    (void)conf; (void)useTickets;
+}
+
+inline void mbedtls_ssl_session_init(mbedtls_ssl_session* session) { memset(session, 0, sizeof(*session)); }
+inline void mbedtls_ssl_session_free(mbedtls_ssl_session* session) { memset(session, 0, sizeof(*session)); }
+
+inline void mbedtls_ssl_init(mbedtls_ssl_context* ssl) { ssl->session = nullptr; }
+inline void mbedtls_ssl_free(mbedtls_ssl_context* ssl) { ssl->session = nullptr; }
+inline int mbedtls_ssl_setup(mbedtls_ssl_context* ssl, const mbedtls_ssl_config* conf) {
+    (void)ssl; (void)conf; return 0;
+}
+inline int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname) {
+    (void)ssl; (void)hostname; return 0;
+}
+inline void mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* ctx, mbedtls_ssl_send_t* send,
+                                mbedtls_ssl_recv_t* recv, mbedtls_ssl_recv_timeout_t* recvTimeout) {
+    (void)ssl; (void)ctx; (void)send; (void)recv; (void)recvTimeout;
+}
+inline int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session) {
+    (void)ssl; (void)session; return 0;
+}
+inline int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session) {
+    (void)ssl; (void)session; return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+}
+inline int mbedtls_ssl_handshake(mbedtls_ssl_context* ssl) { (void)ssl; return MBEDTLS_ERR_SSL_INTERNAL_ERROR; }
+inline int mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len) {
+    (void)ssl; (void)buf; (void)len; return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+}
+inline int mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len) {
+    (void)ssl; (void)buf; (void)len; return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+}
+inline int mbedtls_ssl_close_notify(mbedtls_ssl_context* ssl) { (void)ssl; return 0; }
+inline size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context* ssl) { (void)ssl; return 0; }
+inline const mbedtls_x509_crt* mbedtls_ssl_get_peer_cert(const mbedtls_ssl_context* ssl) {
+    (void)ssl; return nullptr;
+}
+
+inline int mbedtls_sha256_ret(const unsigned char* input, size_t len, unsigned char output[32], int is224) {
+    (void)input; (void)len; (void)output; (void)is224; return MBEDTLS_ERR_SHA256_BAD_INPUT_DATA;
+}
+
+inline int mbedtls_platform_set_calloc_free(void* (*callocFunc)(size_t, size_t), void (*freeFunc)(void*)) {
+    (void)callocFunc; (void)freeFunc; return 0;
+}
+
+#endif // SHIM_MBEDTLS_SSL_H
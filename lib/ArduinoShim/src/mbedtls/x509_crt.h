@@ -0,0 +1,6 @@
+#ifndef SHIM_MBEDTLS_X509_CRT_H
+#define SHIM_MBEDTLS_X509_CRT_H
+
+#include "ssl.h"
+
+#endif // SHIM_MBEDTLS_X509_CRT_H
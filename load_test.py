@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""Replay dashboard traffic against a controller and report how it copes.
+
+Each simulated client behaves like an open status page: it polls
+/api/channels/status and /api/nodes/pending every 2 s (sending the ETag it
+got last, like the browser does) and optionally saves a schedule edit now
+and then. Edits go to a scratch schedule with no weekdays, so it never runs,
+and it is deleted at the end.
+
+Client-side throughput and p50/p99 latency are measured here; handler time,
+loop() busy time and the heap low-water mark come from /api/metrics, whose
+window is reset when the run starts.
+
+Usage:
+    python3 load_test.py 192.168.1.50 --clients 8 --duration 60 --edit-every 20
+The host may carry a port (127.0.0.1:8080 for the host build, see
+test/test_web). Exits with 1 if any request failed. Only the standard
+library is needed.
+"""
+import argparse
+import json
+import random
+import sys
+import threading
+import time
+import urllib.error
+import urllib.request
+
+POLLS = ["/api/channels/status", "/api/nodes/pending"]
+
+
+def request(base, path, method="GET", body=None, etag=None, timeout=10):
+    """Returns (status, latency_s, etag, parsed body or None)."""
+    data = json.dumps(body).encode() if body is not None else None
+    req = urllib.request.Request(base + path, data=data, method=method)
+    if data is not None:
+        req.add_header("Content-Type", "application/json")
+    if etag:
+        req.add_header("If-None-Match", etag)
+
+    start = time.monotonic()
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as resp:
+            payload = resp.read()
+            status, tag = resp.status, resp.headers.get("ETag")
+    except urllib.error.HTTPError as e:
+        payload, status, tag = e.read(), e.code, e.headers.get("ETag")
+    except (urllib.error.URLError, OSError):
+        return None, time.monotonic() - start, None, None
+    latency = time.monotonic() - start
+
+    try:
+        parsed = json.loads(payload) if payload else None
+    except ValueError:
+        parsed = None
+    return status, latency, tag, parsed
+
+
+class Client(threading.Thread):
+    def __init__(self, base, stop_at, poll, edit_every, schedule_id, results, lock):
+        super().__init__(daemon=True)
+        self.base, self.stop_at, self.poll = base, stop_at, poll
+        self.edit_every, self.schedule_id = edit_every, schedule_id
+        self.results, self.lock = results, lock
+        self.etags = {}
+
+    def record(self, kind, status, latency):
+        with self.lock:
+            self.results.append((kind, status, latency))
+
+    def run(self):
+        # Stagger clients like tabs opened at different times
+        time.sleep(random.uniform(0, self.poll))
+        next_edit = time.monotonic() + random.uniform(0, self.edit_every or 1)
+
+        while time.monotonic() < self.stop_at:
+            tick = time.monotonic()
+            for path in POLLS:
+                status, latency, tag, _ = request(self.base, path, etag=self.etags.get(path))
+                if tag:
+                    self.etags[path] = tag
+                self.record("poll", status, latency)
+
+            if self.edit_every and self.schedule_id is not None and tick >= next_edit:
+                next_edit = tick + self.edit_every
+                body = {"id": self.schedule_id, "channel": 1, "hour": 3,
+                        "minute": random.randint(0, 59), "duration": 5, "weekdays": 0}
+                status, latency, _, _ = request(self.base, "/api/schedules", "POST", body)
+                self.record("edit", status, latency)
+                status, latency, _, _ = request(self.base, "/api/schedules")
+                self.record("poll", status, latency)
+
+            time.sleep(max(0.0, self.poll - (time.monotonic() - tick)))
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    k = min(len(values) - 1, max(0, int(round(p / 100.0 * len(values))) - 1))
+    return values[k]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("host", help="controller IP or hostname, optionally :port")
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--duration", type=float, default=60, help="seconds")
+    ap.add_argument("--poll", type=float, default=2.0, help="poll interval per client (s)")
+    ap.add_argument("--edit-every", type=float, default=0, help="schedule edit interval per client (s), 0 = none")
+    args = ap.parse_args()
+    base = "http://" + args.host
+
+    status, _, _, metrics = request(base, "/api/metrics?reset=1")
+    if status != 200:
+        print("Error: %s/api/metrics not reachable (firmware too old?)" % base)
+        sys.exit(1)
+
+    schedule_id = None
+    if args.edit_every:
+        status, _, _, reply = request(base, "/api/schedules", "POST",
+                                      {"channel": 1, "hour": 3, "minute": 0, "duration": 5, "weekdays": 0})
+        if status != 200 or not reply or "index" not in reply:
+            print("Error: could not create the scratch schedule: %s" % reply)
+            sys.exit(1)
+        schedule_id = reply["index"]
+
+    results, lock = [], threading.Lock()
+    start = time.monotonic()
+    stop_at = start + args.duration
+    clients = [Client(base, stop_at, args.poll, args.edit_every, schedule_id, results, lock)
+               for _ in range(args.clients)]
+    print("Running %d client(s) for %.0f s against %s ..." % (args.clients, args.duration, base))
+    for c in clients:
+        c.start()
+    for c in clients:
+        c.join()
+    elapsed = time.monotonic() - start
+
+    _, _, _, metrics = request(base, "/api/metrics")
+    if schedule_id is not None:
+        request(base, "/api/schedules?id=%d" % schedule_id, "DELETE")
+
+    print("-" * 60)
+    failures = 0
+    for kind in ("poll", "edit"):
+        rows = [r for r in results if r[0] == kind]
+        if not rows:
+            continue
+        ok = [lat * 1000 for _, st, lat in rows if st in (200, 304)]
+        failed = len(rows) - len(ok)
+        failures += failed
+        print("%-5s %6d req  %6.1f req/s  p50 %7.1f ms  p99 %7.1f ms  max %7.1f ms  failed %d" % (
+            kind, len(rows), len(rows) / elapsed, percentile(ok, 50), percentile(ok, 99),
+            max(ok) if ok else 0.0, failed))
+
+    if metrics:
+        req, loop, heap = metrics["requests"], metrics["loop"], metrics["heap"]
+        print("device handler  p50 %6.1f ms  p99 %6.1f ms  max %6.1f ms  (%d req)" % (
+            req["p50_us"] / 1000.0, req["p99_us"] / 1000.0, req["max_us"] / 1000.0, req["count"]))
+        print("device loop()   p50 %6.1f ms  p99 %6.1f ms  max %6.1f ms" % (
+            loop["p50_us"] / 1000.0, loop["p99_us"] / 1000.0, loop["max_us"] / 1000.0))
+        print("device heap     free %d  min free %d  largest block %d" % (
+            heap["free"], heap["min_free"], heap["max_alloc"]))
+        arena = metrics.get("json")
+        if arena:
+            print("device json     arena %d  high-water %d  heap fallbacks %d" % (
+                arena["arena"], arena["high_water"], arena["heap_fallbacks"]))
+
+    if failures:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+"""Fire Home Assistant style command storms at a controller over MQTT.
+
+Talks to the same broker as the controller and plays the parts HA does:
+  storm       random channel ON/OFF and duration commands at --rate per second,
+              the way automations and scripts fire them
+  birth       homeassistant/status "online" bursts, as when HA restarts
+  disconnect  runs --bounce-cmd (e.g. "sudo systemctl restart mosquitto")
+              halfway through a storm and times the reconnect
+
+For each ON/OFF the time until the controller publishes the matching
+channel/N/state is measured. After the run every channel's last published
+state is compared with the last command sent to it; a mismatch is a lost
+command. Publish amplification is messages the controller published per
+command sent. With --http, the controller's own counters (received,
+coalesced, dropped, receive-to-publish latency) are read from /api/metrics.
+
+Valves really open: run with the water supply off, and with the controller
+in auto or manual mode (in disabled mode every ON is answered with OFF).
+All tested channels are switched off at the end.
+
+Usage:
+    python3 mqtt_storm.py 192.168.1.10 --channels 1-4 --rate 40 --duration 30 \\
+        --http 192.168.1.50
+Needs paho-mqtt (pip install paho-mqtt).
+"""
+import argparse
+import json
+import random
+import subprocess
+import sys
+import threading
+import time
+import urllib.request
+
+try:
+    import paho.mqtt.client as mqtt
+except ImportError:
+    print("Error: paho-mqtt is required (pip install paho-mqtt)")
+    sys.exit(1)
+
+BASE_TOPIC = "homeassistant/switch/irrigation"     # MQTT_BASE_TOPIC in Config.h
+BIRTH_TOPIC = "homeassistant/status"
+
+
+def parse_channels(spec):
+    channels = []
+    for part in spec.split(","):
+        if "-" in part:
+            lo, hi = part.split("-")
+            channels.extend(range(int(lo), int(hi) + 1))
+        else:
+            channels.append(int(part))
+    return channels
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    k = min(len(values) - 1, max(0, int(round(p / 100.0 * len(values))) - 1))
+    return values[k]
+
+
+def get_metrics(host, reset=False):
+    if not host:
+        return None
+    try:
+        url = "http://%s/api/metrics%s" % (host, "?reset=1" if reset else "")
+        with urllib.request.urlopen(url, timeout=5) as resp:
+            return json.loads(resp.read()).get("mqtt")
+    except (OSError, ValueError):
+        return None
+
+
+class Observer:
+    """Tracks what the controller publishes and what was asked of it."""
+
+    def __init__(self, channels):
+        self.lock = threading.Lock()
+        self.channels = channels
+        self.sent = {}              # channel -> (payload, time) of last ON/OFF
+        self.state = {}             # channel -> last published state
+        self.latencies = []
+        self.commands = 0
+        self.device_msgs = 0
+        self.discovery_msgs = 0
+        self.online_at = None
+        self.offline_at = None
+
+    def command(self, channel, payload):
+        with self.lock:
+            self.sent[channel] = (payload, time.monotonic())
+            self.commands += 1
+
+    def on_message(self, topic, payload):
+        now = time.monotonic()
+        with self.lock:
+            if topic.startswith(BASE_TOPIC + "/"):
+                self.device_msgs += 1
+            elif topic.startswith("homeassistant/") and topic.endswith("/config"):
+                self.discovery_msgs += 1
+
+            if topic == BASE_TOPIC + "/availability":
+                if payload == "online":
+                    self.online_at = now
+                else:
+                    self.offline_at = now
+                return
+
+            parts = topic[len(BASE_TOPIC) + 1:].split("/")
+            if len(parts) == 3 and parts[0] == "channel" and parts[2] == "state":
+                ch = int(parts[1])
+                self.state[ch] = payload
+                last = self.sent.get(ch)
+                if last and last[0] == payload and last[1] is not None:
+                    self.latencies.append((now - last[1]) * 1000)
+                    self.sent[ch] = (payload, None)     # Count the first match only
+
+
+def connect(args, observer):
+    try:
+        client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION2, client_id="irrigation_storm")
+    except AttributeError:
+        client = mqtt.Client(client_id="irrigation_storm")      # paho-mqtt 1.x
+    if args.user:
+        client.username_pw_set(args.user, args.password)
+    client.on_message = lambda c, u, msg: observer.on_message(
+        msg.topic, msg.payload.decode(errors="replace"))
+    # Subscribe on every connect so a broker restart does not blind us
+    client.on_connect = lambda c, *rest: (c.subscribe(BASE_TOPIC + "/#"),
+                                          c.subscribe("homeassistant/+/+/config"))
+    client.connect(args.broker, args.port, keepalive=30)
+    client.loop_start()
+    return client
+
+
+def storm(client, observer, args, stop_at, bounce_at=None):
+    interval = 1.0 / args.rate
+    next_send = time.monotonic()
+    while time.monotonic() < stop_at:
+        if bounce_at and time.monotonic() >= bounce_at:
+            bounce_at = None
+            print("Running: %s" % args.bounce_cmd)
+            observer.offline_at = observer.online_at = None
+            subprocess.call(args.bounce_cmd, shell=True)
+            bounced = time.monotonic()
+            while observer.online_at is None and time.monotonic() < bounced + 60:
+                time.sleep(0.05)
+            if observer.online_at:
+                print("Controller back online after %.1f s" % (observer.online_at - bounced))
+            else:
+                print("Controller did not come back online within 60 s")
+
+        ch = random.choice(observer.channels)
+        if random.random() < args.duration_ratio:
+            client.publish("%s/channel/%d/duration/set" % (BASE_TOPIC, ch), str(random.randint(1, 5)))
+        else:
+            payload = random.choice(("ON", "OFF"))
+            observer.command(ch, payload)
+            client.publish("%s/channel/%d/command" % (BASE_TOPIC, ch), payload)
+
+        next_send += interval
+        time.sleep(max(0.0, next_send - time.monotonic()))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("broker", help="MQTT broker IP or hostname")
+    ap.add_argument("--port", type=int, default=1883)
+    ap.add_argument("--user")
+    ap.add_argument("--password")
+    ap.add_argument("--http", help="controller IP or hostname, to read /api/metrics")
+    ap.add_argument("--scenario", choices=("storm", "birth", "disconnect"), default="storm")
+    ap.add_argument("--channels", default="1-4", help="e.g. 1-4 or 1,3,5")
+    ap.add_argument("--rate", type=float, default=20, help="commands per second")
+    ap.add_argument("--duration", type=float, default=30, help="seconds")
+    ap.add_argument("--duration-ratio", type=float, default=0.2,
+                    help="share of commands that are duration sets")
+    ap.add_argument("--births", type=int, default=5, help="birth messages in the burst")
+    ap.add_argument("--bounce-cmd", help="command that restarts the broker (disconnect scenario)")
+    ap.add_argument("--settle", type=float, default=3, help="seconds to wait for the last states")
+    args = ap.parse_args()
+
+    if args.scenario == "disconnect" and not args.bounce_cmd:
+        print("Error: the disconnect scenario needs --bounce-cmd")
+        sys.exit(1)
+
+    observer = Observer(parse_channels(args.channels))
+    client = connect(args, observer)
+    get_metrics(args.http, reset=True)
+    time.sleep(1)           # Retained states arrive first; do not count them
+    with observer.lock:
+        observer.device_msgs = observer.discovery_msgs = 0
+
+    start = time.monotonic()
+    if args.scenario == "birth":
+        print("Sending %d birth message(s) ..." % args.births)
+        for _ in range(args.births):
+            client.publish(BIRTH_TOPIC, "online")
+        time.sleep(args.settle)
+    else:
+        bounce_at = start + args.duration / 2 if args.scenario == "disconnect" else None
+        print("Storm: %.0f cmd/s on channel(s) %s for %.0f s ..." % (
+            args.rate, args.channels, args.duration))
+        storm(client, observer, args, start + args.duration, bounce_at)
+        time.sleep(args.settle)
+    elapsed = time.monotonic() - start
+    metrics = get_metrics(args.http)
+    lost = report(observer, args, elapsed, metrics)
+
+    for ch in observer.channels:
+        client.publish("%s/channel/%d/command" % (BASE_TOPIC, ch), "OFF")
+    time.sleep(0.5)
+    client.loop_stop()
+    client.disconnect()
+    sys.exit(1 if lost else 0)
+
+
+def report(observer, args, elapsed, metrics):
+    """Prints the run's figures; returns the number of channels whose last command was lost."""
+    print("-" * 60)
+    lost = []
+    with observer.lock:
+        if args.scenario == "birth":
+            print("births %d  discovery configs %d  state messages %d  in %.1f s" % (
+                args.births, observer.discovery_msgs, observer.device_msgs, elapsed))
+        else:
+            lost = [ch for ch, (payload, _) in observer.sent.items()
+                    if observer.state.get(ch) != payload]
+            lat = observer.latencies
+            print("commands %d  state matches %d  lost %d %s" % (
+                observer.commands, len(lat), len(lost), lost if lost else ""))
+            print("command -> state  p50 %7.1f ms  p99 %7.1f ms  max %7.1f ms" % (
+                percentile(lat, 50), percentile(lat, 99), max(lat) if lat else 0.0))
+            print("amplification     %.1f messages published per command" % (
+                observer.device_msgs / float(max(1, observer.commands))))
+
+    if metrics:
+        print("device received %d  coalesced %d  dropped %d  processed %d  state flushes %d" % (
+            metrics["received"], metrics["coalesced"], metrics["dropped"],
+            metrics["processed"], metrics["state_flushes"]))
+        print("device receive -> publish  p50 %6.1f ms  p99 %6.1f ms  max %6.1f ms" % (
+            metrics["p50_us"] / 1000.0, metrics["p99_us"] / 1000.0, metrics["max_us"] / 1000.0))
+    return len(lost)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,227 @@
+#include "AutomationManager.h"
+#include "IrrigationController.h"
+#include "HomeAssistantIntegration.h"
+#include "PressureMonitor.h"
+#include "TimeZone.h"
+#include <WiFi.h>
+#include <math.h>
+
+AutomationManager::AutomationManager(IrrigationController* controller)
+    : _controller(controller),
+      _ha(nullptr),
+      _pressure(nullptr),
+      _signature(0),
+      _generation(1),
+      _lastCheck(0) {
+    _engine.setCallbacks(readInput, runAction, this);
+}
+
+bool AutomationManager::begin() {
+    DEBUG_PRINTLN("AutomationManager: Initializing...");
+    loadRules();
+    _engine.markDirty();
+    DEBUG_PRINTF("AutomationManager: %d rule(s) loaded\n", _engine.getRuleCount());
+    return true;
+}
+
+void AutomationManager::update() {
+    if (!_controller) return;
+
+    if (millis() - _lastCheck >= RULE_CHECK_INTERVAL) {
+        _lastCheck = millis();
+        uint32_t signature = inputSignature();
+        if (signature != _signature) {
+            _signature = signature;
+            _engine.markDirty();
+        }
+    }
+
+    if (_engine.isPending()) {
+        _engine.run(RULE_TICK_BUDGET);
+    }
+}
+
+// ============================================================================
+// Inputs and actions
+// ============================================================================
+
+float AutomationManager::readInput(void* ctx, uint8_t input, float arg) {
+    AutomationManager* self = static_cast<AutomationManager*>(ctx);
+    IrrigationController* ctl = self->_controller;
+
+    if (input <= RULE_IN_TOD) {
+        if (!ctl->hasValidTime()) return NAN;
+        LocalTime local;
+        timeZone.toLocal(ctl->getCurrentTime(), local);
+        switch (input) {
+            case RULE_IN_HOUR:    return local.hour;
+            case RULE_IN_MINUTE:  return local.minute;
+            case RULE_IN_WEEKDAY: return local.weekday;
+            default:              return local.hour * 60 + local.minute;
+        }
+    }
+
+    if (input >= RULE_IN_RUNNING) {
+        if (isnan(arg) || arg < 1 || arg > MAX_CHANNELS) return NAN;
+        uint8_t ch = (uint8_t)arg;
+        float moisture;
+        switch (input) {
+            case RULE_IN_RUNNING:   return ctl->isChannelIrrigating(ch) ? 1 : 0;
+            case RULE_IN_REMAINING: return ctl->getChannelRemaining(ch) / 60.0f;
+            case RULE_IN_MOISTURE:  return ctl->getChannelMoisture(ch, moisture) ? moisture : NAN;
+            default:                return NAN;
+        }
+    }
+
+    switch (input) {
+        case RULE_IN_IRRIGATING: return ctl->isIrrigating() ? 1 : 0;
+        case RULE_IN_ENABLED:    return ctl->isSystemEnabled() ? 1 : 0;
+        case RULE_IN_PRESSURE:
+            return (self->_pressure && self->_pressure->isSensorOk()) ? self->_pressure->getPressure() : NAN;
+        case RULE_IN_PRESSURE_ALARM:
+            return self->_pressure ? self->_pressure->getAlarm() : NAN;
+        case RULE_IN_WIFI:       return WiFi.status() == WL_CONNECTED ? 1 : 0;
+        case RULE_IN_MQTT:       return (self->_ha && self->_ha->isConnected()) ? 1 : 0;
+        default:                 return NAN;
+    }
+}
+
+void AutomationManager::runAction(void* ctx, const Rule& rule) {
+    AutomationManager* self = static_cast<AutomationManager*>(ctx);
+    IrrigationController* ctl = self->_controller;
+    const RuleAction& a = rule.action;
+
+    DEBUG_PRINTF("AutomationManager: Rule '%s' fired: %s\n", rule.name, rule.then);
+    switch (a.op) {
+        case RULE_ACT_START:
+            if (a.target >= 1 && a.target <= MAX_CHANNELS && !ctl->isChannelIrrigating(a.target)) {
+                ctl->startIrrigation(a.target, a.minutes, false);
+            }
+            break;
+        case RULE_ACT_STOP:
+            if (a.target <= MAX_CHANNELS) ctl->stopIrrigation(a.target);
+            break;
+        case RULE_ACT_SKIP:
+            if (a.target < MAX_SCHEDULES) ctl->skipSchedule(a.target);
+            break;
+        case RULE_ACT_ENABLE:
+            ctl->setSystemEnabled(true);
+            break;
+        case RULE_ACT_DISABLE:
+            ctl->setSystemEnabled(false);
+            break;
+    }
+}
+
+// Everything a rule can read, folded into one word (FNV-1a). Moisture is
+// quantized to 1 % and pressure to 5 kPa so sensor noise does not keep the
+// engine busy.
+uint32_t AutomationManager::inputSignature() const {
+    uint32_t h = 2166136261UL;
+    auto mix = [&h](uint32_t v) {
+        for (uint8_t i = 0; i < 4; i++) {
+            h ^= (v >> (8 * i)) & 0xFF;
+            h *= 16777619UL;
+        }
+    };
+
+    mix(_controller->getChannelGeneration());
+    mix(_controller->getScheduleGeneration());
+    mix(_controller->isSystemEnabled());
+    mix((uint32_t)(_controller->getCurrentTime() / 60));
+    mix(WiFi.status() == WL_CONNECTED);
+    mix(_ha && _ha->isConnected());
+    if (_pressure) {
+        mix(_pressure->getAlarm());
+        mix(_pressure->isSensorOk() ? (uint32_t)(_pressure->getPressure() / 5.0f) : 0xFFFFFFFFUL);
+    }
+    for (uint8_t ch = 1; ch <= MAX_CHANNELS; ch++) {
+        float moisture;
+        mix(_controller->getChannelMoisture(ch, moisture) ? (uint32_t)lroundf(moisture) : 0xFFFFFFFFUL);
+    }
+    return h;
+}
+
+// ============================================================================
+// Rule management
+// ============================================================================
+
+int8_t AutomationManager::addRule(const char* name, const char* when, const char* then,
+                                  bool enabled, char* error) {
+    int8_t index = _engine.addRule(name, when, then, enabled, error);
+    if (index >= 0) {
+        _generation++;
+        saveRules();
+    }
+    return index;
+}
+
+bool AutomationManager::replaceRule(uint8_t index, const char* name, const char* when,
+                                    const char* then, bool enabled, char* error) {
+    if (!_engine.replaceRule(index, name, when, then, enabled, error)) return false;
+    _generation++;
+    saveRules();
+    return true;
+}
+
+bool AutomationManager::removeRule(uint8_t index) {
+    if (!_engine.removeRule(index)) return false;
+    _generation++;
+    saveRules();
+    return true;
+}
+
+bool AutomationManager::saveRules() {
+    ArenaJsonDocument doc(4096);
+    JsonArray rules = doc.createNestedArray("rules");
+    for (uint8_t i = 0; i < _engine.getRuleCount(); i++) {
+        const Rule* rule = _engine.getRule(i);
+        JsonObject entry = rules.createNestedObject();
+        entry["name"] = rule->name;
+        entry["when"] = rule->when;
+        entry["then"] = rule->then;
+        entry["enabled"] = rule->enabled;
+    }
+
+    File file = LittleFS.open(RULES_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("AutomationManager: Failed to open rules file for writing");
+        return false;
+    }
+    serializeJson(doc, file);
+    file.close();
+    return true;
+}
+
+bool AutomationManager::loadRules() {
+    if (!LittleFS.exists(RULES_FILE)) {
+        return false;
+    }
+
+    File file = LittleFS.open(RULES_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("AutomationManager: Failed to open rules file");
+        return false;
+    }
+
+    ArenaJsonDocument doc(4096);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        DEBUG_PRINTF("AutomationManager: Failed to parse rules file: %s\n", error.c_str());
+        return false;
+    }
+
+    _engine.clear();
+    char compileError[RULE_ERROR_LEN];
+    for (JsonObject entry : doc["rules"].as<JsonArray>()) {
+        const char* name = entry["name"] | "";
+        if (_engine.addRule(name, entry["when"] | "", entry["then"] | "",
+                            entry["enabled"] | true, compileError) < 0) {
+            // Keep going: one bad rule must not disable the others
+            DEBUG_PRINTF("AutomationManager: Rule '%s' dropped: %s\n", name, compileError);
+        }
+    }
+    return true;
+}
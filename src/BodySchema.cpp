@@ -0,0 +1,337 @@
+#include "BodySchema.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BODY_KEY_MAX     24    // Longer keys cannot be in a schema
+#define BODY_MAX_DEPTH   8     // Nesting skipped inside unknown values
+
+struct Cursor {
+    const char* p;
+    const char* end;
+};
+
+static void skipWs(Cursor& c) {
+    while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\n' || *c.p == '\r')) c.p++;
+}
+
+static bool consume(Cursor& c, const char* literal) {
+    size_t n = strlen(literal);
+    if ((size_t)(c.end - c.p) < n || memcmp(c.p, literal, n) != 0) return false;
+    c.p += n;
+    return true;
+}
+
+static int hexDigit(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+// Reads a string at the opening quote, unescaping into out (if given, up to
+// cap - 1 bytes). overflow is set when the string does not fit.
+static bool readString(Cursor& c, char* out, size_t cap, size_t& len, bool& overflow) {
+    len = 0;
+    overflow = false;
+    if (c.p >= c.end || *c.p != '"') return false;
+    c.p++;
+
+    while (c.p < c.end) {
+        char ch = *c.p++;
+        if (ch == '"') {
+            if (out) out[len < cap ? len : cap - 1] = '\0';
+            return true;
+        }
+        if ((uint8_t)ch < 0x20) return false;
+
+        char utf8[3];
+        uint8_t n = 1;
+        utf8[0] = ch;
+        if (ch == '\\') {
+            if (c.p >= c.end) return false;
+            char esc = *c.p++;
+            switch (esc) {
+                case '"': case '\\': case '/': utf8[0] = esc; break;
+                case 'b': utf8[0] = '\b'; break;
+                case 'f': utf8[0] = '\f'; break;
+                case 'n': utf8[0] = '\n'; break;
+                case 'r': utf8[0] = '\r'; break;
+                case 't': utf8[0] = '\t'; break;
+                case 'u': {
+                    if (c.end - c.p < 4) return false;
+                    uint16_t cp = 0;
+                    for (uint8_t i = 0; i < 4; i++) {
+                        int d = hexDigit(*c.p++);
+                        if (d < 0) return false;
+                        cp = (cp << 4) | d;
+                    }
+                    // Basic plane only; surrogate pairs are not worth the code here
+                    if (cp >= 0xD800 && cp <= 0xDFFF) cp = '?';
+                    if (cp < 0x80) {
+                        utf8[0] = (char)cp;
+                    } else if (cp < 0x800) {
+                        utf8[0] = (char)(0xC0 | (cp >> 6));
+                        utf8[1] = (char)(0x80 | (cp & 0x3F));
+                        n = 2;
+                    } else {
+                        utf8[0] = (char)(0xE0 | (cp >> 12));
+                        utf8[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                        utf8[2] = (char)(0x80 | (cp & 0x3F));
+                        n = 3;
+                    }
+                    break;
+                }
+                default: return false;
+            }
+        }
+
+        if (out) {
+            if (len + n < cap) {
+                memcpy(out + len, utf8, n);
+            } else {
+                overflow = true;
+            }
+        }
+        len += n;
+    }
+    return false;  // Unterminated
+}
+
+// Integer part into value (saturating); integral is false for exponents
+// and non-zero fractions, which no schema field accepts. 10.0 is 10.
+static bool readNumber(Cursor& c, int64_t& value, bool& integral) {
+    bool negative = consume(c, "-");
+    if (c.p >= c.end || *c.p < '0' || *c.p > '9') return false;
+
+    value = 0;
+    while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+        if (value < 10000000000LL) value = value * 10 + (*c.p - '0');
+        c.p++;
+    }
+    if (negative) value = -value;
+
+    integral = true;
+    if (c.p < c.end && *c.p == '.') {
+        c.p++;
+        if (c.p >= c.end || *c.p < '0' || *c.p > '9') return false;
+        while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+            if (*c.p != '0') integral = false;
+            c.p++;
+        }
+    }
+    if (c.p < c.end && (*c.p == 'e' || *c.p == 'E')) {
+        integral = false;
+        c.p++;
+        if (c.p < c.end && (*c.p == '+' || *c.p == '-')) c.p++;
+        if (c.p >= c.end || *c.p < '0' || *c.p > '9') return false;
+        while (c.p < c.end && *c.p >= '0' && *c.p <= '9') c.p++;
+    }
+    return true;
+}
+
+static bool skipValue(Cursor& c, uint8_t depth) {
+    skipWs(c);
+    if (c.p >= c.end) return false;
+
+    size_t len;
+    bool overflow;
+    int64_t number;
+    bool integral;
+    switch (*c.p) {
+        case '"':
+            return readString(c, nullptr, 0, len, overflow);
+        case 't': return consume(c, "true");
+        case 'f': return consume(c, "false");
+        case 'n': return consume(c, "null");
+        case '{':
+        case '[': {
+            if (depth >= BODY_MAX_DEPTH) return false;
+            char close = (*c.p == '{') ? '}' : ']';
+            c.p++;
+            skipWs(c);
+            if (c.p < c.end && *c.p == close) {
+                c.p++;
+                return true;
+            }
+            while (true) {
+                if (close == '}') {
+                    skipWs(c);
+                    if (!readString(c, nullptr, 0, len, overflow)) return false;
+                    skipWs(c);
+                    if (!consume(c, ":")) return false;
+                }
+                if (!skipValue(c, depth + 1)) return false;
+                skipWs(c);
+                if (c.p >= c.end) return false;
+                if (*c.p == close) {
+                    c.p++;
+                    return true;
+                }
+                if (*c.p++ != ',') return false;
+            }
+        }
+        default:
+            return readNumber(c, number, integral);
+    }
+}
+
+static void storeInt(uint8_t* member, uint8_t size, int64_t value) {
+    switch (size) {
+        case 1: *(uint8_t*)member = (uint8_t)value; break;
+        case 2: *(uint16_t*)member = (uint16_t)value; break;
+        default: *(uint32_t*)member = (uint32_t)value; break;
+    }
+}
+
+BodyResult BodySchema::parse(const char* body, size_t length,
+                             const BodyField* fields, uint8_t count, void* out) {
+    BodyResult result = { BODY_OK, 0, 0 };
+    Cursor c = { body, body + length };
+
+    skipWs(c);
+    if (!consume(c, "{")) {
+        result.status = BODY_ERR_SYNTAX;
+        return result;
+    }
+    skipWs(c);
+    bool empty = consume(c, "}");
+
+    while (!empty) {
+        char key[BODY_KEY_MAX];
+        size_t keyLen;
+        bool keyOverflow;
+        skipWs(c);
+        if (!readString(c, key, sizeof(key), keyLen, keyOverflow)) {
+            result.status = BODY_ERR_SYNTAX;
+            return result;
+        }
+        skipWs(c);
+        if (!consume(c, ":")) {
+            result.status = BODY_ERR_SYNTAX;
+            return result;
+        }
+        skipWs(c);
+
+        int8_t index = -1;
+        for (uint8_t i = 0; !keyOverflow && i < count; i++) {
+            if (strcmp(key, fields[i].key) == 0) {
+                index = i;
+                break;
+            }
+        }
+
+        if (index < 0 || consume(c, "null")) {
+            if (index < 0 && !skipValue(c, 0)) {
+                result.status = BODY_ERR_SYNTAX;
+                return result;
+            }
+        } else {
+            const BodyField& field = fields[index];
+            uint8_t* member = (uint8_t*)out + field.offset;
+            result.field = index;
+
+            if (field.type == BODY_INT) {
+                int64_t value;
+                bool integral;
+                if (c.p >= c.end || (*c.p != '-' && (*c.p < '0' || *c.p > '9'))) {
+                    result.status = skipValue(c, 0) ? BODY_ERR_TYPE : BODY_ERR_SYNTAX;
+                    return result;
+                }
+                if (!readNumber(c, value, integral)) {
+                    result.status = BODY_ERR_SYNTAX;
+                    return result;
+                }
+                if (!integral) {
+                    result.status = BODY_ERR_TYPE;
+                    return result;
+                }
+                if (value < field.min || value > field.max) {
+                    result.status = BODY_ERR_RANGE;
+                    return result;
+                }
+                storeInt(member, field.size, value);
+            } else if (field.type == BODY_BOOL) {
+                if (consume(c, "true")) {
+                    *(bool*)member = true;
+                } else if (consume(c, "false")) {
+                    *(bool*)member = false;
+                } else {
+                    result.status = skipValue(c, 0) ? BODY_ERR_TYPE : BODY_ERR_SYNTAX;
+                    return result;
+                }
+            } else {
+                size_t len;
+                bool overflow;
+                if (c.p >= c.end || *c.p != '"') {
+                    result.status = skipValue(c, 0) ? BODY_ERR_TYPE : BODY_ERR_SYNTAX;
+                    return result;
+                }
+                if (!readString(c, (char*)member, field.size, len, overflow)) {
+                    result.status = BODY_ERR_SYNTAX;
+                    return result;
+                }
+                if (overflow || (int32_t)len < field.min) {
+                    result.status = BODY_ERR_LENGTH;
+                    return result;
+                }
+            }
+            result.present |= 1UL << index;
+        }
+
+        skipWs(c);
+        if (consume(c, "}")) break;
+        if (!consume(c, ",")) {
+            result.status = BODY_ERR_SYNTAX;
+            return result;
+        }
+    }
+
+    skipWs(c);
+    if (c.p != c.end) {
+        result.status = BODY_ERR_SYNTAX;
+        return result;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (fields[i].required && !(result.present & (1UL << i))) {
+            result.status = BODY_ERR_MISSING;
+            result.field = i;
+            return result;
+        }
+    }
+    result.field = 0;
+    return result;
+}
+
+void BodySchema::formatError(const BodyResult& result, const BodyField* fields,
+                             char* buffer, size_t size) {
+    const BodyField& field = fields[result.field];
+    switch (result.status) {
+        case BODY_OK:
+            snprintf(buffer, size, "OK");
+            break;
+        case BODY_ERR_MISSING:
+            snprintf(buffer, size, "%s is required", field.key);
+            break;
+        case BODY_ERR_TYPE:
+            snprintf(buffer, size, "%s must be %s", field.key,
+                     field.type == BODY_INT ? "an integer" :
+                     field.type == BODY_BOOL ? "true or false" : "a string");
+            break;
+        case BODY_ERR_RANGE:
+            snprintf(buffer, size, "%s must be %ld-%ld", field.key,
+                     (long)field.min, (long)field.max);
+            break;
+        case BODY_ERR_LENGTH:
+            if (field.min > 0) {
+                snprintf(buffer, size, "%s must be %ld-%d characters", field.key,
+                         (long)field.min, field.size - 1);
+            } else {
+                snprintf(buffer, size, "%s must be at most %d characters", field.key, field.size - 1);
+            }
+            break;
+        default:
+            snprintf(buffer, size, "Invalid JSON");
+            break;
+    }
+}
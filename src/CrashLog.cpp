@@ -0,0 +1,227 @@
+#include "CrashLog.h"
+#include "Config.h"
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include "JsonArena.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_partition.h>
+#include <esp_core_dump.h>
+
+#define CRASH_RTC_MAGIC 0x43524C47  // "CRLG"
+
+struct CrashRing {
+    uint32_t head;             // Next write position
+    uint32_t len;              // Valid bytes, up to CRASH_LOG_SIZE
+    uint32_t lastMillis;       // millis() of the newest line: uptime at the crash
+};
+
+// Not cleared at reset; validated by the magic and bounds checks in startRing()
+struct CrashRtc {
+    uint32_t magic;
+    uint32_t bootCount;
+    uint32_t active;           // Ring this boot writes to
+    CrashRing ring[2];
+    char buf[2][CRASH_LOG_SIZE];
+};
+
+RTC_NOINIT_ATTR static CrashRtc rtcLog;
+
+// Plain statics rather than members: constant-initialized, so they are valid
+// even if another global's constructor prints before crashLog is constructed
+static bool ringStarted = false;
+static portMUX_TYPE ringLock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool isCrashReset(esp_reset_reason_t reason) {
+    return reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+           reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT ||
+           reason == ESP_RST_BROWNOUT;
+}
+
+// First write or begin(), whichever comes first: switch to the other ring so
+// the crashed boot's tail is left alone until begin() has saved it
+static void startRing() {
+    ringStarted = true;
+    esp_reset_reason_t reason = esp_reset_reason();
+
+    bool valid = rtcLog.magic == CRASH_RTC_MAGIC && rtcLog.active <= 1;
+    for (uint8_t i = 0; valid && i < 2; i++) {
+        valid = rtcLog.ring[i].head < CRASH_LOG_SIZE && rtcLog.ring[i].len <= CRASH_LOG_SIZE;
+    }
+
+    if (!valid || reason == ESP_RST_POWERON) {
+        memset(&rtcLog, 0, sizeof(rtcLog));
+        rtcLog.magic = CRASH_RTC_MAGIC;
+    } else {
+        rtcLog.active ^= 1;
+    }
+    rtcLog.bootCount++;
+    memset(&rtcLog.ring[rtcLog.active], 0, sizeof(CrashRing));
+}
+
+CrashLog::CrashLog()
+    : _wasCrash(false),
+      _crashCount(0),
+      _coreDumpAddr(0) {
+    memset(&_coreDump, 0, sizeof(_coreDump));
+}
+
+void CrashLog::begin() {
+    if (!ringStarted) startRing();
+    _wasCrash = isCrashReset(esp_reset_reason());
+
+    if (LittleFS.exists(CRASH_FILE)) {
+        File file = LittleFS.open(CRASH_FILE, "r");
+        if (file) {
+            StaticJsonDocument<64> filter;
+            filter["crashes"] = true;
+            StaticJsonDocument<64> doc;
+            if (!deserializeJson(doc, file, DeserializationOption::Filter(filter))) {
+                _crashCount = doc["crashes"] | 0;
+            }
+            file.close();
+        }
+    }
+
+    loadCoreDump();
+
+    if (_wasCrash) {
+        _crashCount++;
+        saveCrash();
+        DEBUG_PRINTF("CrashLog: Reset by %s (crash #%lu)%s\n", getResetReason(),
+                     (unsigned long)_crashCount, _coreDump.present ? ", core dump in flash" : "");
+    }
+}
+
+size_t CrashLog::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t CrashLog::write(const uint8_t* buffer, size_t size) {
+    if (!ringStarted) startRing();
+    Serial.write(buffer, size);
+
+    // Only the tail of an oversized write fits
+    if (size > CRASH_LOG_SIZE) {
+        buffer += size - CRASH_LOG_SIZE;
+        size = CRASH_LOG_SIZE;
+    }
+
+    portENTER_CRITICAL(&ringLock);
+    CrashRing& ring = rtcLog.ring[rtcLog.active];
+    char* buf = rtcLog.buf[rtcLog.active];
+    size_t first = CRASH_LOG_SIZE - ring.head;
+    if (first > size) first = size;
+    memcpy(buf + ring.head, buffer, first);
+    memcpy(buf, buffer + first, size - first);
+    ring.head = (ring.head + size) % CRASH_LOG_SIZE;
+    ring.len = (ring.len + size > CRASH_LOG_SIZE) ? CRASH_LOG_SIZE : ring.len + size;
+    ring.lastMillis = millis();
+    portEXIT_CRITICAL(&ringLock);
+    return size;
+}
+
+const char* CrashLog::getResetReason() const {
+    switch (esp_reset_reason()) {
+        case ESP_RST_POWERON:   return "poweron";
+        case ESP_RST_EXT:       return "external";
+        case ESP_RST_SW:        return "software";
+        case ESP_RST_PANIC:     return "panic";
+        case ESP_RST_INT_WDT:   return "int_wdt";
+        case ESP_RST_TASK_WDT:  return "task_wdt";
+        case ESP_RST_WDT:       return "wdt";
+        case ESP_RST_DEEPSLEEP: return "deepsleep";
+        case ESP_RST_BROWNOUT:  return "brownout";
+        case ESP_RST_SDIO:      return "sdio";
+        default:                return "unknown";
+    }
+}
+
+uint32_t CrashLog::getBootCount() const {
+    return rtcLog.bootCount;
+}
+
+// The previous boot's ring, oldest byte first
+void CrashLog::saveCrash() {
+    const CrashRing& ring = rtcLog.ring[rtcLog.active ^ 1];
+    const char* buf = rtcLog.buf[rtcLog.active ^ 1];
+    char* tail = (char*)malloc(ring.len + 1);
+    if (!tail) return;
+    size_t start = (ring.len < CRASH_LOG_SIZE) ? 0 : ring.head;
+    for (size_t i = 0; i < ring.len; i++) {
+        char c = buf[(start + i) % CRASH_LOG_SIZE];
+        tail[i] = c ? c : ' ';
+    }
+    tail[ring.len] = '\0';
+
+    StaticJsonDocument<256> doc;
+    doc["crashes"] = _crashCount;
+    doc["reason"] = getResetReason();
+    doc["uptime_s"] = ring.lastMillis / 1000;
+    doc["log"] = (const char*)tail;
+
+    File file = LittleFS.open(CRASH_FILE, "w");
+    if (file) {
+        serializeJson(doc, file);
+        file.close();
+    } else {
+        DEBUG_PRINTLN("CrashLog: Failed to open crash.json for writing");
+    }
+    free(tail);
+}
+
+void CrashLog::loadCoreDump() {
+    memset(&_coreDump, 0, sizeof(_coreDump));
+#if CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH
+    size_t addr = 0, size = 0;
+    if (esp_core_dump_image_get(&addr, &size) != ESP_OK) return;
+    _coreDump.present = true;
+    _coreDump.size = size;
+    _coreDumpAddr = addr;
+
+#if CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF
+    esp_core_dump_summary_t summary;
+    if (esp_core_dump_get_summary(&summary) != ESP_OK) return;
+    strncpy(_coreDump.task, summary.exc_task, sizeof(_coreDump.task) - 1);
+    _coreDump.pc = summary.exc_pc;
+#ifdef __XTENSA__
+    uint8_t depth = summary.exc_bt_info.depth;
+    if (depth > CRASH_BACKTRACE_MAX) depth = CRASH_BACKTRACE_MAX;
+    memcpy(_coreDump.backtrace, summary.exc_bt_info.bt, depth * sizeof(uint32_t));
+    _coreDump.depth = depth;
+    _coreDump.corrupted = summary.exc_bt_info.corrupted;
+#endif
+    strncpy(_coreDump.appSha, (const char*)summary.app_elf_sha256, sizeof(_coreDump.appSha) - 1);
+#endif
+#endif
+}
+
+bool CrashLog::readCoreDump(uint32_t offset, uint8_t* buffer, size_t size) const {
+    if (!_coreDump.present || offset + size > _coreDump.size) return false;
+    const esp_partition_t* part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_COREDUMP, NULL);
+    if (!part) return false;
+    return esp_partition_read(part, _coreDumpAddr - part->address + offset, buffer, size) == ESP_OK;
+}
+
+void CrashLog::clear() {
+    if (_coreDump.present) {
+        const esp_partition_t* part = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_COREDUMP, NULL);
+        if (part) {
+            // Only the sectors the image used; the rest is still erased
+            uint32_t used = (_coreDumpAddr - part->address + _coreDump.size + 4095) & ~4095UL;
+            if (used > part->size) used = part->size;
+            esp_partition_erase_range(part, 0, used);
+        }
+        memset(&_coreDump, 0, sizeof(_coreDump));
+    }
+
+    StaticJsonDocument<64> doc;
+    doc["crashes"] = _crashCount;
+    File file = LittleFS.open(CRASH_FILE, "w");
+    if (file) {
+        serializeJson(doc, file);
+        file.close();
+    }
+}
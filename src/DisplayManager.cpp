@@ -1,4 +1,5 @@
 #include "DisplayManager.h"
+#include "TimeZone.h"
 #include <time.h>
 #include <WiFi.h>
 
@@ -118,8 +119,8 @@ void DisplayManager::drawStatusScreen() {
     // Get current time
     time_t now;
     time(&now);
-    struct tm timeinfo;
-    localtime_r(&now, &timeinfo);
+    LocalTime local;
+    timeZone.toLocal(now, local);
 
     char line1[17];
     char line2[17];
@@ -133,20 +134,15 @@ void DisplayManager::drawStatusScreen() {
     const char* days[] = {"Sun","Mon","Tue","Wed","Thu","Fri","Sat"};
     bool wifiOk = (WiFi.status() == WL_CONNECTED);
     snprintf(line1, 17, "%02d:%02d %s  %s ",
-        timeinfo.tm_hour, timeinfo.tm_min,
-        days[timeinfo.tm_wday],
+        local.hour, local.minute,
+        days[local.weekday],
         wifiOk ? "[*]" : "[ ]");
 
     // Line 2: Status - either running or next schedule
     if (status.irrigating) {
         // Find which channel is running
-        int runningCh = 1;
-        for (int i = 0; i < MAX_CHANNELS; i++) {
-            if (status.channelIrrigating[i]) {
-                runningCh = i + 1;
-                break;
-            }
-        }
+        uint64_t running = status.channelIrrigating.bits();
+        int runningCh = running ? __builtin_ctzll(running) + 1 : 1;
         unsigned long remaining = _controller->getTimeRemaining();
         unsigned long mins = remaining / 60000;
         unsigned long secs = (remaining % 60000) / 1000;
@@ -156,11 +152,10 @@ void DisplayManager::drawStatusScreen() {
         uint8_t nextCh = 0;
         unsigned long nextTime = _controller->getNextScheduledTime(&nextCh);
         if (nextTime > 0) {
-            struct tm nextInfo;
-            time_t nt = (time_t)nextTime;
-            localtime_r(&nt, &nextInfo);
+            LocalTime nextLocal;
+            timeZone.toLocal((time_t)nextTime, nextLocal);
             snprintf(line2, 17, "Nxt Ch%d %02d:%02d  ",
-                nextCh, nextInfo.tm_hour, nextInfo.tm_min);
+                nextCh, nextLocal.hour, nextLocal.minute);
         } else {
             // Check if any schedules are skipped vs none existing
             bool anySkipped = false;
@@ -542,13 +537,13 @@ String DisplayManager::formatTime(time_t time) {
         return "N/A";
     }
 
-    struct tm timeinfo;
-    localtime_r(&time, &timeinfo);
+    LocalTime local;
+    timeZone.toLocal(time, local);
 
     char buffer[20];
     sprintf(buffer, "%02d/%02d %02d:%02d",
-            timeinfo.tm_mon + 1, timeinfo.tm_mday,
-            timeinfo.tm_hour, timeinfo.tm_min);
+            local.month, local.day,
+            local.hour, local.minute);
 
     return String(buffer);
 }
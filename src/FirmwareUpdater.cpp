@@ -0,0 +1,327 @@
+#include "FirmwareUpdater.h"
+
+static String githubUrl(const char* path) {
+    String url = "https://raw.githubusercontent.com/";
+    url += GITHUB_REPO_OWNER;
+    url += "/";
+    url += GITHUB_REPO_NAME;
+    url += "/main/";
+    url += path;
+    return url;
+}
+
+FirmwareUpdater::FirmwareUpdater()
+    : _lock(portMUX_INITIALIZER_UNLOCKED),
+      _status(),
+      _busy(false),
+      _rebootAt(0) {
+    memset(_expect, 0, sizeof(_expect));
+}
+
+void FirmwareUpdater::begin() {
+    loadCache();
+}
+
+const char* FirmwareUpdater::stateName(uint8_t state) {
+    switch (state) {
+        case OTA_CHECKING:    return "checking";
+        case OTA_UP_TO_DATE:  return "up_to_date";
+        case OTA_AVAILABLE:   return "available";
+        case OTA_DOWNLOADING: return "downloading";
+        case OTA_REBOOTING:   return "rebooting";
+        case OTA_FAILED:      return "failed";
+        default:              return "idle";
+    }
+}
+
+OtaStatus FirmwareUpdater::getStatus() const {
+    portENTER_CRITICAL(&_lock);
+    OtaStatus copy = _status;
+    portEXIT_CRITICAL(&_lock);
+    return copy;
+}
+
+void FirmwareUpdater::setState(uint8_t state, const char* error) {
+    portENTER_CRITICAL(&_lock);
+    _status.state = state;
+    if (state == OTA_DOWNLOADING) _status.progress = 0;
+    if (error) {
+        strncpy(_status.error, error, sizeof(_status.error) - 1);
+        _status.error[sizeof(_status.error) - 1] = '\0';
+    } else if (state == OTA_CHECKING) {
+        _status.error[0] = '\0';
+    }
+    _status.generation++;
+    portEXIT_CRITICAL(&_lock);
+
+    DEBUG_PRINTF("FirmwareUpdater: %s%s%s\n", stateName(state), error ? " - " : "", error ? error : "");
+}
+
+void FirmwareUpdater::setProgress(uint8_t progress) {
+    portENTER_CRITICAL(&_lock);
+    _status.progress = progress;
+    _status.generation++;
+    portEXIT_CRITICAL(&_lock);
+}
+
+bool FirmwareUpdater::start(bool install, const char* expect) {
+    if (_busy || _status.state == OTA_REBOOTING) return false;
+    if (WiFi.status() != WL_CONNECTED) {
+        setState(OTA_FAILED, "Not connected to WiFi");
+        return false;
+    }
+
+    _busy = true;
+    strncpy(_expect, expect ? expect : "", sizeof(_expect) - 1);
+    _expect[sizeof(_expect) - 1] = '\0';
+    portENTER_CRITICAL(&_lock);
+    _status.install = install;
+    portEXIT_CRITICAL(&_lock);
+    setState(OTA_CHECKING);
+
+    // Loop priority and unpinned: on dual-core boards the job mostly runs
+    // beside the loop, on the C3 it time-slices with it
+    if (xTaskCreate(jobTask, "ota", OTA_TASK_STACK, this, 1, nullptr) != pdPASS) {
+        _busy = false;
+        setState(OTA_FAILED, "No memory for the update task");
+        return false;
+    }
+    return true;
+}
+
+void FirmwareUpdater::update() {
+    if (_status.state != OTA_REBOOTING) return;
+
+    if (_rebootAt == 0) {
+        _rebootAt = millis();
+    } else if (millis() - _rebootAt >= OTA_RESTART_DELAY) {
+        DEBUG_PRINTLN("FirmwareUpdater: Restarting into the new firmware");
+        delay(100);
+        ESP.restart();
+    }
+}
+
+void FirmwareUpdater::jobTask(void* arg) {
+    FirmwareUpdater* self = static_cast<FirmwareUpdater*>(arg);
+    self->runJob();
+    self->_busy = false;
+    vTaskDelete(nullptr);
+}
+
+void FirmwareUpdater::runJob() {
+    String latest;
+    String error;
+    bool notModified = false;
+    if (!checkVersion(latest, notModified, error)) {
+        setState(OTA_FAILED, error.c_str());
+        return;
+    }
+
+    portENTER_CRITICAL(&_lock);
+    _status.notModified = notModified;
+    _status.checkedAt = millis();
+    bool install = _status.install;
+    portEXIT_CRITICAL(&_lock);
+
+    DEBUG_PRINTF("FirmwareUpdater: Latest version: %s%s, Current: %s\n",
+                 latest.c_str(), notModified ? " (not modified)" : "", VERSION);
+
+    if (latest == VERSION) {
+        setState(OTA_UP_TO_DATE);
+        return;
+    }
+    if (!install) {
+        setState(OTA_AVAILABLE);
+        return;
+    }
+    if (_expect[0] && latest != _expect) {
+        // A newer release landed mid-rollout; it gets a rollout of its own
+        char why[sizeof(_status.error)];
+        snprintf(why, sizeof(why), "Release is now %s, not %s", latest.c_str(), _expect);
+        setState(OTA_FAILED, why);
+        return;
+    }
+
+    setState(OTA_DOWNLOADING);
+    if (download(error)) {
+        setState(OTA_REBOOTING);
+    } else {
+        setState(OTA_FAILED, error.c_str());
+    }
+}
+
+// Conditional GET of the version file: a 304 means the version cached with
+// the validators still stands
+bool FirmwareUpdater::checkVersion(String& latest, bool& notModified, String& error) {
+    HTTPClient http;
+    WiFiClientSecure client;
+    client.setInsecure();  // Skip cert validation for GitHub
+
+    String url = githubUrl(GITHUB_VERSION_PATH);
+    DEBUG_PRINTF("FirmwareUpdater: Checking version at: %s\n", url.c_str());
+
+    http.begin(client, url);
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    static const char* validators[] = { "ETag", "Last-Modified" };
+    http.collectHeaders(validators, 2);
+
+    String cached = getStatus().latest;
+    if (cached.length() > 0) {
+        if (_etag.length() > 0) http.addHeader("If-None-Match", _etag);
+        if (_lastModified.length() > 0) http.addHeader("If-Modified-Since", _lastModified);
+    }
+
+    int httpCode = http.GET();
+    if (httpCode == HTTP_CODE_NOT_MODIFIED && cached.length() > 0) {
+        http.end();
+        latest = cached;
+        notModified = true;
+        return true;
+    }
+    if (httpCode != HTTP_CODE_OK) {
+        error = "Version check failed: " + (httpCode < 0 ? http.errorToString(httpCode) : "HTTP " + String(httpCode));
+        http.end();
+        return false;
+    }
+
+    latest = http.getString();
+    latest.trim();
+    _etag = http.header("ETag");
+    _lastModified = http.header("Last-Modified");
+    http.end();
+
+    if (latest.length() == 0 || latest.length() >= sizeof(_status.latest)) {
+        error = "Version file is empty or too long";
+        return false;
+    }
+    notModified = false;
+
+    portENTER_CRITICAL(&_lock);
+    strncpy(_status.latest, latest.c_str(), sizeof(_status.latest) - 1);
+    portEXIT_CRITICAL(&_lock);
+    saveCache();
+    return true;
+}
+
+bool FirmwareUpdater::download(String& error) {
+    HTTPClient http;
+    WiFiClientSecure client;
+    client.setInsecure();  // Skip cert validation for GitHub
+
+    String url = githubUrl(GITHUB_FIRMWARE_PATH);
+    DEBUG_PRINTF("FirmwareUpdater: Downloading firmware from: %s\n", url.c_str());
+
+    http.begin(client, url);
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    http.setTimeout(60000);  // 60s timeout for large file
+
+    DEBUG_PRINTF("FirmwareUpdater: Free heap before download: %d\n", ESP.getFreeHeap());
+
+    int httpCode = http.GET();
+    if (httpCode != HTTP_CODE_OK) {
+        error = "Download failed: " + (httpCode < 0 ? http.errorToString(httpCode) : "HTTP " + String(httpCode));
+        http.end();
+        return false;
+    }
+
+    int contentLength = http.getSize();
+    if (contentLength <= 0) {
+        error = "No Content-Length on the firmware";
+        http.end();
+        return false;
+    }
+
+    if (!Update.begin(contentLength)) {
+        error = "Not enough space for " + String(contentLength) + " bytes";
+        http.end();
+        return false;
+    }
+
+    WiFiClient* stream = http.getStreamPtr();
+    DEBUG_PRINTF("FirmwareUpdater: Starting firmware write, size: %d bytes\n", contentLength);
+
+    uint8_t buf[1024];
+    size_t written = 0;
+    uint8_t lastPct = 0;
+
+    while (written < (size_t)contentLength) {
+        size_t available = stream->available();
+        if (available == 0) {
+            // Wait for data with timeout
+            unsigned long waitStart = millis();
+            while (!stream->available() && (millis() - waitStart < 10000)) {
+                delay(10);
+            }
+            if (!stream->available()) {
+                error = "Download stalled";
+                break;
+            }
+            continue;
+        }
+
+        size_t toRead = (available > sizeof(buf)) ? sizeof(buf) : available;
+        size_t bytesRead = stream->readBytes(buf, toRead);
+        if (bytesRead == 0) break;
+
+        size_t bytesWritten = Update.write(buf, bytesRead);
+        if (bytesWritten != bytesRead) {
+            error = "Flash write failed";
+            break;
+        }
+        written += bytesWritten;
+
+        uint8_t pct = (uint8_t)((written * 100) / contentLength);
+        if (pct != lastPct) {
+            setProgress(pct);
+            if (pct % 10 == 0) {
+                DEBUG_PRINTF("FirmwareUpdater: OTA progress: %d%% (%d / %d bytes)\n", pct, written, contentLength);
+            }
+            lastPct = pct;
+        }
+    }
+    http.end();
+
+    if (written < (size_t)contentLength) {
+        Update.abort();
+        if (error.length() == 0) error = "Download ended early";
+        return false;
+    }
+    if (!Update.end() || !Update.isFinished()) {
+        error = String("Update failed: ") + Update.errorString();
+        return false;
+    }
+
+    DEBUG_PRINTLN("FirmwareUpdater: Update successfully completed");
+    return true;
+}
+
+bool FirmwareUpdater::loadCache() {
+    File file = LittleFS.open(OTA_CACHE_FILE, "r");
+    if (!file) return false;
+
+    StaticJsonDocument<256> doc;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error) return false;
+
+    _etag = doc["etag"] | "";
+    _lastModified = doc["last_modified"] | "";
+    strncpy(_status.latest, doc["latest"] | "", sizeof(_status.latest) - 1);
+    return true;
+}
+
+bool FirmwareUpdater::saveCache() {
+    StaticJsonDocument<256> doc;
+    doc["etag"] = _etag;
+    doc["last_modified"] = _lastModified;
+    doc["latest"] = getStatus().latest;
+
+    File file = LittleFS.open(OTA_CACHE_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("FirmwareUpdater: Failed to save " OTA_CACHE_FILE);
+        return false;
+    }
+    serializeJson(doc, file);
+    file.close();
+    return true;
+}
@@ -0,0 +1,24 @@
+#include "ForecastMerge.h"
+
+void ForecastCursor::begin(const TimeZone& zone, const ForecastSlot* slots, uint8_t slotCount,
+                           time_t now, uint16_t days) {
+    count = (slotCount < FORECAST_MAX_SLOTS) ? slotCount : FORECAST_MAX_SLOTS;
+    until = now + (time_t)days * 86400;
+    for (uint8_t i = 0; i < count; i++) {
+        slot[i] = slots[i];
+        next[i] = zone.nextLocal(now, slot[i].hour, slot[i].minute, slot[i].weekdays);
+    }
+}
+
+int8_t ForecastCursor::advance(const TimeZone& zone, time_t& start) {
+    int8_t best = -1;
+    for (uint8_t i = 0; i < count; i++) {
+        if (next[i] == 0) continue;
+        if (best < 0 || next[i] < next[best]) best = i;
+    }
+    if (best < 0 || next[best] > until) return -1;
+
+    start = next[best];
+    next[best] = zone.nextLocal(start, slot[best].hour, slot[best].minute, slot[best].weekdays);
+    return best;
+}
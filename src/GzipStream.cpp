@@ -0,0 +1,205 @@
+#include "GzipStream.h"
+#include <string.h>
+
+// RFC 1951 length and distance code bases and extra bits
+static const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// CRC-32 a nibble at a time: 64 bytes of table instead of 1 KB
+static const uint32_t CRC_NIBBLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t crcUpdate(uint32_t crc, const uint8_t* data, size_t length) {
+    while (length--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+    }
+    return crc;
+}
+
+GzipStream::GzipStream()
+    : _sink(nullptr),
+      _context(nullptr),
+      _fill(0),
+      _pos(0),
+      _outLength(0),
+      _bits(0),
+      _bitCount(0),
+      _crc(0),
+      _inputBytes(0),
+      _outputBytes(0) {
+}
+
+void GzipStream::begin(GzipSink sink, void* context) {
+    _sink = sink;
+    _context = context;
+    _fill = 0;
+    _pos = 0;
+    _outLength = 0;
+    _bits = 0;
+    _bitCount = 0;
+    _crc = 0xFFFFFFFFUL;
+    _inputBytes = 0;
+    _outputBytes = 0;
+    memset(_heads, 0, sizeof(_heads));
+
+    // Member header: deflate, no name, no mtime, unknown OS
+    static const uint8_t header[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 255 };
+    for (uint8_t i = 0; i < sizeof(header); i++) putByte(header[i]);
+
+    // One final fixed-Huffman block carries the whole stream
+    putBits(1, 1);
+    putBits(1, 2);
+}
+
+void GzipStream::write(const uint8_t* data, size_t length) {
+    _crc = crcUpdate(_crc, data, length);
+    _inputBytes += length;
+
+    while (length > 0) {
+        size_t room = sizeof(_buffer) - _fill;
+        size_t n = length < room ? length : room;
+        memcpy(_buffer + _fill, data, n);
+        _fill += n;
+        data += n;
+        length -= n;
+
+        if (_fill == sizeof(_buffer)) {
+            compress(false);
+            slide();
+        }
+    }
+}
+
+void GzipStream::finish() {
+    compress(true);
+    putCode(0, 7);                      // End of block (256)
+    if (_bitCount > 0) putBits(0, 8 - _bitCount);
+
+    uint32_t crc = _crc ^ 0xFFFFFFFFUL;
+    for (uint8_t i = 0; i < 4; i++) putByte(crc >> (8 * i));
+    for (uint8_t i = 0; i < 4; i++) putByte(_inputBytes >> (8 * i));
+    flushOutput();
+}
+
+uint16_t GzipStream::hash(const uint8_t* p) {
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (uint16_t)((uint32_t)(v * 2654435761UL) >> (32 - GZIP_HASH_BITS));
+}
+
+// Encodes from _pos, keeping GZIP_MAX_MATCH bytes of lookahead unless
+// flushing at the end of the stream
+void GzipStream::compress(bool flush) {
+    while (_pos < _fill && (flush || _fill - _pos >= GZIP_MAX_MATCH)) {
+        uint16_t available = _fill - _pos;
+        if (available >= GZIP_MIN_MATCH) {
+            uint16_t h = hash(_buffer + _pos);
+            uint16_t candidate = _heads[h];
+            _heads[h] = _pos + 1;
+
+            if (candidate && _pos - (candidate - 1) <= GZIP_WINDOW) {
+                const uint8_t* a = _buffer + _pos;
+                const uint8_t* b = _buffer + candidate - 1;
+                uint16_t limit = available < GZIP_MAX_MATCH ? available : GZIP_MAX_MATCH;
+                uint16_t length = 0;
+                while (length < limit && a[length] == b[length]) length++;
+
+                if (length >= GZIP_MIN_MATCH) {
+                    putMatch(length, _pos - (candidate - 1));
+                    // Index the matched bytes too, so later repeats can refer to them
+                    for (uint16_t i = 1; i < length && _pos + i + GZIP_MIN_MATCH <= _fill; i++) {
+                        _heads[hash(_buffer + _pos + i)] = _pos + i + 1;
+                    }
+                    _pos += length;
+                    continue;
+                }
+            }
+        }
+        putLiteral(_buffer[_pos++]);
+    }
+}
+
+// Drops the older window; with GZIP_MAX_MATCH lookahead left, _pos is
+// always past it
+void GzipStream::slide() {
+    memmove(_buffer, _buffer + GZIP_WINDOW, _fill - GZIP_WINDOW);
+    _fill -= GZIP_WINDOW;
+    _pos -= GZIP_WINDOW;
+    for (uint16_t i = 0; i < (1 << GZIP_HASH_BITS); i++) {
+        _heads[i] = _heads[i] > GZIP_WINDOW ? _heads[i] - GZIP_WINDOW : 0;
+    }
+}
+
+void GzipStream::putBits(uint32_t value, uint8_t count) {
+    _bits |= value << _bitCount;
+    _bitCount += count;
+    while (_bitCount >= 8) {
+        putByte(_bits & 0xFF);
+        _bits >>= 8;
+        _bitCount -= 8;
+    }
+}
+
+// Huffman codes are packed starting from their most significant bit
+void GzipStream::putCode(uint16_t code, uint8_t length) {
+    uint16_t reversed = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    putBits(reversed, length);
+}
+
+void GzipStream::putLiteral(uint8_t value) {
+    if (value < 144) {
+        putCode(0x30 + value, 8);
+    } else {
+        putCode(0x190 + (value - 144), 9);
+    }
+}
+
+void GzipStream::putMatch(uint16_t length, uint16_t distance) {
+    uint8_t code = 28;
+    while (LENGTH_BASE[code] > length) code--;
+    uint16_t symbol = 257 + code;
+    if (symbol < 280) {
+        putCode(symbol - 256, 7);
+    } else {
+        putCode(0xC0 + (symbol - 280), 8);
+    }
+    putBits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+    uint8_t dcode = 29;
+    while (DIST_BASE[dcode] > distance) dcode--;
+    putCode(dcode, 5);
+    putBits(distance - DIST_BASE[dcode], DIST_EXTRA[dcode]);
+}
+
+void GzipStream::putByte(uint8_t value) {
+    _out[_outLength++] = value;
+    if (_outLength == sizeof(_out)) flushOutput();
+}
+
+void GzipStream::flushOutput() {
+    if (_outLength == 0) return;
+    _outputBytes += _outLength;
+    if (_sink) _sink(_context, _out, _outLength);
+    _outLength = 0;
+}
@@ -1,5 +1,7 @@
 #include "HomeAssistantIntegration.h"
 #include "NodeManager.h"
+#include "PressureMonitor.h"
+#include "FirmwareUpdater.h"
 
 // Static instance pointer for callback
 HomeAssistantIntegration* HomeAssistantIntegration::_instance = nullptr;
@@ -8,18 +10,29 @@ HomeAssistantIntegration::HomeAssistantIntegration(IrrigationController* control
                                                    NodeManager* nodeManager)
     : _controller(controller),
       _nodeManager(nodeManager),
-      _wifiClient(nullptr),
+      _pressureMonitor(nullptr),
+      _updater(nullptr),
+      _manualInstall(true),
+      _netClient(nullptr),
       _mqttClient(nullptr),
       _port(MQTT_PORT),
+      _tls(false),
+      _caCert(nullptr),
       _lastReconnectAttempt(0),
+      _reconnectInterval(MQTT_RECONNECT_INTERVAL),
       _lastStatusUpdate(0),
       _lastDiscoveredCount(0),
       _systemEnabled(true),
       _currentMode("auto"),
       _lastIrrigatingState(false),
       _lastFastStatusUpdate(0),
+      _forecastGeneration(0),
+      _lastForecastPublish(0),
+      _updateGeneration(0),
       _needsDiscoveryPublish(true),
-      _lastDiscoveryVersion("") {
+      _lastDiscoveryVersion(""),
+      _cmdCount(0),
+      _statePublishPending(false) {
 
     _instance = this;
 
@@ -29,6 +42,12 @@ HomeAssistantIntegration::HomeAssistantIntegration(IrrigationController* control
         _retryPending[i] = false;
         _commandSentTime[i] = 0;
     }
+    for (uint8_t i = 0; i < MAX_GROUPS; i++) {
+        _discoveredGroups[i] = false;
+    }
+    memset(_discoveredNodes, 0, sizeof(_discoveredNodes));
+    memset(&_cmdStats, 0, sizeof(_cmdStats));
+    memset(&_connStats, 0, sizeof(_connStats));
 }
 
 HomeAssistantIntegration::~HomeAssistantIntegration() {
@@ -36,9 +55,10 @@ HomeAssistantIntegration::~HomeAssistantIntegration() {
         _mqttClient->disconnect();
         delete _mqttClient;
     }
-    if (_wifiClient) {
-        delete _wifiClient;
+    if (_netClient) {
+        delete _netClient;
     }
+    free(_caCert);
 }
 
 bool HomeAssistantIntegration::begin(const char* broker, uint16_t port,
@@ -62,12 +82,25 @@ bool HomeAssistantIntegration::begin(const char* broker, uint16_t port,
         return false;
     }
 
-    _wifiClient = new WiFiClient();
-    _mqttClient = new PubSubClient(*_wifiClient);
+    if (_tls) {
+        // Reserved now, while the heap is still whole after boot
+        if (!TlsClient::reservePool(MQTT_TLS_POOL_SIZE)) {
+            DEBUG_PRINTLN("HomeAssistant: No TLS memory pool, handshakes use the heap");
+        }
+        _caCert = loadCaCert();
+        _netClient = new TlsClient();
+        DEBUG_PRINTF("HomeAssistant: TLS enabled (%s%s)\n",
+                     _caCert ? "pinned CA" : "no CA",
+                     _fingerprint.length() > 0 ? ", pinned fingerprint" : "");
+    } else {
+        _netClient = new WiFiClient();
+    }
+    _mqttClient = new PubSubClient(*_netClient);
 
     _mqttClient->setServer(_broker.c_str(), _port);
     _mqttClient->setCallback(mqttCallback);
-    _mqttClient->setBufferSize(1024);
+    _mqttClient->setBufferSize(MQTT_BUFFER_SIZE);
+    _mqttClient->setKeepAlive(MQTT_KEEPALIVE);
 
     connectMQTT();
 
@@ -87,7 +120,7 @@ bool HomeAssistantIntegration::loadCredentials() {
         return false;
     }
 
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
     DeserializationError error = deserializeJson(doc, file);
     file.close();
 
@@ -96,8 +129,10 @@ bool HomeAssistantIntegration::loadCredentials() {
         return false;
     }
 
+    _tls = doc["tls"] | false;
+    _fingerprint = doc["fingerprint"] | "";
     _broker = doc["broker"] | "";
-    _port = doc["port"] | 1883;
+    _port = doc["port"] | (_tls ? MQTT_TLS_PORT : 1883);
     _user = doc["user"] | "";
     _password = doc["password"] | "";
 
@@ -110,12 +145,15 @@ bool HomeAssistantIntegration::loadCredentials() {
 }
 
 bool HomeAssistantIntegration::saveCredentials(const String& broker, uint16_t port,
-                                                const String& user, const String& password) {
-    StaticJsonDocument<512> doc;
+                                                const String& user, const String& password,
+                                                bool tls, const String& fingerprint) {
+    ArenaJsonDocument doc(512);
     doc["broker"] = broker;
     doc["port"] = port;
     doc["user"] = user;
     doc["password"] = password;
+    doc["tls"] = tls;
+    doc["fingerprint"] = fingerprint;
 
     File file = LittleFS.open(MQTT_CREDENTIALS_FILE, "w");
     if (!file) {
@@ -135,11 +173,27 @@ bool HomeAssistantIntegration::saveCredentials(const String& broker, uint16_t po
 }
 
 bool HomeAssistantIntegration::testConnection(const String& broker, uint16_t port,
-                                               const String& user, const String& password) {
-    DEBUG_PRINTF("HomeAssistant: Testing connection to %s:%d\n", broker.c_str(), port);
+                                               const String& user, const String& password,
+                                               bool tls, const String& fingerprint, const String& ca) {
+    DEBUG_PRINTF("HomeAssistant: Testing connection to %s:%d%s\n", broker.c_str(), port,
+                 tls ? " (TLS)" : "");
+
+    Client* testClient;
+    char* caCert = nullptr;
+    if (tls) {
+        TlsClient* secure = new TlsClient();
+        testClient = secure;
+        caCert = ca.length() > 0 ? strdup(ca.c_str()) : loadCaCert();
+        if (!openTls(*secure, broker, port, caCert, fingerprint)) {
+            delete testClient;
+            free(caCert);
+            return false;
+        }
+    } else {
+        testClient = new WiFiClient();
+    }
 
-    WiFiClient testClient;
-    PubSubClient testMqtt(testClient);
+    PubSubClient testMqtt(*testClient);
     testMqtt.setServer(broker.c_str(), port);
 
     bool connected = false;
@@ -152,11 +206,118 @@ bool HomeAssistantIntegration::testConnection(const String& broker, uint16_t por
     if (connected) {
         DEBUG_PRINTLN("HomeAssistant: Test connection successful");
         testMqtt.disconnect();
-        return true;
     } else {
         DEBUG_PRINTF("HomeAssistant: Test connection failed, state: %d\n", testMqtt.state());
+    }
+    delete testClient;
+    free(caCert);
+    return connected;
+}
+
+// ============================================================================
+// TLS Transport
+// ============================================================================
+
+bool HomeAssistantIntegration::saveCaCert(const String& pem) {
+    if (pem.length() == 0) {
+        return !LittleFS.exists(MQTT_CA_FILE) || LittleFS.remove(MQTT_CA_FILE);
+    }
+
+    File file = LittleFS.open(MQTT_CA_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("HomeAssistant: Failed to open CA file for writing");
         return false;
     }
+    size_t written = file.print(pem);
+    file.close();
+    return written == pem.length();
+}
+
+// The CA is kept in flash (MQTT_CA_FILE) so it can be rotated without a
+// firmware build. Returns a heap copy, nullptr if none is configured.
+char* HomeAssistantIntegration::loadCaCert() {
+    if (!LittleFS.exists(MQTT_CA_FILE)) return nullptr;
+
+    File file = LittleFS.open(MQTT_CA_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("HomeAssistant: Failed to open CA file");
+        return nullptr;
+    }
+
+    size_t size = file.size();
+    char* pem = nullptr;
+    if (size > 0 && size <= MQTT_CA_MAX_SIZE) {
+        pem = (char*)malloc(size + 1);
+        if (pem) {
+            size_t n = file.readBytes(pem, size);
+            pem[n] = '\0';
+        }
+    } else {
+        DEBUG_PRINTF("HomeAssistant: CA file size %u out of range, ignored\n", (unsigned)size);
+    }
+    file.close();
+    return pem;
+}
+
+// With a CA the chain is verified during the handshake. A fingerprint pins
+// the broker's own certificate and is checked once the session is up.
+// Neither still encrypts, but does not authenticate the broker.
+bool HomeAssistantIntegration::openTls(TlsClient& client, const String& broker, uint16_t port,
+                                       const char* caCert, const String& fingerprint) {
+    client.setCACert(caCert);
+    if (!caCert && fingerprint.length() == 0) {
+        DEBUG_PRINTLN("HomeAssistant: WARNING - TLS without CA or fingerprint, broker not verified");
+    }
+    client.setHandshakeTimeout(MQTT_TLS_HANDSHAKE_TIMEOUT);
+
+    if (!client.connect(broker.c_str(), port)) {
+        DEBUG_PRINTF("HomeAssistant: TLS handshake with %s:%d failed\n", broker.c_str(), port);
+        return false;
+    }
+
+    if (fingerprint.length() > 0 && !client.verify(fingerprint.c_str())) {
+        DEBUG_PRINTLN("HomeAssistant: Broker certificate does not match pinned fingerprint");
+        client.stop();
+        client.forgetSession();
+        return false;
+    }
+    return true;
+}
+
+// PubSubClient::connect() reuses a transport that is already connected, so
+// the TLS handshake is done here first where it can be timed and gated.
+// mbedTLS allocates from its own pool (reserved in begin()); without one the
+// handshake needs one large contiguous heap block for the record buffers,
+// and starting it on a fragmented heap fails late and leaves the heap
+// worse, so it then waits (with backoff) for a block of MQTT_TLS_MIN_BLOCK.
+bool HomeAssistantIntegration::openTransport() {
+    if (!_tls || _netClient->connected()) return true;
+
+    uint32_t block = ESP.getMaxAllocHeap();
+    if (!TlsClient::poolReserved() && block < MQTT_TLS_MIN_BLOCK) {
+        DEBUG_PRINTF("HomeAssistant: TLS deferred, largest free block %u bytes\n", block);
+        return false;
+    }
+
+    TlsClient* tls = static_cast<TlsClient*>(_netClient);
+    uint32_t heapBefore = ESP.getFreeHeap();
+    size_t poolBefore = TlsClient::poolUsed();
+    unsigned long start = millis();
+    if (!openTls(*tls, _broker, _port, _caCert, _fingerprint)) {
+        return false;
+    }
+
+    uint32_t heapAfter = ESP.getFreeHeap();
+    size_t poolAfter = TlsClient::poolUsed();
+    _connStats.lastHandshakeMs = millis() - start;
+    _connStats.tlsHeap = (heapBefore > heapAfter ? heapBefore - heapAfter : 0) +
+                         (poolAfter > poolBefore ? poolAfter - poolBefore : 0);
+    _connStats.tlsPoolPeak = TlsClient::poolPeak();
+    if (tls->resumed()) _connStats.resumed++;
+    DEBUG_PRINTF("HomeAssistant: TLS up in %lu ms (%s), session holds %lu bytes\n",
+                 (unsigned long)_connStats.lastHandshakeMs, tls->resumed() ? "resumed" : "full handshake",
+                 (unsigned long)_connStats.tlsHeap);
+    return true;
 }
 
 // ============================================================================
@@ -170,10 +331,13 @@ void HomeAssistantIntegration::connectMQTT() {
     DEBUG_PRINT("HomeAssistant: Connecting to MQTT broker ");
     DEBUG_PRINTLN(_broker);
 
+    unsigned long start = millis();
     String availTopic = buildTopic("availability");
     bool connected = false;
 
-    if (_user.length() > 0) {
+    if (!openTransport()) {
+        connected = false;
+    } else if (_user.length() > 0) {
         connected = _mqttClient->connect(MQTT_CLIENT_ID,
                                          _user.c_str(), _password.c_str(),
                                          availTopic.c_str(), 1, true, "offline");
@@ -184,7 +348,10 @@ void HomeAssistantIntegration::connectMQTT() {
     }
 
     if (connected) {
-        DEBUG_PRINTLN("HomeAssistant: MQTT connected");
+        _connStats.connects++;
+        _connStats.lastConnectMs = millis() - start;
+        _reconnectInterval = MQTT_RECONNECT_INTERVAL;
+        DEBUG_PRINTF("HomeAssistant: MQTT connected in %lu ms\n", (unsigned long)_connStats.lastConnectMs);
 
         // Publish online availability
         _mqttClient->publish(availTopic.c_str(), "online", true);
@@ -206,9 +373,15 @@ void HomeAssistantIntegration::connectMQTT() {
         publishIndividualStatus();
         publishSchedule();
         publishModeState();
+        publishUpdate();
     } else {
-        DEBUG_PRINTF("HomeAssistant: MQTT connection failed, rc=%d\n",
-                     _mqttClient->state());
+        // Back off so a broker that is down does not cost a (TLS) handshake
+        // every few seconds
+        _connStats.failures++;
+        _netClient->stop();
+        _reconnectInterval = min(_reconnectInterval * 2, (unsigned long)MQTT_RECONNECT_MAX);
+        DEBUG_PRINTF("HomeAssistant: MQTT connection failed, rc=%d, retry in %lu s\n",
+                     _mqttClient->state(), _reconnectInterval / 1000);
     }
 }
 
@@ -233,6 +406,18 @@ void HomeAssistantIntegration::subscribe() {
     // HA birth topic — republish discovery when HA restarts
     _mqttClient->subscribe("homeassistant/status");
 
+    // Pressure alert acknowledge
+    if (_pressureMonitor) {
+        String clearTopic = buildTopic("pressure/clear");
+        _mqttClient->subscribe(clearTopic.c_str());
+    }
+
+    // Firmware install
+    if (_updater && _manualInstall) {
+        String installTopic = buildTopic("update/install");
+        _mqttClient->subscribe(installTopic.c_str());
+    }
+
     // Schedule management
     String skipTopic = buildTopic("schedule/skip");
     _mqttClient->subscribe(skipTopic.c_str());
@@ -253,6 +438,14 @@ void HomeAssistantIntegration::subscribe() {
         }
     }
 
+    // Per-group topics
+    for (uint8_t g = 0; g < MAX_GROUPS; g++) {
+        if (_controller->getGroup(g).enabled) {
+            String grpCmd = buildTopic(("group/" + String(g) + "/command").c_str());
+            _mqttClient->subscribe(grpCmd.c_str());
+        }
+    }
+
     DEBUG_PRINTLN("HomeAssistant: Subscriptions complete");
 }
 
@@ -268,15 +461,22 @@ void HomeAssistantIntegration::update() {
 
     // Handle MQTT reconnection
     if (!_mqttClient->connected()) {
-        if (currentMillis - _lastReconnectAttempt >= MQTT_RECONNECT_INTERVAL) {
+        if (currentMillis - _lastReconnectAttempt >= _reconnectInterval) {
             _lastReconnectAttempt = currentMillis;
             connectMQTT();
         }
         return;
     }
 
-    // Process MQTT messages
+    // PubSubClient hands over one packet per loop(). Keep pulling while the
+    // socket has data so a burst from an HA script is read in one pass
+    // instead of piling up in the TCP window, then apply it as a batch.
     _mqttClient->loop();
+    for (uint8_t i = 1; i < MQTT_CMD_QUEUE_LEN && _cmdCount < MQTT_CMD_QUEUE_LEN &&
+                        _netClient->available(); i++) {
+        _mqttClient->loop();
+    }
+    processCommands();
 
     // Change detection — immediate publish on irrigation state change
     bool currentIrrigating = _controller->isIrrigating();
@@ -316,6 +516,17 @@ void HomeAssistantIntegration::update() {
         }
     }
 
+    // Forecast: on schedule/skip changes, and hourly as runs fall off the front
+    if (_controller->getScheduleGeneration() != _forecastGeneration ||
+        currentMillis - _lastForecastPublish >= FORECAST_PUBLISH_INTERVAL) {
+        publishForecast();
+    }
+
+    // Update job: every state change and progress step, as it happens
+    if (_updater && _updater->getGeneration() != _updateGeneration) {
+        publishUpdate();
+    }
+
     // Standard 60s cycle
     if (currentMillis - _lastStatusUpdate >= STATUS_UPDATE_INTERVAL) {
         _lastStatusUpdate = currentMillis;
@@ -323,6 +534,7 @@ void HomeAssistantIntegration::update() {
         publishStatus();
         publishChannelStates();
         publishIndividualStatus();
+        publishNodeHealth();
 
         // Publish per-channel availability for virtual channels
         if (_nodeManager) {
@@ -374,7 +586,7 @@ void HomeAssistantIntegration::publishDiscovery() {
 
     // === 1. System Enable switch (master arm/disarm) ===
     {
-        StaticJsonDocument<512> doc;
+        ArenaJsonDocument doc(512);
         doc["name"] = String(HA_DEVICE_NAME) + " System";
         doc["unique_id"] = String(HA_DEVICE_ID) + "_switch";
         doc["state_topic"] = buildTopic("state");
@@ -402,10 +614,18 @@ void HomeAssistantIntegration::publishDiscovery() {
     // === 3. Global sensors ===
     publishGlobalSensorDiscovery();
     delay(50);
+    if (_pressureMonitor) {
+        publishPressureDiscovery();
+        delay(50);
+    }
+    if (_updater) {
+        publishUpdateDiscovery();
+        delay(50);
+    }
 
     // === 4. Global duration number ===
     {
-        StaticJsonDocument<512> doc;
+        ArenaJsonDocument doc(512);
         doc["name"] = String(HA_DEVICE_NAME) + " Duration";
         doc["unique_id"] = String(HA_DEVICE_ID) + "_duration";
         doc["command_topic"] = buildTopic("duration/set");
@@ -453,11 +673,64 @@ void HomeAssistantIntegration::publishDiscovery() {
         }
     }
 
+    // === 6. Per-group switches ===
+    for (uint8_t g = 0; g < MAX_GROUPS; g++) {
+        if (_controller->getGroup(g).enabled) {
+            publishGroupSwitchDiscovery(g);
+            _discoveredGroups[g] = true;
+            delay(50);
+        } else if (_discoveredGroups[g]) {
+            String topic = String(HA_DISCOVERY_PREFIX) + "/switch/" + HA_DEVICE_ID + "_grp" + String(g) + "/config";
+            _mqttClient->publish(topic.c_str(), "", true);  // Empty payload = remove
+            _discoveredGroups[g] = false;
+            delay(50);
+        }
+    }
+
+    // === 7. Per-slave link diagnostics ===
+    if (_nodeManager) {
+        // Drop slaves that have been unpaired
+        for (uint8_t d = 0; d < MAX_SLAVES; d++) {
+            if (_discoveredNodes[d][0] == '\0') continue;
+            bool paired = false;
+            for (uint8_t s = 0; s < _nodeManager->getSlaveCount(); s++) {
+                const NodePeer* slave = _nodeManager->getSlave(s);
+                if (slave && strcmp(slave->node_id, _discoveredNodes[d]) == 0) {
+                    paired = true;
+                    break;
+                }
+            }
+            if (!paired) {
+                removeNodeHealthDiscovery(_discoveredNodes[d]);
+                _discoveredNodes[d][0] = '\0';
+                delay(50);
+            }
+        }
+
+        for (uint8_t s = 0; s < _nodeManager->getSlaveCount(); s++) {
+            const NodePeer* slave = _nodeManager->getSlave(s);
+            if (!slave) continue;
+            publishNodeHealthDiscovery(slave);
+
+            int8_t free = -1;
+            bool known = false;
+            for (uint8_t d = 0; d < MAX_SLAVES; d++) {
+                if (strcmp(_discoveredNodes[d], slave->node_id) == 0) known = true;
+                if (free < 0 && _discoveredNodes[d][0] == '\0') free = d;
+            }
+            if (!known && free >= 0) {
+                strncpy(_discoveredNodes[free], slave->node_id, sizeof(_discoveredNodes[free]) - 1);
+            }
+            delay(50);
+        }
+        publishNodeHealth();
+    }
+
     DEBUG_PRINTLN("HomeAssistant: Discovery complete");
 }
 
 void HomeAssistantIntegration::publishModeSelectDiscovery() {
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
     String availTopic = buildTopic("availability");
 
     doc["name"] = String(HA_DEVICE_NAME) + " Mode";
@@ -483,7 +756,7 @@ void HomeAssistantIntegration::publishGlobalSensorDiscovery() {
 
     // Irrigating binary sensor
     {
-        StaticJsonDocument<512> doc;
+        ArenaJsonDocument doc(512);
         doc["name"] = String(HA_DEVICE_NAME) + " Irrigating";
         doc["unique_id"] = String(HA_DEVICE_ID) + "_irrigating";
         doc["state_topic"] = buildTopic("status/irrigating");
@@ -502,7 +775,7 @@ void HomeAssistantIntegration::publishGlobalSensorDiscovery() {
 
     // Time remaining sensor
     {
-        StaticJsonDocument<512> doc;
+        ArenaJsonDocument doc(512);
         doc["name"] = String(HA_DEVICE_NAME) + " Time Remaining";
         doc["unique_id"] = String(HA_DEVICE_ID) + "_time_remaining";
         doc["state_topic"] = buildTopic("status/time_remaining");
@@ -522,7 +795,7 @@ void HomeAssistantIntegration::publishGlobalSensorDiscovery() {
 
     // Next scheduled sensor (timestamp)
     {
-        StaticJsonDocument<512> doc;
+        ArenaJsonDocument doc(512);
         doc["name"] = String(HA_DEVICE_NAME) + " Next Scheduled";
         doc["unique_id"] = String(HA_DEVICE_ID) + "_next_scheduled";
         doc["state_topic"] = buildTopic("status/next_scheduled");
@@ -538,9 +811,28 @@ void HomeAssistantIntegration::publishGlobalSensorDiscovery() {
     }
     delay(50);
 
+    // Upcoming runs (count, full forecast as attributes)
+    {
+        ArenaJsonDocument doc(512);
+        doc["name"] = String(HA_DEVICE_NAME) + " Upcoming Runs";
+        doc["unique_id"] = String(HA_DEVICE_ID) + "_forecast";
+        doc["state_topic"] = buildTopic("forecast");
+        doc["value_template"] = "{{ value_json.runs | length }}";
+        doc["json_attributes_topic"] = buildTopic("forecast");
+        doc["availability_topic"] = availTopic;
+        doc["icon"] = "mdi:calendar-range";
+        addDeviceBlock(doc);
+
+        String json;
+        serializeJson(doc, json);
+        String topic = String(HA_DISCOVERY_PREFIX) + "/sensor/" + HA_DEVICE_ID + "_forecast/config";
+        _mqttClient->publish(topic.c_str(), json.c_str(), true);
+    }
+    delay(50);
+
     // Status sensor (JSON blob — backward compat)
     {
-        StaticJsonDocument<512> doc;
+        ArenaJsonDocument doc(512);
         doc["name"] = String(HA_DEVICE_NAME) + " Status";
         doc["unique_id"] = String(HA_DEVICE_ID) + "_status";
         doc["state_topic"] = buildTopic("status");
@@ -557,8 +849,141 @@ void HomeAssistantIntegration::publishGlobalSensorDiscovery() {
     }
 }
 
+void HomeAssistantIntegration::publishPressureDiscovery() {
+    String availTopic = buildTopic("availability");
+
+    // Mainline pressure sensor
+    {
+        ArenaJsonDocument doc(512);
+        doc["name"] = String(HA_DEVICE_NAME) + " Mainline Pressure";
+        doc["unique_id"] = String(HA_DEVICE_ID) + "_pressure";
+        doc["state_topic"] = buildTopic("status/pressure");
+        doc["device_class"] = "pressure";
+        doc["state_class"] = "measurement";
+        doc["unit_of_measurement"] = "kPa";
+        doc["availability_topic"] = availTopic;
+        addDeviceBlock(doc);
+
+        String json;
+        serializeJson(doc, json);
+        String topic = String(HA_DISCOVERY_PREFIX) + "/sensor/" + HA_DEVICE_ID + "_pressure/config";
+        _mqttClient->publish(topic.c_str(), json.c_str(), true);
+    }
+    delay(50);
+
+    // Burst / leak alert
+    {
+        ArenaJsonDocument doc(512);
+        doc["name"] = String(HA_DEVICE_NAME) + " Pressure Alert";
+        doc["unique_id"] = String(HA_DEVICE_ID) + "_pressure_alert";
+        doc["state_topic"] = buildTopic("status/pressure_alert");
+        doc["json_attributes_topic"] = buildTopic("status/pressure_alert/attributes");
+        doc["payload_on"] = "ON";
+        doc["payload_off"] = "OFF";
+        doc["device_class"] = "problem";
+        doc["availability_topic"] = availTopic;
+        addDeviceBlock(doc);
+
+        String json;
+        serializeJson(doc, json);
+        String topic = String(HA_DISCOVERY_PREFIX) + "/binary_sensor/" + HA_DEVICE_ID + "_pressure_alert/config";
+        _mqttClient->publish(topic.c_str(), json.c_str(), true);
+    }
+    delay(50);
+
+    // Acknowledge button
+    {
+        ArenaJsonDocument doc(512);
+        doc["name"] = String(HA_DEVICE_NAME) + " Clear Pressure Alert";
+        doc["unique_id"] = String(HA_DEVICE_ID) + "_pressure_clear";
+        doc["command_topic"] = buildTopic("pressure/clear");
+        doc["availability_topic"] = availTopic;
+        doc["icon"] = "mdi:check-circle-outline";
+        addDeviceBlock(doc);
+
+        String json;
+        serializeJson(doc, json);
+        String topic = String(HA_DISCOVERY_PREFIX) + "/button/" + HA_DEVICE_ID + "_pressure_clear/config";
+        _mqttClient->publish(topic.c_str(), json.c_str(), true);
+    }
+}
+
+// HA update entity: installed vs latest version, with an Install button
+// that starts the same background job as the web UI
+void HomeAssistantIntegration::publishUpdateDiscovery() {
+    ArenaJsonDocument doc(640);
+    doc["name"] = String(HA_DEVICE_NAME) + " Firmware";
+    doc["unique_id"] = String(HA_DEVICE_ID) + "_firmware";
+    doc["state_topic"] = buildTopic("status/update");
+    if (_manualInstall) {
+        doc["command_topic"] = buildTopic("update/install");
+        doc["payload_install"] = "install";
+    }
+    doc["device_class"] = "firmware";
+    doc["entity_category"] = "config";
+    doc["availability_topic"] = buildTopic("availability");
+    addDeviceBlock(doc);
+
+    String json;
+    serializeJson(doc, json);
+    String topic = String(HA_DISCOVERY_PREFIX) + "/update/" + HA_DEVICE_ID + "_firmware/config";
+    _mqttClient->publish(topic.c_str(), json.c_str(), true);
+}
+
+// Link loss, RSSI and round trip of one slave, as diagnostic entities on the
+// controller device. All three read the node's link topic; the full
+// statistics ride along as attributes.
+void HomeAssistantIntegration::publishNodeHealthDiscovery(const NodePeer* peer) {
+    String availTopic = buildTopic("availability");
+    String nodeId = String(HA_DEVICE_ID) + "_node_" + peer->node_id;
+    String linkTopic = buildTopic(("node/" + String(peer->node_id) + "/link").c_str());
+
+    struct {
+        const char* suffix;
+        const char* label;
+        const char* field;
+        const char* unit;
+        const char* deviceClass;
+        const char* icon;
+    } const entities[] = {
+        {"loss", "Link Loss", "loss_pct", "%", nullptr, "mdi:lan-disconnect"},
+        {"rssi", "Link RSSI", "rssi_avg", "dBm", "signal_strength", nullptr},
+        {"rtt", "Link RTT p90", "rtt_p90", "ms", nullptr, "mdi:timer-sync-outline"},
+    };
+
+    for (const auto& e : entities) {
+        ArenaJsonDocument doc(768);
+        doc["name"] = String(HA_DEVICE_NAME) + " " + peer->name + " " + e.label;
+        doc["unique_id"] = nodeId + "_" + e.suffix;
+        doc["state_topic"] = linkTopic;
+        doc["value_template"] = String("{{ value_json.") + e.field + " }}";
+        doc["json_attributes_topic"] = linkTopic;
+        doc["unit_of_measurement"] = e.unit;
+        doc["state_class"] = "measurement";
+        if (e.deviceClass) doc["device_class"] = e.deviceClass;
+        if (e.icon) doc["icon"] = e.icon;
+        doc["entity_category"] = "diagnostic";
+        doc["availability_topic"] = availTopic;
+        addDeviceBlock(doc);
+
+        String json;
+        serializeJson(doc, json);
+        String topic = String(HA_DISCOVERY_PREFIX) + "/sensor/" + nodeId + "_" + e.suffix + "/config";
+        _mqttClient->publish(topic.c_str(), json.c_str(), true);
+    }
+}
+
+void HomeAssistantIntegration::removeNodeHealthDiscovery(const char* nodeId) {
+    String base = String(HA_DISCOVERY_PREFIX) + "/sensor/" + HA_DEVICE_ID + "_node_" + nodeId;
+    const char* suffixes[] = {"_loss", "_rssi", "_rtt"};
+    for (const char* suffix : suffixes) {
+        String topic = base + suffix + "/config";
+        _mqttClient->publish(topic.c_str(), "", true);  // Empty payload = remove
+    }
+}
+
 void HomeAssistantIntegration::publishChannelSwitchDiscovery(uint8_t channel) {
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
     String chId = String(HA_DEVICE_ID) + "_ch" + String(channel);
     String chBase = "channel/" + String(channel);
     String availTopic = buildTopic("availability");
@@ -590,7 +1015,7 @@ void HomeAssistantIntegration::publishChannelSwitchDiscovery(uint8_t channel) {
 }
 
 void HomeAssistantIntegration::publishChannelDurationDiscovery(uint8_t channel) {
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
     String chId = String(HA_DEVICE_ID) + "_ch" + String(channel);
     String chBase = "channel/" + String(channel);
     String availTopic = buildTopic("availability");
@@ -621,7 +1046,7 @@ void HomeAssistantIntegration::publishChannelRuntimeDiscovery(uint8_t channel) {
 
     // Running binary sensor
     {
-        StaticJsonDocument<512> doc;
+        ArenaJsonDocument doc(512);
         doc["name"] = String(HA_DEVICE_NAME) + " Ch" + String(channel) + " Running";
         doc["unique_id"] = chId + "_running";
         doc["state_topic"] = buildTopic((chBase + "/running").c_str());
@@ -640,7 +1065,7 @@ void HomeAssistantIntegration::publishChannelRuntimeDiscovery(uint8_t channel) {
 
     // Time remaining sensor
     {
-        StaticJsonDocument<512> doc;
+        ArenaJsonDocument doc(512);
         doc["name"] = String(HA_DEVICE_NAME) + " Ch" + String(channel) + " Time Left";
         doc["unique_id"] = chId + "_time_remaining";
         doc["state_topic"] = buildTopic((chBase + "/time_remaining").c_str());
@@ -658,6 +1083,31 @@ void HomeAssistantIntegration::publishChannelRuntimeDiscovery(uint8_t channel) {
     }
 }
 
+void HomeAssistantIntegration::publishGroupSwitchDiscovery(uint8_t group) {
+    ArenaJsonDocument doc(640);
+    ChannelGroup grp = _controller->getGroup(group);
+    String grpId = String(HA_DEVICE_ID) + "_grp" + String(group);
+    String grpBase = "group/" + String(group);
+
+    doc["name"] = String(HA_DEVICE_NAME) + " " + String(grp.name);
+    doc["unique_id"] = grpId + "_switch";
+    doc["state_topic"] = buildTopic((grpBase + "/state").c_str());
+    doc["command_topic"] = buildTopic((grpBase + "/command").c_str());
+    doc["json_attributes_topic"] = buildTopic((grpBase + "/attributes").c_str());
+    doc["payload_on"] = "ON";
+    doc["payload_off"] = "OFF";
+    doc["optimistic"] = false;
+    doc["qos"] = 1;
+    doc["icon"] = "mdi:sprinkler-variant";
+    doc["availability_topic"] = buildTopic("availability");
+    addDeviceBlock(doc);
+
+    String json;
+    serializeJson(doc, json);
+    String topic = String(HA_DISCOVERY_PREFIX) + "/switch/" + grpId + "/config";
+    _mqttClient->publish(topic.c_str(), json.c_str(), true);
+}
+
 void HomeAssistantIntegration::refreshDiscovery() {
     _needsDiscoveryPublish = true;
     if (isConnected()) {
@@ -693,10 +1143,127 @@ void HomeAssistantIntegration::removeStaleDiscovery() {
 
 void HomeAssistantIntegration::mqttCallback(char* topic, byte* payload, unsigned int length) {
     if (_instance) {
-        _instance->handleMQTTMessage(topic, payload, length);
+        _instance->queueCommand(topic, payload, length);
     }
 }
 
+// Which channels a queued command reads or writes: 1..MAX_CHANNELS, all of
+// them (group, system and global duration/mode topics), or none
+#define CMD_SCOPE_NONE -1
+#define CMD_SCOPE_ALL  0
+
+static int commandScope(const char* topic) {
+    const char* ch = strstr(topic, "/channel/");
+    if (ch) return atoi(ch + 9);
+    if (strstr(topic, "/group/")) return CMD_SCOPE_ALL;
+    size_t len = strlen(topic);
+    static const char* const global[] = {"/command", "/duration/set", "/mode/set"};
+    for (const char* suffix : global) {
+        size_t n = strlen(suffix);
+        if (len >= n && strcmp(topic + len - n, suffix) == 0) return CMD_SCOPE_ALL;
+    }
+    return CMD_SCOPE_NONE;
+}
+
+static bool scopesOverlap(int a, int b) {
+    if (a == CMD_SCOPE_NONE || b == CMD_SCOPE_NONE) return false;
+    return a == CMD_SCOPE_ALL || b == CMD_SCOPE_ALL || a == b;
+}
+
+// Runs inside PubSubClient::loop(), whose buffer the next packet reuses, so
+// the command is copied out. Switches, durations and the mode are
+// last-writer-wins: a newer command on a topic that is still waiting
+// replaces the older one's payload in its slot, so the batch keeps its
+// order. It is queued separately instead when anything behind the older one
+// touches the same channel: duration/set 10, command ON, duration/set 20
+// must start the run at 10 and leave 20 for the next one.
+// Schedule topics are not idempotent (two adds are two schedules) and
+// always queue.
+void HomeAssistantIntegration::queueCommand(const char* topic, const byte* payload, unsigned int length) {
+    _cmdStats.received++;
+
+    size_t topicLen = strlen(topic);
+    if (topicLen >= MQTT_CMD_TOPIC_LEN || length >= MQTT_CMD_PAYLOAD_LEN) {
+        DEBUG_PRINTF("HomeAssistant: Command on %s too long (%u bytes), dropped\n", topic, length);
+        _cmdStats.dropped++;
+        return;
+    }
+
+    MqttCommand* slot = nullptr;
+    if (!strstr(topic, "/schedule/")) {
+        // Back to the newest entry on this topic, unless another command
+        // on the same channels is queued after it
+        int scope = commandScope(topic);
+        for (int i = _cmdCount - 1; i >= 0; i--) {
+            if (strcmp(_cmdQueue[i].topic, topic) == 0) {
+                slot = &_cmdQueue[i];
+                break;
+            }
+            if (scopesOverlap(scope, commandScope(_cmdQueue[i].topic))) break;
+        }
+    }
+
+    if (slot) {
+        _cmdStats.coalesced++;
+    } else {
+        if (_cmdCount >= MQTT_CMD_QUEUE_LEN) {
+            DEBUG_PRINTF("HomeAssistant: Command queue full, dropped %s\n", topic);
+            _cmdStats.dropped++;
+            return;
+        }
+        slot = &_cmdQueue[_cmdCount++];
+    }
+
+    MqttCommand& cmd = *slot;
+    memcpy(cmd.topic, topic, topicLen + 1);
+    memcpy(cmd.payload, payload, length);
+    cmd.payload[length] = '\0';
+    cmd.length = length;
+    cmd.receivedAt = micros();
+}
+
+// Channel, group and system switches only flag that channel state changed;
+// it is published once after the batch rather than three topics per
+// channel per command.
+void HomeAssistantIntegration::processCommands() {
+    unsigned long waiting[MQTT_CMD_QUEUE_LEN];
+    uint8_t waitingCount = 0;
+
+    for (uint8_t i = 0; i < _cmdCount; i++) {
+        MqttCommand& cmd = _cmdQueue[i];
+        bool pending = _statePublishPending;
+        _statePublishPending = false;
+        handleMQTTMessage(cmd.topic, (byte*)cmd.payload, cmd.length);
+        if (_statePublishPending) {
+            waiting[waitingCount++] = cmd.receivedAt;
+        }
+        _statePublishPending |= pending;
+        _cmdStats.processed++;
+    }
+    _cmdCount = 0;
+
+    if (!_statePublishPending) return;
+    _statePublishPending = false;
+
+    publishChannelStates();
+    publishIndividualStatus();
+    publishState();
+    _cmdStats.stateFlushes++;
+
+    // Already published; keep update()'s change detection from repeating it
+    _lastIrrigatingState = _controller->isIrrigating();
+
+    unsigned long now = micros();
+    for (uint8_t i = 0; i < waitingCount; i++) {
+        _cmdLatency.record(now - waiting[i]);
+    }
+}
+
+void HomeAssistantIntegration::resetCommandStats() {
+    memset(&_cmdStats, 0, sizeof(_cmdStats));
+    _cmdLatency.reset();
+}
+
 void HomeAssistantIntegration::handleMQTTMessage(char* topic, byte* payload, unsigned int length) {
     String message;
     for (unsigned int i = 0; i < length; i++) {
@@ -717,9 +1284,42 @@ void HomeAssistantIntegration::handleMQTTMessage(char* topic, byte* payload, uns
         publishIndividualStatus();
         publishSchedule();
         publishModeState();
+        publishUpdate();
+        return;
+    }
+
+    // --- Pressure alert acknowledge ---
+    if (topicStr == buildTopic("pressure/clear")) {
+        if (_pressureMonitor) {
+            _pressureMonitor->clearAlarm();
+            publishPressure();
+        }
+        return;
+    }
+
+    // --- Firmware install ---
+    if (topicStr == buildTopic("update/install")) {
+        if (!_manualInstall) {
+            DEBUG_PRINTLN("HomeAssistant: Install refused, this node installs through the master's rollout");
+        } else if (_updater && message == "install" && !_updater->start(true)) {
+            DEBUG_PRINTLN("HomeAssistant: Update job already running");
+        }
         return;
     }
 
+    // --- Per-group command: .../group/{N}/command ---
+    if (topicStr.indexOf("/group/") >= 0 && topicStr.endsWith("/command")) {
+        int gStart = topicStr.indexOf("/group/") + 7;
+        int gEnd = topicStr.indexOf("/", gStart);
+        if (gEnd > gStart) {
+            uint8_t g = topicStr.substring(gStart, gEnd).toInt();
+            if (g < MAX_GROUPS) {
+                handleGroupCommand(g, message);
+                return;
+            }
+        }
+    }
+
     // --- Per-channel command: .../channel/{N}/command ---
     if (topicStr.indexOf("/channel/") >= 0 && topicStr.endsWith("/command")) {
         // Extract channel number
@@ -769,10 +1369,8 @@ void HomeAssistantIntegration::handleMQTTMessage(char* topic, byte* payload, uns
             _controller->setSystemEnabled(false);
             _currentMode = "disabled";
         }
-        publishState();
         publishModeState();
-        publishChannelStates();
-        publishIndividualStatus();
+        _statePublishPending = true;
         return;
     }
 
@@ -887,6 +1485,17 @@ void HomeAssistantIntegration::handleMQTTMessage(char* topic, byte* payload, uns
 
         int16_t editIndex = doc["index"] | -1;
 
+        // Cycle-and-soak; an edit that leaves them out keeps the schedule's own
+        uint8_t cycles = 1;
+        uint16_t soak = 0;
+        if (editIndex >= 0 && editIndex < MAX_SCHEDULES) {
+            IrrigationSchedule current = _controller->getSchedule((uint8_t)editIndex);
+            cycles = current.cycles > 0 ? current.cycles : 1;
+            soak = current.soakMinutes;
+        }
+        cycles = doc["cycles"] | cycles;
+        soak = doc["soak"] | soak;
+
         if (channel < 1 || channel > MAX_CHANNELS) {
             DEBUG_PRINTLN("HomeAssistant: schedule/set invalid channel");
             return;
@@ -899,14 +1508,20 @@ void HomeAssistantIntegration::handleMQTTMessage(char* topic, byte* payload, uns
             DEBUG_PRINTLN("HomeAssistant: schedule/set invalid duration");
             return;
         }
+        if (cycles < 1 || cycles > MAX_CYCLES || cycles > duration ||
+            (cycles > 1 && (soak < 1 || soak > MAX_SOAK_MINUTES))) {
+            DEBUG_PRINTLN("HomeAssistant: schedule/set invalid cycle/soak");
+            return;
+        }
 
         bool ok = false;
         if (editIndex >= 0) {
-            ok = _controller->updateSchedule((uint8_t)editIndex, channel, hour, minute, duration, weekdays);
+            ok = _controller->updateSchedule((uint8_t)editIndex, channel, hour, minute, duration, weekdays,
+                                            cycles, soak);
             DEBUG_PRINTF("HomeAssistant: Updated schedule %d via MQTT: ch%d %02d:%02d %dmin -> %s\n",
                          editIndex, channel, hour, minute, duration, ok ? "OK" : "FAIL");
         } else {
-            int8_t newIdx = _controller->addSchedule(channel, hour, minute, duration, weekdays);
+            int8_t newIdx = _controller->addSchedule(channel, hour, minute, duration, weekdays, cycles, soak);
             ok = (newIdx >= 0);
             DEBUG_PRINTF("HomeAssistant: Added schedule via MQTT: ch%d %02d:%02d %dmin -> idx %d\n",
                          channel, hour, minute, duration, newIdx);
@@ -1001,10 +1616,36 @@ void HomeAssistantIntegration::handleChannelCommand(uint8_t channel, const Strin
         _commandSentTime[idx] = 0;
     }
 
-    // Immediate publish
-    publishChannelStates();
-    publishIndividualStatus();
-    publishState();
+    _statePublishPending = true;
+}
+
+void HomeAssistantIntegration::handleGroupCommand(uint8_t group, const String& message) {
+    ChannelGroup grp = _controller->getGroup(group);
+    if (!grp.enabled) return;
+
+    if (message == "ON") {
+        DEBUG_PRINTF("HomeAssistant: Group %d ON via MQTT\n", group);
+        if (!_systemEnabled) {
+            DEBUG_PRINTLN("HomeAssistant: System disabled, ignoring group ON");
+            _mqttClient->publish(buildTopic(("group/" + String(group) + "/state").c_str()).c_str(), "OFF", true);
+            return;
+        }
+
+        // Group runs use the duration of its lowest member channel
+        uint16_t duration = DEFAULT_DURATION_MINUTES;
+        for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+            if (grp.members & (1ULL << i)) {
+                duration = _channelDuration[i];
+                break;
+            }
+        }
+        _controller->startGroup(group, duration);
+    } else if (message == "OFF") {
+        DEBUG_PRINTF("HomeAssistant: Group %d OFF via MQTT\n", group);
+        _controller->stopGroup(group);
+    }
+
+    _statePublishPending = true;
 }
 
 void HomeAssistantIntegration::handleChannelDurationSet(uint8_t channel, const String& message) {
@@ -1070,7 +1711,7 @@ void HomeAssistantIntegration::publishStatus() {
     if (!isConnected()) return;
 
     SystemStatus status = _controller->getStatus();
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
 
     doc["irrigating"] = status.irrigating;
     doc["manual_mode"] = status.manualMode;
@@ -1146,6 +1787,148 @@ void HomeAssistantIntegration::publishIndividualStatus() {
     // System enabled
     String seTopic = buildTopic("status/system_enabled");
     _mqttClient->publish(seTopic.c_str(), _systemEnabled ? "ON" : "OFF", true);
+
+    publishPressure();
+}
+
+void HomeAssistantIntegration::publishPressure() {
+    if (!isConnected() || !_pressureMonitor) return;
+
+    String pTopic = buildTopic("status/pressure");
+    if (_pressureMonitor->isSensorOk()) {
+        _mqttClient->publish(pTopic.c_str(), String(_pressureMonitor->getPressure(), 1).c_str(), true);
+    } else {
+        _mqttClient->publish(pTopic.c_str(), "unknown", true);
+    }
+
+    uint8_t alarm = _pressureMonitor->getAlarm();
+    String aTopic = buildTopic("status/pressure_alert");
+    _mqttClient->publish(aTopic.c_str(), alarm != PRESSURE_EVENT_NONE ? "ON" : "OFF", true);
+
+    StaticJsonDocument<256> doc;
+    doc["type"] = (alarm == PRESSURE_EVENT_BURST) ? "burst" :
+                  (alarm == PRESSURE_EVENT_LEAK) ? "leak" : "none";
+    JsonArray zones = doc.createNestedArray("zones");
+    for (uint8_t ch = 1; ch <= NUM_LOCAL_CHANNELS; ch++) {
+        if (_pressureMonitor->getAlarmZones() & (1UL << (ch - 1))) zones.add(ch);
+    }
+    doc["sensor_ok"] = _pressureMonitor->isSensorOk();
+
+    String json;
+    serializeJson(doc, json);
+    String attrTopic = buildTopic("status/pressure_alert/attributes");
+    _mqttClient->publish(attrTopic.c_str(), json.c_str(), true);
+}
+
+// State of the update entity. Latest falls back to the installed version
+// until a check has answered, so HA does not offer an install of nothing.
+void HomeAssistantIntegration::publishUpdate() {
+    if (!isConnected() || !_updater) return;
+
+    OtaStatus status = _updater->getStatus();
+    _updateGeneration = status.generation;
+
+    StaticJsonDocument<256> doc;
+    doc["installed_version"] = VERSION;
+    doc["latest_version"] = status.latest[0] ? status.latest : VERSION;
+    doc["in_progress"] = status.state == OTA_DOWNLOADING || status.state == OTA_REBOOTING;
+    if (status.state == OTA_DOWNLOADING) {
+        doc["update_percentage"] = status.progress;
+    } else {
+        doc["update_percentage"] = nullptr;
+    }
+    doc["release_summary"] = status.state == OTA_FAILED ? status.error : "";
+
+    String json;
+    serializeJson(doc, json);
+    String topic = buildTopic("status/update");
+    _mqttClient->publish(topic.c_str(), json.c_str(), true);
+}
+
+void HomeAssistantIntegration::publishNodeHealth() {
+    if (!isConnected() || !_nodeManager) return;
+
+    for (uint8_t s = 0; s < _nodeManager->getSlaveCount(); s++) {
+        const NodePeer* slave = _nodeManager->getSlave(s);
+        LinkHealth health;
+        if (!slave || !_nodeManager->getLinkHealth(s, health)) continue;
+
+        ArenaJsonDocument doc(512);
+        doc["online"] = slave->online;
+        doc["loss_pct"] = health.loss_pct;
+        doc["retransmit_pct"] = health.retransmit_pct;
+        doc["frames_lost"] = slave->link.lost_total;
+        doc["commands_dropped"] = slave->link.cmds_dropped;
+        if (health.rssi_samples > 0) {
+            doc["rssi_avg"] = health.rssi_avg;
+            doc["rssi_min"] = health.rssi_min;
+        }
+        if (health.rtt_samples > 0) {
+            doc["rtt_p50"] = health.rtt_p50;
+            doc["rtt_p90"] = health.rtt_p90;
+            doc["rtt_max"] = health.rtt_max;
+        }
+        doc["uptime"] = slave->link.uptime;
+        doc["reboots"] = slave->link.reboots;
+        doc["divergences"] = slave->divergences;
+
+        String json;
+        serializeJson(doc, json);
+        String topic = buildTopic(("node/" + String(slave->node_id) + "/link").c_str());
+        _mqttClient->publish(topic.c_str(), json.c_str(), true);
+    }
+}
+
+// Next FORECAST_DEFAULT_DAYS of runs as {"days":N,"runs":[...]}. The payload
+// can exceed the MQTT buffer, so it is measured in a first pass over the
+// forecast and streamed run by run in a second.
+void HomeAssistantIntegration::publishForecast() {
+    if (!isConnected()) return;
+
+    ForecastCursor cursor;
+    if (!_controller->beginForecast(cursor, FORECAST_DEFAULT_DAYS)) return;
+    _forecastGeneration = _controller->getScheduleGeneration();
+    _lastForecastPublish = millis();
+
+    String head = "{\"days\":" + String(FORECAST_DEFAULT_DAYS) + ",\"runs\":[";
+    const char* tail = "]}";
+
+    ForecastCursor pass = cursor;
+    ForecastRun run;
+    size_t length = head.length() + strlen(tail);
+    uint16_t count = 0;
+    while (_controller->nextForecastRun(pass, run)) {
+        StaticJsonDocument<256> doc;
+        fillForecastRun(doc, run);
+        length += measureJson(doc) + (count > 0 ? 1 : 0);
+        count++;
+    }
+
+    String topic = buildTopic("forecast");
+    if (!_mqttClient->beginPublish(topic.c_str(), length, true)) return;
+    _mqttClient->write((const uint8_t*)head.c_str(), head.length());
+    count = 0;
+    while (_controller->nextForecastRun(cursor, run)) {
+        StaticJsonDocument<256> doc;
+        fillForecastRun(doc, run);
+        if (count++ > 0) _mqttClient->write((uint8_t)',');
+        serializeJson(doc, *_mqttClient);
+    }
+    _mqttClient->write((const uint8_t*)tail, strlen(tail));
+    _mqttClient->endPublish();
+}
+
+void HomeAssistantIntegration::fillForecastRun(JsonDocument& doc, const ForecastRun& run) {
+    doc["start"] = toISO8601(run.start);
+    doc["channel"] = run.channel;
+    doc["duration"] = run.durationMinutes;
+    if (run.cycles > 1) {
+        doc["cycles"] = run.cycles;
+        doc["soak"] = run.soakMinutes;
+    }
+    if (run.skipped) doc["skipped"] = true;
+    if (run.closedLoop) doc["closed_loop"] = true;
+    if (run.channel > NUM_LOCAL_CHANNELS) doc["remote"] = true;
 }
 
 void HomeAssistantIntegration::publishChannelStates() {
@@ -1171,6 +1954,42 @@ void HomeAssistantIntegration::publishChannelStates() {
         String trTopic = buildTopic((chBase + "/time_remaining").c_str());
         _mqttClient->publish(trTopic.c_str(), String(remaining).c_str(), true);
     }
+
+    publishGroupStates();
+}
+
+void HomeAssistantIntegration::publishGroupStates() {
+    if (!isConnected()) return;
+
+    for (uint8_t g = 0; g < MAX_GROUPS; g++) {
+        ChannelGroup grp = _controller->getGroup(g);
+        if (!grp.enabled) continue;
+
+        String grpBase = "group/" + String(g);
+        bool running = _controller->isGroupRunning(g);
+        _mqttClient->publish(buildTopic((grpBase + "/state").c_str()).c_str(),
+                             running ? "ON" : "OFF", true);
+
+        // Attributes: members and whether every node confirmed the last command
+        ArenaJsonDocument doc(384);
+        JsonArray members = doc.createNestedArray("channels");
+        for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+            if (grp.members & (1ULL << i)) members.add(i + 1);
+        }
+        const char* ack = "none";
+        if (_nodeManager) {
+            switch (_nodeManager->getGroupAckState(g)) {
+                case GROUP_ACK_PENDING:   ack = "pending"; break;
+                case GROUP_ACK_CONFIRMED: ack = "confirmed"; break;
+                case GROUP_ACK_FAILED:    ack = "failed"; break;
+            }
+        }
+        doc["ack"] = ack;
+
+        String json;
+        serializeJson(doc, json);
+        _mqttClient->publish(buildTopic((grpBase + "/attributes").c_str()).c_str(), json.c_str(), true);
+    }
 }
 
 void HomeAssistantIntegration::publishSchedule() {
@@ -1180,7 +1999,7 @@ void HomeAssistantIntegration::publishSchedule() {
     uint8_t count;
     _controller->getSchedules(schedules, count);
 
-    DynamicJsonDocument doc(1536);
+    ArenaJsonDocument doc(1536);
     JsonArray array = doc.createNestedArray("schedules");
 
     for (int i = 0; i < count; i++) {
@@ -1193,6 +2012,10 @@ void HomeAssistantIntegration::publishSchedule() {
             schedule["duration"] = schedules[i].durationMinutes;
             schedule["weekdays"] = schedules[i].weekdays;
             schedule["days"] = serialized(weekdaysToDaysArray(schedules[i].weekdays));
+            if (schedules[i].cycles > 1) {
+                schedule["cycles"] = schedules[i].cycles;
+                schedule["soak"] = schedules[i].soakMinutes;
+            }
             schedule["skipped"] = _controller->isScheduleSkipped(i);
         }
     }
@@ -1,4 +1,5 @@
 #include "IrrigationController.h"
+#include "TimeZone.h"
 #include <time.h>
 
 IrrigationController::IrrigationController()
@@ -7,7 +8,14 @@ IrrigationController::IrrigationController()
       _lastScheduleCheck(0),
       _irrigationStartMillis(0),
       _currentDurationMinutes(0),
-      _systemEnabled(true) {
+      _systemEnabled(true),
+      _remoteStageCallback(nullptr),
+      _remoteGroupCallback(nullptr),
+      _runEndCallback(nullptr),
+      _moistureProvider(nullptr),
+      _lastMoistureCheck(0),
+      _channelGeneration(1),
+      _scheduleGeneration(1) {
 
     // Initialize status
     memset(&_status, 0, sizeof(SystemStatus));
@@ -15,8 +23,8 @@ IrrigationController::IrrigationController()
     // Initialize valve pointers
     for (int i = 0; i < MAX_CHANNELS; i++) {
         _valves[i] = nullptr;
-        _channelEnabled[i] = false;
     }
+    _channelEnabled.clear();
 
     // Initialize schedules
     for (int i = 0; i < MAX_SCHEDULES; i++) {
@@ -26,8 +34,16 @@ IrrigationController::IrrigationController()
         _schedules[i].minute = 0;
         _schedules[i].durationMinutes = DEFAULT_DURATION_MINUTES;
         _schedules[i].weekdays = 0x7F; // All days
+        _schedules[i].cycles = 1;
+        _schedules[i].soakMinutes = 0;
         _skipUntil[i] = 0;
     }
+    memset(_cycleRuns, 0, sizeof(_cycleRuns));
+    memset(_groups, 0, sizeof(_groups));
+    memset(_moistureLoops, 0, sizeof(_moistureLoops));
+    memset(_moistureRun, 0, sizeof(_moistureRun));
+    memset(_channelFault, 0, sizeof(_channelFault));
+    memset(_channelChangedAt, 0, sizeof(_channelChangedAt));
 }
 
 IrrigationController::~IrrigationController() {
@@ -58,8 +74,8 @@ bool IrrigationController::begin() {
         _valves[i] = new RemoteValve(i + 1);  // 1-based channel number
     }
     // Initialize status for ALL channels
+    _status.channelIrrigating.clear();
     for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
-        _status.channelIrrigating[i] = false;
         _status.channelStartTime[i] = 0;
         _status.channelDuration[i] = 0;
     }
@@ -68,6 +84,8 @@ bool IrrigationController::begin() {
     if (!loadSchedules()) {
         DEBUG_PRINTLN("IrrigationController: No saved schedules, using defaults");
     }
+    loadGroups();
+    loadMoistureLoops();
 
     DEBUG_PRINTLN("IrrigationController: Initialized successfully");
     return true;
@@ -79,12 +97,22 @@ void IrrigationController::update() {
     // Update irrigation state
     updateIrrigationState();
 
+    // Advance cycle-and-soak runs (cheap when none are active)
+    processCycleRuns();
+
     // Safety check
     safetyCheck();
 
+    // Closed-loop zones: stop once the soil reaches its target
+    if (currentMillis - _lastMoistureCheck >= SOIL_LOOP_CHECK_INTERVAL) {
+        _lastMoistureCheck = currentMillis;
+        checkMoistureLoops();
+    }
+
     // Check schedules periodically
     if (currentMillis - _lastScheduleCheck >= SCHEDULE_CHECK_INTERVAL) {
         _lastScheduleCheck = currentMillis;
+        expireSkips();
         if (_hasValidTime && !_status.manualMode && _systemEnabled) {
             checkSchedules();
         }
@@ -98,6 +126,11 @@ void IrrigationController::startIrrigation(uint8_t channel, uint16_t durationMin
         return;
     }
 
+    if (_channelFault[channel - 1]) {
+        DEBUG_PRINTF("IrrigationController: Channel %d is faulted, start refused\n", channel);
+        return;
+    }
+
     // Validate duration
     if (durationMinutes < MIN_DURATION_MINUTES) {
         durationMinutes = MIN_DURATION_MINUTES;
@@ -109,9 +142,17 @@ void IrrigationController::startIrrigation(uint8_t channel, uint16_t durationMin
     DEBUG_PRINTF("IrrigationController: Starting irrigation on channel %d for %d minutes (manual=%d)\n",
                  channel, durationMinutes, manual);
 
-    uint8_t idx = channel - 1;  // Convert to 0-based index
+    markChannelRunning(channel - 1, durationMinutes);
+    activateValve(channel, true, manual);
+}
+
+void IrrigationController::markChannelRunning(uint8_t idx, uint16_t durationMinutes) {
+    // A restart closes the run in progress; the new one is timed from now
+    if (_status.channelIrrigating[idx]) reportRunEnd(idx, RUN_END_STOPPED);
 
-    _status.channelIrrigating[idx] = true;
+    _channelGeneration++;
+    _channelChangedAt[idx] = millis();
+    _status.channelIrrigating.set(idx);
     _status.channelStartTime[idx] = millis();
     _status.channelDuration[idx] = durationMinutes;
     _status.irrigating = true;
@@ -119,19 +160,56 @@ void IrrigationController::startIrrigation(uint8_t channel, uint16_t durationMin
     _irrigationStartMillis = millis();
     _currentDurationMinutes = durationMinutes;
     _status.currentDuration = durationMinutes;
+}
 
-    activateValve(channel, true, manual);
+void IrrigationController::clearChannelRunning(uint8_t idx, uint8_t reason) {
+    if (_status.channelIrrigating[idx]) reportRunEnd(idx, reason);
+
+    _channelGeneration++;
+    _channelChangedAt[idx] = millis();
+    _status.channelIrrigating.reset(idx);
+    _status.channelStartTime[idx] = 0;
+    _status.channelDuration[idx] = 0;
+}
+
+// Only local valves are reported: a remote channel's run is journaled by the
+// node that drives it, which knows when the valve really opened and closed
+void IrrigationController::reportRunEnd(uint8_t idx, uint8_t reason) {
+    if (!_runEndCallback || idx >= NUM_LOCAL_CHANNELS) return;
+    if (_status.channelStartTime[idx] == 0) return;
+
+    unsigned long seconds = (millis() - _status.channelStartTime[idx]) / 1000;
+    if (seconds > 0xFFFF) seconds = 0xFFFF;
+    uint32_t start = _hasValidTime ? (uint32_t)(_currentTime - (time_t)seconds) : 0;
+    _runEndCallback(idx + 1, start, (uint16_t)seconds, reason);
+}
+
+// Recompute the global irrigating flag after channels were stopped
+void IrrigationController::refreshIrrigatingFlag() {
+    bool anyActive = _status.channelIrrigating.any();
+    _status.irrigating = anyActive;
+
+    if (!anyActive) {
+        _status.manualMode = false;
+        _currentDurationMinutes = 0;
+        _status.currentDuration = 0;
+    }
+}
+
+void IrrigationController::stopIrrigation(uint8_t channel, uint8_t reason) {
+    // An explicit stop also abandons any remaining cycle-and-soak cycles
+    cancelCycleRuns(channel);
+    stopChannel(channel, reason);
 }
 
-void IrrigationController::stopIrrigation(uint8_t channel) {
+void IrrigationController::stopChannel(uint8_t channel, uint8_t reason) {
     if (channel == 0) {
         // Stop all channels
         DEBUG_PRINTLN("IrrigationController: Stopping all channels");
-        for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
-            if (_status.channelIrrigating[i]) {
-                _status.channelIrrigating[i] = false;
-                _status.channelStartTime[i] = 0;
-                _status.channelDuration[i] = 0;
+        uint64_t running = _status.channelIrrigating.bits();
+        for (uint8_t i = 0; running; i++, running >>= 1) {
+            if (running & 1) {
+                clearChannelRunning(i, reason);
                 activateValve(i + 1, false);
             }
         }
@@ -142,34 +220,18 @@ void IrrigationController::stopIrrigation(uint8_t channel) {
     } else if (channel >= 1 && channel <= MAX_CHANNELS) {
         // Stop specific channel
         DEBUG_PRINTF("IrrigationController: Stopping channel %d\n", channel);
-        uint8_t idx = channel - 1;
-        _status.channelIrrigating[idx] = false;
-        _status.channelStartTime[idx] = 0;
-        _status.channelDuration[idx] = 0;
+        clearChannelRunning(channel - 1, reason);
         activateValve(channel, false);
 
         // Update global status - check if any channel is still running
-        bool anyActive = false;
-        for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
-            if (_status.channelIrrigating[i]) {
-                anyActive = true;
-                break;
-            }
-        }
-        _status.irrigating = anyActive;
-
-        if (!anyActive) {
-            _status.manualMode = false;
-            _currentDurationMinutes = 0;
-            _status.currentDuration = 0;
-        }
+        refreshIrrigatingFlag();
     }
 
     _status.lastIrrigationTime = _currentTime;
 }
 
 void IrrigationController::updateIrrigationState() {
-    if (!_status.irrigating) {
+    if (_status.channelIrrigating.none()) {
         return;
     }
 
@@ -179,7 +241,7 @@ void IrrigationController::updateIrrigationState() {
         unsigned long elapsed = (now - _status.channelStartTime[i]) / 60000;
         if (elapsed >= _status.channelDuration[i]) {
             DEBUG_PRINTF("IrrigationController: Channel %d cycle complete\n", i + 1);
-            stopIrrigation(i + 1);
+            stopChannel(i + 1, RUN_END_COMPLETE);
         }
     }
 }
@@ -194,14 +256,12 @@ void IrrigationController::safetyCheck() {
     if (elapsedMinutes >= SAFETY_TIMEOUT_MINUTES) {
         DEBUG_PRINTLN("IrrigationController: SAFETY TIMEOUT - Stopping irrigation!");
         _status.lastError = "Safety timeout triggered";
-        stopIrrigation();
+        stopIrrigation(0, RUN_END_SAFETY);
     }
 }
 
 void IrrigationController::checkSchedules() {
     time_t now = _currentTime;
-    struct tm timeinfo;
-    localtime_r(&now, &timeinfo);
 
     for (int i = 0; i < MAX_SCHEDULES; i++) {
         if (_schedules[i].enabled && shouldRunSchedule(_schedules[i], now)) {
@@ -216,47 +276,77 @@ void IrrigationController::checkSchedules() {
             }
 
             uint8_t channel = _schedules[i].channel;
+            if (channel < 1 || channel > MAX_CHANNELS) {
+                DEBUG_PRINTF("IrrigationController: Schedule %d skipped - invalid channel %d\n", i, channel);
+                continue;
+            }
 
-            // Don't start if this channel is already running
-            if (isChannelIrrigating(channel)) {
+            // Don't start if this channel is already running (or between cycles)
+            if (isChannelIrrigating(channel) || hasCycleRun(channel)) {
                 DEBUG_PRINTF("IrrigationController: Schedule %d skipped - channel %d already running\n", i, channel);
                 continue;
             }
 
+            // Closed loop: soil still wet enough (no fresh reading = timed run)
+            float moisture;
+            if (getChannelMoisture(channel, moisture) &&
+                moisture >= _moistureLoops[channel - 1].startBelow) {
+                DEBUG_PRINTF("IrrigationController: Schedule %d skipped - channel %d moisture %.1f%% >= %d%%\n",
+                             i, channel, moisture, _moistureLoops[channel - 1].startBelow);
+                continue;
+            }
+            _moistureRun[channel - 1] = _moistureLoops[channel - 1].enabled;
+
             DEBUG_PRINTF("IrrigationController: Schedule %d triggered for channel %d\n", i, channel);
+            if (_schedules[i].cycles > 1) {
+                queueCycleRun(i);
+                continue;
+            }
+            // A remote closed-loop zone isn't synced to its slave (the probe
+            // is read here), so the master sends the start itself
+            if (channel > NUM_LOCAL_CHANNELS && _moistureLoops[channel - 1].enabled &&
+                _remoteStageCallback) {
+                _remoteStageCallback(channel, _schedules[i].durationMinutes, 0);
+            }
             startIrrigation(channel, _schedules[i].durationMinutes, false);  // scheduled = not manual
             // Note: Don't break - allow multiple channels to run simultaneously
         }
     }
 }
 
+// Drop skips whose occurrence has passed so isScheduleSkipped() changes
+// only together with the schedule generation
+void IrrigationController::expireSkips() {
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        if (_skipUntil[i] > 0 && _currentTime > _skipUntil[i]) {
+            _skipUntil[i] = 0;
+            _scheduleGeneration++;
+        }
+    }
+}
+
+// A schedule is due in the minute starting at today's local hour:minute,
+// resolved to UTC by the time zone. Matching on that instant (rather than
+// on the wall clock fields) keeps DST days deterministic: a time skipped by
+// spring-forward runs one gap later, a time repeated by fall-back runs once.
 bool IrrigationController::shouldRunSchedule(const IrrigationSchedule& schedule, time_t currentTime) {
-    struct tm timeinfo;
-    localtime_r(&currentTime, &timeinfo);
+    LocalTime local;
+    timeZone.toLocal(currentTime, local);
 
-    // Check if current day is enabled
-    uint8_t currentWeekday = timeinfo.tm_wday; // 0=Sunday
-    if (!(schedule.weekdays & (1 << currentWeekday))) {
+    // Check if current day is enabled (0=Sunday)
+    if (!(schedule.weekdays & (1 << local.weekday))) {
         return false;
     }
 
-    // Check if current time matches schedule
-    if (timeinfo.tm_hour != schedule.hour || timeinfo.tm_min != schedule.minute) {
+    time_t due = timeZone.toUtc(local.year, local.month, local.day,
+                                schedule.hour, schedule.minute);
+    if (currentTime < due || currentTime - due >= 60) {
         return false;
     }
 
     // Prevent running the same schedule multiple times in the same minute
-    if (_status.lastIrrigationTime > 0) {
-        struct tm lastRunTime;
-        localtime_r(&_status.lastIrrigationTime, &lastRunTime);
-
-        if (lastRunTime.tm_year == timeinfo.tm_year &&
-            lastRunTime.tm_mon == timeinfo.tm_mon &&
-            lastRunTime.tm_mday == timeinfo.tm_mday &&
-            lastRunTime.tm_hour == timeinfo.tm_hour &&
-            lastRunTime.tm_min == timeinfo.tm_min) {
-            return false; // Already ran this minute
-        }
+    if (_status.lastIrrigationTime >= due && _status.lastIrrigationTime - due < 60) {
+        return false;
     }
 
     return true;
@@ -359,36 +449,9 @@ unsigned long IrrigationController::getNextScheduledTime(uint8_t* nextChannel, u
             continue;
         }
 
-        struct tm timeinfo;
-        localtime_r(&now, &timeinfo);
-
         // Calculate next occurrence of this schedule
-        timeinfo.tm_hour = _schedules[i].hour;
-        timeinfo.tm_min = _schedules[i].minute;
-        timeinfo.tm_sec = 0;
-
-        time_t scheduleTime = mktime(&timeinfo);
-
-        // If this time has passed today, check tomorrow
-        if (scheduleTime <= now) {
-            scheduleTime += 86400; // Add one day
-        }
-
-        // Check if this day of week is enabled
-        struct tm futureTime;
-        localtime_r(&scheduleTime, &futureTime);
-        uint8_t weekday = futureTime.tm_wday;
-
-        // Find next enabled weekday
-        int daysToAdd = 0;
-        while (!((_schedules[i].weekdays >> weekday) & 1) && daysToAdd < 7) {
-            scheduleTime += 86400;
-            localtime_r(&scheduleTime, &futureTime);
-            weekday = futureTime.tm_wday;
-            daysToAdd++;
-        }
-
-        if (daysToAdd >= 7) {
+        time_t scheduleTime = nextOccurrence(_schedules[i], now);
+        if (scheduleTime == 0) {
             continue; // No valid day found
         }
 
@@ -418,17 +481,12 @@ void IrrigationController::skipSchedule(uint8_t index) {
 
     // Calculate the next occurrence time for this schedule
     if (!_hasValidTime) return;
-    time_t now = _currentTime;
-    struct tm timeinfo;
-    localtime_r(&now, &timeinfo);
-    timeinfo.tm_hour = _schedules[index].hour;
-    timeinfo.tm_min = _schedules[index].minute;
-    timeinfo.tm_sec = 0;
-    time_t scheduleTime = mktime(&timeinfo);
-    if (scheduleTime <= now) scheduleTime += 86400;
+    time_t scheduleTime = nextOccurrence(_schedules[index], _currentTime);
+    if (scheduleTime == 0) return;
 
     // Skip until just past this occurrence
     _skipUntil[index] = scheduleTime + 60;
+    _scheduleGeneration++;
     DEBUG_PRINTF("IrrigationController: Skipping schedule %d (ch %d) next run\n",
                  index, _schedules[index].channel);
 }
@@ -436,6 +494,7 @@ void IrrigationController::skipSchedule(uint8_t index) {
 void IrrigationController::unskipSchedule(uint8_t index) {
     if (index >= MAX_SCHEDULES) return;
     _skipUntil[index] = 0;
+    _scheduleGeneration++;
     DEBUG_PRINTF("IrrigationController: Unskipped schedule %d\n", index);
 }
 
@@ -445,7 +504,8 @@ bool IrrigationController::isScheduleSkipped(uint8_t index) const {
 }
 
 int8_t IrrigationController::addSchedule(uint8_t channel, uint8_t hour, uint8_t minute,
-                                         uint16_t durationMinutes, uint8_t weekdays) {
+                                         uint16_t durationMinutes, uint8_t weekdays,
+                                         uint8_t cycles, uint16_t soakMinutes) {
     // Validate channel
     if (channel < 1 || channel > MAX_CHANNELS) {
         DEBUG_PRINTF("Invalid channel: %d\n", channel);
@@ -464,6 +524,13 @@ int8_t IrrigationController::addSchedule(uint8_t channel, uint8_t hour, uint8_t
         return -1;
     }
 
+    // Validate cycle-and-soak
+    if (cycles < 1 || cycles > MAX_CYCLES || cycles > durationMinutes ||
+        (cycles > 1 && (soakMinutes < 1 || soakMinutes > MAX_SOAK_MINUTES))) {
+        DEBUG_PRINTLN("Invalid cycle/soak");
+        return -1;
+    }
+
     // Find free slot
     int8_t index = findFreeScheduleSlot();
     if (index < 0) {
@@ -477,6 +544,9 @@ int8_t IrrigationController::addSchedule(uint8_t channel, uint8_t hour, uint8_t
     _schedules[index].minute = minute;
     _schedules[index].durationMinutes = durationMinutes;
     _schedules[index].weekdays = weekdays;
+    _schedules[index].cycles = cycles;
+    _schedules[index].soakMinutes = (cycles > 1) ? soakMinutes : 0;
+    _scheduleGeneration++;
 
     DEBUG_PRINTF("IrrigationController: Schedule %d added: Ch%d at %02d:%02d for %d min\n",
                  index, channel, hour, minute, durationMinutes);
@@ -486,7 +556,8 @@ int8_t IrrigationController::addSchedule(uint8_t channel, uint8_t hour, uint8_t
 }
 
 bool IrrigationController::updateSchedule(uint8_t index, uint8_t channel, uint8_t hour, uint8_t minute,
-                                          uint16_t durationMinutes, uint8_t weekdays) {
+                                          uint16_t durationMinutes, uint8_t weekdays,
+                                          uint8_t cycles, uint16_t soakMinutes) {
     if (index >= MAX_SCHEDULES) {
         return false;
     }
@@ -503,11 +574,19 @@ bool IrrigationController::updateSchedule(uint8_t index, uint8_t channel, uint8_
         return false;
     }
 
+    if (cycles < 1 || cycles > MAX_CYCLES || cycles > durationMinutes ||
+        (cycles > 1 && (soakMinutes < 1 || soakMinutes > MAX_SOAK_MINUTES))) {
+        return false;
+    }
+
     _schedules[index].channel = channel;
     _schedules[index].hour = hour;
     _schedules[index].minute = minute;
     _schedules[index].durationMinutes = durationMinutes;
     _schedules[index].weekdays = weekdays;
+    _schedules[index].cycles = cycles;
+    _schedules[index].soakMinutes = (cycles > 1) ? soakMinutes : 0;
+    _scheduleGeneration++;
 
     DEBUG_PRINTF("IrrigationController: Schedule %d updated: Ch%d at %02d:%02d for %d min\n",
                  index, channel, hour, minute, durationMinutes);
@@ -521,6 +600,7 @@ bool IrrigationController::removeSchedule(uint8_t index) {
     }
 
     _schedules[index].enabled = false;
+    _scheduleGeneration++;
     DEBUG_PRINTF("IrrigationController: Schedule %d removed\n", index);
 
     return saveSchedules();
@@ -532,6 +612,7 @@ bool IrrigationController::enableSchedule(uint8_t index, bool enabled) {
     }
 
     _schedules[index].enabled = enabled;
+    _scheduleGeneration++;
     DEBUG_PRINTF("IrrigationController: Schedule %d %s\n",
                  index, enabled ? "enabled" : "disabled");
 
@@ -540,7 +621,7 @@ bool IrrigationController::enableSchedule(uint8_t index, bool enabled) {
 
 IrrigationSchedule IrrigationController::getSchedule(uint8_t index) const {
     if (index >= MAX_SCHEDULES) {
-        IrrigationSchedule empty = {false, 0, 0, 0, 0};
+        IrrigationSchedule empty = {false, 0, 0, 0, 0, 0, 1, 0};
         return empty;
     }
     return _schedules[index];
@@ -554,7 +635,7 @@ void IrrigationController::getSchedules(IrrigationSchedule* schedules, uint8_t&
 bool IrrigationController::saveSchedules() {
     DEBUG_PRINTLN("IrrigationController: Saving schedules to LittleFS");
 
-    DynamicJsonDocument doc(2048);  // Increased size for 16 schedules
+    ArenaJsonDocument doc(2048);  // Increased size for 16 schedules
     JsonArray array = doc.createNestedArray("schedules");
 
     for (int i = 0; i < MAX_SCHEDULES; i++) {
@@ -566,6 +647,10 @@ bool IrrigationController::saveSchedules() {
             schedule["minute"] = _schedules[i].minute;
             schedule["duration"] = _schedules[i].durationMinutes;
             schedule["weekdays"] = _schedules[i].weekdays;
+            if (_schedules[i].cycles > 1) {
+                schedule["cycles"] = _schedules[i].cycles;
+                schedule["soak"] = _schedules[i].soakMinutes;
+            }
         }
     }
 
@@ -596,7 +681,7 @@ bool IrrigationController::loadSchedules() {
         return false;
     }
 
-    DynamicJsonDocument doc(2048);  // Increased size for 16 schedules
+    ArenaJsonDocument doc(2048);  // Increased size for 16 schedules
     DeserializationError error = deserializeJson(doc, file);
     file.close();
 
@@ -617,6 +702,11 @@ bool IrrigationController::loadSchedules() {
         _schedules[index].minute = schedule["minute"] | 0;
         _schedules[index].durationMinutes = schedule["duration"] | DEFAULT_DURATION_MINUTES;
         _schedules[index].weekdays = schedule["weekdays"] | 0x7F;
+        _schedules[index].cycles = schedule["cycles"] | 1;
+        _schedules[index].soakMinutes = schedule["soak"] | 0;
+        if (_schedules[index].cycles < 1 || _schedules[index].cycles > MAX_CYCLES) {
+            _schedules[index].cycles = 1;
+        }
 
         index++;
     }
@@ -639,7 +729,8 @@ bool IrrigationController::isChannelInverted(uint8_t channel) const {
 void IrrigationController::setChannelInverted(uint8_t channel, bool inverted) {
     if (channel < 1 || channel > MAX_CHANNELS) return;
     uint8_t idx = channel - 1;
-    _status.channelInverted[idx] = inverted;
+    _status.channelInverted.set(idx, inverted);
+    _channelGeneration++;
 
     // Update the valve's invert setting (local channels only)
     if (idx < NUM_LOCAL_CHANNELS && _valves[idx]) {
@@ -657,13 +748,15 @@ bool IrrigationController::isChannelEnabled(uint8_t channel) const {
 
 void IrrigationController::setChannelEnabled(uint8_t channel, bool enabled) {
     if (channel < 1 || channel > MAX_CHANNELS) return;
-    _channelEnabled[channel - 1] = enabled;
+    _channelEnabled.set(channel - 1, enabled);
+    _channelGeneration++;
+    _scheduleGeneration++;
     saveChannelSettings();
     DEBUG_PRINTF("IrrigationController: Channel %d enabled set to %d\n", channel, enabled);
 }
 
 bool IrrigationController::saveChannelSettings() {
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
 
     JsonArray inverted = doc.createNestedArray("inverted");
     for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
@@ -689,9 +782,7 @@ bool IrrigationController::saveChannelSettings() {
 
 bool IrrigationController::loadChannelSettings() {
     // Initialize defaults
-    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
-        _status.channelInverted[i] = false;
-    }
+    _status.channelInverted.clear();
 
     if (!LittleFS.exists("/channel_settings.json")) {
         DEBUG_PRINTLN("IrrigationController: No channel settings file, using defaults");
@@ -704,7 +795,7 @@ bool IrrigationController::loadChannelSettings() {
         return false;
     }
 
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
     DeserializationError error = deserializeJson(doc, file);
     file.close();
 
@@ -715,13 +806,13 @@ bool IrrigationController::loadChannelSettings() {
 
     JsonArray inverted = doc["inverted"];
     for (uint8_t i = 0; i < MAX_CHANNELS && i < inverted.size(); i++) {
-        _status.channelInverted[i] = inverted[i] | false;
+        _status.channelInverted.set(i, inverted[i] | false);
     }
 
     JsonArray enabled = doc["enabled"];
     if (enabled.size() > 0) {
         for (uint8_t i = 0; i < NUM_LOCAL_CHANNELS && i < enabled.size(); i++) {
-            _channelEnabled[i] = enabled[i] | false;
+            _channelEnabled.set(i, enabled[i] | false);
         }
     }
 
@@ -741,8 +832,11 @@ void IrrigationController::setRemoteChannelStatus(uint8_t channel, bool irrigati
     if (channel < 1 || channel > MAX_CHANNELS) return;
     uint8_t idx = channel - 1;
 
-    bool wasIrrigating = _status.channelIrrigating[idx];
-    _status.channelIrrigating[idx] = irrigating;
+    bool wasIrrigating = _status.channelIrrigating.set(idx, irrigating);
+    if (irrigating != wasIrrigating) {
+        _channelGeneration++;
+        _channelChangedAt[idx] = millis();
+    }
 
     if (irrigating) {
         // Approximate start time and duration from remaining seconds
@@ -756,12 +850,598 @@ void IrrigationController::setRemoteChannelStatus(uint8_t channel, bool irrigati
     }
 
     // Update global irrigating flag
-    bool anyActive = false;
+    _status.irrigating = _status.channelIrrigating.any();
+}
+
+// A slave's own view of one of its channels. The master's run state is the
+// desired state and a slave that disagrees is corrected by the state vector
+// in the next heartbeat. A report is only adopted for a run the slave
+// started after the master last touched the channel (its own schedule or
+// web UI), for a run that is finished anyway, or for a fault stop.
+void IrrigationController::reportRemoteChannel(uint8_t channel, uint8_t state, uint16_t remainingSec,
+                                               uint16_t elapsedSec) {
+    if (channel <= NUM_LOCAL_CHANNELS || channel > MAX_CHANNELS) return;
+    uint8_t idx = channel - 1;
+
+    if (state == 1) {
+        if (_status.channelIrrigating[idx]) return;
+        unsigned long startedAt = millis() - (unsigned long)elapsedSec * 1000UL;
+        if (_channelChangedAt[idx] != 0 && (long)(startedAt - _channelChangedAt[idx]) <= 0) {
+            return;  // Started before our last stop: the stop was lost
+        }
+        setRemoteChannelStatus(channel, true, remainingSec);
+        _channelChangedAt[idx] = startedAt;
+        return;
+    }
+    if (!_status.channelIrrigating[idx]) return;
+
+    if (state == 2) {
+        DEBUG_PRINTF("IrrigationController: Channel %d faulted on its node, run ended\n", channel);
+        cancelCycleRuns(channel);
+    } else if (getChannelRemaining(channel) > NODE_RECONCILE_TOLERANCE) {
+        return;  // Diverged: the next heartbeat restarts it
+    }
+    clearChannelRunning(idx);
+    refreshIrrigatingFlag();
+}
+
+unsigned long IrrigationController::getChannelRemaining(uint8_t channel) const {
+    if (channel < 1 || channel > MAX_CHANNELS) return 0;
+    uint8_t idx = channel - 1;
+    if (!_status.channelIrrigating[idx]) return 0;
+
+    unsigned long elapsed = (millis() - _status.channelStartTime[idx]) / 1000;
+    unsigned long total = (unsigned long)_status.channelDuration[idx] * 60;
+    return (elapsed < total) ? total - elapsed : 0;
+}
+
+unsigned long IrrigationController::getChannelChangedAt(uint8_t channel) const {
+    if (channel < 1 || channel > MAX_CHANNELS) return 0;
+    return _channelChangedAt[channel - 1];
+}
+
+// ============================================================================
+// Forecast
+// ============================================================================
+
+// First occurrence strictly after 'after'; 0 if no weekday is set. Resolved
+// through the time zone with the same gap/fold rules as shouldRunSchedule().
+time_t IrrigationController::nextOccurrence(const IrrigationSchedule& schedule, time_t after) const {
+    return timeZone.nextLocal(after, schedule.hour, schedule.minute, schedule.weekdays);
+}
+
+bool IrrigationController::beginForecast(ForecastCursor& cursor, uint16_t days) const {
+    if (!_hasValidTime) return false;
+    if (days > FORECAST_MAX_DAYS) days = FORECAST_MAX_DAYS;
+
+    ForecastSlot slots[MAX_SCHEDULES];
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        slots[i].hour = _schedules[i].hour;
+        slots[i].minute = _schedules[i].minute;
+        slots[i].weekdays = _schedules[i].enabled ? _schedules[i].weekdays : 0;
+    }
+    cursor.begin(timeZone, slots, MAX_SCHEDULES, _currentTime, days);
+    return true;
+}
+
+bool IrrigationController::nextForecastRun(ForecastCursor& cursor, ForecastRun& run) const {
+    int8_t best = cursor.advance(timeZone, run.start);
+    if (best < 0) return false;
+
+    const IrrigationSchedule& s = _schedules[best];
+    run.scheduleIndex = best;
+    run.channel = s.channel;
+    run.durationMinutes = s.durationMinutes;
+    run.cycles = s.cycles;
+    run.soakMinutes = s.soakMinutes;
+    run.skipped = _skipUntil[best] > 0 && run.start <= _skipUntil[best];
+    run.closedLoop = s.channel >= 1 && s.channel <= MAX_CHANNELS &&
+                     _moistureLoops[s.channel - 1].enabled;
+    return true;
+}
+
+// ============================================================================
+// Fault hold
+// ============================================================================
+
+void IrrigationController::setChannelFault(uint8_t channel, bool fault) {
+    if (channel < 1 || channel > MAX_CHANNELS) return;
+    uint8_t idx = channel - 1;
+    if (_channelFault[idx] == fault) return;
+
+    _channelFault[idx] = fault;
+    _channelGeneration++;
+    DEBUG_PRINTF("IrrigationController: Channel %d fault %s\n", channel, fault ? "SET" : "cleared");
+    if (fault && (_status.channelIrrigating[idx] || hasCycleRun(channel))) {
+        stopIrrigation(channel, RUN_END_FAULT);
+    }
+}
+
+bool IrrigationController::isChannelFaulted(uint8_t channel) const {
+    if (channel < 1 || channel > MAX_CHANNELS) return false;
+    return _channelFault[channel - 1];
+}
+
+// ============================================================================
+// Cycle-and-soak interleaver
+// ============================================================================
+//
+// A schedule with cycles > 1 is split into equal cycles separated by soak
+// gaps. Runs are not tied to wall-clock slots: whenever a supply slot frees
+// up (CYCLE_SOAK_CONCURRENCY), the run whose soak ended first gets it, so one
+// zone's soak is filled by another zone's cycle.
+//
+// Remote channels are pre-staged: the start is sent CYCLE_PRESTAGE_MS ahead
+// with a delay, and the slave opens the valve on its own timer. Command
+// latency and retries therefore eat into the lead time rather than into the
+// soak or the following zone's cycle.
+
+void IrrigationController::queueCycleRun(uint8_t scheduleIndex) {
+    const IrrigationSchedule& sched = _schedules[scheduleIndex];
+
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        CycleRun& run = _cycleRuns[i];
+        if (run.active) continue;
+
+        run.active = true;
+        run.channel = sched.channel;
+        run.state = CYCLE_IDLE;
+        run.cyclesLeft = sched.cycles;
+        run.minutesLeft = sched.durationMinutes;
+        run.cycleMinutes = (sched.durationMinutes + sched.cycles - 1) / sched.cycles;
+        run.soakMinutes = sched.soakMinutes;
+        run.readyAt = millis();
+        run.startAt = 0;
+        _channelGeneration++;  // Queued run reports as soaking
+
+        DEBUG_PRINTF("IrrigationController: Channel %d queued for %d x %d min (soak %d min)\n",
+                     run.channel, run.cyclesLeft, run.cycleMinutes, run.soakMinutes);
+        return;
+    }
+    DEBUG_PRINTF("IrrigationController: No free cycle slot for schedule %d\n", scheduleIndex);
+}
+
+// Earliest start (ms relative to now, >= earliest) at which a cycle of
+// lengthMs fits without exceeding CYCLE_SOAK_CONCURRENCY.
+long IrrigationController::nextCycleSlot(long earliest, long lengthMs, unsigned long now) const {
+    long best = -1;
+
+    for (int8_t c = -1; c < MAX_SCHEDULES; c++) {
+        long t = earliest;
+        if (c >= 0) {
+            const CycleRun& r = _cycleRuns[c];
+            if (!r.active || r.state == CYCLE_IDLE) continue;
+            t = (long)(r.startAt - now) + (long)r.cycleMinutes * 60000L;
+            if (t < earliest) continue;
+        }
+        if (best >= 0 && t >= best) continue;
+
+        // Concurrency only rises where a run starts: probe t and every
+        // committed start inside [t, t + lengthMs)
+        bool fits = true;
+        for (int8_t p = -1; p < MAX_SCHEDULES && fits; p++) {
+            long point = t;
+            if (p >= 0) {
+                const CycleRun& r = _cycleRuns[p];
+                if (!r.active || r.state == CYCLE_IDLE) continue;
+                point = (long)(r.startAt - now);
+                if (point <= t || point >= t + lengthMs) continue;
+            }
+            uint8_t busy = 0;
+            for (uint8_t k = 0; k < MAX_SCHEDULES; k++) {
+                const CycleRun& r = _cycleRuns[k];
+                if (!r.active || r.state == CYCLE_IDLE) continue;
+                long rStart = (long)(r.startAt - now);
+                long rEnd = rStart + (long)r.cycleMinutes * 60000L;
+                if (rStart <= point && rEnd > point) busy++;
+            }
+            if (busy >= CYCLE_SOAK_CONCURRENCY) fits = false;
+        }
+        if (fits) best = t;
+    }
+    return best;
+}
+
+void IrrigationController::processCycleRuns() {
+    unsigned long now = millis();
+    bool any = false;
+
+    // Advance committed cycles
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        CycleRun& run = _cycleRuns[i];
+        if (!run.active) continue;
+        any = true;
+
+        if (run.state == CYCLE_STAGED && (long)(now - run.startAt) >= 0) {
+            // The slave opens the valve on its own; this only mirrors the
+            // state locally (activateValve skips scheduled remote starts).
+            startIrrigation(run.channel, run.cycleMinutes, false);
+            run.state = CYCLE_RUNNING;
+        }
+
+        if (run.state == CYCLE_RUNNING &&
+            (long)(now - run.startAt) >= (long)run.cycleMinutes * 60000L) {
+            run.cyclesLeft--;
+            run.minutesLeft = (run.minutesLeft > run.cycleMinutes) ? run.minutesLeft - run.cycleMinutes : 0;
+            if (run.cyclesLeft == 0 || run.minutesLeft == 0) {
+                DEBUG_PRINTF("IrrigationController: Channel %d cycle-and-soak complete\n", run.channel);
+                run.active = false;
+                _channelGeneration++;
+                continue;
+            }
+            run.cycleMinutes = (run.minutesLeft + run.cyclesLeft - 1) / run.cyclesLeft;
+            run.readyAt = now + (unsigned long)run.soakMinutes * 60000UL;
+            run.state = CYCLE_IDLE;
+            _channelGeneration++;
+            DEBUG_PRINTF("IrrigationController: Channel %d soaking %d min (%d cycles left)\n",
+                         run.channel, run.soakMinutes, run.cyclesLeft);
+        }
+    }
+    if (!any) return;
+
+    // Hand free slots to waiting runs, earliest soak end first
+    while (true) {
+        int8_t next = -1;
+        for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+            const CycleRun& run = _cycleRuns[i];
+            if (!run.active || run.state != CYCLE_IDLE) continue;
+            if (next < 0 || (long)(run.readyAt - _cycleRuns[next].readyAt) < 0) next = i;
+        }
+        if (next < 0) break;
+
+        CycleRun& run = _cycleRuns[next];
+        long ready = (long)(run.readyAt - now);
+        if (ready < 0) ready = 0;
+        long slot = nextCycleSlot(ready, (long)run.cycleMinutes * 60000L, now);
+        if (slot < 0) break;
+
+        bool remote = run.channel > NUM_LOCAL_CHANNELS;
+        if (!remote) {
+            if (slot > 0) break;
+            startIrrigation(run.channel, run.cycleMinutes, false);
+            run.startAt = now;
+            run.state = CYCLE_RUNNING;
+        } else {
+            if (slot > CYCLE_PRESTAGE_MS) break;
+            if (_remoteStageCallback) {
+                _remoteStageCallback(run.channel, run.cycleMinutes, (uint16_t)slot);
+            }
+            run.startAt = now + slot;
+            run.state = CYCLE_STAGED;
+            _channelGeneration++;
+            DEBUG_PRINTF("IrrigationController: Channel %d cycle staged in %ld ms\n",
+                         run.channel, slot);
+        }
+    }
+}
+
+void IrrigationController::cancelCycleRuns(uint8_t channel) {
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        CycleRun& run = _cycleRuns[i];
+        if (!run.active) continue;
+        if (channel != 0 && run.channel != channel) continue;
+
+        // A staged start is already on the slave; withdraw it
+        if (run.state == CYCLE_STAGED) {
+            activateValve(run.channel, false);
+        }
+        DEBUG_PRINTF("IrrigationController: Channel %d remaining cycles cancelled\n", run.channel);
+        run.active = false;
+        _channelGeneration++;
+    }
+}
+
+bool IrrigationController::hasCycleRun(uint8_t channel) const {
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        if (_cycleRuns[i].active && _cycleRuns[i].channel == channel) return true;
+    }
+    return false;
+}
+
+bool IrrigationController::isChannelSoaking(uint8_t channel) const {
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++) {
+        const CycleRun& run = _cycleRuns[i];
+        if (run.active && run.channel == channel && run.state == CYCLE_IDLE) return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// Channel groups
+// ============================================================================
+//
+// Local members are switched directly. Remote members are handed to the
+// group callback in one go so NodeManager can send a single multi-channel
+// frame per node instead of one CMD_START (and outbox slot) per channel.
+
+int8_t IrrigationController::addGroup(const char* name, uint64_t members) {
+    for (uint8_t i = 0; i < MAX_GROUPS; i++) {
+        if (_groups[i].enabled) continue;
+        if (!updateGroup(i, name, members)) return -1;
+        return i;
+    }
+    DEBUG_PRINTLN("No free group slots");
+    return -1;
+}
+
+bool IrrigationController::updateGroup(uint8_t index, const char* name, uint64_t members) {
+    if (index >= MAX_GROUPS || !name || !name[0]) return false;
+
+    // Only channels that exist on this build
+    if (members == 0 || (members & ~ChannelMask<MAX_CHANNELS>::all())) return false;
+
+    _groups[index].enabled = true;
+    strncpy(_groups[index].name, name, GROUP_NAME_LEN - 1);
+    _groups[index].name[GROUP_NAME_LEN - 1] = '\0';
+    _groups[index].members = members;
+
+    DEBUG_PRINTF("IrrigationController: Group %d '%s' members=0x%016llX\n",
+                 index, _groups[index].name, (unsigned long long)members);
+    return saveGroups();
+}
+
+bool IrrigationController::removeGroup(uint8_t index) {
+    if (index >= MAX_GROUPS) return false;
+    memset(&_groups[index], 0, sizeof(ChannelGroup));
+    DEBUG_PRINTF("IrrigationController: Group %d removed\n", index);
+    return saveGroups();
+}
+
+ChannelGroup IrrigationController::getGroup(uint8_t index) const {
+    if (index >= MAX_GROUPS) {
+        ChannelGroup empty = {};
+        return empty;
+    }
+    return _groups[index];
+}
+
+void IrrigationController::startGroup(uint8_t index, uint16_t durationMinutes) {
+    if (index >= MAX_GROUPS || !_groups[index].enabled) return;
+
+    if (durationMinutes < MIN_DURATION_MINUTES) durationMinutes = MIN_DURATION_MINUTES;
+    if (durationMinutes > MAX_DURATION_MINUTES) durationMinutes = MAX_DURATION_MINUTES;
+
+    DEBUG_PRINTF("IrrigationController: Starting group %d '%s' for %d minutes\n",
+                 index, _groups[index].name, durationMinutes);
+
+    uint64_t remote = 0;
     for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
-        if (_status.channelIrrigating[i]) {
-            anyActive = true;
-            break;
+        if (!(_groups[index].members & (1ULL << i))) continue;
+        if (i < NUM_LOCAL_CHANNELS) {
+            startIrrigation(i + 1, durationMinutes, true);
+        } else {
+            markChannelRunning(i, durationMinutes);
+            static_cast<RemoteValve*>(_valves[i])->setActive(true);
+            remote |= (1ULL << i);
         }
     }
-    _status.irrigating = anyActive;
+
+    if (remote && _remoteGroupCallback) {
+        _remoteGroupCallback(index, remote, true, durationMinutes);
+    }
+}
+
+void IrrigationController::stopGroup(uint8_t index) {
+    if (index >= MAX_GROUPS || !_groups[index].enabled) return;
+
+    DEBUG_PRINTF("IrrigationController: Stopping group %d '%s'\n", index, _groups[index].name);
+
+    uint64_t remote = 0;
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        if (!(_groups[index].members & (1ULL << i))) continue;
+        cancelCycleRuns(i + 1);
+        if (i < NUM_LOCAL_CHANNELS) {
+            stopChannel(i + 1);
+        } else {
+            clearChannelRunning(i);
+            static_cast<RemoteValve*>(_valves[i])->setActive(false);
+            remote |= (1ULL << i);
+        }
+    }
+
+    if (remote) {
+        refreshIrrigatingFlag();
+        _status.lastIrrigationTime = _currentTime;
+        if (_remoteGroupCallback) {
+            _remoteGroupCallback(index, remote, false, 0);
+        }
+    }
+}
+
+bool IrrigationController::isGroupRunning(uint8_t index) const {
+    if (index >= MAX_GROUPS || !_groups[index].enabled) return false;
+    return _status.channelIrrigating.intersects(_groups[index].members);
+}
+
+bool IrrigationController::saveGroups() {
+    ArenaJsonDocument doc(1536);
+    JsonArray array = doc.createNestedArray("groups");
+
+    for (uint8_t i = 0; i < MAX_GROUPS; i++) {
+        if (!_groups[i].enabled) continue;
+        JsonObject group = array.createNestedObject();
+        group["id"] = i;
+        group["name"] = _groups[i].name;
+        JsonArray channels = group.createNestedArray("channels");
+        for (uint8_t c = 0; c < MAX_CHANNELS; c++) {
+            if (_groups[i].members & (1ULL << c)) channels.add(c + 1);
+        }
+    }
+
+    File file = LittleFS.open(GROUPS_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("IrrigationController: Failed to open groups file for writing");
+        return false;
+    }
+
+    serializeJson(doc, file);
+    file.close();
+    return true;
+}
+
+bool IrrigationController::loadGroups() {
+    if (!LittleFS.exists(GROUPS_FILE)) {
+        return false;
+    }
+
+    File file = LittleFS.open(GROUPS_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("IrrigationController: Failed to open groups file");
+        return false;
+    }
+
+    ArenaJsonDocument doc(1536);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        DEBUG_PRINTF("IrrigationController: Failed to parse groups file: %s\n", error.c_str());
+        return false;
+    }
+
+    uint8_t loaded = 0;
+    for (JsonObject group : doc["groups"].as<JsonArray>()) {
+        uint8_t id = group["id"] | 255;
+        if (id >= MAX_GROUPS) continue;
+
+        uint64_t members = 0;
+        for (uint8_t ch : group["channels"].as<JsonArray>()) {
+            if (ch >= 1 && ch <= MAX_CHANNELS) members |= (1ULL << (ch - 1));
+        }
+        if (members == 0) continue;
+
+        _groups[id].enabled = true;
+        strncpy(_groups[id].name, group["name"] | "Group", GROUP_NAME_LEN - 1);
+        _groups[id].name[GROUP_NAME_LEN - 1] = '\0';
+        _groups[id].members = members;
+        loaded++;
+    }
+
+    DEBUG_PRINTF("IrrigationController: Loaded %d groups\n", loaded);
+    return true;
+}
+
+// ============================================================================
+// Closed-loop zones
+// ============================================================================
+//
+// A closed-loop zone keeps its schedules: the trigger time decides when the
+// zone may water, the probe decides whether it does. Runs start only below
+// startBelow and stop early at stopAt, so the gap between the two is the
+// hysteresis band. Without a fresh reading the schedule runs as a plain
+// timed run, and the schedule duration always caps the run.
+
+bool IrrigationController::setMoistureLoop(uint8_t channel, const MoistureLoop& loop) {
+    if (channel < 1 || channel > MAX_CHANNELS) return false;
+    if (loop.enabled) {
+        if (loop.sensorId[0] == '\0') return false;
+        if (loop.probe < 1 || loop.probe > SENSOR_MAX_PROBES) return false;
+        if (loop.startBelow >= loop.stopAt || loop.stopAt > 100) return false;
+    }
+
+    _moistureLoops[channel - 1] = loop;
+    _moistureLoops[channel - 1].sensorId[sizeof(loop.sensorId) - 1] = '\0';
+    if (!loop.enabled) _moistureRun[channel - 1] = false;
+
+    DEBUG_PRINTF("IrrigationController: Channel %d closed loop %s (sensor=%s probe=%d %d-%d%%)\n",
+                 channel, loop.enabled ? "on" : "off", loop.sensorId, loop.probe,
+                 loop.startBelow, loop.stopAt);
+    return saveMoistureLoops();
+}
+
+MoistureLoop IrrigationController::getMoistureLoop(uint8_t channel) const {
+    if (channel < 1 || channel > MAX_CHANNELS) {
+        MoistureLoop empty = {};
+        return empty;
+    }
+    return _moistureLoops[channel - 1];
+}
+
+bool IrrigationController::getChannelMoisture(uint8_t channel, float& moisture) const {
+    if (channel < 1 || channel > MAX_CHANNELS) return false;
+    const MoistureLoop& loop = _moistureLoops[channel - 1];
+    if (!loop.enabled || !_moistureProvider) return false;
+    return _moistureProvider(loop.sensorId, loop.probe, moisture);
+}
+
+void IrrigationController::checkMoistureLoops() {
+    for (uint8_t ch = 1; ch <= MAX_CHANNELS; ch++) {
+        uint8_t idx = ch - 1;
+        if (!_moistureRun[idx]) continue;
+
+        // Run ended on its own (duration cap, manual stop, ...)
+        if (!_status.channelIrrigating[idx] && !hasCycleRun(ch)) {
+            _moistureRun[idx] = false;
+            continue;
+        }
+
+        float moisture;
+        if (getChannelMoisture(ch, moisture) && moisture >= _moistureLoops[idx].stopAt) {
+            DEBUG_PRINTF("IrrigationController: Channel %d reached %.1f%% (target %d%%), stopping\n",
+                         ch, moisture, _moistureLoops[idx].stopAt);
+            _moistureRun[idx] = false;
+            stopIrrigation(ch, RUN_END_MOISTURE);
+        }
+    }
+}
+
+bool IrrigationController::saveMoistureLoops() {
+    ArenaJsonDocument doc(1536);
+    JsonArray array = doc.createNestedArray("loops");
+
+    for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+        const MoistureLoop& loop = _moistureLoops[i];
+        if (!loop.enabled) continue;
+        JsonObject entry = array.createNestedObject();
+        entry["channel"] = i + 1;
+        entry["sensor"] = loop.sensorId;
+        entry["probe"] = loop.probe;
+        entry["start_below"] = loop.startBelow;
+        entry["stop_at"] = loop.stopAt;
+    }
+
+    File file = LittleFS.open(MOISTURE_LOOPS_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("IrrigationController: Failed to open moisture loops file for writing");
+        return false;
+    }
+
+    serializeJson(doc, file);
+    file.close();
+    return true;
+}
+
+bool IrrigationController::loadMoistureLoops() {
+    if (!LittleFS.exists(MOISTURE_LOOPS_FILE)) {
+        return false;
+    }
+
+    File file = LittleFS.open(MOISTURE_LOOPS_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("IrrigationController: Failed to open moisture loops file");
+        return false;
+    }
+
+    ArenaJsonDocument doc(1536);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        DEBUG_PRINTF("IrrigationController: Failed to parse moisture loops file: %s\n", error.c_str());
+        return false;
+    }
+
+    for (JsonObject entry : doc["loops"].as<JsonArray>()) {
+        uint8_t ch = entry["channel"] | 0;
+        if (ch < 1 || ch > MAX_CHANNELS) continue;
+
+        MoistureLoop& loop = _moistureLoops[ch - 1];
+        strncpy(loop.sensorId, entry["sensor"] | "", sizeof(loop.sensorId) - 1);
+        loop.sensorId[sizeof(loop.sensorId) - 1] = '\0';
+        loop.probe = entry["probe"] | 1;
+        loop.startBelow = entry["start_below"] | 0;
+        loop.stopAt = entry["stop_at"] | 0;
+        loop.enabled = loop.sensorId[0] != '\0' && loop.startBelow < loop.stopAt;
+    }
+    return true;
 }
@@ -0,0 +1,82 @@
+#include "JsonArena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_BLOCK   0xFFFFFFFFUL
+#define FREE_FLAG  0x80000000UL
+
+JsonArena::JsonArena()
+    : _top(0),
+      _last(NO_BLOCK),
+      _highWater(0),
+      _allocations(0),
+      _fallbacks(0) {
+}
+
+bool JsonArena::owns(const void* ptr) const {
+    return (const uint8_t*)ptr >= _buffer && (const uint8_t*)ptr < _buffer + JSON_ARENA_SIZE;
+}
+
+void* JsonArena::allocate(size_t size) {
+    _allocations++;
+    size = (size + 7) & ~(size_t)7;
+    if (_top + sizeof(Block) + size > JSON_ARENA_SIZE) {
+        _fallbacks++;
+        return malloc(size);
+    }
+
+    Block* block = (Block*)(_buffer + _top);
+    block->prev = _last;
+    block->size = size;
+    _last = _top;
+    _top += sizeof(Block) + size;
+    if (_top > _highWater) _highWater = _top;
+    return block + 1;
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (!ptr) return;
+    if (!owns(ptr)) {
+        free(ptr);
+        return;
+    }
+
+    blockOf(ptr)->size |= FREE_FLAG;
+
+    // Pop every released block from the top down
+    while (_last != NO_BLOCK) {
+        Block* top = (Block*)(_buffer + _last);
+        if (!(top->size & FREE_FLAG)) break;
+        _top = _last;
+        _last = top->prev;
+    }
+}
+
+// Only shrinkToFit() and garbageCollect() get here; the topmost block is
+// resized in place, anything else moves
+void* JsonArena::reallocate(void* ptr, size_t size) {
+    if (!ptr) return allocate(size);
+    if (!owns(ptr)) return realloc(ptr, size);
+
+    Block* block = blockOf(ptr);
+    uint32_t offset = (uint8_t*)block - _buffer;
+    size_t aligned = (size + 7) & ~(size_t)7;
+    if (offset == _last && offset + sizeof(Block) + aligned <= JSON_ARENA_SIZE) {
+        block->size = aligned;
+        _top = offset + sizeof(Block) + aligned;
+        if (_top > _highWater) _highWater = _top;
+        return ptr;
+    }
+
+    void* moved = allocate(size);
+    if (!moved) return nullptr;
+    memcpy(moved, ptr, block->size < size ? block->size : size);
+    deallocate(ptr);
+    return moved;
+}
+
+void JsonArena::resetStats() {
+    _highWater = _top;
+    _allocations = 0;
+    _fallbacks = 0;
+}
@@ -0,0 +1,51 @@
+#include "LatencyStats.h"
+#include <string.h>
+
+void LatencyStats::reset() {
+    memset(_buckets, 0, sizeof(_buckets));
+    _count = 0;
+    _max = 0;
+    _sum = 0;
+}
+
+void LatencyStats::record(uint32_t micros) {
+    _buckets[bucketOf(micros)]++;
+    _count++;
+    _sum += micros;
+    if (micros > _max) _max = micros;
+}
+
+// Octave from the highest set bit, sub-bucket from the next two bits
+uint8_t LatencyStats::bucketOf(uint32_t micros) {
+    if (micros < LATENCY_SUB_BUCKETS) return micros;
+    uint8_t octave = 31 - __builtin_clz(micros);               // >= 2
+    uint8_t sub = (micros >> (octave - 2)) & (LATENCY_SUB_BUCKETS - 1);
+    uint16_t bucket = (octave - 1) * LATENCY_SUB_BUCKETS + sub;
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+uint32_t LatencyStats::upperBound(uint8_t bucket) {
+    if (bucket < LATENCY_SUB_BUCKETS) return bucket;
+    uint8_t octave = bucket / LATENCY_SUB_BUCKETS + 1;
+    uint8_t sub = bucket % LATENCY_SUB_BUCKETS;
+    uint64_t low = ((uint64_t)(LATENCY_SUB_BUCKETS + sub)) << (octave - 2);
+    uint64_t high = low + (1ULL << (octave - 2)) - 1;
+    return high > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)high;
+}
+
+uint32_t LatencyStats::percentile(float p) const {
+    if (_count == 0) return 0;
+    uint32_t rank = (uint32_t)(p / 100.0f * _count + 0.5f);
+    if (rank < 1) rank = 1;
+    if (rank > _count) rank = _count;
+
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += _buckets[b];
+        if (seen >= rank) {
+            uint32_t bound = upperBound(b);
+            return (bound < _max && b < LATENCY_BUCKETS - 1) ? bound : _max;
+        }
+    }
+    return _max;
+}
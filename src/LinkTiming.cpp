@@ -0,0 +1,71 @@
+#include "LinkTiming.h"
+
+void LinkTiming::trackRx(LinkStats& link, uint16_t seq) {
+    uint16_t lost = 0;
+    if (link.seq_valid) {
+        uint16_t step = seq - link.last_seq;
+        if (step == 0 || step > (uint16_t)(0x10000 - LINK_SEQ_REORDER)) {
+            return;  // Late or repeated frame, already counted as lost
+        }
+        if (step <= LINK_SEQ_RESYNC) lost = step - 1;  // Else the slave restarted
+    }
+    link.last_seq = seq;
+    link.seq_valid = true;
+
+    link.rx_total++;
+    link.lost_total += lost;
+    link.win_rx++;
+    link.win_lost += lost;
+    if (link.win_rx + link.win_lost >= LINK_LOSS_WINDOW) {
+        link.prev_rx = link.win_rx;
+        link.prev_lost = link.win_lost;
+        link.win_rx = 0;
+        link.win_lost = 0;
+    }
+}
+
+float LinkTiming::loss(const LinkStats& link) {
+    uint32_t rx = link.win_rx + link.prev_rx;
+    uint32_t lost = link.win_lost + link.prev_lost;
+    return (rx + lost > 0) ? (float)lost / (rx + lost) : 0.0f;
+}
+
+uint8_t LinkTiming::timeoutMisses(const LinkStats& link) {
+    float p = loss(link);
+    uint8_t misses = NODE_TIMEOUT_MISSES;
+    float chance = 1.0f;
+    for (uint8_t k = 0; k < misses; k++) chance *= p;
+    while (chance > NODE_TIMEOUT_FALSE_RATE && misses < NODE_TIMEOUT_MAX_MISSES) {
+        chance *= p;
+        misses++;
+    }
+    return misses;
+}
+
+uint32_t LinkTiming::interval(bool active, const LinkStats& link) {
+    uint32_t base = active ? NODE_HEARTBEAT_FAST : NODE_HEARTBEAT_IDLE;
+    uint32_t ms = base * NODE_TIMEOUT_MISSES / timeoutMisses(link);
+    return (ms < NODE_HEARTBEAT_MIN) ? NODE_HEARTBEAT_MIN : ms;
+}
+
+// k misses of an interval, but no more than a clean link allows at its
+// base. The loss estimate moves with every frame heard, while the slave
+// keeps the interval it was given until the next ACK gets through; without
+// the cap a rising estimate would stretch detection far past the clean-link
+// deadline. Only an interval held up by NODE_HEARTBEAT_MIN needs the full
+// k. Idle intervals never drop to fast ones, so the base follows from the
+// interval.
+static uint32_t allowance(uint32_t interval, uint8_t misses) {
+    uint32_t ms = interval * misses;
+    if (interval <= NODE_HEARTBEAT_MIN) return ms;
+    uint32_t base = (interval > NODE_HEARTBEAT_FAST) ? NODE_HEARTBEAT_IDLE : NODE_HEARTBEAT_FAST;
+    uint32_t cap = base * NODE_TIMEOUT_MISSES;
+    return (ms > cap) ? cap : ms;
+}
+
+uint32_t LinkTiming::deadline(uint32_t interval, uint32_t prevInterval, const LinkStats& link) {
+    uint8_t misses = timeoutMisses(link);
+    uint32_t current = allowance(interval, misses);
+    uint32_t previous = allowance(prevInterval, misses);
+    return ((previous > current) ? previous : current) + NODE_TIMEOUT_MARGIN;
+}
@@ -1,7 +1,11 @@
 #include "NodeManager.h"
 #include "IrrigationController.h"
+#include "SoilSensor.h"
+#include "FirmwareUpdater.h"
+#include "CrashLog.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include "JsonArena.h"
 
 NodeManager::NodeManager(IrrigationController* controller, const char* nodeId,
                          uint8_t role, const char* nodeName)
@@ -9,6 +13,9 @@ NodeManager::NodeManager(IrrigationController* controller, const char* nodeId,
       _controller(controller),
       _seq(0),
       _slaveCount(0),
+      _sensorCount(0),
+      _peerGeneration(1),
+      _soilSensor(nullptr),
       _masterPort(NODE_UDP_PORT),
       _masterFound(false),
       _lastMdnsQuery(0),
@@ -16,19 +23,38 @@ NodeManager::NodeManager(IrrigationController* controller, const char* nodeId,
       _dedupIdx(0),
       _lastHeartbeat(0),
       _lastStatusSend(0),
+      _hbInterval(NODE_HEARTBEAT_IDLE),
       _initialized(false),
       _pairRequestCallback(nullptr),
       _paired(false),
       _assignedVirtualCh(0),
-      _lastPairAttempt(0) {
+      _lastPairAttempt(0),
+      _reconciled(0),
+      _lastRunBatch(0),
+      _updater(nullptr),
+      _rolloutState(ROLLOUT_IDLE),
+      _updaterSeen(0),
+      _selfUpdate(false),
+      _otaReported(0),
+      _lastOtaStatus(0),
+      _storedCount(0),
+      _groupAckCallback(nullptr) {
     memset(_nodeId, 0, sizeof(_nodeId));
     strncpy(_nodeId, nodeId ? nodeId : DEFAULT_NODE_ID, sizeof(_nodeId) - 1);
     memset(_slaves, 0, sizeof(_slaves));
+    memset(_sensors, 0, sizeof(_sensors));
     memset(_masterNodeId, 0, sizeof(_masterNodeId));
     memset(_outbox, 0, sizeof(_outbox));
     memset(_dedup, 0, sizeof(_dedup));
+    memset(_staged, 0, sizeof(_staged));
+    memset(_groupTrackers, 0, sizeof(_groupTrackers));
+    memset(_stored, 0, sizeof(_stored));
+    memset(_lastCmdSeq, 0, sizeof(_lastCmdSeq));
+    memset(_groupAckState, 0, sizeof(_groupAckState));
     memset(&_pendingPair, 0, sizeof(_pendingPair));
     memset(_nodeName, 0, sizeof(_nodeName));
+    memset(_haltedTarget, 0, sizeof(_haltedTarget));
+    memset(_otaOrder, 0, sizeof(_otaOrder));
     strncpy(_nodeName, nodeName ? nodeName : "Slave", sizeof(_nodeName) - 1);
 }
 
@@ -51,15 +77,21 @@ bool NodeManager::begin() {
     // Load pairing state from LittleFS
     if (_role == NODE_ROLE_MASTER) {
         loadPairedSlaves();
+        loadPairedSensors();
+        loadStoredCommands();
+        loadRunHistory();
+        loadRolloutState();
     } else {
         loadPairedMaster();
+        loadRunJournal();
     }
 
-    const char* roleStr = (_role == NODE_ROLE_MASTER) ? "MASTER" : "SLAVE";
+    const char* roleStr = (_role == NODE_ROLE_MASTER) ? "MASTER" :
+                          (_role == NODE_ROLE_SENSOR) ? "SENSOR" : "SLAVE";
     DEBUG_PRINTF("NodeManager: UDP listening on port %d, role=%s, node_id=%s\n",
                  NODE_UDP_PORT, roleStr, _nodeId);
 
-    if (_role == NODE_ROLE_SLAVE) {
+    if (_role != NODE_ROLE_MASTER) {
         DEBUG_PRINTF("NodeManager: paired=%d, name=%s\n", _paired, _nodeName);
     }
 
@@ -88,15 +120,20 @@ void NodeManager::update() {
     unsigned long now = millis();
 
     if (_role == NODE_ROLE_MASTER) {
-        // Master: send heartbeat to all slaves periodically
-        if (now - _lastHeartbeat >= NODE_HEARTBEAT_INTERVAL) {
+        // Master: heartbeat the slaves that are due, at each one's own interval
+        if (now - _lastHeartbeat >= NODE_HEARTBEAT_MIN) {
             _lastHeartbeat = now;
             sendHeartbeat();
             checkPeerTimeouts();
+            expireStoredCommands();
+            processRollout();
         }
         // Master: auto-reject stale pending pair requests
         checkPairTimeout();
     } else {
+        // Slave: fire pre-staged starts on time, independent of the network
+        processStagedStarts();
+
         // Slave: discover master if not found yet
         if (!_masterFound && _mdnsStarted) {
             if (now - _lastMdnsQuery >= NODE_MDNS_RETRY_INTERVAL) {
@@ -113,15 +150,35 @@ void NodeManager::update() {
             }
         }
 
-        // Slave: send heartbeat + status when paired
+        // Slave: send heartbeat + status when paired. Fast while a valve
+        // runs or a start is staged, otherwise at the master's interval.
         if (_masterFound && _paired) {
-            if (now - _lastHeartbeat >= NODE_HEARTBEAT_INTERVAL) {
+            bool active = isLocallyActive();
+            unsigned long hbEvery = (active && _hbInterval > NODE_HEARTBEAT_FAST) ?
+                NODE_HEARTBEAT_FAST : _hbInterval;
+            unsigned long statusEvery = active ? NODE_STATUS_FAST : _hbInterval;
+
+            if (now - _lastHeartbeat >= hbEvery) {
                 _lastHeartbeat = now;
                 sendHeartbeat();
             }
-            if (now - _lastStatusSend >= NODE_STATUS_INTERVAL) {
+            if (now - _lastStatusSend >= statusEvery) {
                 _lastStatusSend = now;
                 sendStatus();
+                sendOtaStatus();
+            } else if (_updater && _updater->getGeneration() != _otaReported &&
+                       now - _lastOtaStatus >= OTA_STATUS_MIN_GAP) {
+                sendOtaStatus();  // Job progress, without waiting for the round
+            }
+            // Slave: start an ordered install once the valves are idle
+            processOtaOrder();
+            // Sensor: report probes that left their deadband
+            if (_role == NODE_ROLE_SENSOR) {
+                sendSensorReports();
+            }
+            // Slave: ship journaled runs until the master has merged them
+            if (_runJournal.getCount() > 0 && now - _lastRunBatch >= RUN_BATCH_RETRY) {
+                sendRunBatch();
             }
         }
     }
@@ -194,7 +251,8 @@ bool NodeManager::sendUdp(IPAddress ip, uint16_t port, const IrrigationMsg& msg)
 void NodeManager::receiveUdp() {
     int packetSize = _udp.parsePacket();
     while (packetSize > 0) {
-        uint8_t buf[sizeof(IrrigationMsg)];
+        uint8_t buf[sizeof(RunBatchMsg) > sizeof(IrrigationMsg) ?
+                    sizeof(RunBatchMsg) : sizeof(IrrigationMsg)];
         int len = _udp.read(buf, sizeof(buf));
         IPAddress senderIp = _udp.remoteIP();
         uint16_t senderPort = _udp.remotePort();
@@ -215,9 +273,14 @@ void NodeManager::enqueueOutbox(const IrrigationMsg& msg, IPAddress ip, uint16_t
             _outbox[i].msg = msg;
             _outbox[i].dst_ip = ip;
             _outbox[i].dst_port = port;
-            _outbox[i].last_send = millis();
+            _outbox[i].first_send = millis();
+            _outbox[i].last_send = _outbox[i].first_send;
             _outbox[i].retries = 0;
             _outbox[i].active = true;
+            if (_role == NODE_ROLE_MASTER) {
+                NodePeer* peer = findSlaveByNodeId(msg.dst_id);
+                if (peer) peer->link.cmds_sent++;
+            }
             return;
         }
     }
@@ -233,15 +296,31 @@ void NodeManager::processOutbox() {
         unsigned long interval = 200UL << _outbox[i].retries;
         if (now - _outbox[i].last_send < interval) continue;
 
+        NodePeer* peer = (_role == NODE_ROLE_MASTER) ?
+            findSlaveByNodeId(_outbox[i].msg.dst_id) : nullptr;
+
         if (_outbox[i].retries >= NODE_MAX_RETRIES) {
             DEBUG_PRINTF("NodeManager: Message seq=%d dropped after %d retries\n",
                          _outbox[i].msg.seq, NODE_MAX_RETRIES);
+            if (peer) peer->link.cmds_dropped++;
             _outbox[i].active = false;
+            resolveGroupFrame(_outbox[i].msg.seq, false);
+            requeueDropped(_outbox[i].msg);
             continue;
         }
 
         _outbox[i].retries++;
         _outbox[i].last_send = now;
+        if (peer) peer->link.retransmits++;
+
+        // A pre-staged start must still fire at the original instant
+        IrrigationMsg& m = _outbox[i].msg;
+        if (m.type == MSG_CMD_START && m.command.delay_ms > 0) {
+            unsigned long waited = now - _outbox[i].first_send;
+            m.command.delay_ms = (waited < m.command.delay_ms) ? m.command.delay_ms - waited : 1;
+            _outbox[i].first_send = now;
+        }
+
         sendUdp(_outbox[i].dst_ip, _outbox[i].dst_port, _outbox[i].msg);
         DEBUG_PRINTF("NodeManager: Retry %d for seq=%d\n",
                      _outbox[i].retries, _outbox[i].msg.seq);
@@ -277,6 +356,86 @@ void NodeManager::addDedup(const char* srcId, uint16_t seq) {
     _dedupIdx = (_dedupIdx + 1) % DEDUP_SIZE;
 }
 
+// ============================================================================
+// Master: link statistics
+// ============================================================================
+//
+// Loss comes from sequence gaps (LinkTiming). Round trips come from
+// command/ACK pairs, but only for frames that were never retransmitted
+// (Karn's rule), since the ACK of a retried frame cannot be matched to
+// one send.
+
+void NodeManager::recordRtt(LinkStats& link, unsigned long ms) {
+    link.rtt_ms[link.rtt_idx] = (ms > 0xFFFF) ? 0xFFFF : (uint16_t)ms;
+    link.rtt_idx = (link.rtt_idx + 1) % LINK_RTT_SAMPLES;
+    if (link.rtt_count < LINK_RTT_SAMPLES) link.rtt_count++;
+}
+
+void NodeManager::recordRssi(LinkStats& link, int8_t rssi) {
+    link.rssi[link.rssi_idx] = rssi;
+    link.rssi_idx = (link.rssi_idx + 1) % LINK_RSSI_SAMPLES;
+    if (link.rssi_count < LINK_RSSI_SAMPLES) link.rssi_count++;
+}
+
+// Loss over the last one to two buckets, 0..1
+void NodeManager::recordUptime(NodePeer* peer, uint32_t uptime) {
+    LinkStats& link = peer->link;
+    if (link.uptime > 0 && uptime < link.uptime) {
+        link.reboots++;
+        link.seq_valid = false;  // Sequence counter restarted too
+        DEBUG_PRINTF("NodeManager: Slave '%s' rebooted (uptime %lus -> %lus, %d reboots)\n",
+                     peer->node_id, (unsigned long)link.uptime, (unsigned long)uptime,
+                     link.reboots);
+        // Whatever it reported belongs to the previous boot
+        peer->version[0] = '\0';
+        peer->ota_state = OTA_IDLE;
+        peer->fault_mask = 0;
+    }
+    link.uptime = uptime;
+}
+
+bool NodeManager::getLinkHealth(uint8_t index, LinkHealth& health) const {
+    const NodePeer* peer = getSlave(index);
+    if (!peer) return false;
+    const LinkStats& link = peer->link;
+
+    memset(&health, 0, sizeof(health));
+
+    health.loss_pct = 100.0f * LinkTiming::loss(link);
+    if (link.cmds_sent > 0) health.retransmit_pct = 100.0f * link.retransmits / link.cmds_sent;
+
+    // Round-trip distribution: sort a copy of the ring
+    health.rtt_samples = link.rtt_count;
+    if (link.rtt_count > 0) {
+        uint16_t sorted[LINK_RTT_SAMPLES];
+        for (uint8_t n = 0; n < link.rtt_count; n++) {
+            uint16_t v = link.rtt_ms[n];
+            int8_t j = n - 1;
+            while (j >= 0 && sorted[j] > v) {
+                sorted[j + 1] = sorted[j];
+                j--;
+            }
+            sorted[j + 1] = v;
+        }
+        health.rtt_min = sorted[0];
+        health.rtt_p50 = sorted[(link.rtt_count - 1) / 2];
+        health.rtt_p90 = sorted[(link.rtt_count - 1) * 9 / 10];
+        health.rtt_max = sorted[link.rtt_count - 1];
+    }
+
+    health.rssi_samples = link.rssi_count;
+    if (link.rssi_count > 0) {
+        int16_t sum = 0;
+        health.rssi_min = link.rssi[0];
+        for (uint8_t n = 0; n < link.rssi_count; n++) {
+            sum += link.rssi[n];
+            if (link.rssi[n] < health.rssi_min) health.rssi_min = link.rssi[n];
+        }
+        health.rssi_avg = (float)sum / link.rssi_count;
+    }
+    return true;
+}
+
 // ============================================================================
 // Master: register a slave
 // ============================================================================
@@ -308,44 +467,79 @@ bool NodeManager::addSlave(const char* nodeId, uint8_t baseVirtualCh) {
     peer.irrigating = false;
     peer.time_remaining = 0;
     peer.rssi = 0;
+    peer.actual_mask = 0;
+    memset(peer.actual_end, 0, sizeof(peer.actual_end));
+    peer.actual_at = 0;
+    peer.divergences = 0;
+    memset(&peer.link, 0, sizeof(peer.link));
+    peer.hb_interval = NODE_HEARTBEAT_IDLE;
+    peer.hb_prev = NODE_HEARTBEAT_IDLE;
+    peer.last_hb_sent = 0;
+    peer.heard_by = 0;
+    peer.run_seq = 0;
+    memset(peer.version, 0, sizeof(peer.version));
+    peer.ota_state = OTA_IDLE;
+    peer.ota_progress = 0;
+    peer.crashes = 0;
+    peer.fault_mask = 0;
     _slaveCount++;
+    _peerGeneration++;
 
     DEBUG_PRINTF("NodeManager: Added slave '%s' virtual_ch=%d (IP resolved on first heartbeat)\n",
                  nodeId, baseVirtualCh);
     return true;
 }
 
+bool NodeManager::addSensor(const char* nodeId) {
+    if (findSensorByNodeId(nodeId)) return true;
+
+    if (_sensorCount >= MAX_SENSOR_NODES) {
+        DEBUG_PRINTLN("NodeManager: Max sensor nodes reached");
+        return false;
+    }
+
+    SensorPeer& sensor = _sensors[_sensorCount];
+    strncpy(sensor.node_id, nodeId, sizeof(sensor.node_id) - 1);
+    sensor.node_id[sizeof(sensor.node_id) - 1] = '\0';
+    memset(sensor.name, 0, sizeof(sensor.name));
+    sensor.ip = IPAddress(0, 0, 0, 0);
+    sensor.port = NODE_UDP_PORT;
+    sensor.num_probes = 0;  // Updated when heartbeat arrives
+    sensor.online = false;
+    sensor.last_seen = 0;
+    memset(sensor.moisture, 0, sizeof(sensor.moisture));
+    memset(sensor.reading_at, 0, sizeof(sensor.reading_at));
+    sensor.temperature = 0;
+    sensor.has_temperature = false;
+    _sensorCount++;
+    _peerGeneration++;
+
+    DEBUG_PRINTF("NodeManager: Added sensor node '%s'\n", nodeId);
+    return true;
+}
+
 // ============================================================================
 // Master: send commands to virtual channels
 // ============================================================================
 
-bool NodeManager::sendStart(uint8_t virtualChannel, uint16_t durationMinutes) {
+bool NodeManager::sendStart(uint8_t virtualChannel, uint16_t durationMinutes, uint16_t delayMs) {
     NodePeer* peer = findSlaveByVirtualCh(virtualChannel);
     if (!peer) {
         DEBUG_PRINTF("NodeManager: No slave for virtual channel %d\n", virtualChannel);
         return false;
     }
-    if (!peer->online || peer->ip == IPAddress(0, 0, 0, 0)) {
-        DEBUG_PRINTF("NodeManager: Slave '%s' offline, cannot start ch %d\n",
-                     peer->node_id, virtualChannel);
-        return false;
-    }
 
     // Map virtual channel to slave's local channel
     uint8_t localCh = virtualChannel - peer->base_virtual_ch + 1;
 
-    IrrigationMsg msg = {};
-    fillHeader(msg, MSG_CMD_START, peer->node_id, localCh);
-    msg.command.duration = durationMinutes;
-
-    DEBUG_PRINTF("NodeManager: Sending CMD_START to '%s' local_ch=%d duration=%d\n",
-                 peer->node_id, localCh, durationMinutes);
-
-    bool sent = sendUdp(peer->ip, peer->port, msg);
-    if (sent) {
-        enqueueOutbox(msg, peer->ip, peer->port);
+    if (!peer->online || peer->ip == IPAddress(0, 0, 0, 0)) {
+        DEBUG_PRINTF("NodeManager: Slave '%s' offline, queueing start for ch %d\n",
+                     peer->node_id, virtualChannel);
+        return storeCommand(peer->node_id, MSG_CMD_START, localCh, durationMinutes, delayMs);
     }
-    return sent;
+
+    transmitCommand(peer, MSG_CMD_START, localCh, durationMinutes, delayMs);
+    return true;
 }
 
 bool NodeManager::sendStop(uint8_t virtualChannel) {
@@ -357,17 +551,387 @@ bool NodeManager::sendStop(uint8_t virtualChannel) {
 
     uint8_t localCh = virtualChannel - peer->base_virtual_ch + 1;
 
+    if (!peer->online || peer->ip == IPAddress(0, 0, 0, 0)) {
+        DEBUG_PRINTF("NodeManager: Slave '%s' offline, queueing stop for ch %d\n",
+                     peer->node_id, virtualChannel);
+        return storeCommand(peer->node_id, MSG_CMD_STOP, localCh, 0, 0);
+    }
+
+    transmitCommand(peer, MSG_CMD_STOP, localCh, 0, 0);
+    return true;
+}
+
+// Send a start/stop now; the outbox retries it and hands it back to the
+// store-and-forward queue if the slave never answers
+void NodeManager::transmitCommand(NodePeer* peer, uint8_t type, uint8_t localCh,
+                                  uint16_t duration, uint16_t delayMs) {
     IrrigationMsg msg = {};
-    fillHeader(msg, MSG_CMD_STOP, peer->node_id, localCh);
+    fillHeader(msg, type, peer->node_id, localCh);
+    if (type == MSG_CMD_START) {
+        msg.command.duration = duration;
+        msg.command.delay_ms = delayMs;
+    }
+
+    DEBUG_PRINTF("NodeManager: Sending %s to '%s' local_ch=%d duration=%d delay=%dms\n",
+                 type == MSG_CMD_START ? "CMD_START" : "CMD_STOP",
+                 peer->node_id, localCh, duration, delayMs);
+
+    uint8_t vch = peer->base_virtual_ch + localCh - 1;
+    if (vch <= MAX_CHANNELS) _lastCmdSeq[vch] = msg.seq;
+
+    // A live command supersedes anything still queued for the channel
+    if (dropStoredCommands(peer->node_id, localCh)) {
+        saveStoredCommands();
+    }
+
+    sendUdp(peer->ip, peer->port, msg);
+    enqueueOutbox(msg, peer->ip, peer->port);
+}
+
+uint8_t NodeManager::sendGroupCommand(uint8_t groupId, uint64_t members, bool start,
+                                     uint16_t durationMinutes) {
+    if (_role != NODE_ROLE_MASTER) return 0;
+    if (groupId >= MAX_GROUPS) return 0;
+
+    // Replace any tracker still open for this group (newest command wins)
+    GroupAckTracker* tracker = nullptr;
+    for (uint8_t t = 0; t < GROUP_TRACK_SIZE; t++) {
+        if (_groupTrackers[t].active && _groupTrackers[t].group_id == groupId) {
+            tracker = &_groupTrackers[t];
+            break;
+        }
+    }
+    for (uint8_t t = 0; t < GROUP_TRACK_SIZE && !tracker; t++) {
+        if (!_groupTrackers[t].active) tracker = &_groupTrackers[t];
+    }
+    if (!tracker) {
+        DEBUG_PRINTLN("NodeManager: Group tracker table full, reusing slot 0");
+        tracker = &_groupTrackers[0];
+    }
+    memset(tracker, 0, sizeof(GroupAckTracker));
+    tracker->active = true;
+    tracker->group_id = groupId;
+    tracker->start = start;
+
+    for (uint8_t s = 0; s < _slaveCount; s++) {
+        NodePeer& peer = _slaves[s];
+        uint8_t numCh = peer.num_channels ? peer.num_channels : 1;
+
+        uint16_t localMask = 0;
+        for (uint8_t c = 0; c < numCh && c < 16; c++) {
+            uint8_t vch = peer.base_virtual_ch + c;
+            if (vch >= 1 && vch <= MAX_CHANNELS && (members & (1ULL << (vch - 1)))) {
+                localMask |= (1U << c);
+            }
+        }
+        if (localMask == 0) continue;
+
+        if (!peer.online || peer.ip == IPAddress(0, 0, 0, 0)) {
+            DEBUG_PRINTF("NodeManager: Slave '%s' offline, group %d queued per channel\n",
+                         peer.node_id, groupId);
+            for (uint8_t c = 0; c < 16; c++) {
+                if (!(localMask & (1U << c))) continue;
+                storeCommand(peer.node_id, start ? MSG_CMD_START : MSG_CMD_STOP, c + 1,
+                             start ? durationMinutes : 0, 0);
+            }
+            tracker->failed = true;
+            continue;
+        }
+
+        IrrigationMsg msg = {};
+        fillHeader(msg, start ? MSG_CMD_GROUP_START : MSG_CMD_GROUP_STOP, peer.node_id, 0xFF);
+        msg.group.duration = start ? durationMinutes : 0;
+        msg.group.channel_mask = localMask;
+        msg.group.group_id = groupId;
+
+        DEBUG_PRINTF("NodeManager: Sending %s group=%d to '%s' mask=0x%04X\n",
+                     start ? "GROUP_START" : "GROUP_STOP", groupId, peer.node_id, localMask);
+
+        bool superseded = false;
+        for (uint8_t c = 0; c < 16; c++) {
+            if (!(localMask & (1U << c))) continue;
+            uint8_t vch = peer.base_virtual_ch + c;
+            if (vch <= MAX_CHANNELS) _lastCmdSeq[vch] = msg.seq;
+            superseded |= dropStoredCommands(peer.node_id, c + 1);
+        }
+        if (superseded) saveStoredCommands();
+
+        sendUdp(peer.ip, peer.port, msg);
+        enqueueOutbox(msg, peer.ip, peer.port);
+        tracker->seqs[tracker->frames] = msg.seq;
+        tracker->pending |= (1U << tracker->frames);
+        tracker->frames++;
+    }
+
+    _groupAckState[groupId] = GROUP_ACK_PENDING;
+    if (tracker->pending == 0) {
+        finishGroupTracker(*tracker);
+    }
+    return tracker->frames;
+}
+
+uint8_t NodeManager::getGroupAckState(uint8_t groupId) const {
+    return (groupId < MAX_GROUPS) ? _groupAckState[groupId] : GROUP_ACK_NONE;
+}
+
+// Called for every ACK and every outbox drop; a no-op unless the seq
+// belongs to an open group command
+void NodeManager::resolveGroupFrame(uint16_t seq, bool ok) {
+    for (uint8_t t = 0; t < GROUP_TRACK_SIZE; t++) {
+        GroupAckTracker& tracker = _groupTrackers[t];
+        if (!tracker.active) continue;
+        for (uint8_t f = 0; f < tracker.frames; f++) {
+            if (!(tracker.pending & (1U << f)) || tracker.seqs[f] != seq) continue;
+            tracker.pending &= ~(1U << f);
+            if (!ok) tracker.failed = true;
+            if (tracker.pending == 0) {
+                finishGroupTracker(tracker);
+            }
+            return;
+        }
+    }
+}
+
+void NodeManager::finishGroupTracker(GroupAckTracker& tracker) {
+    bool confirmed = !tracker.failed;
+    tracker.active = false;
+    _groupAckState[tracker.group_id] = confirmed ? GROUP_ACK_CONFIRMED : GROUP_ACK_FAILED;
+
+    DEBUG_PRINTF("NodeManager: Group %d %s %s (%d nodes)\n", tracker.group_id,
+                 tracker.start ? "start" : "stop",
+                 confirmed ? "confirmed" : "FAILED", tracker.frames);
+
+    if (_groupAckCallback) {
+        _groupAckCallback(tracker.group_id, tracker.start, confirmed);
+    }
+}
+
+// ============================================================================
+// Master: store-and-forward for unreachable slaves
+// ============================================================================
+//
+// Commands for a slave that is offline, or whose outbox retries ran out,
+// are held in arrival order (and persisted) until its next heartbeat. Only
+// the newest command per channel is kept: a stop cancels a queued start
+// and a later start replaces a queued stop. Starts expire after
+// STORE_FWD_START_TTL, stops after STORE_FWD_STOP_TTL.
+
+bool NodeManager::storeCommand(const char* nodeId, uint8_t type, uint8_t localCh,
+                               uint16_t duration, uint16_t delayMs) {
+    if (_role != NODE_ROLE_MASTER) return false;
+
+    if (dropStoredCommands(nodeId, localCh)) {
+        DEBUG_PRINTF("NodeManager: Queued command for '%s' ch %d superseded\n", nodeId, localCh);
+    }
+
+    // Retire any older frame for this channel still in the outbox, so its
+    // eventual drop cannot requeue it over this one
+    NodePeer* peer = findSlaveByNodeId(nodeId);
+    if (peer) {
+        uint8_t vch = peer->base_virtual_ch + localCh - 1;
+        if (vch <= MAX_CHANNELS) _lastCmdSeq[vch] = _seq++;
+    }
+
+    if (_storedCount >= STORE_FWD_SIZE || getStoredCommandCount(nodeId) >= STORE_FWD_PER_PEER) {
+        DEBUG_PRINTF("NodeManager: Store-and-forward full, dropping command for '%s'\n", nodeId);
+        saveStoredCommands();
+        return false;
+    }
+
+    StoredCommand& cmd = _stored[_storedCount++];
+    strncpy(cmd.node_id, nodeId, sizeof(cmd.node_id) - 1);
+    cmd.node_id[sizeof(cmd.node_id) - 1] = '\0';
+    cmd.type = type;
+    cmd.channel = localCh;
+    cmd.duration = duration;
+    cmd.delay_ms = delayMs;
+    cmd.queued_at = millis();
+    cmd.ttl = (type == MSG_CMD_START) ? STORE_FWD_START_TTL : STORE_FWD_STOP_TTL;
+    _peerGeneration++;
+
+    DEBUG_PRINTF("NodeManager: Queued %s for '%s' ch %d (%d pending)\n",
+                 type == MSG_CMD_START ? "CMD_START" : "CMD_STOP",
+                 nodeId, localCh, getStoredCommandCount(nodeId));
+    saveStoredCommands();
+    return true;
+}
+
+bool NodeManager::dropStoredCommands(const char* nodeId, uint8_t localCh) {
+    bool dropped = false;
+    uint8_t i = 0;
+    while (i < _storedCount) {
+        const StoredCommand& cmd = _stored[i];
+        if (strncmp(cmd.node_id, nodeId, sizeof(cmd.node_id)) == 0 &&
+            (localCh == 0 || cmd.channel == localCh)) {
+            removeStoredAt(i);
+            dropped = true;
+            continue;
+        }
+        i++;
+    }
+    return dropped;
+}
+
+void NodeManager::removeStoredAt(uint8_t index) {
+    for (uint8_t j = index; j < _storedCount - 1; j++) {
+        _stored[j] = _stored[j + 1];
+    }
+    _storedCount--;
+    memset(&_stored[_storedCount], 0, sizeof(StoredCommand));
+    _peerGeneration++;
+}
+
+uint8_t NodeManager::getStoredCommandCount(const char* nodeId) const {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < _storedCount; i++) {
+        if (strncmp(_stored[i].node_id, nodeId, sizeof(_stored[i].node_id)) == 0) count++;
+    }
+    return count;
+}
+
+void NodeManager::flushStoredCommands(NodePeer* peer) {
+    uint8_t freeSlots = 0;
+    for (uint8_t i = 0; i < OUTBOX_SIZE; i++) {
+        if (!_outbox[i].active) freeSlots++;
+    }
+
+    unsigned long now = millis();
+    bool flushed = false;
+    uint8_t i = 0;
+    while (i < _storedCount && freeSlots > 0) {
+        StoredCommand cmd = _stored[i];
+        if (strncmp(cmd.node_id, peer->node_id, sizeof(cmd.node_id)) != 0) {
+            i++;
+            continue;
+        }
+        removeStoredAt(i);
+        flushed = true;
+        if (now - cmd.queued_at >= cmd.ttl) continue;
+
+        // A pre-staged start keeps its original firing instant where it can
+        unsigned long waited = now - cmd.queued_at;
+        uint16_t delayMs = (waited < cmd.delay_ms) ? cmd.delay_ms - waited : 0;
+
+        DEBUG_PRINTF("NodeManager: Forwarding queued command to '%s' (held %lus)\n",
+                     peer->node_id, waited / 1000);
+        transmitCommand(peer, cmd.type, cmd.channel, cmd.duration, delayMs);
+        freeSlots--;
+    }
+    // Anything left waits for the next heartbeat once the outbox drains
+
+    if (flushed) saveStoredCommands();
+}
+
+void NodeManager::expireStoredCommands() {
+    unsigned long now = millis();
+    bool expired = false;
+    uint8_t i = 0;
+    while (i < _storedCount) {
+        const StoredCommand& cmd = _stored[i];
+        if (now - cmd.queued_at >= cmd.ttl) {
+            DEBUG_PRINTF("NodeManager: Queued %s for '%s' ch %d expired\n",
+                         cmd.type == MSG_CMD_START ? "CMD_START" : "CMD_STOP",
+                         cmd.node_id, cmd.channel);
+            removeStoredAt(i);
+            expired = true;
+            continue;
+        }
+        i++;
+    }
+    if (expired) saveStoredCommands();
+}
+
+// Outbox gave up on a frame: keep it for the next heartbeat unless a newer
+// command for the same channel was sent since
+void NodeManager::requeueDropped(const IrrigationMsg& msg) {
+    if (_role != NODE_ROLE_MASTER) return;
+
+    NodePeer* peer = findSlaveByNodeId(msg.dst_id);
+    if (!peer) return;
+
+    if (msg.type == MSG_CMD_START || msg.type == MSG_CMD_STOP) {
+        uint8_t vch = peer->base_virtual_ch + msg.channel - 1;
+        if (vch > MAX_CHANNELS || _lastCmdSeq[vch] != msg.seq) return;
+        storeCommand(peer->node_id, msg.type, msg.channel,
+                     msg.type == MSG_CMD_START ? msg.command.duration : 0, 0);
+    } else if (msg.type == MSG_CMD_GROUP_START || msg.type == MSG_CMD_GROUP_STOP) {
+        bool start = (msg.type == MSG_CMD_GROUP_START);
+        for (uint8_t c = 0; c < 16; c++) {
+            if (!(msg.group.channel_mask & (1U << c))) continue;
+            uint8_t vch = peer->base_virtual_ch + c;
+            if (vch > MAX_CHANNELS || _lastCmdSeq[vch] != msg.seq) continue;
+            storeCommand(peer->node_id, start ? MSG_CMD_START : MSG_CMD_STOP, c + 1,
+                         start ? msg.group.duration : 0, 0);
+        }
+    }
+}
+
+void NodeManager::saveStoredCommands() {
+    ArenaJsonDocument doc(3072);
+    JsonArray array = doc.createNestedArray("commands");
+
+    // Store the remaining lifetime; millis() restarts with the node
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < _storedCount; i++) {
+        const StoredCommand& cmd = _stored[i];
+        unsigned long age = now - cmd.queued_at;
+        if (age >= cmd.ttl) continue;
+        JsonObject entry = array.createNestedObject();
+        entry["node_id"] = cmd.node_id;
+        entry["type"] = cmd.type;
+        entry["channel"] = cmd.channel;
+        entry["duration"] = cmd.duration;
+        entry["ttl"] = cmd.ttl - age;
+    }
+
+    File file = LittleFS.open(STORED_COMMANDS_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("NodeManager: Failed to open stored_commands.json for writing");
+        return;
+    }
+    serializeJson(doc, file);
+    file.close();
+}
+
+void NodeManager::loadStoredCommands() {
+    if (!LittleFS.exists(STORED_COMMANDS_FILE)) return;
+
+    File file = LittleFS.open(STORED_COMMANDS_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("NodeManager: Failed to open stored_commands.json");
+        return;
+    }
+
+    ArenaJsonDocument doc(3072);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
 
-    DEBUG_PRINTF("NodeManager: Sending CMD_STOP to '%s' local_ch=%d\n",
-                 peer->node_id, localCh);
+    if (error) {
+        DEBUG_PRINTF("NodeManager: Failed to parse stored_commands.json: %s\n", error.c_str());
+        return;
+    }
 
-    bool sent = sendUdp(peer->ip, peer->port, msg);
-    if (sent) {
-        enqueueOutbox(msg, peer->ip, peer->port);
+    unsigned long now = millis();
+    for (JsonObject entry : doc["commands"].as<JsonArray>()) {
+        if (_storedCount >= STORE_FWD_SIZE) break;
+        const char* nodeId = entry["node_id"] | "";
+        uint8_t type = entry["type"] | 0;
+        if (!findSlaveByNodeId(nodeId)) continue;  // Unpaired since
+        if (type != MSG_CMD_START && type != MSG_CMD_STOP) continue;
+
+        StoredCommand& cmd = _stored[_storedCount++];
+        strncpy(cmd.node_id, nodeId, sizeof(cmd.node_id) - 1);
+        cmd.node_id[sizeof(cmd.node_id) - 1] = '\0';
+        cmd.type = type;
+        cmd.channel = entry["channel"] | 1;
+        cmd.duration = entry["duration"] | 0;
+        cmd.delay_ms = 0;  // Staged timing did not survive the reboot
+        cmd.queued_at = now;
+        cmd.ttl = entry["ttl"] | 0UL;
+    }
+    if (_storedCount > 0) {
+        DEBUG_PRINTF("NodeManager: Loaded %d queued commands for offline slaves\n", _storedCount);
     }
-    return sent;
 }
 
 // ============================================================================
@@ -392,16 +956,26 @@ void NodeManager::handleMessage(IPAddress senderIp, uint16_t senderPort,
     }
 
     // Dedup (skip for ACK messages — they are responses)
-    if (msg.type != MSG_CMD_ACK && msg.type != MSG_HEARTBEAT_ACK) {
+    if (msg.type != MSG_CMD_ACK && msg.type != MSG_HEARTBEAT_ACK && msg.type != MSG_RUN_ACK) {
         if (isDuplicate(msg.src_id, msg.seq)) {
             return;
         }
         addDedup(msg.src_id, msg.seq);
     }
 
+    if (_role == NODE_ROLE_MASTER) {
+        NodePeer* peer = findSlaveByNodeId(msg.src_id);
+        if (peer) {
+            LinkTiming::trackRx(peer->link, msg.seq);
+            refreshDeadline(*peer);
+        }
+    }
+
     switch (msg.type) {
         case MSG_CMD_START:     handleCmdStart(senderIp, senderPort, msg); break;
         case MSG_CMD_STOP:      handleCmdStop(senderIp, senderPort, msg); break;
+        case MSG_CMD_GROUP_START:
+        case MSG_CMD_GROUP_STOP: handleCmdGroup(senderIp, senderPort, msg); break;
         case MSG_CMD_SKIP:      handleCmdSkip(senderIp, senderPort, msg); break;
         case MSG_CMD_UNSKIP:    handleCmdUnskip(senderIp, senderPort, msg); break;
         case MSG_CMD_ACK:       handleCmdAck(msg); break;
@@ -413,6 +987,11 @@ void NodeManager::handleMessage(IPAddress senderIp, uint16_t senderPort,
         case MSG_PAIR_REQUEST:  handlePairRequest(senderIp, senderPort, msg); break;
         case MSG_PAIR_ACCEPT:   handlePairAccept(msg); break;
         case MSG_PAIR_REJECT:   handlePairReject(msg); break;
+        case MSG_SENSOR_REPORT: handleSensorReport(senderIp, senderPort, msg); break;
+        case MSG_RUN_BATCH:     handleRunBatch(senderIp, senderPort, data, len); break;
+        case MSG_RUN_ACK:       handleRunAck(msg); break;
+        case MSG_OTA_START:     handleOtaStart(senderIp, senderPort, msg); break;
+        case MSG_OTA_STATUS:    handleOtaStatus(msg); break;
         default:
             DEBUG_PRINTF("NodeManager: Unknown msg type 0x%02X\n", msg.type);
             break;
@@ -430,10 +1009,27 @@ void NodeManager::handleCmdStart(IPAddress senderIp, uint16_t senderPort,
 
     uint8_t ch = msg.channel;
     uint16_t duration = msg.command.duration;
-    DEBUG_PRINTF("NodeManager: Received CMD_START ch=%d duration=%d\n", ch, duration);
+    uint16_t delayMs = msg.command.delay_ms;
+    DEBUG_PRINTF("NodeManager: Received CMD_START ch=%d duration=%d delay=%dms\n", ch, duration, delayMs);
 
-    _controller->startIrrigation(ch, duration);
-    sendAck(senderIp, senderPort, MSG_CMD_START, ACK_OK, msg.seq);
+    if (delayMs == 0) {
+        _controller->startIrrigation(ch, duration);
+        sendAck(senderIp, senderPort, MSG_CMD_START, ACK_OK, msg.seq);
+        return;
+    }
+
+    // Pre-staged: one pending start per channel, newest wins
+    cancelStagedStart(ch);
+    for (uint8_t i = 0; i < STAGED_SIZE; i++) {
+        if (_staged[i].active) continue;
+        _staged[i].channel = ch;
+        _staged[i].duration = duration;
+        _staged[i].due_at = millis() + delayMs;
+        _staged[i].active = true;
+        sendAck(senderIp, senderPort, MSG_CMD_START, ACK_OK, msg.seq);
+        return;
+    }
+    sendAck(senderIp, senderPort, MSG_CMD_START, ACK_ERR_BUSY, msg.seq);
 }
 
 void NodeManager::handleCmdStop(IPAddress senderIp, uint16_t senderPort,
@@ -444,26 +1040,201 @@ void NodeManager::handleCmdStop(IPAddress senderIp, uint16_t senderPort,
     uint8_t ch = msg.channel;
     DEBUG_PRINTF("NodeManager: Received CMD_STOP ch=%d\n", ch);
 
+    cancelStagedStart(ch);
     _controller->stopIrrigation(ch);
     sendAck(senderIp, senderPort, MSG_CMD_STOP, ACK_OK, msg.seq);
 }
 
+void NodeManager::handleCmdGroup(IPAddress senderIp, uint16_t senderPort,
+                                 const IrrigationMsg& msg) {
+    if (_role != NODE_ROLE_SLAVE) return;
+    if (!_controller) return;
+
+    bool start = (msg.type == MSG_CMD_GROUP_START);
+    uint16_t mask = msg.group.channel_mask;
+    DEBUG_PRINTF("NodeManager: Received %s group=%d mask=0x%04X duration=%d\n",
+                 start ? "GROUP_START" : "GROUP_STOP", msg.group.group_id, mask, msg.group.duration);
+
+    uint8_t result = ACK_OK;
+    for (uint8_t i = 0; i < 16; i++) {
+        if (!(mask & (1U << i))) continue;
+        if (i >= NUM_LOCAL_CHANNELS) {
+            result = ACK_ERR_CHANNEL;
+            continue;
+        }
+        if (start) {
+            _controller->startIrrigation(i + 1, msg.group.duration);
+        } else {
+            cancelStagedStart(i + 1);
+            _controller->stopIrrigation(i + 1);
+        }
+    }
+
+    // One ACK covers every channel in the frame
+    sendAck(senderIp, senderPort, msg.type, result, msg.seq);
+}
+
+void NodeManager::processStagedStarts() {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < STAGED_SIZE; i++) {
+        if (!_staged[i].active) continue;
+        if ((long)(now - _staged[i].due_at) < 0) continue;
+
+        DEBUG_PRINTF("NodeManager: Staged start ch=%d duration=%d (late by %lums)\n",
+                     _staged[i].channel, _staged[i].duration, now - _staged[i].due_at);
+        _staged[i].active = false;
+        if (_controller) {
+            _controller->startIrrigation(_staged[i].channel, _staged[i].duration);
+        }
+    }
+}
+
+void NodeManager::cancelStagedStart(uint8_t channel) {
+    for (uint8_t i = 0; i < STAGED_SIZE; i++) {
+        if (_staged[i].active && (channel == 0 || _staged[i].channel == channel)) {
+            _staged[i].active = false;
+        }
+    }
+}
+
+bool NodeManager::hasStagedStart(uint8_t channel) const {
+    for (uint8_t i = 0; i < STAGED_SIZE; i++) {
+        if (_staged[i].active && _staged[i].channel == channel) return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// Anti-entropy: valve state vector
+// ============================================================================
+//
+// Every master heartbeat carries the desired state of the slave's channels
+// (open mask plus end times); the slave corrects itself against it and
+// answers with its actual state. A lost CMD_STOP, a slave reboot mid-run or
+// a drifted end time is therefore fixed within one heartbeat without any
+// extra command traffic. Channels that changed within NODE_RECONCILE_GRACE
+// are left alone on both sides so in-flight commands and schedule starts
+// racing the heartbeat are not mistaken for divergence.
+
+// Open mask and seconds-to-end of channels firstCh..firstCh+count-1 as seen
+// by the local controller (desired state on the master, actual on a slave)
+void NodeManager::fillStateVector(IrrigationMsg& msg, uint8_t firstCh, uint8_t count) {
+    msg.heartbeat.valve_mask = 0;
+    memset(msg.heartbeat.end_sec, 0, sizeof(msg.heartbeat.end_sec));
+    msg.heartbeat.epoch_time = 0;
+    if (!_controller || !_controller->hasValidTime()) return;  // No vector
+
+    msg.heartbeat.epoch_time = (uint32_t)_controller->getCurrentTime();
+    for (uint8_t c = 0; c < count && c < 8; c++) {
+        uint8_t ch = firstCh + c;
+        if (!_controller->isChannelIrrigating(ch)) continue;
+        msg.heartbeat.valve_mask |= (1U << c);
+        if (c < HEARTBEAT_END_SLOTS) {
+            unsigned long left = _controller->getChannelRemaining(ch);
+            msg.heartbeat.end_sec[c] = (left > 0xFFFF) ? 0xFFFF : (uint16_t)left;
+        }
+    }
+}
+
+// Master: does the slave's last reported state disagree with what this
+// heartbeat asks for?
+bool NodeManager::isPeerDiverged(const NodePeer& peer, const IrrigationMsg& desired) {
+    if (peer.actual_at == 0 || desired.heartbeat.epoch_time == 0) return false;
+
+    unsigned long now = millis();
+    unsigned long age = (now - peer.actual_at) / 1000;
+    for (uint8_t c = 0; c < peer.num_channels && c < 8; c++) {
+        uint8_t vch = peer.base_virtual_ch + c;
+        if (now - _controller->getChannelChangedAt(vch) < NODE_RECONCILE_GRACE) continue;
+
+        bool want = desired.heartbeat.valve_mask & (1U << c);
+        bool have = peer.actual_mask & (1U << c);
+        if (want != have) return true;
+        if (!want || c >= HEARTBEAT_END_SLOTS) continue;
+
+        long haveLeft = (long)peer.actual_end[c] - (long)age;
+        long diff = haveLeft - (long)desired.heartbeat.end_sec[c];
+        if (diff > NODE_RECONCILE_TOLERANCE || diff < -NODE_RECONCILE_TOLERANCE) return true;
+    }
+    return false;
+}
+
+// Slave: bring local valves in line with the master's desired state
+void NodeManager::reconcileState(const IrrigationMsg& msg) {
+    if (!_controller) return;
+
+    unsigned long now = millis();
+    uint8_t corrected = 0;
+    for (uint8_t ch = 1; ch <= NUM_LOCAL_CHANNELS && ch <= 8; ch++) {
+        if (now - _controller->getChannelChangedAt(ch) < NODE_RECONCILE_GRACE) continue;
+        if (hasStagedStart(ch)) continue;
+
+        bool want = msg.heartbeat.valve_mask & (1U << (ch - 1));
+        bool have = _controller->isChannelIrrigating(ch);
+
+        if (!want) {
+            if (!have) continue;
+            DEBUG_PRINTF("NodeManager: Reconcile ch %d: master wants it closed\n", ch);
+            _controller->stopIrrigation(ch);
+            corrected++;
+            continue;
+        }
+
+        // Faulted channels stay shut; the status report tells the master why
+        if (_controller->isChannelFaulted(ch)) continue;
+        if (ch > HEARTBEAT_END_SLOTS) continue;  // On/off only, and no end to start with
+
+        unsigned long wantLeft = msg.heartbeat.end_sec[ch - 1];
+        if (wantLeft <= NODE_RECONCILE_TOLERANCE) continue;  // Ending anyway
+        if (have) {
+            long diff = (long)_controller->getChannelRemaining(ch) - (long)wantLeft;
+            if (diff <= NODE_RECONCILE_TOLERANCE && diff >= -NODE_RECONCILE_TOLERANCE) continue;
+        }
+
+        DEBUG_PRINTF("NodeManager: Reconcile ch %d: master wants it open for %lus more (%s)\n",
+                     ch, wantLeft, have ? "end time moved" : "was closed");
+        _controller->startIrrigation(ch, (wantLeft + 59) / 60);
+        corrected++;
+    }
+
+    if (corrected > 0) {
+        _reconciled += corrected;
+        DEBUG_PRINTF("NodeManager: Reconciled %d channel(s) (%d total)\n", corrected, _reconciled);
+    }
+}
+
 // ============================================================================
 // Master-side handlers (receives status/heartbeat from slaves)
 // ============================================================================
 
 void NodeManager::handleCmdAck(const IrrigationMsg& msg) {
-    if (_role != NODE_ROLE_MASTER) return;
+    if (_role == NODE_ROLE_SLAVE) return;  // Master and sensor nodes use the outbox
 
     const char* typeStr = (msg.ack.acked_type == MSG_CMD_START) ? "START" :
                           (msg.ack.acked_type == MSG_CMD_STOP)  ? "STOP" :
                           (msg.ack.acked_type == MSG_CMD_SKIP)  ? "SKIP" :
                           (msg.ack.acked_type == MSG_CMD_UNSKIP) ? "UNSKIP" :
-                          (msg.ack.acked_type == MSG_SCHEDULE_SET) ? "SCHED_SET" : "?";
+                          (msg.ack.acked_type == MSG_CMD_GROUP_START) ? "GROUP_START" :
+                          (msg.ack.acked_type == MSG_CMD_GROUP_STOP) ? "GROUP_STOP" :
+                          (msg.ack.acked_type == MSG_SCHEDULE_SET) ? "SCHED_SET" :
+                          (msg.ack.acked_type == MSG_SENSOR_REPORT) ? "SENSOR_REPORT" :
+                          (msg.ack.acked_type == MSG_OTA_START) ? "OTA_START" : "?";
     DEBUG_PRINTF("NodeManager: ACK for %s (seq=%d), result=%d\n",
                  typeStr, msg.ack.acked_seq, msg.ack.result);
 
+    // Round trip, only for frames that were sent once
+    NodePeer* peer = (_role == NODE_ROLE_MASTER) ? findSlaveByNodeId(msg.src_id) : nullptr;
+    if (peer) {
+        for (uint8_t i = 0; i < OUTBOX_SIZE; i++) {
+            if (_outbox[i].active && _outbox[i].msg.seq == msg.ack.acked_seq) {
+                if (_outbox[i].retries == 0) recordRtt(peer->link, millis() - _outbox[i].last_send);
+                break;
+            }
+        }
+    }
+
     removeFromOutbox(msg.ack.acked_seq);
+    resolveGroupFrame(msg.ack.acked_seq, msg.ack.result == ACK_OK);
 }
 
 void NodeManager::handleStatus(IPAddress senderIp, const IrrigationMsg& msg) {
@@ -475,7 +1246,11 @@ void NodeManager::handleStatus(IPAddress senderIp, const IrrigationMsg& msg) {
     peer->last_seen = millis();
     peer->irrigating = (msg.status.state == 1);
     peer->time_remaining = msg.status.time_remaining;
-    peer->rssi = msg.status.rssi;
+    if (peer->rssi != msg.status.rssi) {
+        peer->rssi = msg.status.rssi;
+        _peerGeneration++;
+    }
+    if (msg.channel == 1) recordRssi(peer->link, msg.status.rssi);  // Once per status round
 
     // Update IP if changed (DHCP renewal)
     if (peer->ip != senderIp) {
@@ -484,29 +1259,83 @@ void NodeManager::handleStatus(IPAddress senderIp, const IrrigationMsg& msg) {
         peer->ip = senderIp;
     }
 
+    // Actual state for the divergence check
+    uint8_t c = msg.channel - 1;
+    if (c < 8) {
+        if (peer->irrigating) {
+            peer->actual_mask |= (1U << c);
+        } else {
+            peer->actual_mask &= ~(1U << c);
+        }
+        if (msg.status.state == 2) {
+            peer->fault_mask |= (1U << c);
+        } else {
+            peer->fault_mask &= ~(1U << c);
+        }
+        if (c < HEARTBEAT_END_SLOTS) peer->actual_end[c] = msg.status.time_remaining;
+        peer->actual_at = millis();
+    }
+
     // Update the virtual channel state on the controller
     if (_controller) {
         uint8_t virtualCh = peer->base_virtual_ch + msg.channel - 1;
-        _controller->setRemoteChannelStatus(virtualCh, peer->irrigating,
-                                            msg.status.time_remaining);
+        _controller->reportRemoteChannel(virtualCh, msg.status.state,
+                                         msg.status.time_remaining, msg.status.run_elapsed);
     }
 }
 
 void NodeManager::handleHeartbeat(IPAddress senderIp, uint16_t senderPort,
                                   const IrrigationMsg& msg) {
     if (_role == NODE_ROLE_MASTER) {
-        // Master receives heartbeat from slave
+        // Master receives heartbeat from slave (or sensor node)
         NodePeer* peer = findSlaveByNodeId(msg.src_id);
-        if (!peer) {
+        SensorPeer* sensor = peer ? nullptr : findSensorByNodeId(msg.src_id);
+        if (!peer && !sensor) {
             DEBUG_PRINTF("NodeManager: Heartbeat from unknown node '%s' at %s\n",
                          msg.src_id, senderIp.toString().c_str());
             return;
         }
 
+        if (sensor) {
+            if (!sensor->online) {
+                DEBUG_PRINTF("NodeManager: Sensor '%s' ONLINE (uptime=%lus, probes=%d, IP=%s)\n",
+                             sensor->node_id, (unsigned long)msg.heartbeat.uptime,
+                             msg.heartbeat.num_channels, senderIp.toString().c_str());
+            }
+            if (!sensor->online || sensor->num_probes != msg.heartbeat.num_channels) {
+                _peerGeneration++;
+            }
+            sensor->online = true;
+            sensor->last_seen = millis();
+            sensor->num_probes = msg.heartbeat.num_channels;
+            sensor->ip = senderIp;
+            sensor->port = senderPort;
+
+            IrrigationMsg ack = {};
+            fillHeader(ack, MSG_HEARTBEAT_ACK, msg.src_id, 0);
+            if (_controller && _controller->hasValidTime()) {
+                ack.heartbeat_ack.epoch_time = (uint32_t)_controller->getCurrentTime();
+            }
+            ack.heartbeat_ack.interval_s = NODE_HEARTBEAT_IDLE / 1000;
+            sendUdp(senderIp, senderPort, ack);
+            return;
+        }
+
         bool wasOffline = !peer->online;
+        if (wasOffline || peer->num_channels != msg.heartbeat.num_channels) {
+            _peerGeneration++;
+        }
         peer->online = true;
         peer->last_seen = millis();
         peer->num_channels = msg.heartbeat.num_channels;
+        recordUptime(peer, msg.heartbeat.uptime);
+
+        // Slave's actual valve state (answer to our state vector)
+        if (msg.heartbeat.epoch_time != 0) {
+            peer->actual_mask = msg.heartbeat.valve_mask;
+            memcpy(peer->actual_end, msg.heartbeat.end_sec, sizeof(peer->actual_end));
+            peer->actual_at = millis();
+        }
 
         // Update IP if changed
         if (peer->ip != senderIp) {
@@ -525,14 +1354,23 @@ void NodeManager::handleHeartbeat(IPAddress senderIp, uint16_t senderPort,
             syncSchedulesForSlave(peer);
         }
 
-        // Reply with HEARTBEAT_ACK containing current epoch time
+        // Reply with HEARTBEAT_ACK containing current epoch time and the
+        // interval this slave should heartbeat at from now on
+        peer->hb_prev = peer->hb_interval;
+        peer->hb_interval = peerInterval(*peer);
+        refreshDeadline(*peer);
+
         IrrigationMsg ack = {};
         fillHeader(ack, MSG_HEARTBEAT_ACK, msg.src_id, 0);
         if (_controller && _controller->hasValidTime()) {
             ack.heartbeat_ack.epoch_time = (uint32_t)_controller->getCurrentTime();
         }
+        ack.heartbeat_ack.interval_s = peer->hb_interval / 1000;
         sendUdp(senderIp, senderPort, ack);
 
+        // The slave is reachable again: deliver what was held for it
+        flushStoredCommands(peer);
+
     } else {
         // Slave receives heartbeat from master — update master info
         if (!_masterFound) {
@@ -544,16 +1382,103 @@ void NodeManager::handleHeartbeat(IPAddress senderIp, uint16_t senderPort,
             DEBUG_PRINTF("NodeManager: Master found via heartbeat at %s\n",
                          senderIp.toString().c_str());
         }
+
+        // Desired-state vector: correct our valves, then answer at once
+        // with the actual state so the master sees the result this round
+        if (_role == NODE_ROLE_SLAVE && _paired && msg.heartbeat.epoch_time != 0) {
+            reconcileState(msg);
+            sendHeartbeat();
+            _lastHeartbeat = millis();
+        }
     }
 }
 
 void NodeManager::handleHeartbeatAck(const IrrigationMsg& msg) {
-    if (_role != NODE_ROLE_SLAVE) return;
+    if (_role == NODE_ROLE_MASTER) return;
 
     // Slave receives time sync from master
     if (msg.heartbeat_ack.epoch_time > 0 && _controller) {
         _controller->setCurrentTime((time_t)msg.heartbeat_ack.epoch_time);
     }
+
+    // ...and the heartbeat interval it expects (0 from older masters)
+    if (msg.heartbeat_ack.interval_s > 0) {
+        unsigned long interval = (unsigned long)msg.heartbeat_ack.interval_s * 1000;
+        if (interval < NODE_HEARTBEAT_MIN) interval = NODE_HEARTBEAT_MIN;
+        if (interval != _hbInterval) {
+            DEBUG_PRINTF("NodeManager: Heartbeat interval %lus -> %lus\n",
+                         _hbInterval / 1000, interval / 1000);
+            _hbInterval = interval;
+        }
+    }
+}
+
+// ============================================================================
+// Sensor reports
+// ============================================================================
+
+void NodeManager::handleSensorReport(IPAddress senderIp, uint16_t senderPort,
+                                     const IrrigationMsg& msg) {
+    if (_role != NODE_ROLE_MASTER) return;
+
+    SensorPeer* sensor = findSensorByNodeId(msg.src_id);
+    if (!sensor) {
+        DEBUG_PRINTF("NodeManager: Sensor report from unknown node '%s'\n", msg.src_id);
+        return;
+    }
+
+    uint8_t probe = msg.channel;
+    if (probe < 1 || probe > SENSOR_MAX_PROBES) {
+        sendAck(senderIp, senderPort, MSG_SENSOR_REPORT, ACK_ERR_CHANNEL, msg.seq);
+        return;
+    }
+
+    unsigned long now = millis();
+    if (!sensor->online || sensor->num_probes != msg.sensor.num_probes) {
+        _peerGeneration++;
+    }
+    sensor->online = true;
+    sensor->last_seen = now;
+    sensor->ip = senderIp;
+    sensor->port = senderPort;
+    sensor->num_probes = msg.sensor.num_probes;
+    sensor->moisture[probe - 1] = msg.sensor.moisture_x10 / 10.0f;
+    sensor->reading_at[probe - 1] = now;
+    sensor->has_temperature = (msg.sensor.temp_x10 != SENSOR_TEMP_NONE);
+    if (sensor->has_temperature) {
+        sensor->temperature = msg.sensor.temp_x10 / 10.0f;
+    }
+
+    DEBUG_PRINTF("NodeManager: Sensor '%s' probe %d moisture=%.1f%% raw=%dmV%s\n",
+                 sensor->node_id, probe, sensor->moisture[probe - 1], msg.sensor.raw_mv,
+                 (msg.sensor.flags & SENSOR_FLAG_KEEPALIVE) ? " (keepalive)" : "");
+
+    sendAck(senderIp, senderPort, MSG_SENSOR_REPORT, ACK_OK, msg.seq);
+}
+
+// Sensor node: one reliable report per probe that left its deadband
+// or whose keepalive expired
+void NodeManager::sendSensorReports() {
+    if (_role != NODE_ROLE_SENSOR || !_soilSensor) return;
+
+    for (uint8_t probe = 1; probe <= _soilSensor->getProbeCount(); probe++) {
+        if (!_soilSensor->needsReport(probe)) continue;
+
+        IrrigationMsg msg = {};
+        fillHeader(msg, MSG_SENSOR_REPORT, _masterNodeId, probe);
+        float moisture = _soilSensor->getMoisture(probe);
+        msg.sensor.moisture_x10 = (uint16_t)(moisture * 10.0f + 0.5f);
+        msg.sensor.temp_x10 = _soilSensor->hasTemperature() ?
+            (int16_t)lroundf(_soilSensor->getTemperature() * 10.0f) : SENSOR_TEMP_NONE;
+        msg.sensor.raw_mv = _soilSensor->getRawMilliVolts(probe);
+        msg.sensor.flags = _soilSensor->isKeepaliveDue(probe) ? SENSOR_FLAG_KEEPALIVE : 0;
+        msg.sensor.num_probes = _soilSensor->getProbeCount();
+
+        if (sendUdp(_masterIp, _masterPort, msg)) {
+            enqueueOutbox(msg, _masterIp, _masterPort);
+        }
+        _soilSensor->markReported(probe);
+    }
 }
 
 // ============================================================================
@@ -565,22 +1490,46 @@ void NodeManager::sendHeartbeat() {
     fillHeader(msg, MSG_HEARTBEAT, NODE_BROADCAST_ID, 0);
     msg.heartbeat.uptime = millis() / 1000;
     msg.heartbeat.num_channels = NUM_LOCAL_CHANNELS;
+    if (_role == NODE_ROLE_SENSOR) {
+        msg.heartbeat.num_channels = _soilSensor ? _soilSensor->getProbeCount() : 0;
+    }
     msg.heartbeat.role = _role;
-    msg.heartbeat.pending_cmds = 0;
+    msg.heartbeat.pending_cmds = 0;  // Master fills in the per-slave queue depth
 
     if (_role == NODE_ROLE_MASTER) {
         // Send heartbeat to each known slave
         for (uint8_t i = 0; i < _slaveCount; i++) {
             if (_slaves[i].ip != IPAddress(0, 0, 0, 0)) {
+                unsigned long now = millis();
+                if (_slaves[i].last_hb_sent != 0 &&
+                    now - _slaves[i].last_hb_sent < _slaves[i].hb_interval) {
+                    continue;  // Not due yet
+                }
+                _slaves[i].last_hb_sent = now;
+
                 strncpy(msg.dst_id, _slaves[i].node_id, sizeof(msg.dst_id) - 1);
                 msg.dst_id[sizeof(msg.dst_id) - 1] = '\0';
                 msg.seq = _seq++;
+                msg.heartbeat.pending_cmds = getStoredCommandCount(_slaves[i].node_id);
+
+                // Desired valve state for this slave's channels
+                fillStateVector(msg, _slaves[i].base_virtual_ch, _slaves[i].num_channels);
+                if (_slaves[i].online && isPeerDiverged(_slaves[i], msg)) {
+                    _slaves[i].divergences++;
+                    _peerGeneration++;  // Reported by /api/nodes/pending
+                    DEBUG_PRINTF("NodeManager: Slave '%s' diverged from desired state (mask %02X, has %02X)\n",
+                                 _slaves[i].node_id, msg.heartbeat.valve_mask,
+                                 _slaves[i].actual_mask);
+                }
                 sendUdp(_slaves[i].ip, _slaves[i].port, msg);
             }
         }
     } else if (_masterFound) {
         strncpy(msg.dst_id, _masterNodeId, sizeof(msg.dst_id) - 1);
         msg.dst_id[sizeof(msg.dst_id) - 1] = '\0';
+        if (_role == NODE_ROLE_SLAVE) {
+            fillStateVector(msg, 1, NUM_LOCAL_CHANNELS);  // Actual valve state
+        }
         sendUdp(_masterIp, _masterPort, msg);
     }
 }
@@ -595,7 +1544,11 @@ void NodeManager::sendStatus() {
         IrrigationMsg msg = {};
         fillHeader(msg, MSG_STATUS, _masterNodeId, ch);
 
-        msg.status.state = _controller->isChannelIrrigating(ch) ? 1 : 0;
+        if (_controller->isChannelFaulted(ch)) {
+            msg.status.state = 2;  // Held closed, master must not reopen it
+        } else {
+            msg.status.state = _controller->isChannelIrrigating(ch) ? 1 : 0;
+        }
 
         // Calculate remaining seconds for this channel
         SystemStatus st = _controller->getStatus();
@@ -605,8 +1558,10 @@ void NodeManager::sendStatus() {
             unsigned long totalSec = (unsigned long)st.channelDuration[idx] * 60;
             msg.status.time_remaining = (elapsed < totalSec) ?
                 (uint16_t)(totalSec - elapsed) : 0;
+            msg.status.run_elapsed = (elapsed > 0xFFFF) ? 0xFFFF : (uint16_t)elapsed;
         } else {
             msg.status.time_remaining = 0;
+            msg.status.run_elapsed = 0;
         }
 
         msg.status.flow_litres = 0;
@@ -659,6 +1614,76 @@ const NodePeer* NodeManager::getSlave(uint8_t index) const {
     return &_slaves[index];
 }
 
+SensorPeer* NodeManager::findSensorByNodeId(const char* nodeId) {
+    for (uint8_t i = 0; i < _sensorCount; i++) {
+        if (strncmp(_sensors[i].node_id, nodeId, sizeof(_sensors[i].node_id)) == 0) {
+            return &_sensors[i];
+        }
+    }
+    return nullptr;
+}
+
+const SensorPeer* NodeManager::getSensor(uint8_t index) const {
+    if (index >= _sensorCount) return nullptr;
+    return &_sensors[index];
+}
+
+bool NodeManager::getSensorMoisture(const char* nodeId, uint8_t probe, float& moisture) const {
+    if (probe < 1 || probe > SENSOR_MAX_PROBES) return false;
+    for (uint8_t i = 0; i < _sensorCount; i++) {
+        const SensorPeer& sensor = _sensors[i];
+        if (strncmp(sensor.node_id, nodeId, sizeof(sensor.node_id)) != 0) continue;
+
+        unsigned long at = sensor.reading_at[probe - 1];
+        if (at == 0 || millis() - at >= SOIL_READING_STALE_MS) return false;
+        moisture = sensor.moisture[probe - 1];
+        return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// Adaptive intervals
+// ============================================================================
+//
+// The interval and deadline arithmetic lives in LinkTiming; this decides
+// whether a slave is active and applies the result to the peer.
+
+bool NodeManager::isPeerActive(const NodePeer& peer) const {
+    if (peer.actual_mask != 0 || peer.irrigating) return true;
+    if (getStoredCommandCount(peer.node_id) > 0) return true;
+    for (uint8_t i = 0; i < OUTBOX_SIZE; i++) {
+        if (_outbox[i].active && strncmp(_outbox[i].msg.dst_id, peer.node_id,
+                                         sizeof(peer.node_id)) == 0) {
+            return true;
+        }
+    }
+    if (_controller) {
+        for (uint8_t c = 0; c < peer.num_channels; c++) {
+            if (_controller->isChannelIrrigating(peer.base_virtual_ch + c)) return true;
+        }
+    }
+    return false;
+}
+
+unsigned long NodeManager::peerInterval(const NodePeer& peer) const {
+    return LinkTiming::interval(isPeerActive(peer), peer.link);
+}
+
+// Master: expected-next-heard deadline
+void NodeManager::refreshDeadline(NodePeer& peer) {
+    peer.heard_by = millis() + LinkTiming::deadline(peer.hb_interval, peer.hb_prev, peer.link);
+}
+
+// Slave: a valve is open or a start is staged
+bool NodeManager::isLocallyActive() const {
+    if (_role != NODE_ROLE_SLAVE || !_controller) return false;
+    for (uint8_t ch = 1; ch <= NUM_LOCAL_CHANNELS; ch++) {
+        if (_controller->isChannelIrrigating(ch) || hasStagedStart(ch)) return true;
+    }
+    return false;
+}
+
 // ============================================================================
 // Timeout check
 // ============================================================================
@@ -668,11 +1693,12 @@ void NodeManager::checkPeerTimeouts() {
 
     for (uint8_t i = 0; i < _slaveCount; i++) {
         if (_slaves[i].online && _slaves[i].last_seen > 0) {
-            if (now - _slaves[i].last_seen >= NODE_PEER_TIMEOUT) {
+            if ((long)(now - _slaves[i].heard_by) >= 0) {
                 DEBUG_PRINTF("NodeManager: Slave '%s' OFFLINE (timeout)\n",
                              _slaves[i].node_id);
                 _slaves[i].online = false;
                 _slaves[i].irrigating = false;
+                _peerGeneration++;
                 _slaves[i].time_remaining = 0;
 
                 // Mark virtual channels as not irrigating
@@ -685,12 +1711,28 @@ void NodeManager::checkPeerTimeouts() {
             }
         }
     }
+
+    for (uint8_t i = 0; i < _sensorCount; i++) {
+        if (_sensors[i].online && now - _sensors[i].last_seen >=
+            (unsigned long)NODE_HEARTBEAT_IDLE * NODE_TIMEOUT_MISSES + NODE_TIMEOUT_MARGIN) {
+            DEBUG_PRINTF("NodeManager: Sensor '%s' OFFLINE (timeout)\n", _sensors[i].node_id);
+            _sensors[i].online = false;
+            _peerGeneration++;
+        }
+    }
 }
 
 // ============================================================================
 // Schedule Sync: Master-side
 // ============================================================================
 
+// Cycle-and-soak and closed-loop schedules stay on the master, which
+// stages each run on the slave; the rest are synced for the slave to keep
+bool NodeManager::isMasterDriven(const IrrigationSchedule& schedule) const {
+    if (schedule.cycles > 1) return true;
+    return _controller && _controller->getMoistureLoop(schedule.channel).enabled;
+}
+
 void NodeManager::syncSchedulesForSlave(NodePeer* slave) {
     if (!slave || !_controller) return;
     if (!slave->online || slave->ip == IPAddress(0, 0, 0, 0)) {
@@ -713,6 +1755,7 @@ void NodeManager::syncSchedulesForSlave(NodePeer* slave) {
         if (!schedules[i].enabled) continue;
         uint8_t ch = schedules[i].channel;
         if (ch < baseVch || ch >= baseVch + numCh) continue;
+        if (isMasterDriven(schedules[i])) continue;
 
         uint8_t localCh = ch - baseVch + 1;
 
@@ -792,6 +1835,7 @@ void NodeManager::sendSkipToSlave(uint8_t virtualChannel, uint8_t scheduleIndex)
         if (!schedules[i].enabled) continue;
         uint8_t ch = schedules[i].channel;
         if (ch < baseVch || ch >= baseVch + numCh) continue;
+        if (isMasterDriven(schedules[i])) continue;
         if (i == scheduleIndex) {
             found = true;
             break;
@@ -839,6 +1883,7 @@ void NodeManager::sendUnskipToSlave(uint8_t virtualChannel, uint8_t scheduleInde
         if (!schedules[i].enabled) continue;
         uint8_t ch = schedules[i].channel;
         if (ch < baseVch || ch >= baseVch + numCh) continue;
+        if (isMasterDriven(schedules[i])) continue;
         if (i == scheduleIndex) {
             found = true;
             break;
@@ -969,9 +2014,25 @@ void NodeManager::handlePairRequest(IPAddress senderIp, uint16_t senderPort,
     const char* srcId = msg.src_id;
     const char* name = msg.pair.name;
     uint8_t numCh = msg.pair.num_channels;
+    bool isSensor = (msg.pair.role == NODE_ROLE_SENSOR);
 
-    DEBUG_PRINTF("NodeManager: PAIR_REQUEST from '%s' name='%s' channels=%d IP=%s\n",
-                 srcId, name, numCh, senderIp.toString().c_str());
+    DEBUG_PRINTF("NodeManager: PAIR_REQUEST from '%s' name='%s' channels=%d sensor=%d IP=%s\n",
+                 srcId, name, numCh, isSensor, senderIp.toString().c_str());
+
+    // Already known sensor node? Re-send PAIR_ACCEPT (no virtual channels)
+    SensorPeer* knownSensor = findSensorByNodeId(srcId);
+    if (knownSensor) {
+        IrrigationMsg reply = {};
+        fillHeader(reply, MSG_PAIR_ACCEPT, srcId, 0);
+        reply.pair_accept.base_virtual_ch = 0;
+        sendUdp(senderIp, senderPort, reply);
+        knownSensor->ip = senderIp;
+        knownSensor->port = senderPort;
+        if (!knownSensor->online) _peerGeneration++;
+        knownSensor->online = true;
+        knownSensor->last_seen = millis();
+        return;
+    }
 
     // Already known slave? Re-send PAIR_ACCEPT (idempotent)
     NodePeer* existing = findSlaveByNodeId(srcId);
@@ -985,6 +2046,7 @@ void NodeManager::handlePairRequest(IPAddress senderIp, uint16_t senderPort,
         // Update IP in case it changed
         existing->ip = senderIp;
         existing->port = senderPort;
+        if (!existing->online) _peerGeneration++;
         existing->online = true;
         existing->last_seen = millis();
         return;
@@ -998,8 +2060,8 @@ void NodeManager::handlePairRequest(IPAddress senderIp, uint16_t senderPort,
     }
 
     // Slots full?
-    if (_slaveCount >= MAX_SLAVES) {
-        DEBUG_PRINTLN("NodeManager: Max slaves reached, sending PAIR_REJECT(FULL)");
+    if (isSensor ? (_sensorCount >= MAX_SENSOR_NODES) : (_slaveCount >= MAX_SLAVES)) {
+        DEBUG_PRINTLN("NodeManager: Max nodes reached, sending PAIR_REJECT(FULL)");
         IrrigationMsg reply = {};
         fillHeader(reply, MSG_PAIR_REJECT, srcId, 0);
         reply.pair_reject.reason = PAIR_REJECT_FULL;
@@ -1013,10 +2075,12 @@ void NodeManager::handlePairRequest(IPAddress senderIp, uint16_t senderPort,
     strncpy(_pendingPair.name, name, sizeof(_pendingPair.name) - 1);
     _pendingPair.name[sizeof(_pendingPair.name) - 1] = '\0';
     _pendingPair.num_channels = numCh;
+    _pendingPair.role = isSensor ? NODE_ROLE_SENSOR : NODE_ROLE_SLAVE;
     _pendingPair.ip = senderIp;
     _pendingPair.port = senderPort;
     _pendingPair.received_at = millis();
     _pendingPair.active = true;
+    _peerGeneration++;
 
     DEBUG_PRINTF("NodeManager: Pair request stored — waiting for user approval (60s timeout)\n");
 
@@ -1029,6 +2093,35 @@ void NodeManager::handlePairRequest(IPAddress senderIp, uint16_t senderPort,
 void NodeManager::acceptPendingPair() {
     if (!_pendingPair.active) return;
 
+    // Sensor nodes get no virtual channels
+    if (_pendingPair.role == NODE_ROLE_SENSOR) {
+        if (!addSensor(_pendingPair.node_id)) {
+            rejectPendingPair(PAIR_REJECT_FULL);
+            return;
+        }
+        SensorPeer* sensor = findSensorByNodeId(_pendingPair.node_id);
+        if (sensor) {
+            strncpy(sensor->name, _pendingPair.name, sizeof(sensor->name) - 1);
+            sensor->name[sizeof(sensor->name) - 1] = '\0';
+            sensor->ip = _pendingPair.ip;
+            sensor->port = _pendingPair.port;
+            sensor->online = true;
+            sensor->last_seen = millis();
+        }
+        savePairedSensors();
+
+        IrrigationMsg reply = {};
+        fillHeader(reply, MSG_PAIR_ACCEPT, _pendingPair.node_id, 0);
+        reply.pair_accept.base_virtual_ch = 0;
+        sendUdp(_pendingPair.ip, _pendingPair.port, reply);
+
+        DEBUG_PRINTF("NodeManager: Accepted sensor node '%s' (%s)\n",
+                     _pendingPair.name, _pendingPair.node_id);
+        memset(&_pendingPair, 0, sizeof(_pendingPair));
+        _peerGeneration++;
+        return;
+    }
+
     uint8_t vch = nextVirtualChannel();
     if (vch == 0) {
         DEBUG_PRINTLN("NodeManager: No virtual channels available, rejecting");
@@ -1049,6 +2142,7 @@ void NodeManager::acceptPendingPair() {
         peer->port = _pendingPair.port;
         peer->online = true;
         peer->last_seen = millis();
+        peer->run_seq = 0;  // A (re-)paired node may have started a fresh journal
     }
 
     // Persist to LittleFS
@@ -1065,6 +2159,7 @@ void NodeManager::acceptPendingPair() {
 
     // Clear pending
     memset(&_pendingPair, 0, sizeof(_pendingPair));
+    _peerGeneration++;
 }
 
 void NodeManager::rejectPendingPair(uint8_t reason) {
@@ -1082,6 +2177,7 @@ void NodeManager::rejectPendingPair(uint8_t reason) {
     sendUdp(_pendingPair.ip, _pendingPair.port, reply);
 
     memset(&_pendingPair, 0, sizeof(_pendingPair));
+    _peerGeneration++;
 }
 
 void NodeManager::checkPairTimeout() {
@@ -1110,7 +2206,21 @@ bool NodeManager::unpairSlave(const char* nodeId) {
             break;
         }
     }
-    if (idx < 0) return false;
+    if (idx < 0) {
+        // Not a slave — try the sensor nodes
+        for (uint8_t i = 0; i < _sensorCount; i++) {
+            if (strncmp(_sensors[i].node_id, nodeId, sizeof(_sensors[i].node_id)) != 0) continue;
+            DEBUG_PRINTF("NodeManager: Unpaired sensor '%s'\n", _sensors[i].node_id);
+            for (uint8_t j = i; j < _sensorCount - 1; j++) {
+                _sensors[j] = _sensors[j + 1];
+            }
+            _sensorCount--;
+            _peerGeneration++;
+            savePairedSensors();
+            return true;
+        }
+        return false;
+    }
 
     // Clear virtual channel status on controller
     if (_controller) {
@@ -1129,17 +2239,30 @@ bool NodeManager::unpairSlave(const char* nodeId) {
     }
     _slaveCount--;
     memset(&_slaves[_slaveCount], 0, sizeof(NodePeer));
+    _peerGeneration++;
 
+    if (dropStoredCommands(nodeId, 0)) {
+        saveStoredCommands();
+    }
     savePairedSlaves();
     return true;
 }
 
 bool NodeManager::renameSlave(const char* nodeId, const char* newName) {
     NodePeer* peer = findSlaveByNodeId(nodeId);
-    if (!peer) return false;
+    if (!peer) {
+        SensorPeer* sensor = findSensorByNodeId(nodeId);
+        if (!sensor) return false;
+        strncpy(sensor->name, newName, sizeof(sensor->name) - 1);
+        sensor->name[sizeof(sensor->name) - 1] = '\0';
+        _peerGeneration++;
+        savePairedSensors();
+        return true;
+    }
 
     strncpy(peer->name, newName, sizeof(peer->name) - 1);
     peer->name[sizeof(peer->name) - 1] = '\0';
+    _peerGeneration++;
 
     savePairedSlaves();
     DEBUG_PRINTF("NodeManager: Renamed slave '%s' to '%s'\n", nodeId, newName);
@@ -1159,17 +2282,18 @@ void NodeManager::sendPairRequest() {
 
     IrrigationMsg msg = {};
     fillHeader(msg, MSG_PAIR_REQUEST, dstId, 0);
-    msg.pair.num_channels = NUM_LOCAL_CHANNELS;
+    msg.pair.num_channels = (_role == NODE_ROLE_SENSOR) ? 0 : NUM_LOCAL_CHANNELS;
     strncpy(msg.pair.name, _nodeName, sizeof(msg.pair.name) - 1);
     msg.pair.name[sizeof(msg.pair.name) - 1] = '\0';
+    msg.pair.role = _role;
 
     DEBUG_PRINTF("NodeManager: Sending PAIR_REQUEST to master (name='%s', channels=%d, dst='%s')\n",
-                 _nodeName, NUM_LOCAL_CHANNELS, dstId);
+                 _nodeName, msg.pair.num_channels, dstId);
     sendUdp(_masterIp, _masterPort, msg);
 }
 
 void NodeManager::handlePairAccept(const IrrigationMsg& msg) {
-    if (_role != NODE_ROLE_SLAVE) return;
+    if (_role == NODE_ROLE_MASTER) return;
 
     _assignedVirtualCh = msg.pair_accept.base_virtual_ch;
     _paired = true;
@@ -1185,7 +2309,7 @@ void NodeManager::handlePairAccept(const IrrigationMsg& msg) {
 }
 
 void NodeManager::handlePairReject(const IrrigationMsg& msg) {
-    if (_role != NODE_ROLE_SLAVE) return;
+    if (_role == NODE_ROLE_MASTER) return;
 
     const char* reasonStr = (msg.pair_reject.reason == PAIR_REJECT_FULL) ? "FULL" :
                             (msg.pair_reject.reason == PAIR_REJECT_USER) ? "USER" :
@@ -1200,13 +2324,14 @@ void NodeManager::handlePairReject(const IrrigationMsg& msg) {
 // ============================================================================
 
 void NodeManager::savePairedSlaves() {
-    DynamicJsonDocument doc(1024);
+    ArenaJsonDocument doc(1024);
 
     for (uint8_t i = 0; i < _slaveCount; i++) {
         JsonObject slave = doc.createNestedObject(_slaves[i].node_id);
         slave["virtual_channel"] = _slaves[i].base_virtual_ch;
         slave["name"] = _slaves[i].name;
         slave["num_channels"] = _slaves[i].num_channels;
+        slave["run_seq"] = _slaves[i].run_seq;
     }
 
     File file = LittleFS.open(PAIRED_SLAVES_FILE, "w");
@@ -1231,7 +2356,7 @@ void NodeManager::loadPairedSlaves() {
         return;
     }
 
-    DynamicJsonDocument doc(1024);
+    ArenaJsonDocument doc(1024);
     DeserializationError error = deserializeJson(doc, file);
     file.close();
 
@@ -1256,6 +2381,7 @@ void NodeManager::loadPairedSlaves() {
             strncpy(peer->name, name, sizeof(peer->name) - 1);
             peer->name[sizeof(peer->name) - 1] = '\0';
             peer->num_channels = numCh;
+            peer->run_seq = kv.value()["run_seq"] | 0;
         }
 
         DEBUG_PRINTF("NodeManager: Loaded paired slave '%s' (%s) virtual_ch=%d\n",
@@ -1263,6 +2389,55 @@ void NodeManager::loadPairedSlaves() {
     }
 }
 
+void NodeManager::savePairedSensors() {
+    ArenaJsonDocument doc(512);
+
+    for (uint8_t i = 0; i < _sensorCount; i++) {
+        JsonObject sensor = doc.createNestedObject(_sensors[i].node_id);
+        sensor["name"] = _sensors[i].name;
+    }
+
+    File file = LittleFS.open(PAIRED_SENSORS_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("NodeManager: Failed to open paired_sensors.json for writing");
+        return;
+    }
+    serializeJson(doc, file);
+    file.close();
+    DEBUG_PRINTF("NodeManager: Saved %d paired sensors to LittleFS\n", _sensorCount);
+}
+
+void NodeManager::loadPairedSensors() {
+    if (!LittleFS.exists(PAIRED_SENSORS_FILE)) return;
+
+    File file = LittleFS.open(PAIRED_SENSORS_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("NodeManager: Failed to open paired_sensors.json");
+        return;
+    }
+
+    ArenaJsonDocument doc(512);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        DEBUG_PRINTF("NodeManager: Failed to parse paired_sensors.json: %s\n", error.c_str());
+        return;
+    }
+
+    for (JsonPair kv : doc.as<JsonObject>()) {
+        const char* nodeId = kv.key().c_str();
+        if (strlen(nodeId) == 0 || !addSensor(nodeId)) continue;
+
+        SensorPeer* sensor = findSensorByNodeId(nodeId);
+        if (sensor) {
+            strncpy(sensor->name, kv.value()["name"] | "", sizeof(sensor->name) - 1);
+            sensor->name[sizeof(sensor->name) - 1] = '\0';
+        }
+        DEBUG_PRINTF("NodeManager: Loaded paired sensor '%s'\n", nodeId);
+    }
+}
+
 void NodeManager::savePairedMaster() {
     StaticJsonDocument<256> doc;
     doc["master_id"] = _masterNodeId;
@@ -1306,7 +2481,8 @@ void NodeManager::loadPairedMaster() {
     const char* masterId = doc["master_id"] | "";
     _assignedVirtualCh = doc["virtual_channel"] | 0;
 
-    if (strlen(masterId) > 0 && _assignedVirtualCh > 0) {
+    // Sensor nodes are paired without a virtual channel
+    if (strlen(masterId) > 0 && (_assignedVirtualCh > 0 || _role == NODE_ROLE_SENSOR)) {
         strncpy(_masterNodeId, masterId, sizeof(_masterNodeId) - 1);
         _masterNodeId[sizeof(_masterNodeId) - 1] = '\0';
         _paired = true;
@@ -1317,3 +2493,441 @@ void NodeManager::loadPairedMaster() {
         DEBUG_PRINTLN("NodeManager: Invalid paired_master.json — will request pairing");
     }
 }
+
+// ============================================================================
+// Firmware rollout: master orders, slaves install when idle
+// ============================================================================
+
+static_assert(MAX_SLAVES <= ROLLOUT_MAX_NODES, "the rollout planner cannot track every slave");
+
+bool NodeManager::startRollout(const char* target, const char* canary) {
+    if (_role != NODE_ROLE_MASTER) return false;
+
+    RolloutNode nodes[MAX_SLAVES];
+    for (uint8_t i = 0; i < _slaveCount; i++) {
+        memset(&nodes[i], 0, sizeof(nodes[i]));
+        memcpy(nodes[i].nodeId, _slaves[i].node_id, sizeof(nodes[i].nodeId));
+        memcpy(nodes[i].version, _slaves[i].version, sizeof(nodes[i].version));
+        nodes[i].online = _slaves[i].online;
+    }
+    if (!_rollout.start(target, nodes, _slaveCount, canary, millis())) return false;
+
+    // A retry by hand clears the halt; the master itself goes last
+    if (strcmp(_haltedTarget, target) == 0) _haltedTarget[0] = '\0';
+    _selfUpdate = strcmp(target, VERSION) != 0;
+    _rolloutState = ROLLOUT_IDLE;
+    DEBUG_PRINTF("NodeManager: Rollout of %s started, canary '%s', %d wave(s)\n", target,
+                 _rollout.getEntryCount() ? _rollout.getEntry(0).nodeId : "", _rollout.getWaveCount());
+    return true;
+}
+
+void NodeManager::abortRollout() {
+    if (!_rollout.isRunning()) return;
+    _rollout.halt("Aborted");
+    _selfUpdate = false;
+}
+
+// Once per master tick: auto-start after a check, step the planner, send
+// its install orders, and update the master itself after the last wave
+void NodeManager::processRollout() {
+    if (!_updater) return;
+    unsigned long now = millis();
+
+    // Give the slaves a status round after boot to report their firmware
+    OtaStatus ota = _updater->getStatus();
+    if (!_rollout.isRunning() && !_updater->isBusy() && ota.generation != _updaterSeen &&
+        now >= ROLLOUT_SETTLE) {
+        _updaterSeen = ota.generation;
+        bool behind = strcmp(ota.latest, VERSION) != 0;
+        for (uint8_t i = 0; i < _slaveCount && !behind; i++) {
+            behind = _slaves[i].version[0] && strcmp(_slaves[i].version, ota.latest) != 0;
+        }
+        if ((ota.state == OTA_AVAILABLE || ota.state == OTA_UP_TO_DATE) && behind &&
+            strcmp(ota.latest, _haltedTarget) != 0) {
+            startRollout(ota.latest);
+        }
+    }
+
+    if (_rollout.isRunning()) {
+        RolloutNode nodes[MAX_SLAVES];
+        for (uint8_t i = 0; i < _slaveCount; i++) {
+            const NodePeer& peer = _slaves[i];
+            RolloutNode& n = nodes[i];
+            memcpy(n.nodeId, peer.node_id, sizeof(n.nodeId));
+            memcpy(n.version, peer.version, sizeof(n.version));
+            n.online = peer.online;
+            n.busy = isPeerActive(peer);
+            n.jobRunning = peer.ota_state == OTA_CHECKING || peer.ota_state == OTA_DOWNLOADING ||
+                           peer.ota_state == OTA_REBOOTING;
+            n.jobFailed = peer.ota_state == OTA_FAILED;
+            n.reboots = peer.link.reboots;
+            n.crashes = peer.crashes;
+            n.divergences = peer.divergences;
+            n.faultMask = peer.fault_mask;
+            n.valveReportAt = peer.actual_at;
+        }
+
+        uint32_t orders = _rollout.step(nodes, _slaveCount, now);
+        for (uint8_t i = 0; i < _slaveCount; i++) {
+            if (orders & (1UL << i)) sendOtaStart(_slaves[i]);
+        }
+    }
+
+    uint8_t state = _rollout.getState();
+    if (state != _rolloutState) {
+        _rolloutState = state;
+        if (state == ROLLOUT_HALTED) {
+            DEBUG_PRINTF("NodeManager: Rollout of %s halted - %s\n",
+                         _rollout.getTarget(), _rollout.getReason());
+            strncpy(_haltedTarget, _rollout.getTarget(), sizeof(_haltedTarget) - 1);
+            _selfUpdate = false;
+            saveRolloutState();
+        } else if (state == ROLLOUT_DONE) {
+            DEBUG_PRINTF("NodeManager: Rollout of %s done on the slaves\n", _rollout.getTarget());
+            saveRolloutState();
+        }
+    }
+
+    // Restarting the master mid-run would leave the slaves' runs unattended
+    if (state == ROLLOUT_DONE && _selfUpdate && !_updater->isBusy() &&
+        !(_controller && _controller->isIrrigating())) {
+        _selfUpdate = false;
+        _updater->start(true, _rollout.getTarget());
+    }
+}
+
+void NodeManager::sendOtaStart(const NodePeer& peer) {
+    IrrigationMsg msg = {};
+    fillHeader(msg, MSG_OTA_START, peer.node_id, 0);
+    strncpy(msg.ota_start.version, _rollout.getTarget(), sizeof(msg.ota_start.version) - 1);
+
+    DEBUG_PRINTF("NodeManager: Ordering '%s' to install %s\n", peer.node_id, msg.ota_start.version);
+    sendUdp(peer.ip, peer.port, msg);
+    enqueueOutbox(msg, peer.ip, peer.port);
+}
+
+// Slave: the order is acknowledged at once and held until the valves are
+// idle and the updater is free (a daily check may be running)
+void NodeManager::handleOtaStart(IPAddress senderIp, uint16_t senderPort,
+                                 const IrrigationMsg& msg) {
+    if (_role != NODE_ROLE_SLAVE) return;
+
+    if (!_updater) {
+        sendAck(senderIp, senderPort, MSG_OTA_START, ACK_ERR_BUSY, msg.seq);
+        return;
+    }
+    strncpy(_otaOrder, msg.ota_start.version, sizeof(_otaOrder) - 1);
+    _otaOrder[sizeof(_otaOrder) - 1] = '\0';
+    DEBUG_PRINTF("NodeManager: Master ordered an install of %s\n", _otaOrder);
+    sendAck(senderIp, senderPort, MSG_OTA_START, ACK_OK, msg.seq);
+}
+
+void NodeManager::processOtaOrder() {
+    if (!_otaOrder[0] || !_updater) return;
+    if (strcmp(_otaOrder, VERSION) == 0) {
+        _otaOrder[0] = '\0';
+        return;
+    }
+    if (_updater->isBusy() || isLocallyActive() || !WiFi.isConnected()) return;
+
+    if (_updater->start(true, _otaOrder)) _otaOrder[0] = '\0';
+}
+
+void NodeManager::sendOtaStatus() {
+    if (_role != NODE_ROLE_SLAVE || !_masterFound) return;
+
+    IrrigationMsg msg = {};
+    fillHeader(msg, MSG_OTA_STATUS, _masterNodeId, 0);
+    if (_updater) {
+        OtaStatus ota = _updater->getStatus();
+        msg.ota_status.state = ota.state;
+        msg.ota_status.progress = ota.progress;
+        _otaReported = ota.generation;
+    }
+    uint32_t crashes = crashLog.getCrashCount();
+    msg.ota_status.crashes = (crashes > 0xFFFF) ? 0xFFFF : (uint16_t)crashes;
+    strncpy(msg.ota_status.version, VERSION, sizeof(msg.ota_status.version) - 1);
+
+    _lastOtaStatus = millis();
+    sendUdp(_masterIp, _masterPort, msg);
+}
+
+void NodeManager::handleOtaStatus(const IrrigationMsg& msg) {
+    if (_role != NODE_ROLE_MASTER) return;
+
+    NodePeer* peer = findSlaveByNodeId(msg.src_id);
+    if (!peer) return;
+
+    if (strncmp(peer->version, msg.ota_status.version, sizeof(peer->version)) != 0) {
+        memcpy(peer->version, msg.ota_status.version, sizeof(peer->version));
+        peer->version[sizeof(peer->version) - 1] = '\0';
+        _peerGeneration++;
+    }
+    peer->ota_state = msg.ota_status.state;
+    peer->ota_progress = msg.ota_status.progress;
+    peer->crashes = msg.ota_status.crashes;
+}
+
+// Only the outcome is kept: a halted release is not rolled out again
+// automatically after a master restart
+void NodeManager::saveRolloutState() {
+    StaticJsonDocument<192> doc;
+    doc["target"] = _rollout.getTarget();
+    doc["state"] = RolloutPlanner::stateName(_rollout.getState());
+    doc["reason"] = _rollout.getReason();
+
+    File file = LittleFS.open(ROLLOUT_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("NodeManager: Failed to open rollout.json for writing");
+        return;
+    }
+    serializeJson(doc, file);
+    file.close();
+}
+
+void NodeManager::loadRolloutState() {
+    if (!LittleFS.exists(ROLLOUT_FILE)) return;
+
+    File file = LittleFS.open(ROLLOUT_FILE, "r");
+    if (!file) return;
+    StaticJsonDocument<192> doc;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error) return;
+
+    if (strcmp(doc["state"] | "", "halted") == 0) {
+        strncpy(_haltedTarget, doc["target"] | "", sizeof(_haltedTarget) - 1);
+        DEBUG_PRINTF("NodeManager: Rollout of %s halted earlier (%s); not restarted automatically\n",
+                     _haltedTarget, doc["reason"] | "");
+    }
+}
+
+// ============================================================================
+// Run records: slave journal -> master fleet history
+// ============================================================================
+
+// Each node journals its own valves, so a run is recorded with the times it
+// really had even when the master or the network was down meanwhile
+void NodeManager::recordRun(const RunRecord& run) {
+    if (_role == NODE_ROLE_MASTER) {
+        if (_runHistory.insert(run)) saveRunHistory();
+        return;
+    }
+    if (_role != NODE_ROLE_SLAVE) return;
+
+    uint32_t lostBefore = _runJournal.getOverwritten();
+    uint16_t seq = _runJournal.append(run);
+    if (_runJournal.getOverwritten() != lostBefore) {
+        DEBUG_PRINTLN("NodeManager: Run journal full, oldest unmerged run dropped");
+    }
+    saveRunJournal();
+    _lastRunBatch = millis() - RUN_BATCH_RETRY;  // Ship on the next update()
+
+    DEBUG_PRINTF("NodeManager: Journaled run #%u ch%d %us\n",
+                 seq, run.channel, run.duration_s);
+}
+
+// Slave: the oldest unacknowledged runs, as many as fit in one frame. Each
+// send gets a fresh header seq so the master's dedup never swallows a retry;
+// the master drops records it already merged by their journal seq.
+void NodeManager::sendRunBatch() {
+    _lastRunBatch = millis();
+    if (!WiFi.isConnected()) return;
+
+    RunBatchMsg batch = {};
+    batch.version = NODE_PROTO_VERSION;
+    batch.type = MSG_RUN_BATCH;
+    batch.seq = _seq++;
+    strncpy(batch.src_id, _nodeId, sizeof(batch.src_id) - 1);
+    strncpy(batch.dst_id, _masterNodeId, sizeof(batch.dst_id) - 1);
+
+    uint8_t count = _runJournal.getCount();
+    if (count > RUN_BATCH_MAX) count = RUN_BATCH_MAX;
+    for (uint8_t i = 0; i < count; i++) {
+        batch.runs[i] = _runJournal.at(i);
+    }
+    batch.count = count;
+
+    _udp.beginPacket(_masterIp, _masterPort);
+    _udp.write((const uint8_t*)&batch, offsetof(RunBatchMsg, runs) + count * sizeof(RunRecord));
+    _udp.endPacket();
+}
+
+void NodeManager::handleRunBatch(IPAddress senderIp, uint16_t senderPort,
+                                 const uint8_t* data, int len) {
+    if (_role != NODE_ROLE_MASTER) return;
+    if ((size_t)len < offsetof(RunBatchMsg, runs)) return;
+
+    RunBatchMsg batch = {};
+    memcpy(&batch, data, (size_t)len < sizeof(batch) ? (size_t)len : sizeof(batch));
+    if (batch.count > RUN_BATCH_MAX ||
+        (size_t)len < offsetof(RunBatchMsg, runs) + batch.count * sizeof(RunRecord)) {
+        DEBUG_PRINTF("NodeManager: Malformed run batch from '%s' (%d bytes)\n", batch.src_id, len);
+        return;
+    }
+
+    NodePeer* peer = findSlaveByNodeId(batch.src_id);
+    if (!peer) return;  // Not paired; it will re-pair first
+
+    uint8_t merged = 0;
+    for (uint8_t i = 0; i < batch.count; i++) {
+        RunRecord run = batch.runs[i];
+
+        // Already merged, unless the step back is so large the slave restarted
+        int16_t step = (int16_t)(run.seq - peer->run_seq);
+        if (step <= 0 && step > -LINK_SEQ_RESYNC) continue;
+        peer->run_seq = run.seq;
+
+        if (run.channel < 1 || run.channel > peer->num_channels) continue;
+        run.channel = peer->base_virtual_ch + run.channel - 1;
+
+        // A slave without a clock: best guess is that the run just ended
+        if (run.start == 0 && _controller && _controller->hasValidTime()) {
+            run.start = (uint32_t)_controller->getCurrentTime() - run.duration_s;
+        }
+        _runHistory.insert(run);
+        merged++;
+    }
+
+    if (merged > 0) {
+        saveRunHistory();
+        savePairedSlaves();
+        DEBUG_PRINTF("NodeManager: Merged %d run(s) from '%s' up to #%u\n",
+                     merged, peer->node_id, peer->run_seq);
+    }
+
+    // Always answer, so a lost ACK is repaired by the slave's next resend
+    IrrigationMsg ack = {};
+    fillHeader(ack, MSG_RUN_ACK, peer->node_id, 0);
+    ack.run_ack.seq = peer->run_seq;
+    sendUdp(senderIp, senderPort, ack);
+}
+
+void NodeManager::handleRunAck(const IrrigationMsg& msg) {
+    if (_role != NODE_ROLE_SLAVE) return;
+    if (strncmp(msg.src_id, _masterNodeId, sizeof(msg.src_id)) != 0) return;
+
+    if (_runJournal.acknowledge(msg.run_ack.seq) == 0) return;
+    saveRunJournal();
+
+    // More waiting: send the next batch now rather than after the retry interval
+    if (_runJournal.getCount() > 0) sendRunBatch();
+}
+
+void NodeManager::saveRunJournal() {
+    ArenaJsonDocument doc(JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(RUN_JOURNAL_SIZE) +
+                            RUN_JOURNAL_SIZE * JSON_ARRAY_SIZE(6));
+    doc["next_seq"] = _runJournal.getNextSeq();
+    JsonArray runs = doc.createNestedArray("runs");
+    for (uint8_t i = 0; i < _runJournal.getCount(); i++) {
+        const RunRecord& run = _runJournal.at(i);
+        JsonArray r = runs.createNestedArray();
+        r.add(run.seq);
+        r.add(run.start);
+        r.add(run.duration_s);
+        r.add(run.volume_dl);
+        r.add(run.channel);
+        r.add(run.reason);
+    }
+
+    File file = LittleFS.open(RUN_JOURNAL_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("NodeManager: Failed to open run_journal.json for writing");
+        return;
+    }
+    serializeJson(doc, file);
+    file.close();
+}
+
+void NodeManager::loadRunJournal() {
+    if (!LittleFS.exists(RUN_JOURNAL_FILE)) return;
+
+    File file = LittleFS.open(RUN_JOURNAL_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("NodeManager: Failed to open run_journal.json");
+        return;
+    }
+
+    ArenaJsonDocument doc(JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(RUN_JOURNAL_SIZE) +
+                            RUN_JOURNAL_SIZE * JSON_ARRAY_SIZE(6) + 64);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        DEBUG_PRINTF("NodeManager: Failed to parse run_journal.json: %s\n", error.c_str());
+        return;
+    }
+
+    RunRecord records[RUN_JOURNAL_SIZE];
+    uint8_t count = 0;
+    for (JsonArray r : doc["runs"].as<JsonArray>()) {
+        if (count >= RUN_JOURNAL_SIZE) break;
+        RunRecord& run = records[count++];
+        run.seq = r[0] | 0;
+        run.start = r[1] | 0UL;
+        run.duration_s = r[2] | 0;
+        run.volume_dl = r[3] | RUN_VOLUME_NONE;
+        run.channel = r[4] | 1;
+        run.reason = r[5] | RUN_END_STOPPED;
+    }
+    _runJournal.restore(records, count, doc["next_seq"] | 1);
+
+    if (count > 0) {
+        DEBUG_PRINTF("NodeManager: Loaded %d unmerged run(s)\n", count);
+    }
+}
+
+// Saved after every merge; runs are minutes apart, so flash wear is low
+void NodeManager::saveRunHistory() {
+    ArenaJsonDocument doc(JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(RUN_HISTORY_SIZE) +
+                            RUN_HISTORY_SIZE * JSON_ARRAY_SIZE(5));
+    JsonArray runs = doc.createNestedArray("runs");
+    for (uint8_t i = 0; i < _runHistory.getCount(); i++) {
+        const RunRecord& run = _runHistory.at(i);
+        JsonArray r = runs.createNestedArray();
+        r.add(run.start);
+        r.add(run.duration_s);
+        r.add(run.volume_dl);
+        r.add(run.channel);
+        r.add(run.reason);
+    }
+
+    File file = LittleFS.open(RUN_HISTORY_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("NodeManager: Failed to open run_history.json for writing");
+        return;
+    }
+    serializeJson(doc, file);
+    file.close();
+}
+
+void NodeManager::loadRunHistory() {
+    if (!LittleFS.exists(RUN_HISTORY_FILE)) return;
+
+    File file = LittleFS.open(RUN_HISTORY_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("NodeManager: Failed to open run_history.json");
+        return;
+    }
+
+    ArenaJsonDocument doc(JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(RUN_HISTORY_SIZE) +
+                            RUN_HISTORY_SIZE * JSON_ARRAY_SIZE(5) + 64);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        DEBUG_PRINTF("NodeManager: Failed to parse run_history.json: %s\n", error.c_str());
+        return;
+    }
+
+    for (JsonArray r : doc["runs"].as<JsonArray>()) {
+        RunRecord run = {};
+        run.start = r[0] | 0UL;
+        run.duration_s = r[1] | 0;
+        run.volume_dl = r[2] | RUN_VOLUME_NONE;
+        run.channel = r[3] | 1;
+        run.reason = r[4] | RUN_END_STOPPED;
+        _runHistory.insert(run);
+    }
+    DEBUG_PRINTF("NodeManager: Loaded %d run(s) of fleet history\n", _runHistory.getCount());
+}
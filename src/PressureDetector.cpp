@@ -0,0 +1,214 @@
+#include "PressureDetector.h"
+#include <math.h>
+#include <string.h>
+
+PressureDetector::PressureDetector() {
+    memset(_zoneBaseline, 0, sizeof(_zoneBaseline));
+    _staticBaseline = 0;
+    _reportedStatic = 0;
+    _baselinesChanged = false;
+    reset();
+}
+
+void PressureDetector::reset() {
+    _open = 0;
+    _settleUntil = 0;
+    _settleSum = 0;
+    _settleCount = 0;
+    _settled = false;
+    _primed = false;
+    _filtered = 0;
+    _reference = 0;
+    _cusum = 0;
+    _runClean = false;
+    _leakSince = 0;
+    _leakActive = false;
+    _driftSum = 0;
+    _driftCount = 0;
+    _sagLow = 0;
+    _sagSince = 0;
+    _alarm = PRESSURE_EVENT_NONE;
+    _alarmZones = 0;
+}
+
+void PressureDetector::clearAlarm() {
+    _alarm = PRESSURE_EVENT_NONE;
+    _alarmZones = 0;
+    // Acknowledging a leak accepts the current level as the new static pressure
+    if (_leakActive) {
+        _leakActive = false;
+        _leakSince = 0;
+        if (_open == 0 && _primed) moveStatic(_filtered);
+    }
+}
+
+float PressureDetector::getZoneBaseline(uint8_t zone) const {
+    if (zone < 1 || zone > PRESSURE_MAX_ZONES) return 0;
+    return _zoneBaseline[zone - 1];
+}
+
+void PressureDetector::setZoneBaseline(uint8_t zone, float kPa) {
+    if (zone < 1 || zone > PRESSURE_MAX_ZONES) return;
+    _zoneBaseline[zone - 1] = kPa;
+}
+
+void PressureDetector::setStaticBaseline(float kPa) {
+    _staticBaseline = kPa;
+    _reportedStatic = kPa;
+}
+
+bool PressureDetector::takeBaselinesChanged() {
+    bool changed = _baselinesChanged;
+    _baselinesChanged = false;
+    return changed;
+}
+
+uint8_t PressureDetector::singleZone() const {
+    if (_open == 0 || (_open & (_open - 1))) return 0;
+    uint8_t zone = 1;
+    for (uint32_t m = _open; !(m & 1); m >>= 1) zone++;
+    return zone;
+}
+
+void PressureDetector::learn(float& baseline, float value) {
+    baseline = (baseline <= 0) ? value : baseline + PRESSURE_LEARN_WEIGHT * (value - baseline);
+    _baselinesChanged = true;
+}
+
+// Flags the change only once it adds up to PRESSURE_SAVE_DELTA, so drift
+// tracking doesn't rewrite the baseline file on every persist interval
+void PressureDetector::moveStatic(float kPa) {
+    _staticBaseline = kPa;
+    if (fabsf(kPa - _reportedStatic) >= PRESSURE_SAVE_DELTA) {
+        _reportedStatic = kPa;
+        _baselinesChanged = true;
+    }
+}
+
+// Follows supply drift with an EMA on block means; per-sample steps that
+// small would round away against a 400 kPa float. Below the band a sag may
+// be draining towards a leak, so the baseline holds still. A sag that
+// stops making new lows for PRESSURE_SAG_STEADY_MS was a step in the supply.
+void PressureDetector::trackStatic(uint32_t nowMs) {
+    if (_filtered < _staticBaseline - PRESSURE_DRIFT_BAND) {
+        _driftSum = 0;
+        _driftCount = 0;
+        if (_sagSince == 0 || _filtered < _sagLow - PRESSURE_SAG_STEP) {
+            _sagLow = _filtered;
+            _sagSince = nowMs ? nowMs : 1;
+        } else if (nowMs - _sagSince >= PRESSURE_SAG_STEADY_MS) {
+            moveStatic(_filtered);
+            _sagSince = 0;
+        }
+        return;
+    }
+
+    _sagSince = 0;
+    _driftSum += _filtered - _staticBaseline;
+    if (++_driftCount < PRESSURE_DRIFT_BLOCK) return;
+    float mean = _driftSum / _driftCount;
+    _driftSum = 0;
+    _driftCount = 0;
+    moveStatic(_staticBaseline + PRESSURE_DRIFT_ALPHA * mean);
+}
+
+uint8_t PressureDetector::raise(uint8_t event, uint32_t zones) {
+    _alarm = event;
+    _alarmZones = zones;
+    _runClean = false;
+    _cusum = 0;
+    _reference = _filtered;  // Report each collapse once
+    return event;
+}
+
+void PressureDetector::setOpenZones(uint32_t mask, uint32_t nowMs) {
+    if (mask == _open) return;
+
+    // A clean, settled single-zone run just ended: fold it into the baseline
+    uint8_t zone = singleZone();
+    if (zone > 0 && _settled && _runClean) {
+        learn(_zoneBaseline[zone - 1], _reference);
+    }
+
+    _open = mask;
+    _settleUntil = nowMs + PRESSURE_SETTLE_MS;
+    _settleSum = 0;
+    _settleCount = 0;
+    _settled = false;
+    _cusum = 0;
+    _leakSince = 0;
+    _driftSum = 0;
+    _driftCount = 0;
+    _sagSince = 0;
+}
+
+uint8_t PressureDetector::addSample(float kPa, uint32_t nowMs) {
+    _filtered = _primed ? _filtered + PRESSURE_FILTER_ALPHA * (kPa - _filtered) : kPa;
+    _primed = true;
+
+    if (!_settled) {
+        if ((int32_t)(nowMs - _settleUntil) < 0) {
+            // Average the second half of the settling window
+            if ((int32_t)(_settleUntil - nowMs) <= PRESSURE_SETTLE_MS / 2) {
+                _settleSum += _filtered;
+                _settleCount++;
+            }
+            return PRESSURE_EVENT_NONE;
+        }
+        _settled = true;
+        _runClean = true;
+        _reference = _settleCount ? _settleSum / _settleCount : _filtered;
+
+        // Opened onto an already broken lateral: compare with what this
+        // zone normally settles at
+        uint8_t zone = singleZone();
+        if (zone > 0) {
+            float baseline = _zoneBaseline[zone - 1];
+            if (baseline > 0 && _reference < baseline * (1.0f - PRESSURE_BURST_DROP)) {
+                return raise(PRESSURE_EVENT_BURST, _open);
+            }
+        }
+        if (_open == 0 && _staticBaseline <= 0) {
+            learn(_staticBaseline, _reference);
+            _reportedStatic = _staticBaseline;
+        }
+    }
+
+    if (_open != 0) {
+        // One-sided CUSUM for a downward change point
+        float sag = _reference - _filtered - PRESSURE_CUSUM_SLACK;
+        _cusum = (_cusum + sag > 0) ? _cusum + sag : 0;
+
+        if (_cusum > PRESSURE_CUSUM_LIMIT) {
+            if (_filtered < _reference * (1.0f - PRESSURE_BURST_DROP)) {
+                return raise(PRESSURE_EVENT_BURST, _open);
+            }
+            _reference = _filtered;  // Modest step (shared supply): re-anchor
+            _cusum = 0;
+            _runClean = false;       // ...but don't learn this run
+        } else if (_cusum == 0) {
+            _reference += PRESSURE_TRACK_ALPHA * (_filtered - _reference);
+        }
+        return PRESSURE_EVENT_NONE;
+    }
+
+    // Every valve closed: the line should hold its static pressure
+    if (_staticBaseline <= 0) return PRESSURE_EVENT_NONE;
+
+    if (_filtered < _staticBaseline - PRESSURE_LEAK_DROP) {
+        if (_leakActive) return PRESSURE_EVENT_NONE;
+        if (_leakSince == 0) _leakSince = nowMs ? nowMs : 1;
+        if (nowMs - _leakSince >= PRESSURE_LEAK_HOLD_MS) {
+            _leakActive = true;
+            return raise(PRESSURE_EVENT_LEAK, 0);
+        }
+        return PRESSURE_EVENT_NONE;
+    }
+
+    _leakSince = 0;
+    if (_leakActive && _filtered > _staticBaseline - PRESSURE_LEAK_DROP / 2) {
+        _leakActive = false;  // Recovered (alarm stays latched for the record)
+    }
+    if (!_leakActive) trackStatic(nowMs);
+    return PRESSURE_EVENT_NONE;
+}
@@ -0,0 +1,176 @@
+#include "PressureMonitor.h"
+#include "IrrigationController.h"
+
+PressureMonitor::PressureMonitor(IrrigationController* controller)
+    : _controller(controller),
+      _alertCallback(nullptr),
+      _queue(nullptr),
+      _task(nullptr),
+      _sensorOk(false),
+      _baselinesDirty(false),
+      _lastSave(0) {
+}
+
+bool PressureMonitor::begin() {
+    DEBUG_PRINTLN("PressureMonitor: Initializing...");
+
+    loadBaselines();
+
+    pinMode(PRESSURE_SENSOR_PIN, INPUT);
+    analogReadResolution(12);
+
+    _queue = xQueueCreate(PRESSURE_QUEUE_LEN, sizeof(PressureBlock));
+    if (!_queue) {
+        DEBUG_PRINTLN("PressureMonitor: Failed to create sample queue");
+        return false;
+    }
+
+    // Sampling lives in its own task so a slow loop (HTTP, MQTT reconnect)
+    // delays detection but never the sample clock
+    if (xTaskCreate(samplerTask, "pressure", 2048, this, 2, &_task) != pdPASS) {
+        DEBUG_PRINTLN("PressureMonitor: Failed to start sampler task");
+        return false;
+    }
+
+    DEBUG_PRINTF("PressureMonitor: Sampling GPIO%d at %d Hz (static baseline %.0f kPa)\n",
+                 PRESSURE_SENSOR_PIN, PRESSURE_SAMPLE_HZ, _detector.getStaticBaseline());
+    return true;
+}
+
+void PressureMonitor::samplerTask(void* arg) {
+    PressureMonitor* self = static_cast<PressureMonitor*>(arg);
+    TickType_t period = pdMS_TO_TICKS(1000 / PRESSURE_SAMPLE_HZ);
+    if (period == 0) period = 1;
+
+    TickType_t wake = xTaskGetTickCount();
+    uint32_t sum = 0;
+    uint8_t count = 0;
+
+    while (true) {
+        vTaskDelayUntil(&wake, period);
+        sum += analogReadMilliVolts(PRESSURE_SENSOR_PIN);
+        if (++count < PRESSURE_BLOCK_SIZE) continue;
+
+        PressureBlock block;
+        block.milliVolts = (uint16_t)(sum / count);
+        block.at = millis();
+        xQueueSend(self->_queue, &block, 0);  // Full queue: drop, the loop is stalled
+        sum = 0;
+        count = 0;
+    }
+}
+
+uint32_t PressureMonitor::openLocalZones() const {
+    // The transducer sits on this node's mainline: only local valves matter
+    const uint64_t local = ~0ULL >> (64 - NUM_LOCAL_CHANNELS);
+    return (uint32_t)(_controller->getIrrigatingMask() & local);
+}
+
+void PressureMonitor::update() {
+    if (!_queue || !_controller) return;
+
+    PressureBlock block;
+    while (xQueueReceive(_queue, &block, 0) == pdTRUE) {
+        _detector.setOpenZones(openLocalZones(), block.at);
+
+        bool ok = block.milliVolts >= PRESSURE_MV_ZERO - PRESSURE_MV_FAULT_MARGIN &&
+                  block.milliVolts <= PRESSURE_MV_FULL + PRESSURE_MV_FAULT_MARGIN;
+        if (ok != _sensorOk) {
+            _sensorOk = ok;
+            DEBUG_PRINTF("PressureMonitor: Sensor %s (%d mV)\n", ok ? "OK" : "FAULT", block.milliVolts);
+        }
+        if (!ok) continue;
+
+        float kPa = (float)((int)block.milliVolts - PRESSURE_MV_ZERO) * PRESSURE_KPA_FULL /
+                    (PRESSURE_MV_FULL - PRESSURE_MV_ZERO);
+        if (kPa < 0) kPa = 0;
+
+        uint8_t event = _detector.addSample(kPa, block.at);
+        if (event == PRESSURE_EVENT_NONE) continue;
+
+        uint32_t zones = _detector.getAlarmZones();
+        if (event == PRESSURE_EVENT_BURST) {
+            DEBUG_PRINTF("PressureMonitor: BURST at %.0f kPa, shutting zones 0x%lx\n",
+                         _detector.getPressure(), (unsigned long)zones);
+            for (uint8_t ch = 1; ch <= NUM_LOCAL_CHANNELS; ch++) {
+                // Held off until the alarm is cleared, so neither a schedule
+                // nor the master's state vector can reopen a burst zone
+                if (zones & (1UL << (ch - 1))) _controller->setChannelFault(ch, true);
+            }
+        } else {
+            DEBUG_PRINTF("PressureMonitor: LEAK — %.0f kPa with all valves closed (static %.0f kPa)\n",
+                         _detector.getPressure(), _detector.getStaticBaseline());
+        }
+        if (_alertCallback) {
+            _alertCallback(event, zones, _detector.getPressure());
+        }
+    }
+
+    if (_detector.takeBaselinesChanged()) _baselinesDirty = true;
+    if (_baselinesDirty && millis() - _lastSave >= PRESSURE_SAVE_INTERVAL) {
+        _lastSave = millis();
+        _baselinesDirty = false;
+        saveBaselines();
+    }
+}
+
+void PressureMonitor::clearAlarm() {
+    uint32_t zones = _detector.getAlarmZones();
+    for (uint8_t ch = 1; ch <= NUM_LOCAL_CHANNELS; ch++) {
+        if (zones & (1UL << (ch - 1))) _controller->setChannelFault(ch, false);
+    }
+    _detector.clearAlarm();
+    DEBUG_PRINTLN("PressureMonitor: Alarm cleared");
+}
+
+// ============================================================================
+// Baseline persistence
+// ============================================================================
+
+bool PressureMonitor::saveBaselines() {
+    ArenaJsonDocument doc(512);
+    doc["static"] = _detector.getStaticBaseline();
+    JsonArray zones = doc.createNestedArray("zones");
+    for (uint8_t ch = 1; ch <= NUM_LOCAL_CHANNELS; ch++) {
+        zones.add(_detector.getZoneBaseline(ch));
+    }
+
+    File file = LittleFS.open(PRESSURE_BASELINE_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("PressureMonitor: Failed to open baseline file for writing");
+        return false;
+    }
+    serializeJson(doc, file);
+    file.close();
+    return true;
+}
+
+bool PressureMonitor::loadBaselines() {
+    if (!LittleFS.exists(PRESSURE_BASELINE_FILE)) {
+        DEBUG_PRINTLN("PressureMonitor: No baselines yet, learning from scratch");
+        return false;
+    }
+
+    File file = LittleFS.open(PRESSURE_BASELINE_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("PressureMonitor: Failed to open baseline file");
+        return false;
+    }
+
+    ArenaJsonDocument doc(512);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        DEBUG_PRINTF("PressureMonitor: Failed to parse baseline file: %s\n", error.c_str());
+        return false;
+    }
+
+    _detector.setStaticBaseline(doc["static"] | 0.0f);
+    uint8_t ch = 1;
+    for (float kPa : doc["zones"].as<JsonArray>()) {
+        if (ch > NUM_LOCAL_CHANNELS) break;
+        _detector.setZoneBaseline(ch++, kPa);
+    }
+    return true;
+}
@@ -0,0 +1,291 @@
+#include "RolloutPlanner.h"
+#include <string.h>
+
+static void copyString(char* dst, const char* src, size_t size) {
+    strncpy(dst, src ? src : "", size - 1);
+    dst[size - 1] = '\0';
+}
+
+RolloutPlanner::RolloutPlanner()
+    : _state(ROLLOUT_IDLE),
+      _wave(0),
+      _waveCount(0),
+      _count(0),
+      _generation(0) {
+    memset(_target, 0, sizeof(_target));
+    memset(_reason, 0, sizeof(_reason));
+    memset(_entries, 0, sizeof(_entries));
+}
+
+const char* RolloutPlanner::stateName(uint8_t state) {
+    switch (state) {
+        case ROLLOUT_CANARY: return "canary";
+        case ROLLOUT_WAVES:  return "waves";
+        case ROLLOUT_DONE:   return "done";
+        case ROLLOUT_HALTED: return "halted";
+        default:             return "idle";
+    }
+}
+
+const char* RolloutPlanner::nodeStateName(uint8_t state) {
+    switch (state) {
+        case ROLLOUT_NODE_ORDERED:  return "ordered";
+        case ROLLOUT_NODE_UPDATING: return "updating";
+        case ROLLOUT_NODE_SOAKING:  return "soaking";
+        case ROLLOUT_NODE_DONE:     return "done";
+        case ROLLOUT_NODE_SKIPPED:  return "skipped";
+        case ROLLOUT_NODE_FAILED:   return "failed";
+        default:                    return "pending";
+    }
+}
+
+int8_t RolloutPlanner::findNode(const RolloutNode* nodes, uint8_t count, const char* nodeId) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (strncmp(nodes[i].nodeId, nodeId, sizeof(nodes[i].nodeId)) == 0) return i;
+    }
+    return -1;
+}
+
+// A node can take part if it has reported a version other than the target.
+// Offline nodes have not reported yet and get their chance at their turn.
+bool RolloutPlanner::start(const char* target, const RolloutNode* nodes, uint8_t count,
+                           const char* canary, uint32_t nowMs) {
+    if (isRunning() || !target || !target[0]) return false;
+    if (count > ROLLOUT_MAX_NODES) count = ROLLOUT_MAX_NODES;
+
+    int8_t canaryIdx = -1;
+    if (canary && canary[0]) {
+        canaryIdx = findNode(nodes, count, canary);
+        if (canaryIdx < 0) return false;
+        const RolloutNode& n = nodes[canaryIdx];
+        if (!n.online || !n.version[0] || strcmp(n.version, target) == 0) return false;
+    }
+
+    copyString(_target, target, sizeof(_target));
+    _reason[0] = '\0';
+    _count = 0;
+    uint8_t eligible = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        RolloutEntry& e = _entries[_count++];
+        memset(&e, 0, sizeof(e));
+        copyString(e.nodeId, nodes[i].nodeId, sizeof(e.nodeId));
+        e.wave = ROLLOUT_WAVE_NONE;
+        e.since = nowMs;
+
+        if (nodes[i].online && !nodes[i].version[0]) {
+            e.state = ROLLOUT_NODE_SKIPPED;
+            copyString(e.reason, "No rollout support", sizeof(e.reason));
+        } else if (strcmp(nodes[i].version, target) == 0) {
+            e.state = ROLLOUT_NODE_SKIPPED;
+            copyString(e.reason, "Already on the target", sizeof(e.reason));
+        } else {
+            e.state = ROLLOUT_NODE_PENDING;
+            eligible++;
+            // Without a choice, the first node that is online now
+            if (canaryIdx < 0 && nodes[i].online) canaryIdx = i;
+        }
+    }
+
+    // Canary, then waves of ROLLOUT_FIRST_WAVE, 2x, 4x... in pairing order
+    if (canaryIdx < 0) {
+        for (uint8_t i = 0; i < _count && canaryIdx < 0; i++) {
+            if (_entries[i].state == ROLLOUT_NODE_PENDING) canaryIdx = i;
+        }
+    }
+    _waveCount = 0;
+    uint8_t wave = 1;
+    uint8_t size = ROLLOUT_FIRST_WAVE;
+    uint8_t filled = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        RolloutEntry& e = _entries[i];
+        if (e.state != ROLLOUT_NODE_PENDING) continue;
+        if (i == canaryIdx) {
+            e.wave = 0;
+            continue;
+        }
+        e.wave = wave;
+        if (++filled == size) {
+            wave++;
+            size *= 2;
+            filled = 0;
+        }
+    }
+    _waveCount = (eligible == 0) ? 0 : (filled > 0 ? wave + 1 : wave);
+
+    _wave = 0;
+    _state = (eligible == 0) ? ROLLOUT_DONE : ROLLOUT_CANARY;
+    _generation++;
+    return true;
+}
+
+void RolloutPlanner::halt(const char* reason) {
+    if (!isRunning()) return;
+    _state = ROLLOUT_HALTED;
+    copyString(_reason, reason, sizeof(_reason));
+    _generation++;
+}
+
+uint32_t RolloutPlanner::step(const RolloutNode* nodes, uint8_t count, uint32_t nowMs) {
+    if (!isRunning()) return 0;
+
+    // Gates first, so a failure this step keeps new orders from going out
+    uint32_t orders = 0;
+    for (uint8_t pass = 0; pass < 2 && isRunning(); pass++) {
+        for (uint8_t i = 0; i < _count; i++) {
+            RolloutEntry& e = _entries[i];
+            if (e.state == ROLLOUT_NODE_DONE || e.state == ROLLOUT_NODE_SKIPPED ||
+                e.state == ROLLOUT_NODE_FAILED) continue;
+            if ((e.state == ROLLOUT_NODE_PENDING) != (pass == 1)) continue;
+
+            int8_t index = findNode(nodes, count, e.nodeId);
+            if (index < 0) {
+                enter(e, ROLLOUT_NODE_SKIPPED, nowMs, "Unpaired");
+                continue;
+            }
+            stepEntry(e, &nodes[index], nowMs, orders, index);
+        }
+    }
+    if (!isRunning()) return 0;
+
+    advanceWave();
+    return orders;
+}
+
+void RolloutPlanner::stepEntry(RolloutEntry& e, const RolloutNode* node, uint32_t nowMs,
+                               uint32_t& orders, uint8_t index) {
+    const RolloutNode& n = *node;
+    switch (e.state) {
+        case ROLLOUT_NODE_PENDING: {
+            if (e.wave != _wave) return;
+            bool deferred = true;
+            if (!n.online) {
+                if (e.offlineSince == 0) e.offlineSince = nowMs ? nowMs : 1;
+                if (nowMs - e.offlineSince >= ROLLOUT_OFFLINE_LIMIT) {
+                    enter(e, ROLLOUT_NODE_SKIPPED, nowMs, "Offline");
+                    return;
+                }
+            } else if (strcmp(n.version, _target) == 0) {
+                enter(e, ROLLOUT_NODE_SKIPPED, nowMs, "Already on the target");
+                return;
+            } else if (!n.busy) {
+                e.reboots = n.reboots;
+                e.offlineSince = 0;
+                enter(e, ROLLOUT_NODE_ORDERED, nowMs);
+                orders |= 1UL << index;
+                deferred = false;
+            } else {
+                e.offlineSince = 0;
+            }
+            if (e.deferred != deferred) {
+                e.deferred = deferred;
+                _generation++;
+            }
+            break;
+        }
+
+        case ROLLOUT_NODE_ORDERED:
+            // A failure left over from an earlier job is not this order's;
+            // only a job seen running, or a restart, moves it on
+            if (n.jobRunning || n.reboots != e.reboots) {
+                enter(e, ROLLOUT_NODE_UPDATING, nowMs);
+            } else if (nowMs - e.since >= ROLLOUT_START_TIMEOUT) {
+                if (!n.online || n.busy) {
+                    // Held on the node until it is idle: ask again later
+                    e.deferred = true;
+                    enter(e, ROLLOUT_NODE_PENDING, nowMs);
+                } else {
+                    fail(e, nowMs, "No install started");
+                }
+            }
+            break;
+
+        case ROLLOUT_NODE_UPDATING:
+            if (n.jobFailed && !n.jobRunning && n.reboots == e.reboots) {
+                fail(e, nowMs, "Install failed");
+            } else if (n.reboots != e.reboots && n.online && n.version[0]) {
+                if (strcmp(n.version, _target) == 0) {
+                    enterSoak(e, n, nowMs);
+                } else {
+                    fail(e, nowMs, "Came back on the old version");
+                }
+            } else if (nowMs - e.since >= ROLLOUT_UPDATE_TIMEOUT) {
+                fail(e, nowMs, "Did not come back");
+            }
+            break;
+
+        case ROLLOUT_NODE_SOAKING: {
+            uint32_t soak = (e.wave == 0) ? ROLLOUT_CANARY_SOAK : ROLLOUT_WAVE_SOAK;
+            if (!n.online) {
+                fail(e, nowMs, "Heartbeat lost");
+            } else if (n.reboots != e.reboots) {
+                fail(e, nowMs, "Restarted during the soak");
+            } else if (n.crashes != e.crashes) {
+                fail(e, nowMs, "Crashed during the soak");
+            } else if (n.faultMask != 0) {
+                fail(e, nowMs, "Valve fault");
+            } else if (n.divergences != e.divergences) {
+                fail(e, nowMs, "Valves did not follow");
+            } else if (nowMs - e.since >= soak && n.valveReportAt != 0 &&
+                       (int32_t)(n.valveReportAt - e.since) >= 0) {
+                // Valves must have been reported since the restart, too
+                enter(e, ROLLOUT_NODE_DONE, nowMs);
+            }
+            break;
+        }
+    }
+}
+
+void RolloutPlanner::enter(RolloutEntry& e, uint8_t state, uint32_t nowMs, const char* reason) {
+    e.state = state;
+    e.since = nowMs;
+    if (state != ROLLOUT_NODE_PENDING) e.deferred = false;
+    if (reason) copyString(e.reason, reason, sizeof(e.reason));
+    _generation++;
+}
+
+void RolloutPlanner::enterSoak(RolloutEntry& e, const RolloutNode& n, uint32_t nowMs) {
+    e.reboots = n.reboots;
+    e.crashes = n.crashes;
+    e.divergences = n.divergences;
+    enter(e, ROLLOUT_NODE_SOAKING, nowMs);
+}
+
+void RolloutPlanner::fail(RolloutEntry& e, uint32_t nowMs, const char* reason) {
+    enter(e, ROLLOUT_NODE_FAILED, nowMs, reason);
+
+    char why[sizeof(_reason)];
+    strncpy(why, e.nodeId, sizeof(why) - 1);
+    why[sizeof(why) - 1] = '\0';
+    strncat(why, ": ", sizeof(why) - strlen(why) - 1);
+    strncat(why, reason, sizeof(why) - strlen(why) - 1);
+    halt(why);
+}
+
+// Moves on once every node of the current wave is done or skipped. A
+// canary that was skipped proved nothing, so the next node takes its place.
+void RolloutPlanner::advanceWave() {
+    bool canaryDone = false;
+    for (uint8_t i = 0; i < _count; i++) {
+        const RolloutEntry& e = _entries[i];
+        if (e.wave != _wave) continue;
+        if (e.state != ROLLOUT_NODE_DONE && e.state != ROLLOUT_NODE_SKIPPED) return;
+        if (e.state == ROLLOUT_NODE_DONE) canaryDone = true;
+    }
+
+    if (_wave == 0 && !canaryDone) {
+        for (uint8_t w = 1; w < _waveCount; w++) {
+            for (uint8_t i = 0; i < _count; i++) {
+                RolloutEntry& e = _entries[i];
+                if (e.wave == w && e.state == ROLLOUT_NODE_PENDING) {
+                    e.wave = 0;
+                    _generation++;
+                    return;
+                }
+            }
+        }
+    }
+
+    _wave++;
+    _state = (_wave >= _waveCount) ? ROLLOUT_DONE : ROLLOUT_WAVES;
+    _generation++;
+}
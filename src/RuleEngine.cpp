@@ -0,0 +1,517 @@
+#include "RuleEngine.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Opcodes. Operands follow inline; jump offsets are forward, relative to
+// the byte after the operand.
+enum : uint8_t {
+    OP_END = 0,
+    OP_CONST,                  // k          push consts[k]
+    OP_VAR,                    // input      push input()
+    OP_CALL,                   // input      replace top with input(top)
+    OP_NOT,
+    OP_NEG,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV,
+    OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE,
+    OP_AND,                    // off        top false: top = 0, jump; else pop
+    OP_OR,                     // off        top true:  top = 1, jump; else pop
+    OP_BOOL,                   // top = truth(top)
+};
+
+struct InputName {
+    const char* name;
+    uint8_t input;
+    bool takesArg;
+};
+
+static const InputName INPUT_NAMES[] = {
+    {"hour", RULE_IN_HOUR, false},
+    {"minute", RULE_IN_MINUTE, false},
+    {"weekday", RULE_IN_WEEKDAY, false},
+    {"tod", RULE_IN_TOD, false},
+    {"irrigating", RULE_IN_IRRIGATING, false},
+    {"enabled", RULE_IN_ENABLED, false},
+    {"pressure", RULE_IN_PRESSURE, false},
+    {"pressure_alarm", RULE_IN_PRESSURE_ALARM, false},
+    {"wifi", RULE_IN_WIFI, false},
+    {"mqtt", RULE_IN_MQTT, false},
+    {"running", RULE_IN_RUNNING, true},
+    {"remaining", RULE_IN_REMAINING, true},
+    {"moisture", RULE_IN_MOISTURE, true},
+};
+
+static inline bool truth(float v) {
+    return v != 0.0f && !isnan(v);
+}
+
+// Comparisons involving an unknown input are false, != included
+static inline float compare(float a, float b, uint8_t op) {
+    if (isnan(a) || isnan(b)) return 0.0f;
+    bool r;
+    switch (op) {
+        case OP_LT: r = a <  b; break;
+        case OP_LE: r = a <= b; break;
+        case OP_GT: r = a >  b; break;
+        case OP_GE: r = a >= b; break;
+        case OP_EQ: r = a == b; break;
+        default:    r = a != b; break;
+    }
+    return r ? 1.0f : 0.0f;
+}
+
+// ============================================================================
+// Compiler
+// ============================================================================
+
+// Recursive descent over the condition, emitting code as it goes:
+//   or    := and  ( ("||" | "or")  and )*
+//   and   := cmp  ( ("&&" | "and") cmp )*
+//   cmp   := sum  ( ("<" | "<=" | ">" | ">=" | "==" | "!=") sum )?
+//   sum   := term ( ("+" | "-") term )*
+//   term  := unary ( ("*" | "/") unary )*
+//   unary := ("!" | "not" | "-") unary | atom
+//   atom  := number | "true" | "false" | name | name "(" or ")" | "(" or ")"
+namespace {
+
+struct Compiler {
+    const char* p;
+    Rule& rule;
+    char* error;
+    uint8_t depth;             // Runtime stack depth at this point of the code
+    uint8_t nesting;           // Parser recursion (bounded for the loop task's stack)
+    uint8_t constCount;
+    bool failed;
+
+    Compiler(const char* src, Rule& r, char* err)
+        : p(src), rule(r), error(err), depth(0), nesting(0), constCount(0), failed(false) {}
+
+    bool fail(const char* msg) {
+        if (!failed) {
+            failed = true;
+            if (error) snprintf(error, RULE_ERROR_LEN, "%s at '%.12s'", msg, p);
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (*p == ' ' || *p == '\t') p++;
+    }
+
+    // Symbol token (operators, parentheses)
+    bool accept(const char* tok) {
+        skipSpace();
+        size_t n = strlen(tok);
+        if (strncmp(p, tok, n) != 0) return false;
+        // "<" must not match the start of "<=", "!" not "!="
+        if (n == 1 && (tok[0] == '<' || tok[0] == '>' || tok[0] == '!') && p[1] == '=') return false;
+        p += n;
+        return true;
+    }
+
+    // Keyword token (not, and, or, ...): must end at a word boundary
+    bool acceptWord(const char* word) {
+        skipSpace();
+        size_t n = strlen(word);
+        if (strncmp(p, word, n) != 0) return false;
+        char c = p[n];
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_') {
+            return false;
+        }
+        p += n;
+        return true;
+    }
+
+    bool emit(uint8_t byte) {
+        if (rule.codeLen >= RULE_MAX_CODE) return fail("Rule too long");
+        rule.code[rule.codeLen++] = byte;
+        return true;
+    }
+
+    bool push() {
+        if (++depth > RULE_STACK_DEPTH) return fail("Expression too deep");
+        return true;
+    }
+
+    bool emitConst(float value) {
+        uint8_t k = 0;
+        while (k < constCount && rule.consts[k] != value) k++;
+        if (k == constCount) {
+            if (constCount >= RULE_MAX_CONSTS) return fail("Too many numbers");
+            rule.consts[constCount++] = value;
+        }
+        return emit(OP_CONST) && emit(k) && push();
+    }
+
+    bool binary(uint8_t op) {
+        depth--;
+        return emit(op);
+    }
+
+    bool atom() {
+        skipSpace();
+        if (accept("(")) {
+            if (!orExpr()) return false;
+            return accept(")") || fail("Expected ')'");
+        }
+        if ((*p >= '0' && *p <= '9') || *p == '.') {
+            char* end;
+            float value = strtof(p, &end);
+            if (end == p) return fail("Bad number");
+            p = end;
+            return emitConst(value);
+        }
+        if (acceptWord("true")) return emitConst(1.0f);
+        if (acceptWord("false")) return emitConst(0.0f);
+
+        const char* start = p;
+        while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_' ||
+               (p > start && *p >= '0' && *p <= '9')) {
+            p++;
+        }
+        size_t len = p - start;
+        if (len == 0) {
+            return fail("Expected a value");
+        }
+        for (const InputName& in : INPUT_NAMES) {
+            if (strlen(in.name) != len || strncmp(in.name, start, len) != 0) continue;
+            if (!in.takesArg) return emit(OP_VAR) && emit(in.input) && push();
+            if (!accept("(")) return fail("Expected '('");
+            if (!orExpr()) return false;
+            if (!accept(")")) return fail("Expected ')'");
+            return emit(OP_CALL) && emit(in.input);
+        }
+        p = start;
+        return fail("Unknown name");
+    }
+
+    bool unary() {
+        if (++nesting > RULE_STACK_DEPTH * 2) return fail("Nested too deep");
+        bool ok;
+        if (accept("!") || acceptWord("not")) ok = unary() && emit(OP_NOT);
+        else if (accept("-")) ok = unary() && emit(OP_NEG);
+        else ok = atom();
+        nesting--;
+        return ok;
+    }
+
+    bool term() {
+        if (!unary()) return false;
+        while (true) {
+            if (accept("*")) {
+                if (!unary() || !binary(OP_MUL)) return false;
+            } else if (accept("/")) {
+                if (!unary() || !binary(OP_DIV)) return false;
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool sum() {
+        if (!term()) return false;
+        while (true) {
+            if (accept("+")) {
+                if (!term() || !binary(OP_ADD)) return false;
+            } else if (accept("-")) {
+                if (!term() || !binary(OP_SUB)) return false;
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool compare() {
+        if (!sum()) return false;
+        uint8_t op;
+        if (accept("<=")) op = OP_LE;
+        else if (accept(">=")) op = OP_GE;
+        else if (accept("==")) op = OP_EQ;
+        else if (accept("!=")) op = OP_NE;
+        else if (accept("<")) op = OP_LT;
+        else if (accept(">")) op = OP_GT;
+        else return true;
+        return sum() && binary(op);
+    }
+
+    // a && b:  a AND(L) b BOOL L:    (a || b likewise with OR)
+    bool logic(uint8_t op, bool (Compiler::*operand)(), const char* sym, const char* word) {
+        if (!(this->*operand)()) return false;
+        while (accept(sym) || acceptWord(word)) {
+            if (!emit(op) || !emit(0)) return false;
+            uint8_t patch = rule.codeLen - 1;
+            depth--;  // Popped when falling through
+            if (!(this->*operand)() || !emit(OP_BOOL)) return false;
+            uint8_t offset = rule.codeLen - (patch + 1);
+            rule.code[patch] = offset;
+        }
+        return true;
+    }
+
+    bool andExpr() { return logic(OP_AND, &Compiler::compare, "&&", "and"); }
+    bool orExpr() { return logic(OP_OR, &Compiler::andExpr, "||", "or"); }
+
+    bool compile() {
+        rule.codeLen = 0;
+        if (!orExpr()) return false;
+        skipSpace();
+        if (*p != '\0') return fail("Unexpected text");
+        return emit(OP_END);
+    }
+};
+
+} // namespace
+
+bool RuleEngine::compile(const char* when, const char* then, Rule& out, char* error) {
+    if (error) error[0] = '\0';
+    if (!when || !when[0] || strlen(when) >= RULE_WHEN_LEN) {
+        if (error) snprintf(error, RULE_ERROR_LEN, "Condition empty or too long");
+        return false;
+    }
+    if (!then || strlen(then) >= RULE_THEN_LEN || !parseAction(then, out.action, error)) {
+        if (error && !error[0]) snprintf(error, RULE_ERROR_LEN, "Invalid action");
+        return false;
+    }
+
+    Compiler c(when, out, error);
+    if (!c.compile()) return false;
+
+    strcpy(out.when, when);
+    strcpy(out.then, then);
+    return true;
+}
+
+// "start <ch> <minutes>", "stop [ch]", "skip <schedule>", "enable", "disable"
+bool RuleEngine::parseAction(const char* then, RuleAction& action, char* error) {
+    char verb[12];
+    int a = -1, b = -1;
+    int n = sscanf(then, " %11s %d %d", verb, &a, &b);
+    if (n < 1) return false;
+
+    action.target = 0;
+    action.minutes = 0;
+    if (strcmp(verb, "start") == 0 && n == 3) {
+        action.op = RULE_ACT_START;
+    } else if (strcmp(verb, "stop") == 0 && n <= 2) {
+        action.op = RULE_ACT_STOP;
+        if (n == 1) a = 0;
+    } else if (strcmp(verb, "skip") == 0 && n == 2) {
+        action.op = RULE_ACT_SKIP;
+    } else if (strcmp(verb, "enable") == 0 && n == 1) {
+        action.op = RULE_ACT_ENABLE;
+        a = 0;
+    } else if (strcmp(verb, "disable") == 0 && n == 1) {
+        action.op = RULE_ACT_DISABLE;
+        a = 0;
+    } else {
+        if (error) snprintf(error, RULE_ERROR_LEN, "Unknown action '%s'", then);
+        return false;
+    }
+
+    if (a < 0 || a > 255 || (action.op == RULE_ACT_START && (b < 1 || b > 65535))) {
+        if (error) snprintf(error, RULE_ERROR_LEN, "Action argument out of range");
+        return false;
+    }
+    action.target = (uint8_t)a;
+    action.minutes = (action.op == RULE_ACT_START) ? (uint16_t)b : 0;
+    return true;
+}
+
+// ============================================================================
+// Rule table
+// ============================================================================
+
+RuleEngine::RuleEngine()
+    : _count(0),
+      _cursor(0),
+      _pending(false),
+      _again(false),
+      _passes(0),
+      _deferrals(0),
+      _input(nullptr),
+      _action(nullptr),
+      _ctx(nullptr) {
+}
+
+void RuleEngine::setCallbacks(RuleInputCallback input, RuleActionCallback action, void* ctx) {
+    _input = input;
+    _action = action;
+    _ctx = ctx;
+}
+
+int8_t RuleEngine::addRule(const char* name, const char* when, const char* then, bool enabled,
+                           char* error) {
+    if (_count >= RULE_MAX_RULES) {
+        if (error) snprintf(error, RULE_ERROR_LEN, "Rule table full");
+        return -1;
+    }
+    if (!store(_count, name, when, then, enabled, error)) return -1;
+    return (int8_t)(_count - 1);
+}
+
+bool RuleEngine::replaceRule(uint8_t index, const char* name, const char* when, const char* then,
+                             bool enabled, char* error) {
+    if (index >= _count) {
+        if (error) snprintf(error, RULE_ERROR_LEN, "No such rule");
+        return false;
+    }
+    return store(index, name, when, then, enabled, error);
+}
+
+// Compile into a scratch rule, then write it to the slot (index == _count
+// appends)
+bool RuleEngine::store(uint8_t index, const char* name, const char* when, const char* then,
+                       bool enabled, char* error) {
+    if (!name || !name[0] || strlen(name) >= RULE_NAME_LEN) {
+        if (error) snprintf(error, RULE_ERROR_LEN, "Invalid name");
+        return false;
+    }
+
+    Rule compiled;
+    memset(&compiled, 0, sizeof(compiled));
+    if (!compile(when, then, compiled, error)) return false;
+    strcpy(compiled.name, name);
+    compiled.enabled = enabled;
+
+    _rules[index] = compiled;
+    if (index == _count) _count++;
+    markDirty();
+    return true;
+}
+
+bool RuleEngine::removeRule(uint8_t index) {
+    if (index >= _count) return false;
+    for (uint8_t i = index; i + 1 < _count; i++) {
+        _rules[i] = _rules[i + 1];
+    }
+    _count--;
+    _cursor = 0;
+    _pending = _count > 0;
+    return true;
+}
+
+void RuleEngine::clear() {
+    _count = 0;
+    _cursor = 0;
+    _pending = false;
+    _again = false;
+}
+
+// ============================================================================
+// Evaluation
+// ============================================================================
+
+void RuleEngine::markDirty() {
+    if (_pending && _cursor > 0) {
+        _again = true;  // Finish this pass, then start over
+        return;
+    }
+    _pending = _count > 0;
+    _cursor = 0;
+}
+
+uint16_t RuleEngine::run(uint16_t budget) {
+    uint16_t spent = 0;
+    while (_pending) {
+        while (_cursor < _count) {
+            Rule& rule = _rules[_cursor];
+            if (rule.enabled) {
+                // Code length bounds the cost (forward jumps only)
+                if (spent > 0 && spent + rule.codeLen > budget) {
+                    _deferrals++;
+                    return spent;
+                }
+                bool was = rule.active;
+                rule.active = truth(execute(rule));
+                spent += rule.lastSteps;
+                if (rule.active && !was) {
+                    rule.fired++;
+                    if (_action) _action(_ctx, rule);
+                }
+            } else {
+                rule.active = false;
+            }
+            _cursor++;
+        }
+
+        _passes++;
+        _cursor = 0;
+        _pending = _again;
+        _again = false;
+    }
+    return spent;
+}
+
+bool RuleEngine::evaluate(uint8_t index, float& result) {
+    if (index >= _count) return false;
+    result = execute(_rules[index]);
+    return true;
+}
+
+float RuleEngine::execute(Rule& rule) {
+    float stack[RULE_STACK_DEPTH];
+    int8_t sp = -1;
+    uint8_t pc = 0;
+    uint8_t steps = 0;
+
+    while (true) {
+        steps++;
+        uint8_t op = rule.code[pc++];
+        switch (op) {
+            case OP_END:
+                rule.lastSteps = steps;
+                rule.evaluations++;
+                return sp >= 0 ? stack[sp] : NAN;
+            case OP_CONST:
+                stack[++sp] = rule.consts[rule.code[pc++]];
+                break;
+            case OP_VAR:
+                stack[++sp] = _input ? _input(_ctx, rule.code[pc++], 0) : NAN;
+                break;
+            case OP_CALL:
+                stack[sp] = _input ? _input(_ctx, rule.code[pc++], stack[sp]) : NAN;
+                break;
+            case OP_NOT:  stack[sp] = truth(stack[sp]) ? 0.0f : 1.0f; break;
+            case OP_NEG:  stack[sp] = -stack[sp]; break;
+            case OP_BOOL: stack[sp] = truth(stack[sp]) ? 1.0f : 0.0f; break;
+            case OP_ADD:  sp--; stack[sp] = stack[sp] + stack[sp + 1]; break;
+            case OP_SUB:  sp--; stack[sp] = stack[sp] - stack[sp + 1]; break;
+            case OP_MUL:  sp--; stack[sp] = stack[sp] * stack[sp + 1]; break;
+            case OP_DIV:  sp--; stack[sp] = stack[sp] / stack[sp + 1]; break;
+            case OP_LT:
+            case OP_LE:
+            case OP_GT:
+            case OP_GE:
+            case OP_EQ:
+            case OP_NE:
+                sp--;
+                stack[sp] = compare(stack[sp], stack[sp + 1], op);
+                break;
+            case OP_AND: {
+                uint8_t offset = rule.code[pc++];
+                if (!truth(stack[sp])) {
+                    stack[sp] = 0.0f;
+                    pc += offset;
+                } else {
+                    sp--;
+                }
+                break;
+            }
+            case OP_OR: {
+                uint8_t offset = rule.code[pc++];
+                if (truth(stack[sp])) {
+                    stack[sp] = 1.0f;
+                    pc += offset;
+                } else {
+                    sp--;
+                }
+                break;
+            }
+            default:
+                // Only reachable with corrupted code
+                rule.lastSteps = steps;
+                return NAN;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#include "RunJournal.h"
+#include <string.h>
+
+// ============================================================================
+// RunJournal
+// ============================================================================
+
+RunJournal::RunJournal() {
+    clear();
+}
+
+void RunJournal::clear() {
+    memset(_records, 0, sizeof(_records));
+    _head = 0;
+    _count = 0;
+    _nextSeq = 1;
+    _overwritten = 0;
+}
+
+uint16_t RunJournal::append(RunRecord record) {
+    record.seq = _nextSeq++;
+    if (_count == RUN_JOURNAL_SIZE) {
+        _head = (_head + 1) % RUN_JOURNAL_SIZE;
+        _count--;
+        _overwritten++;
+    }
+    _records[(_head + _count) % RUN_JOURNAL_SIZE] = record;
+    _count++;
+    return record.seq;
+}
+
+void RunJournal::restore(const RunRecord* records, uint8_t count, uint16_t nextSeq) {
+    clear();
+    if (count > RUN_JOURNAL_SIZE) {
+        records += count - RUN_JOURNAL_SIZE;
+        count = RUN_JOURNAL_SIZE;
+    }
+    memcpy(_records, records, count * sizeof(RunRecord));
+    _count = count;
+    _nextSeq = nextSeq;
+}
+
+// Sequence numbers wrap, so "up to" is judged by signed distance
+uint8_t RunJournal::acknowledge(uint16_t seq) {
+    uint8_t dropped = 0;
+    while (_count > 0 && (int16_t)(seq - _records[_head].seq) >= 0) {
+        _head = (_head + 1) % RUN_JOURNAL_SIZE;
+        _count--;
+        dropped++;
+    }
+    return dropped;
+}
+
+const RunRecord& RunJournal::at(uint8_t i) const {
+    return _records[(_head + i) % RUN_JOURNAL_SIZE];
+}
+
+// ============================================================================
+// RunHistory
+// ============================================================================
+
+RunHistory::RunHistory() : _generation(0) {
+    clear();
+}
+
+void RunHistory::clear() {
+    memset(_records, 0, sizeof(_records));
+    _count = 0;
+    _generation++;
+}
+
+bool RunHistory::insert(const RunRecord& record) {
+    // Ties keep arrival order
+    uint8_t pos = _count;
+    while (pos > 0 && _records[pos - 1].start > record.start) pos--;
+
+    if (_count == RUN_HISTORY_SIZE) {
+        if (pos == 0) return false;
+        memmove(&_records[0], &_records[1], (pos - 1) * sizeof(RunRecord));
+        pos--;
+    } else {
+        memmove(&_records[pos + 1], &_records[pos], (_count - pos) * sizeof(RunRecord));
+        _count++;
+    }
+    _records[pos] = record;
+    _generation++;
+    return true;
+}
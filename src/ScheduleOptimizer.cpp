@@ -0,0 +1,197 @@
+#include "ScheduleOptimizer.h"
+#include <string.h>
+
+ScheduleOptimizer::ScheduleOptimizer() {
+    reset();
+}
+
+void ScheduleOptimizer::reset() {
+    memset(_zones, 0, sizeof(_zones));
+    memset(_start, 0, sizeof(_start));
+    memset(_placed, 0, sizeof(_placed));
+    memset(_order, 0, sizeof(_order));
+    for (uint8_t s = 0; s < SCHEDULE_OPT_MAX_SUPPLIES; s++) {
+        _supplyLimit[s] = 1;
+    }
+    _zoneCount = 0;
+    _placedCount = 0;
+    _spanStart = 0;
+    _spanEnd = 0;
+    _peakFlow = 0;
+}
+
+bool ScheduleOptimizer::setSupplyLimit(uint8_t supply, uint8_t maxConcurrent) {
+    if (supply >= SCHEDULE_OPT_MAX_SUPPLIES || maxConcurrent == 0) return false;
+    _supplyLimit[supply] = maxConcurrent;
+    return true;
+}
+
+int8_t ScheduleOptimizer::addZone(const OptZone& zone) {
+    if (_zoneCount >= SCHEDULE_OPT_MAX_ZONES) return -1;
+    if (zone.supply >= SCHEDULE_OPT_MAX_SUPPLIES) return -1;
+    if ((zone.weekdays & 0x7F) == 0 || zone.durationMinutes == 0) return -1;
+    if (zone.windowEnd > SCHEDULE_OPT_MINUTES_DAY || zone.windowStart >= zone.windowEnd) return -1;
+
+    _zones[_zoneCount] = zone;
+    _zones[_zoneCount].weekdays &= 0x7F;
+    return (int8_t)_zoneCount++;
+}
+
+bool ScheduleOptimizer::isPlaced(uint8_t index) const {
+    return index < _zoneCount && _placed[index];
+}
+
+uint16_t ScheduleOptimizer::getStart(uint8_t index) const {
+    return (index < _zoneCount) ? _start[index] : 0;
+}
+
+// Longest run first; among equal durations the zone with the tighter window
+// goes first so it is not crowded out by zones that could go anywhere.
+void ScheduleOptimizer::sortByDuration() {
+    for (uint8_t i = 0; i < _zoneCount; i++) {
+        _order[i] = i;
+    }
+    for (uint8_t i = 1; i < _zoneCount; i++) {
+        uint8_t cur = _order[i];
+        const OptZone& c = _zones[cur];
+        uint16_t cWin = c.windowEnd - c.windowStart;
+        int8_t j = i - 1;
+        while (j >= 0) {
+            const OptZone& o = _zones[_order[j]];
+            uint16_t oWin = o.windowEnd - o.windowStart;
+            bool before = (c.durationMinutes > o.durationMinutes) ||
+                          (c.durationMinutes == o.durationMinutes && cWin < oWin);
+            if (!before) break;
+            _order[j + 1] = _order[j];
+            j--;
+        }
+        _order[j + 1] = cur;
+    }
+}
+
+// Checks whether zone `zoneIdx` can start at `start` without exceeding its
+// supply limit on any of its weekdays. On success, `peakFlow` receives the
+// highest total flow (all supplies) seen during the run.
+bool ScheduleOptimizer::evaluate(uint8_t zoneIdx, uint16_t start, uint32_t& peakFlow) const {
+    const OptZone& z = _zones[zoneIdx];
+    uint16_t end = start + z.durationMinutes;
+    uint8_t limit = _supplyLimit[z.supply];
+
+    // Placed runs that overlap [start, end) on at least one shared day
+    uint8_t overlap[SCHEDULE_OPT_MAX_ZONES];
+    uint8_t overlapCount = 0;
+    for (uint8_t i = 0; i < _zoneCount; i++) {
+        if (!_placed[i]) continue;
+        if (!(_zones[i].weekdays & z.weekdays)) continue;
+        uint16_t rStart = _start[i];
+        uint16_t rEnd = rStart + _zones[i].durationMinutes;
+        if (rStart < end && rEnd > start) {
+            overlap[overlapCount++] = i;
+        }
+    }
+
+    peakFlow = z.flow;
+    if (overlapCount == 0) return true;
+
+    for (uint8_t day = 0; day < 7; day++) {
+        uint8_t bit = 1 << day;
+        if (!(z.weekdays & bit)) continue;
+
+        // Concurrency only changes where a run begins, so it is enough to
+        // probe our own start and every overlapping start inside the run.
+        for (int16_t p = -1; p < overlapCount; p++) {
+            uint16_t point = start;
+            if (p >= 0) {
+                uint8_t r = overlap[p];
+                if (!(_zones[r].weekdays & bit)) continue;
+                point = _start[r];
+                if (point <= start) continue;
+            }
+
+            uint8_t sameSupply = 1;
+            uint32_t flow = z.flow;
+            for (uint8_t k = 0; k < overlapCount; k++) {
+                uint8_t r = overlap[k];
+                if (!(_zones[r].weekdays & bit)) continue;
+                uint16_t rStart = _start[r];
+                uint16_t rEnd = rStart + _zones[r].durationMinutes;
+                if (rStart <= point && rEnd > point) {
+                    flow += _zones[r].flow;
+                    if (_zones[r].supply == z.supply) sameSupply++;
+                }
+            }
+            if (sameSupply > limit) return false;
+            if (flow > peakFlow) peakFlow = flow;
+        }
+    }
+    return true;
+}
+
+bool ScheduleOptimizer::solve() {
+    memset(_placed, 0, sizeof(_placed));
+    _placedCount = 0;
+    _spanStart = 0;
+    _spanEnd = 0;
+    _peakFlow = 0;
+
+    sortByDuration();
+
+    for (uint8_t n = 0; n < _zoneCount; n++) {
+        uint8_t zi = _order[n];
+        const OptZone& z = _zones[zi];
+        if (z.durationMinutes > z.windowEnd - z.windowStart) continue;
+        uint16_t latest = z.windowEnd - z.durationMinutes;
+
+        bool found = false;
+        uint16_t bestStart = 0;
+        uint16_t bestSpan = 0;
+        uint32_t bestPeak = 0;
+
+        // Candidate starts: the window opening, right after any placed run
+        // ends, or finishing right as a placed run begins.
+        for (int16_t c = -1; c < (int16_t)_zoneCount * 2; c++) {
+            int32_t t;
+            if (c < 0) {
+                t = z.windowStart;
+            } else {
+                uint8_t r = c / 2;
+                if (!_placed[r]) continue;
+                t = (c & 1) ? (int32_t)_start[r] - z.durationMinutes
+                            : (int32_t)_start[r] + _zones[r].durationMinutes;
+            }
+            if (t < z.windowStart || t > latest) continue;
+
+            uint32_t peak;
+            if (!evaluate(zi, (uint16_t)t, peak)) continue;
+
+            uint16_t spanStart = (_placedCount == 0 || t < _spanStart) ? t : _spanStart;
+            uint16_t runEnd = t + z.durationMinutes;
+            uint16_t spanEnd = (_placedCount == 0 || runEnd > _spanEnd) ? runEnd : _spanEnd;
+            uint16_t span = spanEnd - spanStart;
+            if (peak < _peakFlow) peak = _peakFlow;
+
+            bool better = !found ||
+                          span < bestSpan ||
+                          (span == bestSpan && peak < bestPeak) ||
+                          (span == bestSpan && peak == bestPeak && t < bestStart);
+            if (better) {
+                found = true;
+                bestStart = (uint16_t)t;
+                bestSpan = span;
+                bestPeak = peak;
+            }
+        }
+
+        if (!found) continue;  // Left unplaced; caller reports it
+
+        uint16_t runEnd = bestStart + z.durationMinutes;
+        if (_placedCount == 0 || bestStart < _spanStart) _spanStart = bestStart;
+        if (_placedCount == 0 || runEnd > _spanEnd) _spanEnd = runEnd;
+        _peakFlow = bestPeak;
+        _start[zi] = bestStart;
+        _placed[zi] = true;
+        _placedCount++;
+    }
+
+    return _placedCount == _zoneCount;
+}
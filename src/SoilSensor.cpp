@@ -0,0 +1,231 @@
+#include "SoilSensor.h"
+#include <math.h>
+
+SoilSensor::SoilSensor()
+    : _probeCount(0),
+      _temperature(25.0f),
+      _tempValid(false),
+      _lastSample(0) {
+    memset(_probes, 0, sizeof(_probes));
+    for (uint8_t i = 0; i < SENSOR_MAX_PROBES; i++) {
+        _probes[i].dryMv = SOIL_DRY_MV;
+        _probes[i].wetMv = SOIL_WET_MV;
+    }
+}
+
+bool SoilSensor::begin() {
+    DEBUG_PRINTLN("SoilSensor: Initializing...");
+
+    for (uint8_t i = 0; i < SOIL_PROBE_COUNT && i < SENSOR_MAX_PROBES; i++) {
+        if (SOIL_PROBE_PINS[i] < 0) break;
+        pinMode(SOIL_PROBE_PINS[i], INPUT);
+        _probeCount++;
+    }
+    if (SOIL_NTC_PIN >= 0) {
+        pinMode(SOIL_NTC_PIN, INPUT);
+    }
+    analogReadResolution(12);
+
+    loadCalibration();
+
+    DEBUG_PRINTF("SoilSensor: %d probes, thermistor=%s\n",
+                 _probeCount, SOIL_NTC_PIN >= 0 ? "yes" : "no");
+    return _probeCount > 0;
+}
+
+void SoilSensor::update() {
+    unsigned long now = millis();
+    if (_lastSample != 0 && now - _lastSample < SOIL_SAMPLE_INTERVAL) return;
+    _lastSample = now;
+
+    float celsius;
+    _tempValid = readTemperature(celsius);
+    _temperature = _tempValid ? celsius : 25.0f;
+
+    for (uint8_t i = 0; i < _probeCount; i++) {
+        SoilProbe& probe = _probes[i];
+        probe.rawMv = sampleMilliVolts(SOIL_PROBE_PINS[i]);
+
+        // Capacitive probes drift with temperature; pull the reading back
+        // to what it would be at 25 degC before mapping it to moisture
+        float mv = probe.rawMv;
+        if (_tempValid) {
+            mv -= SOIL_TEMP_COEFF_MV * (_temperature - 25.0f);
+        }
+        probe.moisture = toMoisture(probe, mv);
+        probe.valid = true;
+    }
+}
+
+// ============================================================================
+// Sampling
+// ============================================================================
+
+// Oversampled read: sort SOIL_OVERSAMPLE readings and average the middle
+// half (interquartile mean)
+uint16_t SoilSensor::sampleMilliVolts(uint8_t pin) const {
+    uint16_t samples[SOIL_OVERSAMPLE];
+    for (uint8_t n = 0; n < SOIL_OVERSAMPLE; n++) {
+        uint16_t v = analogReadMilliVolts(pin);
+        int8_t j = n - 1;
+        while (j >= 0 && samples[j] > v) {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+        samples[j + 1] = v;
+    }
+
+    uint32_t sum = 0;
+    uint8_t from = SOIL_OVERSAMPLE / 4;
+    uint8_t to = SOIL_OVERSAMPLE - SOIL_OVERSAMPLE / 4;
+    for (uint8_t n = from; n < to; n++) {
+        sum += samples[n];
+    }
+    return (uint16_t)(sum / (to - from));
+}
+
+// NTC on the low side of a divider: R = Rseries * V / (Vcc - V),
+// then the beta equation
+bool SoilSensor::readTemperature(float& celsius) const {
+    if (SOIL_NTC_PIN < 0) return false;
+
+    float mv = sampleMilliVolts(SOIL_NTC_PIN);
+    if (mv < 50.0f || mv > 3250.0f) return false;  // Open or shorted
+
+    float ohms = SOIL_NTC_SERIES_OHMS * mv / (3300.0f - mv);
+    float kelvin = 1.0f / (1.0f / 298.15f + logf(ohms / SOIL_NTC_NOMINAL_OHMS) / SOIL_NTC_BETA);
+    celsius = kelvin - 273.15f;
+    return celsius > -30.0f && celsius < 80.0f;
+}
+
+float SoilSensor::toMoisture(const SoilProbe& probe, float milliVolts) const {
+    float span = (float)probe.dryMv - (float)probe.wetMv;
+    if (span == 0.0f) return 0.0f;
+
+    float pct = ((float)probe.dryMv - milliVolts) / span * 100.0f;
+    if (pct < 0.0f) pct = 0.0f;
+    if (pct > 100.0f) pct = 100.0f;
+    return pct;
+}
+
+// ============================================================================
+// Readings and reporting
+// ============================================================================
+
+bool SoilSensor::isValid(uint8_t probe) const {
+    if (probe < 1 || probe > _probeCount) return false;
+    return _probes[probe - 1].valid;
+}
+
+float SoilSensor::getMoisture(uint8_t probe) const {
+    if (probe < 1 || probe > _probeCount) return 0.0f;
+    return _probes[probe - 1].moisture;
+}
+
+uint16_t SoilSensor::getRawMilliVolts(uint8_t probe) const {
+    if (probe < 1 || probe > _probeCount) return 0;
+    return _probes[probe - 1].rawMv;
+}
+
+bool SoilSensor::isKeepaliveDue(uint8_t probe) const {
+    if (probe < 1 || probe > _probeCount) return false;
+    const SoilProbe& p = _probes[probe - 1];
+    return p.reported && millis() - p.lastReport >= SOIL_KEEPALIVE_INTERVAL;
+}
+
+bool SoilSensor::needsReport(uint8_t probe) const {
+    if (!isValid(probe)) return false;
+    const SoilProbe& p = _probes[probe - 1];
+    if (!p.reported) return true;
+    if (fabsf(p.moisture - p.reportedMoisture) >= SOIL_REPORT_DEADBAND) return true;
+    return isKeepaliveDue(probe);
+}
+
+void SoilSensor::markReported(uint8_t probe) {
+    if (probe < 1 || probe > _probeCount) return;
+    SoilProbe& p = _probes[probe - 1];
+    p.reportedMoisture = p.moisture;
+    p.lastReport = millis();
+    p.reported = true;
+}
+
+// ============================================================================
+// Calibration
+// ============================================================================
+
+bool SoilSensor::setCalibration(uint8_t probe, uint16_t dryMv, uint16_t wetMv) {
+    if (probe < 1 || probe > _probeCount) return false;
+    if (dryMv == wetMv || dryMv > 3300 || wetMv > 3300) return false;
+
+    _probes[probe - 1].dryMv = dryMv;
+    _probes[probe - 1].wetMv = wetMv;
+    _probes[probe - 1].reported = false;  // Force a fresh report
+    _lastSample = 0;                      // Resample on next update
+
+    DEBUG_PRINTF("SoilSensor: Probe %d calibrated dry=%dmV wet=%dmV\n", probe, dryMv, wetMv);
+    return saveCalibration();
+}
+
+uint16_t SoilSensor::getDryMilliVolts(uint8_t probe) const {
+    if (probe < 1 || probe > _probeCount) return 0;
+    return _probes[probe - 1].dryMv;
+}
+
+uint16_t SoilSensor::getWetMilliVolts(uint8_t probe) const {
+    if (probe < 1 || probe > _probeCount) return 0;
+    return _probes[probe - 1].wetMv;
+}
+
+bool SoilSensor::saveCalibration() {
+    ArenaJsonDocument doc(512);
+    JsonArray probes = doc.createNestedArray("probes");
+    for (uint8_t i = 0; i < _probeCount; i++) {
+        JsonObject probe = probes.createNestedObject();
+        probe["dry_mv"] = _probes[i].dryMv;
+        probe["wet_mv"] = _probes[i].wetMv;
+    }
+
+    File file = LittleFS.open(SOIL_CALIBRATION_FILE, "w");
+    if (!file) {
+        DEBUG_PRINTLN("SoilSensor: Failed to open calibration file for writing");
+        return false;
+    }
+    serializeJson(doc, file);
+    file.close();
+    return true;
+}
+
+bool SoilSensor::loadCalibration() {
+    if (!LittleFS.exists(SOIL_CALIBRATION_FILE)) {
+        DEBUG_PRINTLN("SoilSensor: No calibration file, using defaults");
+        return false;
+    }
+
+    File file = LittleFS.open(SOIL_CALIBRATION_FILE, "r");
+    if (!file) {
+        DEBUG_PRINTLN("SoilSensor: Failed to open calibration file");
+        return false;
+    }
+
+    ArenaJsonDocument doc(512);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        DEBUG_PRINTF("SoilSensor: Failed to parse calibration file: %s\n", error.c_str());
+        return false;
+    }
+
+    uint8_t i = 0;
+    for (JsonObject probe : doc["probes"].as<JsonArray>()) {
+        if (i >= SENSOR_MAX_PROBES) break;
+        uint16_t dry = probe["dry_mv"] | SOIL_DRY_MV;
+        uint16_t wet = probe["wet_mv"] | SOIL_WET_MV;
+        if (dry != wet) {
+            _probes[i].dryMv = dry;
+            _probes[i].wetMv = wet;
+        }
+        i++;
+    }
+    return true;
+}
@@ -0,0 +1,299 @@
+#include "TimeZone.h"
+#include <string.h>
+
+static int32_t floorDiv(int64_t a, int32_t b) {
+    int64_t q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+    return (int32_t)q;
+}
+
+TimeZone::TimeZone()
+    : _stdOffset(0),
+      _dstOffset(0),
+      _hasDst(false),
+      _validFrom(1),
+      _validTo(0),
+      _offset(0),
+      _dst(false) {
+    memset(&_start, 0, sizeof(_start));
+    memset(&_end, 0, sizeof(_end));
+    strcpy(_spec, "UTC0");
+}
+
+bool TimeZone::set(const char* spec) {
+    if (!spec || strlen(spec) >= TZ_SPEC_LEN) return false;
+
+    // Parse into a scratch copy so a bad string leaves the zone as it was
+    TimeZone parsed;
+    if (!parsed.parse(spec)) return false;
+
+    *this = parsed;
+    strcpy(_spec, spec);
+    _validFrom = 1;  // Empty interval: recompute on next use
+    _validTo = 0;
+    return true;
+}
+
+// ============================================================================
+// Calendar arithmetic
+// ============================================================================
+
+// Days since 1970-01-01 (H. Hinnant's civil calendar algorithms)
+int32_t TimeZone::daysFromCivil(int16_t year, uint8_t month, uint8_t day) {
+    int32_t y = year - (month <= 2 ? 1 : 0);
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    uint32_t yoe = (uint32_t)(y - era * 400);
+    uint32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+void TimeZone::civilFromDays(int32_t days, int16_t& year, uint8_t& month, uint8_t& day) {
+    int32_t z = days + 719468;
+    int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+    day = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+    month = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+    year = (int16_t)((int32_t)yoe + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+uint8_t TimeZone::weekdayFromDays(int32_t days) {
+    int32_t wd = (days + 4) % 7;  // 1970-01-01 was a Thursday
+    return (uint8_t)(wd < 0 ? wd + 7 : wd);
+}
+
+// ============================================================================
+// POSIX TZ parsing
+// ============================================================================
+
+// Zone name: three or more letters, or anything in <...>
+static const char* parseName(const char* p) {
+    if (*p == '<') {
+        const char* end = strchr(p, '>');
+        return (end && end - p > 1) ? end + 1 : nullptr;
+    }
+    const char* start = p;
+    while ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) p++;
+    return (p - start >= 3) ? p : nullptr;
+}
+
+static const char* parseNumber(const char* p, int32_t& value, int32_t max) {
+    if (*p < '0' || *p > '9') return nullptr;
+    value = 0;
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p++ - '0');
+        if (value > max) return nullptr;
+    }
+    return p;
+}
+
+// [+-]hh[:mm[:ss]] in seconds
+static const char* parseClock(const char* p, int32_t& seconds, int32_t maxHours) {
+    int32_t sign = 1;
+    if (*p == '+' || *p == '-') {
+        if (*p == '-') sign = -1;
+        p++;
+    }
+    int32_t h, m = 0, s = 0;
+    p = parseNumber(p, h, maxHours);
+    if (!p) return nullptr;
+    if (*p == ':') {
+        p = parseNumber(p + 1, m, 59);
+        if (!p) return nullptr;
+        if (*p == ':') {
+            p = parseNumber(p + 1, s, 59);
+            if (!p) return nullptr;
+        }
+    }
+    seconds = sign * (h * 3600 + m * 60 + s);
+    return p;
+}
+
+bool TimeZone::parse(const char* spec) {
+    const char* p = parseName(spec);
+    if (!p) return false;
+
+    // POSIX offsets count hours west of Greenwich
+    int32_t west;
+    p = parseClock(p, west, 24);
+    if (!p) return false;
+    _stdOffset = -west;
+    _dstOffset = _stdOffset;
+    _hasDst = false;
+    if (*p == '\0') return true;
+
+    p = parseName(p);
+    if (!p) return false;
+    _hasDst = true;
+    _dstOffset = _stdOffset + 3600;
+    if (*p != ',' && *p != '\0') {
+        p = parseClock(p, west, 24);
+        if (!p) return false;
+        _dstOffset = -west;
+    }
+
+    // No rules: the POSIX default (US rules)
+    if (*p == '\0') p = ",M3.2.0,M11.1.0";
+
+    Rule* rules[2] = {&_start, &_end};
+    for (Rule* r : rules) {
+        if (*p++ != ',') return false;
+        int32_t v;
+        if (*p == 'M') {
+            r->kind = 'M';
+            p = parseNumber(p + 1, v, 12);
+            if (!p || v < 1 || *p != '.') return false;
+            r->month = v;
+            p = parseNumber(p + 1, v, 5);
+            if (!p || v < 1 || *p != '.') return false;
+            r->week = v;
+            p = parseNumber(p + 1, v, 6);
+            if (!p) return false;
+            r->weekday = v;
+        } else if (*p == 'J') {
+            r->kind = 'J';
+            p = parseNumber(p + 1, v, 365);
+            if (!p || v < 1) return false;
+            r->day = v;
+        } else {
+            r->kind = 'N';
+            p = parseNumber(p, v, 365);
+            if (!p) return false;
+            r->day = v;
+        }
+        r->time = 7200;  // 02:00 unless given
+        if (*p == '/') {
+            p = parseClock(p + 1, r->time, 167);
+            if (!p) return false;
+        }
+    }
+    return *p == '\0';
+}
+
+// ============================================================================
+// Transitions and the offset cache
+// ============================================================================
+
+// UTC instant of a rule in a year; the rule's time is wall time under the
+// offset in force just before it
+time_t TimeZone::transition(const Rule& rule, int16_t year, int32_t offsetBefore) const {
+    int32_t jan1 = daysFromCivil(year, 1, 1);
+    int32_t day;
+
+    if (rule.kind == 'M') {
+        int32_t first = daysFromCivil(year, rule.month, 1);
+        int32_t next = (rule.month == 12) ? daysFromCivil(year + 1, 1, 1)
+                                          : daysFromCivil(year, rule.month + 1, 1);
+        day = first + (rule.weekday - weekdayFromDays(first) + 7) % 7 + (rule.week - 1) * 7;
+        while (day >= next) day -= 7;  // Week 5 = last
+    } else if (rule.kind == 'J') {
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        day = jan1 + rule.day - 1 + ((leap && rule.day >= 60) ? 1 : 0);
+    } else {
+        day = jan1 + rule.day;
+    }
+
+    return (time_t)((int64_t)day * 86400 + rule.time - offsetBefore);
+}
+
+// Find the transitions around utc and cache the offset between them
+void TimeZone::refresh(time_t utc) const {
+    int16_t year;
+    uint8_t month, day;
+    civilFromDays(floorDiv((int64_t)utc + _stdOffset, 86400), year, month, day);
+
+    // Transitions of the surrounding years, in time order
+    time_t at[6];
+    bool intoDst[6];
+    uint8_t n = 0;
+    for (int16_t y = year - 1; y <= year + 1; y++) {
+        time_t events[2] = {transition(_start, y, _stdOffset), transition(_end, y, _dstOffset)};
+        for (uint8_t e = 0; e < 2; e++) {
+            int8_t j = n - 1;
+            while (j >= 0 && at[j] > events[e]) {
+                at[j + 1] = at[j];
+                intoDst[j + 1] = intoDst[j];
+                j--;
+            }
+            at[j + 1] = events[e];
+            intoDst[j + 1] = (e == 0);
+            n++;
+        }
+    }
+
+    uint8_t i = 0;
+    while (i + 1 < n && at[i + 1] <= utc) i++;
+    _dst = intoDst[i];
+    _offset = _dst ? _dstOffset : _stdOffset;
+    _validFrom = at[i];
+    _validTo = at[i + 1];
+}
+
+int32_t TimeZone::offsetAt(time_t utc) const {
+    if (!_hasDst) {
+        _dst = false;
+        return _stdOffset;
+    }
+    if (utc < _validFrom || utc >= _validTo) refresh(utc);
+    return _offset;
+}
+
+// ============================================================================
+// Conversions
+// ============================================================================
+
+void TimeZone::toLocal(time_t utc, LocalTime& out) const {
+    int64_t local = (int64_t)utc + offsetAt(utc);
+    int32_t days = floorDiv(local, 86400);
+    int32_t secs = (int32_t)(local - (int64_t)days * 86400);
+
+    civilFromDays(days, out.year, out.month, out.day);
+    out.hour = secs / 3600;
+    out.minute = (secs / 60) % 60;
+    out.second = secs % 60;
+    out.weekday = weekdayFromDays(days);
+    out.dst = _dst;
+}
+
+time_t TimeZone::toUtc(int16_t year, uint8_t month, uint8_t day,
+                       uint8_t hour, uint8_t minute, uint8_t second) const {
+    int64_t local = (int64_t)daysFromCivil(year, month, day) * 86400 +
+                    hour * 3600 + minute * 60 + second;
+    if (!_hasDst) return (time_t)(local - _stdOffset);
+
+    time_t asDst = (time_t)(local - _dstOffset);
+    time_t asStd = (time_t)(local - _stdOffset);
+    bool dstOk = offsetAt(asDst) == _dstOffset;
+    bool stdOk = offsetAt(asStd) == _stdOffset;
+
+    if (dstOk && stdOk) return (asDst < asStd) ? asDst : asStd;  // Fold: first occurrence
+    if (dstOk) return asDst;
+    if (stdOk) return asStd;
+
+    // Gap: read the wall time with the offset from before the jump forward
+    int32_t lower = (_stdOffset < _dstOffset) ? _stdOffset : _dstOffset;
+    return (time_t)(local - lower);
+}
+
+time_t TimeZone::nextLocal(time_t after, uint8_t hour, uint8_t minute, uint8_t weekdays) const {
+    if ((weekdays & 0x7F) == 0) return 0;
+
+    LocalTime now;
+    toLocal(after, now);
+    int32_t today = daysFromCivil(now.year, now.month, now.day);
+
+    for (uint8_t d = 0; d <= 7; d++) {
+        int32_t days = today + d;
+        if (!(weekdays & (1 << weekdayFromDays(days)))) continue;
+
+        int16_t y;
+        uint8_t m, dd;
+        civilFromDays(days, y, m, dd);
+        time_t at = toUtc(y, m, dd, hour, minute);
+        if (at > after) return at;
+    }
+    return 0;
+}
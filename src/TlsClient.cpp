@@ -0,0 +1,352 @@
+#include "TlsClient.h"
+#include "Config.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/sha256.h"
+
+TlsClient::TlsClient()
+    : _hasSession(false),
+      _sessionPort(0),
+      _caCert(nullptr),
+      _timeout(MQTT_TLS_HANDSHAKE_TIMEOUT * 1000UL),
+      _active(false),
+      _connected(false),
+      _resumed(false),
+      _peeked(-1) {
+    mbedtls_ssl_session_init(&_session);
+}
+
+TlsClient::~TlsClient() {
+    stop();
+    mbedtls_ssl_session_free(&_session);
+}
+
+void TlsClient::forgetSession() {
+    mbedtls_ssl_session_free(&_session);
+    mbedtls_ssl_session_init(&_session);
+    _hasSession = false;
+}
+
+// ============================================================================
+// Connection
+// ============================================================================
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    stop();
+    if (_hasSession && (_sessionHost != host || _sessionPort != port)) forgetSession();
+    if (!_tcp.connect(host, port)) return 0;
+
+    mbedtls_ssl_init(&_ssl);
+    mbedtls_ssl_config_init(&_conf);
+    mbedtls_x509_crt_init(&_ca);
+    mbedtls_entropy_init(&_entropy);
+    mbedtls_ctr_drbg_init(&_drbg);
+    _active = true;
+
+    static const char personal[] = "irrigation_tls";
+    int ret = mbedtls_ctr_drbg_seed(&_drbg, mbedtls_entropy_func, &_entropy,
+                                    (const unsigned char*)personal, sizeof(personal) - 1);
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0 && _caCert) {
+        // PEM parsing wants the terminating NUL in the length
+        ret = mbedtls_x509_crt_parse(&_ca, (const unsigned char*)_caCert, strlen(_caCert) + 1);
+        mbedtls_ssl_conf_ca_chain(&_conf, &_ca, nullptr);
+    }
+    if (ret == 0) {
+        mbedtls_ssl_conf_authmode(&_conf, _caCert ? MBEDTLS_SSL_VERIFY_REQUIRED : MBEDTLS_SSL_VERIFY_NONE);
+        mbedtls_ssl_conf_rng(&_conf, mbedtls_ctr_drbg_random, &_drbg);
+#ifdef MBEDTLS_SSL_SESSION_TICKETS
+        mbedtls_ssl_conf_session_tickets(&_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+        ret = mbedtls_ssl_setup(&_ssl, &_conf);
+    }
+    if (ret == 0) ret = mbedtls_ssl_set_hostname(&_ssl, host);
+    if (ret != 0) {
+        DEBUG_PRINTF("TlsClient: Setup failed, -0x%04x\n", -ret);
+        stop();
+        return 0;
+    }
+    mbedtls_ssl_set_bio(&_ssl, &_tcp, sendCallback, recvCallback, nullptr);
+
+    bool offered = _hasSession && mbedtls_ssl_set_session(&_ssl, &_session) == 0;
+    if (!handshake()) {
+        // A session the broker no longer accepts falls back to a full
+        // handshake inside mbedTLS; a failure here is not about the session,
+        // but do not offer it again either
+        forgetSession();
+        stop();
+        return 0;
+    }
+
+    // Resumption is the broker echoing the cached session ID (for tickets,
+    // the ID mbedTLS generated to go with the ticket)
+    _resumed = offered && _session.id_len > 0 && _ssl.session->id_len == _session.id_len &&
+               memcmp(_ssl.session->id, _session.id, _session.id_len) == 0;
+
+    forgetSession();
+    if (mbedtls_ssl_get_session(&_ssl, &_session) == 0) {
+        _hasSession = true;
+        _sessionHost = host;
+        _sessionPort = port;
+    }
+    _connected = true;
+    return 1;
+}
+
+bool TlsClient::handshake() {
+    unsigned long start = millis();
+    for (;;) {
+        int ret = mbedtls_ssl_handshake(&_ssl);
+        if (ret == 0) return true;
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            DEBUG_PRINTF("TlsClient: Handshake failed, -0x%04x\n", -ret);
+            return false;
+        }
+        if (millis() - start > _timeout) {
+            DEBUG_PRINTLN("TlsClient: Handshake timed out");
+            return false;
+        }
+        delay(1);
+    }
+}
+
+bool TlsClient::verify(const char* fingerprint) {
+    if (!_connected || !fingerprint) return false;
+    const mbedtls_x509_crt* peer = mbedtls_ssl_get_peer_cert(&_ssl);
+    if (!peer) return false;
+
+    unsigned char hash[32];
+    if (mbedtls_sha256_ret(peer->raw.p, peer->raw.len, hash, 0) != 0) return false;
+    char hex[65];
+    for (uint8_t i = 0; i < sizeof(hash); i++) {
+        snprintf(hex + i * 2, 3, "%02x", hash[i]);
+    }
+    return strcasecmp(hex, fingerprint) == 0;
+}
+
+void TlsClient::stop() {
+    if (_active) {
+        if (_connected) mbedtls_ssl_close_notify(&_ssl);
+        release();
+    }
+    _tcp.stop();
+    _connected = false;
+    _peeked = -1;
+}
+
+// Frees everything but the cached session, which outlives the connection
+void TlsClient::release() {
+    mbedtls_ssl_free(&_ssl);
+    mbedtls_ssl_config_free(&_conf);
+    mbedtls_x509_crt_free(&_ca);
+    mbedtls_ctr_drbg_free(&_drbg);
+    mbedtls_entropy_free(&_entropy);
+    _active = false;
+}
+
+uint8_t TlsClient::connected() {
+    if (_connected && !_tcp.connected() && _peeked < 0 && mbedtls_ssl_get_bytes_avail(&_ssl) == 0) {
+        stop();
+    }
+    return _connected;
+}
+
+// ============================================================================
+// Data
+// ============================================================================
+
+int TlsClient::sendCallback(void* ctx, const unsigned char* buf, size_t len) {
+    WiFiClient* tcp = static_cast<WiFiClient*>(ctx);
+    if (!tcp->connected()) return MBEDTLS_ERR_NET_CONN_RESET;
+    size_t n = tcp->write(buf, len);
+    return n > 0 ? (int)n : MBEDTLS_ERR_SSL_WANT_WRITE;
+}
+
+int TlsClient::recvCallback(void* ctx, unsigned char* buf, size_t len) {
+    WiFiClient* tcp = static_cast<WiFiClient*>(ctx);
+    if (tcp->available() <= 0) {
+        return tcp->connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    int n = tcp->read(buf, len);
+    return n > 0 ? n : MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+// Stalled writes give up after the handshake timeout
+size_t TlsClient::write(const uint8_t* buffer, size_t size) {
+    size_t sent = 0;
+    unsigned long start = millis();
+    while (_connected && sent < size) {
+        int ret = mbedtls_ssl_write(&_ssl, buffer + sent, size - sent);
+        if (ret > 0) {
+            sent += ret;
+        } else if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            if (millis() - start > _timeout) break;
+            delay(1);
+        } else {
+            stop();
+        }
+    }
+    return sent;
+}
+
+// Decrypts the next record when only ciphertext is waiting, so PubSubClient
+// sees a byte count it can read without blocking
+int TlsClient::available() {
+    if (!_connected) return 0;
+    size_t pending = mbedtls_ssl_get_bytes_avail(&_ssl);
+    if (pending == 0 && _tcp.available() > 0) {
+        int ret = mbedtls_ssl_read(&_ssl, nullptr, 0);
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            int peeked = _peeked >= 0 ? 1 : 0;
+            stop();
+            return peeked;
+        }
+        pending = mbedtls_ssl_get_bytes_avail(&_ssl);
+    }
+    return (_peeked >= 0 ? 1 : 0) + pending;
+}
+
+int TlsClient::read(uint8_t* buffer, size_t size) {
+    if (size == 0) return 0;
+    size_t got = 0;
+    if (_peeked >= 0) {
+        buffer[got++] = (uint8_t)_peeked;
+        _peeked = -1;
+    }
+    if (_connected && got < size && (got == 0 || mbedtls_ssl_get_bytes_avail(&_ssl) > 0)) {
+        int ret = mbedtls_ssl_read(&_ssl, buffer + got, size - got);
+        if (ret > 0) {
+            got += ret;
+        } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            stop();     // Close notify (0 or PEER_CLOSE_NOTIFY) or a fatal alert
+        }
+    }
+    return got > 0 ? (int)got : -1;
+}
+
+int TlsClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int TlsClient::peek() {
+    if (_peeked < 0) _peeked = read();
+    return _peeked;
+}
+
+// ============================================================================
+// Memory pool
+// ============================================================================
+
+// First fit over a list of blocks, each with a header; adjacent free blocks
+// merge on free. mbedTLS allocates a few dozen blocks per connection, so a
+// walk is short enough to run under the lock.
+struct PoolBlock {
+    uint32_t size;              // Including this header
+    uint32_t used;
+};
+
+#define POOL_ALIGN 8
+
+static uint8_t* pool = nullptr;
+static size_t poolSize = 0;
+static size_t poolInUse = 0;
+static size_t poolHigh = 0;
+static portMUX_TYPE poolLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void* poolAlloc(size_t bytes) {
+    size_t need = sizeof(PoolBlock) + ((bytes + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1));
+    void* p = nullptr;
+
+    portENTER_CRITICAL(&poolLock);
+    for (size_t off = 0; off < poolSize;) {
+        PoolBlock* b = (PoolBlock*)(pool + off);
+        if (!b->used && b->size >= need) {
+            if (b->size - need >= sizeof(PoolBlock) + POOL_ALIGN) {
+                PoolBlock* rest = (PoolBlock*)(pool + off + need);
+                rest->size = b->size - need;
+                rest->used = 0;
+                b->size = need;
+            }
+            b->used = 1;
+            poolInUse += b->size;
+            if (poolInUse > poolHigh) poolHigh = poolInUse;
+            p = b + 1;
+            break;
+        }
+        off += b->size;
+    }
+    portEXIT_CRITICAL(&poolLock);
+    return p;
+}
+
+static void poolRelease(void* p) {
+    portENTER_CRITICAL(&poolLock);
+    PoolBlock* b = (PoolBlock*)p - 1;
+    b->used = 0;
+    poolInUse -= b->size;
+    for (size_t off = 0; off < poolSize;) {
+        PoolBlock* cur = (PoolBlock*)(pool + off);
+        PoolBlock* next = (PoolBlock*)(pool + off + cur->size);
+        if (!cur->used && off + cur->size < poolSize && !next->used) {
+            cur->size += next->size;
+        } else {
+            off += cur->size;
+        }
+    }
+    portEXIT_CRITICAL(&poolLock);
+}
+
+static void* poolCalloc(size_t n, size_t size) {
+    if (size != 0 && n > SIZE_MAX / size) return nullptr;
+    void* p = poolAlloc(n * size);
+    if (!p) return calloc(n, size);     // Pool full: the heap, as without one
+    memset(p, 0, n * size);
+    return p;
+}
+
+static void poolFree(void* p) {
+    if ((uint8_t*)p >= pool && (uint8_t*)p < pool + poolSize) {
+        poolRelease(p);
+    } else {
+        free(p);
+    }
+}
+
+bool TlsClient::reservePool(size_t bytes) {
+    if (pool) return true;
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO)
+    bytes &= ~(size_t)(POOL_ALIGN - 1);
+    pool = (uint8_t*)malloc(bytes);
+    if (!pool) return false;
+    poolSize = bytes;
+    PoolBlock* first = (PoolBlock*)pool;
+    first->size = bytes;
+    first->used = 0;
+    // Blocks mbedTLS allocated before this still free to the heap
+    mbedtls_platform_set_calloc_free(poolCalloc, poolFree);
+    return true;
+#else
+    (void)bytes;
+    return false;       // mbedTLS built without replaceable calloc/free
+#endif
+}
+
+bool TlsClient::poolReserved() {
+    return pool != nullptr;
+}
+
+size_t TlsClient::poolUsed() {
+    return poolInUse;
+}
+
+size_t TlsClient::poolPeak() {
+    return poolHigh;
+}
@@ -3,6 +3,12 @@
 #include "HomeAssistantIntegration.h"
 #include "NodeManager.h"
 #include "WiFiManager.h"
+#include "ScheduleOptimizer.h"
+#include "SoilSensor.h"
+#include "PressureMonitor.h"
+#include "AutomationManager.h"
+#include "TimeZone.h"
+#include "CrashLog.h"
 extern Features features;
 extern String nodeId;
 extern String nodeRole;
@@ -17,63 +23,301 @@ WebAPIHandler::WebAPIHandler(WebServer* server,
     , _ha(ha)
     , _nm(nm)
     , _wm(wm)
+    , _soil(nullptr)
+    , _pressure(nullptr)
+    , _automation(nullptr)
+    , _bootId(esp_random())
+    , _msgpackResponses(0)
+    , _msgpackBytes(0)
+    , _msgpackJsonBytes(0)
+    , _chunkType(nullptr)
+    , _chunkCode(200)
+    , _chunkStarted(false)
+    , _chunkGzip(false)
+    , _gzipResponses(0)
+    , _gzipInBytes(0)
+    , _gzipOutBytes(0)
+    , _gzipMicros(0)
+    , _gzipSendMicros(0)
 {
 }
 
 void WebAPIHandler::begin() {
+    // WebServer only keeps request headers it was told to collect
+    static const char* headerKeys[] = { "If-None-Match", "Accept", "Content-Type", "Accept-Encoding" };
+    _server->collectHeaders(headerKeys, 4);
+
     // Schedule management APIs
-    _server->on("/api/schedules", HTTP_GET, [this]() { handleGetSchedules(); });
-    _server->on("/api/schedules", HTTP_POST, [this]() { handlePostSchedule(); });
-    _server->on("/api/schedules", HTTP_DELETE, [this]() { handleDeleteSchedule(); });
+    route("/api/schedules", HTTP_GET, &WebAPIHandler::handleGetSchedules);
+    route("/api/schedules", HTTP_POST, &WebAPIHandler::handlePostSchedule);
+    route("/api/schedules", HTTP_DELETE, &WebAPIHandler::handleDeleteSchedule);
+    route("/api/schedules/optimize", HTTP_POST, &WebAPIHandler::handlePostScheduleOptimize);
+    route("/api/schedules/forecast", HTTP_GET, &WebAPIHandler::handleGetScheduleForecast);
 
     // Channel APIs
-    _server->on("/api/channels/status", HTTP_GET, [this]() { handleGetChannelStatus(); });
-    _server->on("/api/channel/invert", HTTP_POST, [this]() { handlePostChannelInvert(); });
-    _server->on("/api/channel/enable", HTTP_POST, [this]() { handlePostChannelEnable(); });
-    _server->on("/api/channels/available", HTTP_GET, [this]() { handleGetChannelsAvailable(); });
+    route("/api/channels/status", HTTP_GET, &WebAPIHandler::handleGetChannelStatus);
+    route("/api/channel/invert", HTTP_POST, &WebAPIHandler::handlePostChannelInvert);
+    route("/api/channel/enable", HTTP_POST, &WebAPIHandler::handlePostChannelEnable);
+    route("/api/channels/available", HTTP_GET, &WebAPIHandler::handleGetChannelsAvailable);
 
     // Schedule skip/unskip
-    _server->on("/api/schedule/skip", HTTP_POST, [this]() { handlePostScheduleSkip(); });
-    _server->on("/api/schedule/unskip", HTTP_POST, [this]() { handlePostScheduleUnskip(); });
+    route("/api/schedule/skip", HTTP_POST, &WebAPIHandler::handlePostScheduleSkip);
+    route("/api/schedule/unskip", HTTP_POST, &WebAPIHandler::handlePostScheduleUnskip);
 
     // Channel start/stop
-    _server->on("/api/channel/start", HTTP_POST, [this]() { handlePostChannelStart(); });
-    _server->on("/api/channel/stop", HTTP_POST, [this]() { handlePostChannelStop(); });
+    route("/api/channel/start", HTTP_POST, &WebAPIHandler::handlePostChannelStart);
+    route("/api/channel/stop", HTTP_POST, &WebAPIHandler::handlePostChannelStop);
+
+    // Channel groups
+    route("/api/groups", HTTP_GET, &WebAPIHandler::handleGetGroups);
+    route("/api/groups", HTTP_POST, &WebAPIHandler::handlePostGroup);
+    route("/api/groups", HTTP_DELETE, &WebAPIHandler::handleDeleteGroup);
+    route("/api/group/start", HTTP_POST, &WebAPIHandler::handlePostGroupStart);
+    route("/api/group/stop", HTTP_POST, &WebAPIHandler::handlePostGroupStop);
+
+    // Soil-moisture sensors and closed-loop zones
+    route("/api/sensors", HTTP_GET, &WebAPIHandler::handleGetSensors);
+    route("/api/sensor/calibrate", HTTP_POST, &WebAPIHandler::handlePostSensorCalibrate);
+    route("/api/channel/moisture", HTTP_GET, &WebAPIHandler::handleGetChannelMoisture);
+    route("/api/channel/moisture", HTTP_POST, &WebAPIHandler::handlePostChannelMoisture);
+
+    // Mainline pressure monitoring
+    route("/api/pressure", HTTP_GET, &WebAPIHandler::handleGetPressure);
+    route("/api/pressure/clear", HTTP_POST, &WebAPIHandler::handlePostPressureClear);
+
+    // Local automation rules
+    route("/api/rules", HTTP_GET, &WebAPIHandler::handleGetRules);
+    route("/api/rules", HTTP_POST, &WebAPIHandler::handlePostRule);
+    route("/api/rules", HTTP_DELETE, &WebAPIHandler::handleDeleteRule);
+
+    // Request and loop timing, heap
+    route("/api/metrics", HTTP_GET, &WebAPIHandler::handleGetMetrics);
+
+    // Post-mortem: reset reason, last crash's serial tail, core dump
+    route("/api/crash", HTTP_GET, &WebAPIHandler::handleGetCrash);
+    route("/api/crash", HTTP_DELETE, &WebAPIHandler::handleDeleteCrash);
+    route("/api/crash/coredump", HTTP_GET, &WebAPIHandler::handleGetCrashCoreDump);
 
     // Node pairing API endpoints
-    _server->on("/api/nodes/pending", HTTP_GET, [this]() { handleGetNodesPending(); });
-    _server->on("/api/nodes/accept", HTTP_POST, [this]() { handlePostNodesAccept(); });
-    _server->on("/api/nodes/reject", HTTP_POST, [this]() { handlePostNodesReject(); });
-    _server->on("/api/nodes/rename", HTTP_POST, [this]() { handlePostNodesRename(); });
-    _server->on("/api/nodes/unpair", HTTP_POST, [this]() { handlePostNodesUnpair(); });
+    route("/api/nodes/pending", HTTP_GET, &WebAPIHandler::handleGetNodesPending);
+    route("/api/nodes/health", HTTP_GET, &WebAPIHandler::handleGetNodesHealth);
+    route("/api/nodes/accept", HTTP_POST, &WebAPIHandler::handlePostNodesAccept);
+    route("/api/nodes/reject", HTTP_POST, &WebAPIHandler::handlePostNodesReject);
+    route("/api/nodes/rename", HTTP_POST, &WebAPIHandler::handlePostNodesRename);
+    route("/api/nodes/unpair", HTTP_POST, &WebAPIHandler::handlePostNodesUnpair);
+    route("/api/runs", HTTP_GET, &WebAPIHandler::handleGetRuns);
 
     // MQTT configuration
-    _server->on("/mqtt/save", HTTP_POST, [this]() { handlePostMqttSave(); });
-    _server->on("/mqtt/test", HTTP_POST, [this]() { handlePostMqttTest(); });
+    route("/mqtt/save", HTTP_POST, &WebAPIHandler::handlePostMqttSave);
+    route("/mqtt/test", HTTP_POST, &WebAPIHandler::handlePostMqttTest);
 
     // WiFi/MQTT credential removal
-    _server->on("/wifi/remove", HTTP_POST, [this]() { handlePostWifiRemove(); });
-    _server->on("/mqtt/remove", HTTP_POST, [this]() { handlePostMqttRemove(); });
+    route("/wifi/remove", HTTP_POST, &WebAPIHandler::handlePostWifiRemove);
+    route("/mqtt/remove", HTTP_POST, &WebAPIHandler::handlePostMqttRemove);
 
     // Feature flags config API
-    _server->on("/api/config", HTTP_GET, [this]() { handleGetConfig(); });
-    _server->on("/api/config", HTTP_POST, [this]() { handlePostConfig(); });
+    route("/api/config", HTTP_GET, &WebAPIHandler::handleGetConfig);
+    route("/api/config", HTTP_POST, &WebAPIHandler::handlePostConfig);
 
     // System restart
-    _server->on("/system/restart", HTTP_POST, [this]() { handlePostSystemRestart(); });
+    route("/system/restart", HTTP_POST, &WebAPIHandler::handlePostSystemRestart);
+
+    // Firmware update job
+    route("/api/ota", HTTP_GET, &WebAPIHandler::handleGetOta);
+    route("/api/ota", HTTP_POST, &WebAPIHandler::handlePostOta);
+    route("/api/rollout", HTTP_GET, &WebAPIHandler::handleGetRollout);
+    route("/api/rollout", HTTP_POST, &WebAPIHandler::handlePostRollout);
+    route("/api/rollout/abort", HTTP_POST, &WebAPIHandler::handlePostRolloutAbort);
+}
+
+// WebServer serves one request per handleClient() from the main loop, so
+// handler time is also time every valve, schedule and node timer waits
+void WebAPIHandler::route(const char* uri, HTTPMethod method, void (WebAPIHandler::*handler)()) {
+    _server->on(uri, method, [this, handler]() {
+        unsigned long start = micros();
+        // WebServer keeps the body as a C string, so a binary one would be
+        // cut at its first zero byte; refuse it rather than misparse it
+        String type = _server->header("Content-Type");
+        if (type.startsWith("application/msgpack") || type.startsWith("application/x-msgpack") ||
+            type.startsWith("application/cbor")) {
+            _server->send(415, "application/json", "{\"success\":false,\"message\":\"Request body must be JSON\"}");
+        } else {
+            // Any response may be MessagePack or gzip depending on these
+            // request headers (304s included), so it is declared once here
+            _server->sendHeader("Vary", "Accept, Accept-Encoding");
+            (this->*handler)();
+        }
+        _requestLatency.record(micros() - start);
+    });
+}
+
+// ================================================================
+// Response encoding
+// ================================================================
+
+// Clients on slow links (the fleet manager) can ask for MessagePack with
+// "Accept: application/msgpack"; the document is the same, only the
+// encoding differs. CBOR is not offered: ArduinoJson has no CBOR writer.
+bool WebAPIHandler::wantsMsgPack() {
+    String accept = _server->header("Accept");
+    return accept.indexOf("application/msgpack") >= 0 ||
+           accept.indexOf("application/x-msgpack") >= 0;
+}
+
+// The MessagePack bytes go through an arena block rather than a String,
+// whose ArduinoJson writer stops at the first zero byte
+void WebAPIHandler::sendDocument(const JsonDocument& doc, int code) {
+    if (!wantsMsgPack()) {
+        String json;
+        serializeJson(doc, json);
+        if (json.length() >= GZIP_MIN_BYTES && acceptsGzip()) {
+            beginChunked("application/json", code);
+            sendChunk(json);
+            endChunked();
+        } else {
+            _server->send(code, "application/json", json);
+        }
+        return;
+    }
+
+    size_t length = measureMsgPack(doc);
+    char* buffer = (char*)jsonArena.allocate(length);
+    if (!buffer) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
+        return;
+    }
+    serializeMsgPack(doc, buffer, length);
+    if (length >= GZIP_MIN_BYTES && acceptsGzip()) {
+        beginChunked("application/msgpack", code);
+        sendChunk(buffer, length);
+        endChunked();
+    } else {
+        _server->send_P(code, "application/msgpack", buffer, length);
+    }
+    jsonArena.deallocate(buffer);
+
+    _msgpackResponses++;
+    _msgpackBytes += length;
+    _msgpackJsonBytes += measureJson(doc);
+}
+
+// Chunked responses. Headers wait for the first chunk: a body that needs a
+// sendChunk() before endChunked() has outgrown one chunk, and is gzipped if
+// the client accepts it. A single short chunk goes out as it is.
+bool WebAPIHandler::acceptsGzip() {
+    return _server->header("Accept-Encoding").indexOf("gzip") >= 0;
+}
+
+void WebAPIHandler::beginChunked(const char* type, int code) {
+    _chunkType = type;
+    _chunkCode = code;
+    _chunkStarted = false;
+    _chunkGzip = false;
+}
+
+void WebAPIHandler::sendChunk(const char* data, size_t length, bool last) {
+    if (!_chunkStarted) {
+        _chunkStarted = true;
+        _chunkGzip = acceptsGzip() && (!last || length >= GZIP_MIN_BYTES);
+        if (_chunkGzip) {
+            _server->sendHeader("Content-Encoding", "gzip");
+            _gzip.begin(gzipSink, this);
+        }
+        _server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+        _server->send(_chunkCode, _chunkType, "");
+    }
+    if (length == 0) return;
+
+    if (_chunkGzip) {
+        // Encoder time only; what the sink spends on the socket is taken out
+        unsigned long start = micros();
+        _gzipSendMicros = 0;
+        _gzip.write((const uint8_t*)data, length);
+        _gzipMicros += micros() - start - _gzipSendMicros;
+    } else {
+        _server->sendContent(data, length);
+    }
+}
+
+void WebAPIHandler::endChunked(const String& tail) {
+    sendChunk(tail.c_str(), tail.length(), true);
+    if (_chunkGzip) {
+        unsigned long start = micros();
+        _gzipSendMicros = 0;
+        _gzip.finish();
+        _gzipMicros += micros() - start - _gzipSendMicros;
+
+        _gzipResponses++;
+        _gzipInBytes += _gzip.getInputBytes();
+        _gzipOutBytes += _gzip.getOutputBytes();
+    }
+    _server->sendContent("");  // End of chunked response
+}
+
+void WebAPIHandler::gzipSink(void* context, const uint8_t* data, size_t length) {
+    WebAPIHandler* self = (WebAPIHandler*)context;
+    unsigned long start = micros();
+    self->_server->sendContent((const char*)data, length);
+    self->_gzipSendMicros += micros() - start;
 }
 
 // ================================================================
 // Schedule management
 // ================================================================
 
+// The status page polls every couple of seconds from each open tab. The
+// ETag is built from the generation counters of the state a response is
+// made of, so an unchanged poll costs a header compare instead of a
+// document build and serialisation.
+bool WebAPIHandler::notModified(const char* kind, uint32_t genA, uint32_t genB) {
+    char etag[40];
+    snprintf(etag, sizeof(etag), "\"%08lx-%s%lu-%lu%s\"",
+             (unsigned long)_bootId, kind, (unsigned long)genA, (unsigned long)genB,
+             wantsMsgPack() ? "-m" : "");
+
+    _server->sendHeader("ETag", etag);
+    _server->sendHeader("Cache-Control", "no-cache");
+    if (_server->header("If-None-Match") != etag) return false;
+
+    _server->send(304);
+    return true;
+}
+
+// Flat request bodies go through BodySchema instead of a JsonDocument: the
+// body is scanned once and each value lands in the handler's struct already
+// range-checked, so the arena is left alone and the 400 names the field.
+bool WebAPIHandler::parseBody(const BodyField* fields, uint8_t count, void* out, uint32_t* present) {
+    if (!_server->hasArg("plain")) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing payload\"}");
+        return false;
+    }
+
+    // WebServer::arg() returns the stored body by value; this copy is the
+    // one allocation the parse makes
+    String body = _server->arg("plain");
+    BodyResult result = BodySchema::parse(body.c_str(), body.length(), fields, count, out);
+    if (present) *present = result.present;
+    if (result.status == BODY_OK) return true;
+
+    char message[64];
+    BodySchema::formatError(result, fields, message, sizeof(message));
+    char reply[112];
+    snprintf(reply, sizeof(reply), "{\"success\":false,\"message\":\"%s\"}", message);
+    _server->send(400, "application/json", reply);
+    return false;
+}
+
 void WebAPIHandler::handleGetSchedules() {
     if (!_controller) {
         _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
         return;
     }
+    if (notModified("s", _controller->getScheduleGeneration(),
+                    _nm ? _nm->getPeerGeneration() : 0)) {
+        return;
+    }
 
-    DynamicJsonDocument doc(2048);
+    ArenaJsonDocument doc(4096);
     doc["success"] = true;
 
     JsonArray channels = doc.createNestedArray("channels");
@@ -117,56 +361,134 @@ void WebAPIHandler::handleGetSchedules() {
         entry["minute"] = schedules[i].minute;
         entry["duration"] = schedules[i].durationMinutes;
         entry["weekdays"] = schedules[i].weekdays;
+        entry["cycles"] = schedules[i].cycles;
+        entry["soak"] = schedules[i].soakMinutes;
         entry["pin"] = _controller->getChannelPin(schedules[i].channel);
         entry["skipped"] = _controller->isScheduleSkipped(i);
     }
 
-    String json;
-    serializeJson(doc, json);
-    _server->send(200, "application/json", json);
+    sendDocument(doc);
 }
 
-void WebAPIHandler::handlePostSchedule() {
+// Every run of the next ?days=N days (default FORECAST_DEFAULT_DAYS) in time
+// order. Runs are serialized one at a time and sent in ~1 KB chunks, so the
+// response size is independent of the horizon.
+void WebAPIHandler::handleGetScheduleForecast() {
     if (!_controller) {
         _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
         return;
     }
 
-    if (!_server->hasArg("plain")) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing payload\"}");
-        return;
+    uint16_t days = FORECAST_DEFAULT_DAYS;
+    if (_server->hasArg("days")) {
+        long requested = _server->arg("days").toInt();
+        if (requested < 1 || requested > FORECAST_MAX_DAYS) {
+            _server->send(400, "application/json", "{\"success\":false,\"message\":\"days must be 1-31\"}");
+            return;
+        }
+        days = (uint16_t)requested;
     }
 
-    DynamicJsonDocument doc(512);
-    DeserializationError error = deserializeJson(doc, _server->arg("plain"));
-    if (error) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+    ForecastCursor cursor;
+    if (!_controller->beginForecast(cursor, days)) {
+        _server->send(503, "application/json", "{\"success\":false,\"message\":\"Time not synchronized\"}");
         return;
     }
 
-    uint8_t channel = doc["channel"] | 0;
-    uint8_t hour = doc["hour"] | 0;
-    uint8_t minute = doc["minute"] | 0;
-    uint16_t duration = doc["duration"] | DEFAULT_DURATION_MINUTES;
-    uint8_t weekdays = doc["weekdays"] | 0x7F;
-    int16_t editId = doc["id"] | -1;
+    beginChunked("application/json");
+
+    String chunk = "{\"success\":true,\"from\":" + String((unsigned long)_controller->getCurrentTime()) +
+                   ",\"days\":" + String(days) + ",\"runs\":[";
+    ForecastRun run;
+    bool first = true;
+    while (_controller->nextForecastRun(cursor, run)) {
+        StaticJsonDocument<256> doc;
+        doc["start"] = (unsigned long)run.start;
+        doc["channel"] = run.channel;
+        doc["schedule"] = run.scheduleIndex;
+        doc["duration"] = run.durationMinutes;
+        if (run.cycles > 1) {
+            doc["cycles"] = run.cycles;
+            doc["soak"] = run.soakMinutes;
+        }
+        if (run.skipped) doc["skipped"] = true;
+        if (run.closedLoop) doc["closed_loop"] = true;
+        if (run.channel > NUM_LOCAL_CHANNELS && _nm) {
+            doc["remote"] = true;
+            for (uint8_t s = 0; s < _nm->getSlaveCount(); s++) {
+                const NodePeer* slave = _nm->getSlave(s);
+                if (slave && run.channel >= slave->base_virtual_ch &&
+                    run.channel < slave->base_virtual_ch + slave->num_channels) {
+                    doc["slave"] = slave->name[0] ? slave->name : slave->node_id;
+                    break;
+                }
+            }
+        }
 
-    if (channel < 1 || channel > MAX_CHANNELS) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid channel\"}");
-        return;
+        char buf[256];
+        serializeJson(doc, buf, sizeof(buf));
+        if (!first) chunk += ",";
+        chunk += buf;
+        first = false;
+
+        if (chunk.length() >= 1024) {
+            sendChunk(chunk);
+            chunk = "";
+        }
     }
-    if (hour > 23 || minute > 59) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid start time\"}");
+    chunk += "]}";
+    endChunked(chunk);
+}
+
+void WebAPIHandler::handlePostSchedule() {
+    if (!_controller) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
         return;
     }
-    if (duration < MIN_DURATION_MINUTES || duration > MAX_DURATION_MINUTES) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid duration\"}");
+
+    struct ScheduleBody {
+        uint8_t channel, hour, minute, weekdays, cycles;
+        uint16_t duration, soak;
+        int16_t id;
+    };
+    static const BodyField fields[] = {
+        BODY_FIELD_INT("channel", ScheduleBody, channel, true, 1, MAX_CHANNELS),
+        BODY_FIELD_INT("hour", ScheduleBody, hour, false, 0, 23),
+        BODY_FIELD_INT("minute", ScheduleBody, minute, false, 0, 59),
+        BODY_FIELD_INT("duration", ScheduleBody, duration, false, MIN_DURATION_MINUTES, MAX_DURATION_MINUTES),
+        BODY_FIELD_INT("weekdays", ScheduleBody, weekdays, false, 0, 0x7F),
+        BODY_FIELD_INT("cycles", ScheduleBody, cycles, false, 1, MAX_CYCLES),
+        BODY_FIELD_INT("soak", ScheduleBody, soak, false, 0, MAX_SOAK_MINUTES),
+        BODY_FIELD_INT("id", ScheduleBody, id, false, -1, MAX_SCHEDULES - 1),
+    };
+    ScheduleBody body = { 0, 0, 0, 0x7F, 1, DEFAULT_DURATION_MINUTES, 0, -1 };
+    uint32_t present;
+    if (!parseBody(fields, &body, &present)) return;
+
+    uint8_t channel = body.channel;
+    uint8_t hour = body.hour;
+    uint8_t minute = body.minute;
+    uint16_t duration = body.duration;
+    uint8_t weekdays = body.weekdays;
+    uint8_t cycles = body.cycles;
+    uint16_t soak = body.soak;
+    int16_t editId = body.id;
+
+    // An edit that leaves out cycles or soak keeps the schedule's own
+    if (editId >= 0) {
+        IrrigationSchedule current = _controller->getSchedule((uint8_t)editId);
+        if (!(present & (1UL << 5))) cycles = current.cycles > 0 ? current.cycles : 1;
+        if (!(present & (1UL << 6))) soak = current.soakMinutes;
+    }
+
+    if (cycles > duration || (cycles > 1 && soak < 1)) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid cycle/soak\"}");
         return;
     }
 
     if (editId >= 0) {
         // Update existing schedule
-        if (_controller->updateSchedule((uint8_t)editId, channel, hour, minute, duration, weekdays)) {
+        if (_controller->updateSchedule((uint8_t)editId, channel, hour, minute, duration, weekdays, cycles, soak)) {
             // Sync to slave if virtual channel
             if (_nm && channel > NUM_LOCAL_CHANNELS) {
                 const NodePeer* slave = _nm->getSlave(0);
@@ -190,7 +512,7 @@ void WebAPIHandler::handlePostSchedule() {
         }
     } else {
         // Add new schedule
-        int8_t index = _controller->addSchedule(channel, hour, minute, duration, weekdays);
+        int8_t index = _controller->addSchedule(channel, hour, minute, duration, weekdays, cycles, soak);
         if (index >= 0) {
             // Sync to slave if virtual channel
             if (_nm && channel > NUM_LOCAL_CHANNELS) {
@@ -255,6 +577,159 @@ void WebAPIHandler::handleDeleteSchedule() {
     }
 }
 
+// Accepts "HH:MM" or plain minutes since midnight; returns -1 if invalid
+static int16_t parseMinuteOfDay(JsonVariantConst value, int16_t fallback) {
+    if (value.isNull()) return fallback;
+    if (value.is<const char*>()) {
+        const char* text = value.as<const char*>();
+        int h = 0, m = 0;
+        if (sscanf(text, "%d:%d", &h, &m) != 2) return -1;
+        if (h == 24 && m == 0) return SCHEDULE_OPT_MINUTES_DAY;
+        if (h < 0 || h > 23 || m < 0 || m > 59) return -1;
+        return h * 60 + m;
+    }
+    int v = value.as<int>();
+    return (v < 0 || v > SCHEDULE_OPT_MINUTES_DAY) ? -1 : v;
+}
+
+static String formatMinuteOfDay(uint16_t minutes) {
+    char buf[6];
+    snprintf(buf, sizeof(buf), "%02u:%02u", minutes / 60, minutes % 60);
+    return String(buf);
+}
+
+// Computes a proposed schedule set; nothing is saved. The client reviews the
+// proposal and applies it through POST /api/schedules as usual.
+void WebAPIHandler::handlePostScheduleOptimize() {
+    if (!_controller) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
+        return;
+    }
+
+    ArenaJsonDocument req(4096);
+    if (_server->hasArg("plain") && _server->arg("plain").length() > 0) {
+        DeserializationError error = deserializeJson(req, _server->arg("plain"));
+        if (error) {
+            _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+            return;
+        }
+    }
+
+    int16_t defStart = parseMinuteOfDay(req["window_start"], 5 * 60);
+    int16_t defEnd = parseMinuteOfDay(req["window_end"], 9 * 60);
+    if (defStart < 0 || defEnd < 0 || defStart >= defEnd) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid window\"}");
+        return;
+    }
+
+    ScheduleOptimizer optimizer;
+    uint8_t defConcurrent = req["max_concurrent"] | 1;
+    for (uint8_t s = 0; s < SCHEDULE_OPT_MAX_SUPPLIES; s++) {
+        optimizer.setSupplyLimit(s, defConcurrent);
+    }
+    for (JsonObjectConst supply : req["supplies"].as<JsonArrayConst>()) {
+        uint8_t id = supply["id"] | 0;
+        uint8_t limit = supply["max_concurrent"] | 0;
+        if (!optimizer.setSupplyLimit(id, limit)) {
+            _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid supply\"}");
+            return;
+        }
+    }
+
+    JsonArrayConst zones = req["zones"].as<JsonArrayConst>();
+    if (!zones.isNull()) {
+        for (JsonObjectConst zone : zones) {
+            OptZone z;
+            z.channel = zone["channel"] | 0;
+            z.durationMinutes = zone["duration"] | 0;
+            z.weekdays = zone["weekdays"] | 0x7F;
+            z.supply = zone["supply"] | 0;
+            z.flow = (uint16_t)((zone["flow"] | 0.0f) * 10.0f + 0.5f);
+            int16_t wStart = parseMinuteOfDay(zone["window_start"], defStart);
+            int16_t wEnd = parseMinuteOfDay(zone["window_end"], defEnd);
+
+            if (z.channel < 1 || z.channel > MAX_CHANNELS) {
+                _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid channel\"}");
+                return;
+            }
+            if (z.durationMinutes < MIN_DURATION_MINUTES || z.durationMinutes > MAX_DURATION_MINUTES) {
+                _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid duration\"}");
+                return;
+            }
+            if (wStart < 0 || wEnd < 0) {
+                _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid window\"}");
+                return;
+            }
+            z.windowStart = wStart;
+            z.windowEnd = wEnd;
+            if (optimizer.addZone(z) < 0) {
+                _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid zone\"}");
+                return;
+            }
+        }
+    } else {
+        // No explicit zones: re-pack the existing enabled schedules
+        IrrigationSchedule schedules[MAX_SCHEDULES];
+        uint8_t count = 0;
+        _controller->getSchedules(schedules, count);
+        for (uint8_t i = 0; i < count; i++) {
+            if (!schedules[i].enabled) continue;
+            OptZone z = {};
+            z.channel = schedules[i].channel;
+            z.durationMinutes = schedules[i].durationMinutes;
+            z.weekdays = schedules[i].weekdays;
+            z.windowStart = defStart;
+            z.windowEnd = defEnd;
+            optimizer.addZone(z);
+        }
+    }
+
+    if (optimizer.getZoneCount() == 0) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"No zones to optimize\"}");
+        return;
+    }
+
+    unsigned long started = millis();
+    bool complete = optimizer.solve();
+    unsigned long elapsed = millis() - started;
+    DEBUG_PRINTF("WebAPI: Optimized %d zones in %lu ms (%d placed)\n",
+                 optimizer.getZoneCount(), elapsed, optimizer.getPlacedCount());
+
+    uint8_t n = optimizer.getZoneCount();
+    ArenaJsonDocument doc(JSON_OBJECT_SIZE(9) + JSON_ARRAY_SIZE(n) * 2 +
+                            n * JSON_OBJECT_SIZE(7) + 128);
+    doc["success"] = true;
+    doc["complete"] = complete;
+    if (optimizer.getPlacedCount() > 0) {
+        doc["window_start"] = formatMinuteOfDay(optimizer.getWindowStart());
+        doc["window_end"] = formatMinuteOfDay(optimizer.getWindowEnd());
+        doc["window_minutes"] = optimizer.getWindowEnd() - optimizer.getWindowStart();
+    }
+    doc["peak_flow"] = optimizer.getPeakFlow() / 10.0f;
+    doc["elapsed_ms"] = elapsed;
+
+    JsonArray proposed = doc.createNestedArray("schedules");
+    JsonArray unplaced = doc.createNestedArray("unplaced");
+    for (uint8_t i = 0; i < n; i++) {
+        const OptZone& z = optimizer.getZone(i);
+        if (!optimizer.isPlaced(i)) {
+            unplaced.add(z.channel);
+            continue;
+        }
+        uint16_t start = optimizer.getStart(i);
+        JsonObject entry = proposed.createNestedObject();
+        entry["channel"] = z.channel;
+        entry["hour"] = start / 60;
+        entry["minute"] = start % 60;
+        entry["duration"] = z.durationMinutes;
+        entry["weekdays"] = z.weekdays;
+        entry["supply"] = z.supply;
+        entry["flow"] = z.flow / 10.0f;
+    }
+
+    sendDocument(doc);
+}
+
 // ================================================================
 // Channel status and control
 // ================================================================
@@ -264,8 +739,12 @@ void WebAPIHandler::handleGetChannelStatus() {
         _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
         return;
     }
+    if (notModified("c", _controller->getChannelGeneration(),
+                    _nm ? _nm->getPeerGeneration() : 0)) {
+        return;
+    }
 
-    DynamicJsonDocument doc(512);
+    ArenaJsonDocument doc(1024);
     doc["success"] = true;
 
     JsonArray channels = doc.createNestedArray("channels");
@@ -276,6 +755,7 @@ void WebAPIHandler::handleGetChannelStatus() {
         ch["channel"] = i + 1;
         ch["pin"] = CHANNEL_PINS[i];
         ch["running"] = _controller->isChannelIrrigating(i + 1);
+        ch["soaking"] = _controller->isChannelSoaking(i + 1);
         ch["inverted"] = _controller->isChannelInverted(i + 1);
     }
     // Virtual channels for paired slaves
@@ -289,6 +769,7 @@ void WebAPIHandler::handleGetChannelStatus() {
                 ch["channel"] = vch;
                 ch["pin"] = 0;
                 ch["running"] = _controller->isChannelIrrigating(vch);
+                ch["soaking"] = _controller->isChannelSoaking(vch);
                 ch["inverted"] = _controller->isChannelInverted(vch);
                 ch["remote"] = true;
                 ch["slave"] = slave->name[0] ? slave->name : slave->node_id;
@@ -296,9 +777,7 @@ void WebAPIHandler::handleGetChannelStatus() {
         }
     }
 
-    String json;
-    serializeJson(doc, json);
-    _server->send(200, "application/json", json);
+    sendDocument(doc);
 }
 
 void WebAPIHandler::handlePostChannelInvert() {
@@ -307,25 +786,15 @@ void WebAPIHandler::handlePostChannelInvert() {
         return;
     }
 
-    if (!_server->hasArg("plain")) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing payload\"}");
-        return;
-    }
-
-    DynamicJsonDocument doc(256);
-    DeserializationError error = deserializeJson(doc, _server->arg("plain"));
-    if (error) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
-        return;
-    }
-
-    uint8_t channel = doc["channel"] | 0;
-    bool inverted = doc["inverted"] | false;
-
-    if (channel < 1 || channel > MAX_CHANNELS) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid channel\"}");
-        return;
-    }
+    struct InvertBody { uint8_t channel; bool inverted; };
+    static const BodyField fields[] = {
+        BODY_FIELD_INT("channel", InvertBody, channel, true, 1, MAX_CHANNELS),
+        BODY_FIELD_BOOL("inverted", InvertBody, inverted, false),
+    };
+    InvertBody body = { 0, false };
+    if (!parseBody(fields, &body)) return;
+    uint8_t channel = body.channel;
+    bool inverted = body.inverted;
 
     _controller->setChannelInverted(channel, inverted);
     DEBUG_PRINTF("WebAPIHandler: Channel %d invert set to %d\n", channel, inverted);
@@ -333,27 +802,25 @@ void WebAPIHandler::handlePostChannelInvert() {
 }
 
 void WebAPIHandler::handlePostChannelEnable() {
-    if (!_controller || !_server->hasArg("plain")) {
+    if (!_controller) {
         _server->send(400, "application/json", "{\"success\":false,\"message\":\"Bad request\"}");
         return;
     }
 
-    StaticJsonDocument<128> doc;
-    deserializeJson(doc, _server->arg("plain"));
-    uint8_t channel = doc["channel"] | 0;
-    bool enabled = doc["enabled"] | true;
-
-    if (channel < 1 || channel > NUM_LOCAL_CHANNELS) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid channel\"}");
-        return;
-    }
+    struct EnableBody { uint8_t channel; bool enabled; };
+    static const BodyField fields[] = {
+        BODY_FIELD_INT("channel", EnableBody, channel, true, 1, NUM_LOCAL_CHANNELS),
+        BODY_FIELD_BOOL("enabled", EnableBody, enabled, false),
+    };
+    EnableBody body = { 0, true };
+    if (!parseBody(fields, &body)) return;
 
-    _controller->setChannelEnabled(channel, enabled);
+    _controller->setChannelEnabled(body.channel, body.enabled);
     _server->send(200, "application/json", "{\"success\":true}");
 }
 
 void WebAPIHandler::handleGetChannelsAvailable() {
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
     doc["success"] = true;
     JsonArray channels = doc.createNestedArray("channels");
     for (uint8_t i = 0; i < NUM_LOCAL_CHANNELS; i++) {
@@ -362,31 +829,25 @@ void WebAPIHandler::handleGetChannelsAvailable() {
         ch["pin"] = CHANNEL_PINS[i];
         ch["enabled"] = _controller->isChannelEnabled(i + 1);
     }
-    String json;
-    serializeJson(doc, json);
-    _server->send(200, "application/json", json);
+    sendDocument(doc);
 }
 
 // ================================================================
 // Schedule skip/unskip
 // ================================================================
 
+// Body is just {"id": n}, parsed straight into a uint8_t
+static const BodyField SCHEDULE_ID_FIELDS[] = {
+    BODY_FIELD_SCALAR("id", BODY_INT, uint8_t, true, 0, MAX_SCHEDULES - 1),
+};
+
 void WebAPIHandler::handlePostScheduleSkip() {
     if (!_controller) {
         _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
         return;
     }
-    if (!_server->hasArg("plain")) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing payload\"}");
-        return;
-    }
-    DynamicJsonDocument doc(128);
-    deserializeJson(doc, _server->arg("plain"));
-    uint8_t id = doc["id"] | 255;
-    if (id >= MAX_SCHEDULES) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid schedule id\"}");
-        return;
-    }
+    uint8_t id = 0;
+    if (!parseBody(SCHEDULE_ID_FIELDS, &id)) return;
     _controller->skipSchedule(id);
 
     // Forward skip to slave if schedule is for a virtual channel
@@ -411,17 +872,8 @@ void WebAPIHandler::handlePostScheduleUnskip() {
         _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
         return;
     }
-    if (!_server->hasArg("plain")) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing payload\"}");
-        return;
-    }
-    DynamicJsonDocument doc(128);
-    deserializeJson(doc, _server->arg("plain"));
-    uint8_t id = doc["id"] | 255;
-    if (id >= MAX_SCHEDULES) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid schedule id\"}");
-        return;
-    }
+    uint8_t id = 0;
+    if (!parseBody(SCHEDULE_ID_FIELDS, &id)) return;
     _controller->unskipSchedule(id);
 
     // Forward unskip to slave if schedule is for a virtual channel
@@ -451,25 +903,15 @@ void WebAPIHandler::handlePostChannelStart() {
         return;
     }
 
-    if (!_server->hasArg("plain")) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing payload\"}");
-        return;
-    }
-
-    DynamicJsonDocument doc(256);
-    DeserializationError error = deserializeJson(doc, _server->arg("plain"));
-    if (error) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
-        return;
-    }
-
-    uint8_t channel = doc["channel"] | 0;
-    uint16_t duration = doc["duration"] | DEFAULT_DURATION_MINUTES;
-
-    if (channel < 1 || channel > MAX_CHANNELS) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid channel\"}");
-        return;
-    }
+    struct StartBody { uint8_t channel; uint16_t duration; };
+    static const BodyField fields[] = {
+        BODY_FIELD_INT("channel", StartBody, channel, true, 1, MAX_CHANNELS),
+        BODY_FIELD_INT("duration", StartBody, duration, false, MIN_DURATION_MINUTES, MAX_DURATION_MINUTES),
+    };
+    StartBody body = { 0, DEFAULT_DURATION_MINUTES };
+    if (!parseBody(fields, &body)) return;
+    uint8_t channel = body.channel;
+    uint16_t duration = body.duration;
 
     _controller->startIrrigation(channel, duration);
     DEBUG_PRINTF("WebAPIHandler: Manual start channel %d for %d min\n", channel, duration);
@@ -488,24 +930,11 @@ void WebAPIHandler::handlePostChannelStop() {
         return;
     }
 
-    if (!_server->hasArg("plain")) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing payload\"}");
-        return;
-    }
-
-    DynamicJsonDocument doc(256);
-    DeserializationError error = deserializeJson(doc, _server->arg("plain"));
-    if (error) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
-        return;
-    }
-
-    uint8_t channel = doc["channel"] | 0;
-
-    if (channel < 1 || channel > MAX_CHANNELS) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid channel\"}");
-        return;
-    }
+    static const BodyField fields[] = {
+        BODY_FIELD_SCALAR("channel", BODY_INT, uint8_t, true, 1, MAX_CHANNELS),
+    };
+    uint8_t channel = 0;
+    if (!parseBody(fields, &channel)) return;
 
     _controller->stopIrrigation(channel);
     DEBUG_PRINTF("WebAPIHandler: Manual stop channel %d\n", channel);
@@ -519,73 +948,49 @@ void WebAPIHandler::handlePostChannelStop() {
 }
 
 // ================================================================
-// Node pairing API endpoints
+// Channel groups
 // ================================================================
 
-void WebAPIHandler::handleGetNodesPending() {
-    DynamicJsonDocument doc(1024);
+void WebAPIHandler::handleGetGroups() {
+    if (!_controller) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
+        return;
+    }
+
+    ArenaJsonDocument doc(2048);
     doc["success"] = true;
 
-    if (_nm) {
-        // Pending pair request
-        if (_nm->hasPendingPair()) {
-            const PendingPairRequest& req = _nm->getPendingPair();
-            JsonObject pending = doc.createNestedObject("pending");
-            pending["node_id"] = req.node_id;
-            pending["name"] = req.name;
-            pending["num_channels"] = req.num_channels;
-            pending["ip"] = req.ip.toString();
+    JsonArray groups = doc.createNestedArray("groups");
+    for (uint8_t g = 0; g < MAX_GROUPS; g++) {
+        ChannelGroup grp = _controller->getGroup(g);
+        if (!grp.enabled) continue;
+
+        JsonObject entry = groups.createNestedObject();
+        entry["id"] = g;
+        entry["name"] = grp.name;
+        JsonArray channels = entry.createNestedArray("channels");
+        for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+            if (grp.members & (1ULL << i)) channels.add(i + 1);
         }
-
-        // Paired slaves
-        JsonArray slaves = doc.createNestedArray("slaves");
-        for (uint8_t i = 0; i < _nm->getSlaveCount(); i++) {
-            const NodePeer* peer = _nm->getSlave(i);
-            if (!peer) continue;
-            JsonObject s = slaves.createNestedObject();
-            s["node_id"] = peer->node_id;
-            s["name"] = peer->name;
-            s["virtual_channel"] = peer->base_virtual_ch;
-            s["num_channels"] = peer->num_channels;
-            s["online"] = peer->online;
-            s["rssi"] = peer->rssi;
+        entry["running"] = _controller->isGroupRunning(g);
+
+        const char* ack = "none";
+        if (_nm) {
+            switch (_nm->getGroupAckState(g)) {
+                case GROUP_ACK_PENDING:   ack = "pending"; break;
+                case GROUP_ACK_CONFIRMED: ack = "confirmed"; break;
+                case GROUP_ACK_FAILED:    ack = "failed"; break;
+            }
         }
+        entry["ack"] = ack;
     }
 
-    String json;
-    serializeJson(doc, json);
-    _server->send(200, "application/json", json);
-}
-
-void WebAPIHandler::handlePostNodesAccept() {
-    if (!_nm) {
-        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
-        return;
-    }
-    if (!_nm->hasPendingPair()) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"No pending pair request\"}");
-        return;
-    }
-    _nm->acceptPendingPair();
-    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Pair accepted\"}");
-}
-
-void WebAPIHandler::handlePostNodesReject() {
-    if (!_nm) {
-        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
-        return;
-    }
-    if (!_nm->hasPendingPair()) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"No pending pair request\"}");
-        return;
-    }
-    _nm->rejectPendingPair(PAIR_REJECT_USER);
-    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Pair rejected\"}");
+    sendDocument(doc);
 }
 
-void WebAPIHandler::handlePostNodesRename() {
-    if (!_nm) {
-        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
+void WebAPIHandler::handlePostGroup() {
+    if (!_controller) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
         return;
     }
 
@@ -594,50 +999,786 @@ void WebAPIHandler::handlePostNodesRename() {
         return;
     }
 
-    StaticJsonDocument<256> reqDoc;
-    DeserializationError error = deserializeJson(reqDoc, _server->arg("plain"));
+    ArenaJsonDocument doc(512);
+    DeserializationError error = deserializeJson(doc, _server->arg("plain"));
     if (error) {
         _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
         return;
     }
 
-    const char* reqNodeId = reqDoc["node_id"] | "";
-    const char* newName = reqDoc["name"] | "";
-    if (strlen(reqNodeId) == 0 || strlen(newName) == 0) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"node_id and name required\"}");
+    const char* name = doc["name"] | "";
+    int16_t editId = doc["id"] | -1;
+    uint64_t members = 0;
+    for (JsonVariant ch : doc["channels"].as<JsonArray>()) {
+        uint8_t c = ch | 0;
+        if (c < 1 || c > MAX_CHANNELS) {
+            _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid channel\"}");
+            return;
+        }
+        members |= (1ULL << (c - 1));
+    }
+
+    if (!name[0] || strlen(name) >= GROUP_NAME_LEN) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid name\"}");
+        return;
+    }
+    if (members == 0) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Group has no channels\"}");
         return;
     }
 
-    if (_nm->renameSlave(reqNodeId, newName)) {
-        _server->send(200, "application/json", "{\"success\":true,\"message\":\"Slave renamed\"}");
+    int8_t index;
+    if (editId >= 0) {
+        index = _controller->updateGroup((uint8_t)editId, name, members) ? editId : -1;
     } else {
-        _server->send(404, "application/json", "{\"success\":false,\"message\":\"Slave not found\"}");
+        index = _controller->addGroup(name, members);
     }
+    if (index < 0) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Unable to save group\"}");
+        return;
+    }
+
+    if (_ha) _ha->refreshDiscovery();
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Group saved\",\"id\":" + String(index) + "}");
 }
 
-void WebAPIHandler::handlePostNodesUnpair() {
-    if (!_nm) {
-        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
+void WebAPIHandler::handleDeleteGroup() {
+    if (!_controller) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
         return;
     }
 
-    if (!_server->hasArg("plain")) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing payload\"}");
+    if (!_server->hasArg("id")) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing group id\"}");
         return;
     }
 
-    StaticJsonDocument<128> reqDoc;
-    DeserializationError error = deserializeJson(reqDoc, _server->arg("plain"));
-    if (error) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
+    uint8_t index = _server->arg("id").toInt();
+    if (_controller->isGroupRunning(index)) {
+        _controller->stopGroup(index);
+    }
+    if (_controller->removeGroup(index)) {
+        if (_ha) _ha->refreshDiscovery();
+        _server->send(200, "application/json", "{\"success\":true,\"message\":\"Group removed\"}");
+    } else {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Failed to remove group\"}");
+    }
+}
+
+void WebAPIHandler::handlePostGroupStart() {
+    if (!_controller) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
+        return;
+    }
+
+    struct GroupStartBody { uint8_t id; uint16_t duration; };
+    static const BodyField fields[] = {
+        BODY_FIELD_INT("id", GroupStartBody, id, true, 0, MAX_GROUPS - 1),
+        BODY_FIELD_INT("duration", GroupStartBody, duration, false, MIN_DURATION_MINUTES, MAX_DURATION_MINUTES),
+    };
+    GroupStartBody body = { 0, DEFAULT_DURATION_MINUTES };
+    if (!parseBody(fields, &body)) return;
+    uint8_t id = body.id;
+    uint16_t duration = body.duration;
+
+    if (!_controller->getGroup(id).enabled) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid group\"}");
+        return;
+    }
+
+    _controller->startGroup(id, duration);
+    DEBUG_PRINTF("WebAPIHandler: Manual start group %d for %d min\n", id, duration);
+    if (_ha) {
+        _ha->publishChannelStates();
+        _ha->publishIndividualStatus();
+        _ha->publishState();
+    }
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Group started\"}");
+}
+
+void WebAPIHandler::handlePostGroupStop() {
+    if (!_controller) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
+        return;
+    }
+
+    static const BodyField fields[] = {
+        BODY_FIELD_SCALAR("id", BODY_INT, uint8_t, true, 0, MAX_GROUPS - 1),
+    };
+    uint8_t id = 0;
+    if (!parseBody(fields, &id)) return;
+    if (!_controller->getGroup(id).enabled) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid group\"}");
+        return;
+    }
+
+    _controller->stopGroup(id);
+    DEBUG_PRINTF("WebAPIHandler: Manual stop group %d\n", id);
+    if (_ha) {
+        _ha->publishChannelStates();
+        _ha->publishIndividualStatus();
+        _ha->publishState();
+    }
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Group stopped\"}");
+}
+
+// ================================================================
+// Soil-moisture sensors and closed-loop zones
+// ================================================================
+
+void WebAPIHandler::handleGetSensors() {
+    ArenaJsonDocument doc(2048);
+    doc["success"] = true;
+
+    // Local probes (sensor node)
+    if (_soil) {
+        JsonObject local = doc.createNestedObject("local");
+        if (_soil->hasTemperature()) local["temperature"] = _soil->getTemperature();
+        JsonArray probes = local.createNestedArray("probes");
+        for (uint8_t p = 1; p <= _soil->getProbeCount(); p++) {
+            JsonObject probe = probes.createNestedObject();
+            probe["probe"] = p;
+            probe["valid"] = _soil->isValid(p);
+            probe["moisture"] = _soil->getMoisture(p);
+            probe["raw_mv"] = _soil->getRawMilliVolts(p);
+            probe["dry_mv"] = _soil->getDryMilliVolts(p);
+            probe["wet_mv"] = _soil->getWetMilliVolts(p);
+        }
+    }
+
+    // Paired sensor nodes (master)
+    if (_nm) {
+        JsonArray nodes = doc.createNestedArray("nodes");
+        unsigned long now = millis();
+        for (uint8_t i = 0; i < _nm->getSensorCount(); i++) {
+            const SensorPeer* sensor = _nm->getSensor(i);
+            if (!sensor) continue;
+            JsonObject node = nodes.createNestedObject();
+            node["node_id"] = sensor->node_id;
+            node["name"] = sensor->name;
+            node["online"] = sensor->online;
+            if (sensor->has_temperature) node["temperature"] = sensor->temperature;
+            JsonArray probes = node.createNestedArray("probes");
+            for (uint8_t p = 0; p < sensor->num_probes && p < SENSOR_MAX_PROBES; p++) {
+                JsonObject probe = probes.createNestedObject();
+                probe["probe"] = p + 1;
+                if (sensor->reading_at[p] == 0) continue;
+                probe["moisture"] = sensor->moisture[p];
+                probe["age"] = (now - sensor->reading_at[p]) / 1000;
+            }
+        }
+    }
+
+    sendDocument(doc);
+}
+
+void WebAPIHandler::handlePostSensorCalibrate() {
+    if (!_soil) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"No soil sensor on this node\"}");
+        return;
+    }
+
+    struct CalibrateBody { uint8_t probe; uint16_t dryMv, wetMv; char capture[4]; };
+    static const BodyField fields[] = {
+        BODY_FIELD_INT("probe", CalibrateBody, probe, true, 1, SENSOR_MAX_PROBES),
+        BODY_FIELD_INT("dry_mv", CalibrateBody, dryMv, false, 0, 3300),
+        BODY_FIELD_INT("wet_mv", CalibrateBody, wetMv, false, 0, 3300),
+        BODY_FIELD_STR("capture", CalibrateBody, capture, false, 0),
+    };
+    CalibrateBody body = {};
+    uint32_t present;
+    if (!parseBody(fields, &body, &present)) return;
+
+    uint8_t probe = body.probe;
+    uint16_t dryMv = (present & (1UL << 1)) ? body.dryMv : _soil->getDryMilliVolts(probe);
+    uint16_t wetMv = (present & (1UL << 2)) ? body.wetMv : _soil->getWetMilliVolts(probe);
+
+    // "capture": "dry" or "wet" takes the probe's current reading as that point
+    const char* capture = body.capture;
+    if (strcmp(capture, "dry") == 0) dryMv = _soil->getRawMilliVolts(probe);
+    if (strcmp(capture, "wet") == 0) wetMv = _soil->getRawMilliVolts(probe);
+
+    if (!_soil->setCalibration(probe, dryMv, wetMv)) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid calibration\"}");
+        return;
+    }
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Calibration saved\"}");
+}
+
+void WebAPIHandler::handleGetChannelMoisture() {
+    if (!_controller) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
+        return;
+    }
+
+    ArenaJsonDocument doc(2048);
+    doc["success"] = true;
+    JsonArray array = doc.createNestedArray("loops");
+
+    for (uint8_t ch = 1; ch <= MAX_CHANNELS; ch++) {
+        MoistureLoop loop = _controller->getMoistureLoop(ch);
+        if (!loop.enabled) continue;
+        JsonObject entry = array.createNestedObject();
+        entry["channel"] = ch;
+        entry["sensor"] = loop.sensorId;
+        entry["probe"] = loop.probe;
+        entry["start_below"] = loop.startBelow;
+        entry["stop_at"] = loop.stopAt;
+        float moisture;
+        if (_controller->getChannelMoisture(ch, moisture)) {
+            entry["moisture"] = moisture;
+        }
+    }
+
+    sendDocument(doc);
+}
+
+void WebAPIHandler::handlePostChannelMoisture() {
+    if (!_controller) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Controller not ready\"}");
+        return;
+    }
+
+    // Fills the MoistureLoop in place; the controller checks the band
+    struct MoistureBody { uint8_t channel; MoistureLoop loop; };
+    static const BodyField fields[] = {
+        BODY_FIELD_INT("channel", MoistureBody, channel, true, 1, MAX_CHANNELS),
+        BODY_FIELD_BOOL("enabled", MoistureBody, loop.enabled, false),
+        BODY_FIELD_STR("sensor", MoistureBody, loop.sensorId, false, 0),
+        BODY_FIELD_INT("probe", MoistureBody, loop.probe, false, 1, SENSOR_MAX_PROBES),
+        BODY_FIELD_INT("start_below", MoistureBody, loop.startBelow, false, 0, 100),
+        BODY_FIELD_INT("stop_at", MoistureBody, loop.stopAt, false, 0, 100),
+    };
+    MoistureBody body = {};
+    body.loop.enabled = true;
+    body.loop.probe = 1;
+    if (!parseBody(fields, &body)) return;
+
+    if (!_controller->setMoistureLoop(body.channel, body.loop)) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid closed-loop settings (start_below must be below stop_at)\"}");
+        return;
+    }
+
+    // A remote zone's schedules move between the slave and the master
+    if (_nm && body.channel > NUM_LOCAL_CHANNELS) {
+        for (uint8_t s = 0; s < _nm->getSlaveCount(); s++) {
+            const NodePeer* slave = _nm->getSlave(s);
+            if (slave && body.channel >= slave->base_virtual_ch &&
+                body.channel < slave->base_virtual_ch + slave->num_channels) {
+                _nm->sendScheduleSync(slave->node_id);
+                break;
+            }
+        }
+    }
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Closed-loop settings updated\"}");
+}
+
+// ================================================================
+// Mainline pressure monitoring
+// ================================================================
+
+void WebAPIHandler::handleGetPressure() {
+    if (!_pressure) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"No pressure sensor on this node\"}");
+        return;
+    }
+
+    const PressureDetector& detector = _pressure->getDetector();
+    ArenaJsonDocument doc(1024);
+    doc["success"] = true;
+    doc["sensor_ok"] = _pressure->isSensorOk();
+    doc["pressure"] = _pressure->getPressure();
+    doc["settled"] = detector.isSettled();
+
+    uint8_t alarm = _pressure->getAlarm();
+    doc["alarm"] = (alarm == PRESSURE_EVENT_BURST) ? "burst" :
+                   (alarm == PRESSURE_EVENT_LEAK) ? "leak" : "none";
+    JsonArray zones = doc.createNestedArray("alarm_zones");
+    for (uint8_t ch = 1; ch <= NUM_LOCAL_CHANNELS; ch++) {
+        if (_pressure->getAlarmZones() & (1UL << (ch - 1))) zones.add(ch);
+    }
+
+    JsonObject baselines = doc.createNestedObject("baselines");
+    baselines["static"] = detector.getStaticBaseline();
+    JsonArray zoneBaselines = baselines.createNestedArray("zones");
+    for (uint8_t ch = 1; ch <= NUM_LOCAL_CHANNELS; ch++) {
+        zoneBaselines.add(detector.getZoneBaseline(ch));
+    }
+
+    sendDocument(doc);
+}
+
+void WebAPIHandler::handlePostPressureClear() {
+    if (!_pressure) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"No pressure sensor on this node\"}");
+        return;
+    }
+
+    _pressure->clearAlarm();
+    if (_ha) _ha->publishPressure();
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Pressure alarm cleared\"}");
+}
+
+// ================================================================
+// Local automation rules
+// ================================================================
+
+void WebAPIHandler::handleGetRules() {
+    if (!_automation) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Rules not available on this node\"}");
+        return;
+    }
+
+    const RuleEngine& engine = _automation->getEngine();
+    ArenaJsonDocument doc(4096);
+    doc["success"] = true;
+    doc["passes"] = engine.getPasses();
+    doc["deferrals"] = engine.getDeferrals();
+    doc["budget"] = RULE_TICK_BUDGET;
+
+    JsonArray rules = doc.createNestedArray("rules");
+    for (uint8_t i = 0; i < engine.getRuleCount(); i++) {
+        const Rule* rule = engine.getRule(i);
+        JsonObject entry = rules.createNestedObject();
+        entry["id"] = i;
+        entry["name"] = rule->name;
+        entry["when"] = rule->when;
+        entry["then"] = rule->then;
+        entry["enabled"] = rule->enabled;
+        entry["active"] = rule->active;
+        entry["code_bytes"] = rule->codeLen;      // Worst-case instructions per evaluation
+        entry["last_steps"] = rule->lastSteps;
+        entry["evaluations"] = rule->evaluations;
+        entry["fired"] = rule->fired;
+    }
+
+    sendDocument(doc);
+}
+
+void WebAPIHandler::handlePostRule() {
+    if (!_automation) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Rules not available on this node\"}");
+        return;
+    }
+
+    // Sized like the Rule fields, so an over-long source is refused here
+    struct RuleBody {
+        char name[RULE_NAME_LEN];
+        char when[RULE_WHEN_LEN];
+        char then[RULE_THEN_LEN];
+        bool enabled;
+        int8_t id;
+    };
+    static const BodyField fields[] = {
+        BODY_FIELD_STR("name", RuleBody, name, false, 0),
+        BODY_FIELD_STR("when", RuleBody, when, false, 0),
+        BODY_FIELD_STR("then", RuleBody, then, false, 0),
+        BODY_FIELD_BOOL("enabled", RuleBody, enabled, false),
+        BODY_FIELD_INT("id", RuleBody, id, false, -1, RULE_MAX_RULES - 1),
+    };
+    RuleBody body = {};
+    body.enabled = true;
+    body.id = -1;
+    if (!parseBody(fields, &body)) return;
+
+    const char* name = body.name;
+    const char* when = body.when;
+    const char* then = body.then;
+    bool enabled = body.enabled;
+    int16_t editId = body.id;
+
+    // Compile errors go back to the caller with the position they refer to
+    char compileError[RULE_ERROR_LEN];
+    int8_t index;
+    if (editId >= 0) {
+        index = _automation->replaceRule((uint8_t)editId, name, when, then, enabled, compileError) ? editId : -1;
+    } else {
+        index = _automation->addRule(name, when, then, enabled, compileError);
+    }
+    if (index < 0) {
+        StaticJsonDocument<128> reply;
+        reply["success"] = false;
+        reply["message"] = compileError;
+        sendDocument(reply, 400);
+        return;
+    }
+
+    const Rule* rule = _automation->getEngine().getRule(index);
+    _server->send(200, "application/json",
+        "{\"success\":true,\"message\":\"Rule saved\",\"id\":" + String(index) +
+        ",\"code_bytes\":" + String(rule ? rule->codeLen : 0) + "}");
+}
+
+void WebAPIHandler::handleDeleteRule() {
+    if (!_automation) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Rules not available on this node\"}");
+        return;
+    }
+
+    if (!_server->hasArg("id")) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Missing rule id\"}");
+        return;
+    }
+
+    if (!_automation->removeRule(_server->arg("id").toInt())) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid rule id\"}");
+        return;
+    }
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Rule deleted\"}");
+}
+
+// ================================================================
+// Metrics
+// ================================================================
+
+// Percentiles since boot or the last ?reset=1 (applied after reading, so a
+// load run can read and restart the window in one request)
+void WebAPIHandler::handleGetMetrics() {
+    ArenaJsonDocument doc(1536);
+    doc["success"] = true;
+    doc["uptime_s"] = millis() / 1000;
+
+    JsonObject req = doc.createNestedObject("requests");
+    req["count"] = _requestLatency.getCount();
+    req["p50_us"] = _requestLatency.percentile(50);
+    req["p99_us"] = _requestLatency.percentile(99);
+    req["max_us"] = _requestLatency.getMax();
+    req["mean_us"] = _requestLatency.getMean();
+
+    JsonObject loop = doc.createNestedObject("loop");
+    loop["count"] = loopLatency.getCount();
+    loop["p50_us"] = loopLatency.percentile(50);
+    loop["p99_us"] = loopLatency.percentile(99);
+    loop["max_us"] = loopLatency.getMax();
+
+    if (_ha) {
+        const MqttCommandStats& stats = _ha->getCommandStats();
+        const LatencyStats& latency = _ha->getCommandLatency();
+        JsonObject mqtt = doc.createNestedObject("mqtt");
+        mqtt["connected"] = _ha->isConnected();
+        mqtt["received"] = stats.received;
+        mqtt["coalesced"] = stats.coalesced;
+        mqtt["dropped"] = stats.dropped;
+        mqtt["processed"] = stats.processed;
+        mqtt["state_flushes"] = stats.stateFlushes;
+        mqtt["p50_us"] = latency.percentile(50);       // Receive to state publish
+        mqtt["p99_us"] = latency.percentile(99);
+        mqtt["max_us"] = latency.getMax();
+
+        const MqttConnectionStats& conn = _ha->getConnectionStats();
+        mqtt["tls"] = _ha->getMqttTls();
+        mqtt["connects"] = conn.connects;
+        mqtt["connect_failures"] = conn.failures;
+        mqtt["connect_ms"] = conn.lastConnectMs;
+        mqtt["handshake_ms"] = conn.lastHandshakeMs;
+        mqtt["tls_resumed"] = conn.resumed;
+        mqtt["tls_heap"] = conn.tlsHeap;
+        mqtt["tls_pool_peak"] = conn.tlsPoolPeak;
+    }
+
+    JsonObject boot = doc.createNestedObject("boot");
+    boot["reset_reason"] = crashLog.getResetReason();
+    boot["boots"] = crashLog.getBootCount();        // Since power-on
+    boot["crashes"] = crashLog.getCrashCount();
+    boot["coredump"] = crashLog.getCoreDump().present;
+
+    JsonObject arena = doc.createNestedObject("json");
+    arena["arena"] = jsonArena.getCapacity();
+    arena["used"] = jsonArena.getUsed();
+    arena["high_water"] = jsonArena.getHighWater();
+    arena["allocations"] = jsonArena.getAllocations();
+    arena["heap_fallbacks"] = jsonArena.getFallbacks();  // Did not fit in the arena
+
+    JsonObject msgpack = doc.createNestedObject("msgpack");
+    msgpack["responses"] = _msgpackResponses;
+    msgpack["bytes"] = _msgpackBytes;
+    msgpack["json_bytes"] = _msgpackJsonBytes;   // Same documents as JSON
+
+    JsonObject gzip = doc.createNestedObject("gzip");
+    gzip["responses"] = _gzipResponses;
+    gzip["in_bytes"] = _gzipInBytes;
+    gzip["out_bytes"] = _gzipOutBytes;
+    gzip["cpu_us"] = _gzipMicros;                // Encoder time, sends excluded
+
+    JsonObject heap = doc.createNestedObject("heap");
+    heap["free"] = ESP.getFreeHeap();
+    heap["min_free"] = ESP.getMinFreeHeap();       // Low-water mark since boot
+    heap["max_alloc"] = ESP.getMaxAllocHeap();     // Largest free block
+
+    sendDocument(doc);
+
+    if (_server->hasArg("reset") && _server->arg("reset") == "1") {
+        _requestLatency.reset();
+        loopLatency.reset();
+        jsonArena.resetStats();
+        _msgpackResponses = 0;
+        _msgpackBytes = 0;
+        _msgpackJsonBytes = 0;
+        _gzipResponses = 0;
+        _gzipInBytes = 0;
+        _gzipOutBytes = 0;
+        _gzipMicros = 0;
+        if (_ha) _ha->resetCommandStats();
+    }
+}
+
+// ================================================================
+// Post-mortem
+// ================================================================
+
+// Why the controller last reset, the serial tail of the boot that crashed
+// (saved from RTC RAM on the next boot) and a summary of the core dump.
+// crash_decode.py turns this and /api/crash/coredump into a backtrace.
+void WebAPIHandler::handleGetCrash() {
+    ArenaJsonDocument doc(CRASH_LOG_SIZE + 1024);
+    doc["success"] = true;
+    doc["node_id"] = nodeId;
+    doc["version"] = VERSION;
+    doc["reset_reason"] = crashLog.getResetReason();
+    doc["boots"] = crashLog.getBootCount();
+    doc["crashes"] = crashLog.getCrashCount();
+    doc["uptime_s"] = millis() / 1000;
+
+    if (LittleFS.exists(CRASH_FILE)) {
+        File file = LittleFS.open(CRASH_FILE, "r");
+        if (file) {
+            ArenaJsonDocument last(CRASH_LOG_SIZE + 256);
+            if (!deserializeJson(last, file) && last.containsKey("reason")) {
+                last.remove("crashes");
+                doc["last"] = last;
+            }
+            file.close();
+        }
+    }
+
+    const CoreDumpSummary& dump = crashLog.getCoreDump();
+    if (dump.present) {
+        JsonObject cd = doc.createNestedObject("coredump");
+        cd["size"] = dump.size;
+        cd["task"] = dump.task;
+        char hex[11];
+        snprintf(hex, sizeof(hex), "0x%08lx", (unsigned long)dump.pc);
+        cd["pc"] = hex;
+        JsonArray bt = cd.createNestedArray("backtrace");
+        for (uint8_t i = 0; i < dump.depth; i++) {
+            snprintf(hex, sizeof(hex), "0x%08lx", (unsigned long)dump.backtrace[i]);
+            bt.add(hex);
+        }
+        if (dump.corrupted) cd["corrupted"] = true;
+        cd["app_sha"] = dump.appSha;
+    } else {
+        doc["coredump"] = nullptr;
+    }
+
+    sendDocument(doc);
+}
+
+// Raw image as espcoredump.py expects it (-t raw)
+void WebAPIHandler::handleGetCrashCoreDump() {
+    const CoreDumpSummary& dump = crashLog.getCoreDump();
+    if (!dump.present) {
+        _server->send(404, "application/json", "{\"success\":false,\"message\":\"No core dump\"}");
+        return;
+    }
+
+    char disposition[64];
+    snprintf(disposition, sizeof(disposition), "attachment; filename=\"%s-coredump.bin\"", nodeId.c_str());
+    _server->sendHeader("Content-Disposition", disposition);
+    _server->setContentLength(dump.size);
+    _server->send(200, "application/octet-stream", "");
+
+    uint8_t buf[1024];
+    for (uint32_t offset = 0; offset < dump.size; offset += sizeof(buf)) {
+        size_t n = dump.size - offset < sizeof(buf) ? dump.size - offset : sizeof(buf);
+        if (!crashLog.readCoreDump(offset, buf, n)) break;
+        _server->sendContent((const char*)buf, n);
+    }
+}
+
+void WebAPIHandler::handleDeleteCrash() {
+    crashLog.clear();
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Crash data cleared\"}");
+}
+
+// ================================================================
+// Node pairing API endpoints
+// ================================================================
+
+void WebAPIHandler::handleGetNodesPending() {
+    if (notModified("p", _nm ? _nm->getPeerGeneration() : 0, 0)) {
+        return;
+    }
+
+    ArenaJsonDocument doc(1024);
+    doc["success"] = true;
+
+    if (_nm) {
+        // Pending pair request
+        if (_nm->hasPendingPair()) {
+            const PendingPairRequest& req = _nm->getPendingPair();
+            JsonObject pending = doc.createNestedObject("pending");
+            pending["node_id"] = req.node_id;
+            pending["name"] = req.name;
+            pending["num_channels"] = req.num_channels;
+            pending["sensor"] = (req.role == NODE_ROLE_SENSOR);
+            pending["ip"] = req.ip.toString();
+        }
+
+        // Paired slaves
+        JsonArray slaves = doc.createNestedArray("slaves");
+        for (uint8_t i = 0; i < _nm->getSlaveCount(); i++) {
+            const NodePeer* peer = _nm->getSlave(i);
+            if (!peer) continue;
+            JsonObject s = slaves.createNestedObject();
+            s["node_id"] = peer->node_id;
+            s["name"] = peer->name;
+            s["virtual_channel"] = peer->base_virtual_ch;
+            s["num_channels"] = peer->num_channels;
+            s["online"] = peer->online;
+            s["rssi"] = peer->rssi;
+            s["pending_cmds"] = _nm->getStoredCommandCount(peer->node_id);
+            s["divergences"] = peer->divergences;
+        }
+
+        // Paired sensor nodes
+        JsonArray sensors = doc.createNestedArray("sensors");
+        for (uint8_t i = 0; i < _nm->getSensorCount(); i++) {
+            const SensorPeer* sensor = _nm->getSensor(i);
+            if (!sensor) continue;
+            JsonObject s = sensors.createNestedObject();
+            s["node_id"] = sensor->node_id;
+            s["name"] = sensor->name;
+            s["num_probes"] = sensor->num_probes;
+            s["online"] = sensor->online;
+        }
+    }
+
+    sendDocument(doc);
+}
+
+// Per-slave link quality: loss, retransmits, round trips, RSSI, reboots
+void WebAPIHandler::handleGetNodesHealth() {
+    if (!_nm) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
         return;
     }
 
-    const char* reqNodeId = reqDoc["node_id"] | "";
-    if (strlen(reqNodeId) == 0) {
-        _server->send(400, "application/json", "{\"success\":false,\"message\":\"node_id required\"}");
+    ArenaJsonDocument doc(4096);
+    doc["success"] = true;
+    JsonArray nodes = doc.createNestedArray("nodes");
+    unsigned long now = millis();
+
+    for (uint8_t i = 0; i < _nm->getSlaveCount(); i++) {
+        const NodePeer* peer = _nm->getSlave(i);
+        LinkHealth health;
+        if (!peer || !_nm->getLinkHealth(i, health)) continue;
+        const LinkStats& link = peer->link;
+
+        JsonObject n = nodes.createNestedObject();
+        n["node_id"] = peer->node_id;
+        n["name"] = peer->name;
+        n["online"] = peer->online;
+        n["last_seen_s"] = peer->last_seen ? (now - peer->last_seen) / 1000 : 0;
+        n["uptime"] = link.uptime;
+        n["reboots"] = link.reboots;
+        n["heartbeat_s"] = peer->hb_interval / 1000;
+        if (peer->online) {
+            long left = (long)(peer->heard_by - now);
+            n["expected_within_s"] = (left > 0) ? left / 1000 : 0;
+        }
+
+        JsonObject frames = n.createNestedObject("frames");
+        frames["received"] = link.rx_total;
+        frames["lost"] = link.lost_total;
+        frames["loss_pct"] = health.loss_pct;
+
+        JsonObject cmds = n.createNestedObject("commands");
+        cmds["sent"] = link.cmds_sent;
+        cmds["retransmits"] = link.retransmits;
+        cmds["dropped"] = link.cmds_dropped;
+        cmds["retransmit_pct"] = health.retransmit_pct;
+        cmds["pending"] = _nm->getStoredCommandCount(peer->node_id);
+
+        JsonObject rtt = n.createNestedObject("rtt_ms");
+        rtt["samples"] = health.rtt_samples;
+        if (health.rtt_samples > 0) {
+            rtt["min"] = health.rtt_min;
+            rtt["p50"] = health.rtt_p50;
+            rtt["p90"] = health.rtt_p90;
+            rtt["max"] = health.rtt_max;
+        }
+
+        JsonObject rssi = n.createNestedObject("rssi");
+        rssi["last"] = peer->rssi;
+        if (health.rssi_samples > 0) {
+            rssi["min"] = health.rssi_min;
+            rssi["avg"] = health.rssi_avg;
+        }
+
+        n["divergences"] = peer->divergences;
+    }
+
+    sendDocument(doc);
+}
+
+void WebAPIHandler::handlePostNodesAccept() {
+    if (!_nm) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
         return;
     }
+    if (!_nm->hasPendingPair()) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"No pending pair request\"}");
+        return;
+    }
+    _nm->acceptPendingPair();
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Pair accepted\"}");
+}
+
+void WebAPIHandler::handlePostNodesReject() {
+    if (!_nm) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
+        return;
+    }
+    if (!_nm->hasPendingPair()) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"No pending pair request\"}");
+        return;
+    }
+    _nm->rejectPendingPair(PAIR_REJECT_USER);
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Pair rejected\"}");
+}
+
+void WebAPIHandler::handlePostNodesRename() {
+    if (!_nm) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
+        return;
+    }
+
+    struct RenameBody { char nodeId[12]; char name[16]; };
+    static const BodyField fields[] = {
+        BODY_FIELD_STR("node_id", RenameBody, nodeId, true, 1),
+        BODY_FIELD_STR("name", RenameBody, name, true, 1),
+    };
+    RenameBody body;
+    if (!parseBody(fields, &body)) return;
+
+    if (_nm->renameSlave(body.nodeId, body.name)) {
+        _server->send(200, "application/json", "{\"success\":true,\"message\":\"Slave renamed\"}");
+    } else {
+        _server->send(404, "application/json", "{\"success\":false,\"message\":\"Slave not found\"}");
+    }
+}
+
+void WebAPIHandler::handlePostNodesUnpair() {
+    if (!_nm) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
+        return;
+    }
+
+    static const BodyField fields[] = {
+        BODY_FIELD_SCALAR("node_id", BODY_STR, char[12], true, 1, 0),
+    };
+    char reqNodeId[12];
+    if (!parseBody(fields, reqNodeId)) return;
 
     if (_nm->unpairSlave(reqNodeId)) {
         // Refresh HA discovery to remove stale channel entities
@@ -648,22 +1789,144 @@ void WebAPIHandler::handlePostNodesUnpair() {
     }
 }
 
+static const char* runEndReason(uint8_t reason) {
+    switch (reason) {
+        case RUN_END_COMPLETE: return "complete";
+        case RUN_END_STOPPED:  return "stopped";
+        case RUN_END_SAFETY:   return "safety";
+        case RUN_END_FAULT:    return "fault";
+        case RUN_END_MOISTURE: return "moisture";
+        default:               return "unknown";
+    }
+}
+
+// Fleet run history in time order: ?since=<epoch> keeps runs that started at
+// or after it, ?channel=N one channel, ?limit=N the newest N that match.
+// Runs of remote channels come from the slave's journal, so they include
+// runs made while the slave was cut off from the master.
+void WebAPIHandler::handleGetRuns() {
+    if (!_nm) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"NodeManager not available\"}");
+        return;
+    }
+
+    uint32_t since = _server->hasArg("since") ? (uint32_t)_server->arg("since").toInt() : 0;
+    uint8_t channel = _server->hasArg("channel") ? (uint8_t)_server->arg("channel").toInt() : 0;
+    long limit = _server->hasArg("limit") ? _server->arg("limit").toInt() : RUN_HISTORY_SIZE;
+    if (limit < 1) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"limit must be at least 1\"}");
+        return;
+    }
+
+    const RunHistory& history = _nm->getRunHistory();
+    if (notModified("r", history.getGeneration(), 0)) {
+        return;
+    }
+
+    // Walk back from the newest run to find where the newest `limit` matches begin
+    uint8_t first = history.getCount();
+    long matched = 0;
+    while (first > 0 && matched < limit) {
+        const RunRecord& run = history.at(first - 1);
+        if (run.start < since) break;
+        first--;
+        if (channel == 0 || run.channel == channel) matched++;
+    }
+
+    beginChunked("application/json");
+
+    String chunk = "{\"success\":true,\"runs\":[";
+    bool firstOut = true;
+    for (uint8_t i = first; i < history.getCount(); i++) {
+        const RunRecord& run = history.at(i);
+        if (channel != 0 && run.channel != channel) continue;
+
+        StaticJsonDocument<256> doc;
+        doc["channel"] = run.channel;
+        if (run.channel <= NUM_LOCAL_CHANNELS) {
+            doc["node"] = nodeId;
+        } else {
+            for (uint8_t s = 0; s < _nm->getSlaveCount(); s++) {
+                const NodePeer* slave = _nm->getSlave(s);
+                if (slave && run.channel >= slave->base_virtual_ch &&
+                    run.channel < slave->base_virtual_ch + slave->num_channels) {
+                    doc["node"] = slave->name[0] ? slave->name : slave->node_id;
+                    break;
+                }
+            }
+        }
+        doc["start"] = (unsigned long)run.start;
+        doc["duration_s"] = run.duration_s;
+        if (run.volume_dl != RUN_VOLUME_NONE) {
+            doc["volume_l"] = run.volume_dl / 10.0f;
+        } else {
+            doc["volume_l"] = nullptr;
+        }
+        doc["reason"] = runEndReason(run.reason);
+
+        char buf[256];
+        serializeJson(doc, buf, sizeof(buf));
+        if (!firstOut) chunk += ",";
+        chunk += buf;
+        firstOut = false;
+
+        if (chunk.length() >= 1024) {
+            sendChunk(chunk);
+            chunk = "";
+        }
+    }
+    chunk += "]}";
+    endChunked(chunk);
+}
+
 // ================================================================
 // MQTT configuration
 // ================================================================
 
+// Certificate SHA-256 as 64 hex digits; ':' and ' ' separators are dropped.
+// An empty fingerprint is valid (no pinning).
+static bool normalizeFingerprint(String& fingerprint) {
+    String hex;
+    for (size_t i = 0; i < fingerprint.length(); i++) {
+        char c = fingerprint[i];
+        if (c == ':' || c == ' ') continue;
+        if (!isxdigit((unsigned char)c)) return false;
+        hex += (char)tolower((unsigned char)c);
+    }
+    if (hex.length() != 0 && hex.length() != 64) return false;
+    fingerprint = hex;
+    return true;
+}
+
 void WebAPIHandler::handlePostMqttSave() {
+    bool tls = _server->hasArg("tls") && _server->arg("tls") == "1";
     String broker = _server->hasArg("broker") ? _server->arg("broker") : "";
-    uint16_t port = _server->hasArg("port") ? _server->arg("port").toInt() : 1883;
+    uint16_t port = _server->hasArg("port") ? _server->arg("port").toInt() : (tls ? MQTT_TLS_PORT : 1883);
     String user = _server->hasArg("user") ? _server->arg("user") : "";
     String password = _server->hasArg("password") ? _server->arg("password") : "";
+    String fingerprint = _server->hasArg("fingerprint") ? _server->arg("fingerprint") : "";
+    String ca = _server->hasArg("ca") ? _server->arg("ca") : "";
 
     if (broker.length() == 0) {
         _server->send(400, "application/json", "{\"success\":false,\"message\":\"Broker required\"}");
         return;
     }
+    if (!normalizeFingerprint(fingerprint)) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid fingerprint\"}");
+        return;
+    }
+    if (ca.length() > 0 && (ca.length() > MQTT_CA_MAX_SIZE || ca.indexOf("-----BEGIN CERTIFICATE-----") < 0)) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid CA certificate\"}");
+        return;
+    }
+
+    // A new CA replaces the pinned one; an empty field keeps it
+    if (ca.length() > 0 && !HomeAssistantIntegration::saveCaCert(ca)) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"Failed to save CA certificate\"}");
+        return;
+    }
 
-    if (!HomeAssistantIntegration::saveCredentials(broker, port, user, password)) {
+    if (!HomeAssistantIntegration::saveCredentials(broker, port, user, password, tls, fingerprint)) {
         _server->send(500, "application/json", "{\"success\":false,\"message\":\"Failed to save credentials\"}");
         return;
     }
@@ -671,7 +1934,7 @@ void WebAPIHandler::handlePostMqttSave() {
     // Enable mqtt feature flag and persist to config.json so it survives reboot
     features.mqtt = true;
 
-    StaticJsonDocument<1024> cfgDoc;
+    ArenaJsonDocument cfgDoc(1024);
     File cfgRead = LittleFS.open(CONFIG_FILE, "r");
     if (cfgRead) {
         deserializeJson(cfgDoc, cfgRead);
@@ -695,17 +1958,30 @@ void WebAPIHandler::handlePostMqttSave() {
 }
 
 void WebAPIHandler::handlePostMqttTest() {
+    bool tls = _server->hasArg("tls") && _server->arg("tls") == "1";
     String broker = _server->hasArg("broker") ? _server->arg("broker") : "";
-    uint16_t port = _server->hasArg("port") ? _server->arg("port").toInt() : 1883;
+    uint16_t port = _server->hasArg("port") ? _server->arg("port").toInt() : (tls ? MQTT_TLS_PORT : 1883);
     String user = _server->hasArg("user") ? _server->arg("user") : "";
     String password = _server->hasArg("password") ? _server->arg("password") : "";
+    String fingerprint = _server->hasArg("fingerprint") ? _server->arg("fingerprint") : "";
+    String ca = _server->hasArg("ca") ? _server->arg("ca") : "";
 
     if (broker.length() == 0) {
         _server->send(400, "application/json", "{\"success\":false,\"message\":\"Broker required\"}");
         return;
     }
+    if (!normalizeFingerprint(fingerprint)) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid fingerprint\"}");
+        return;
+    }
+    if (ca.length() > 0 && (ca.length() > MQTT_CA_MAX_SIZE || ca.indexOf("-----BEGIN CERTIFICATE-----") < 0)) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid CA certificate\"}");
+        return;
+    }
 
-    bool success = HomeAssistantIntegration::testConnection(broker, port, user, password);
+    // A CA in the form is tested as it would be saved; an empty field
+    // tests against the one already pinned in flash
+    bool success = HomeAssistantIntegration::testConnection(broker, port, user, password, tls, fingerprint, ca);
 
     if (success) {
         _server->send(200, "application/json", "{\"success\":true,\"message\":\"Connection successful!\"}");
@@ -733,6 +2009,8 @@ void WebAPIHandler::handlePostWifiRemove() {
 void WebAPIHandler::handlePostMqttRemove() {
     DEBUG_PRINTLN("WebAPIHandler: MQTT credentials removal requested via web interface");
 
+    HomeAssistantIntegration::saveCaCert("");
+
     // Remove MQTT credentials file
     if (LittleFS.exists(MQTT_CREDENTIALS_FILE)) {
         if (LittleFS.remove(MQTT_CREDENTIALS_FILE)) {
@@ -740,7 +2018,7 @@ void WebAPIHandler::handlePostMqttRemove() {
 
             // Disable mqtt feature flag in config.json
             features.mqtt = false;
-            StaticJsonDocument<1024> cfgDoc;
+            ArenaJsonDocument cfgDoc(1024);
             File cfgRead = LittleFS.open(CONFIG_FILE, "r");
             if (cfgRead) {
                 deserializeJson(cfgDoc, cfgRead);
@@ -768,10 +2046,11 @@ void WebAPIHandler::handlePostMqttRemove() {
 // ================================================================
 
 void WebAPIHandler::handleGetConfig() {
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
     doc["success"] = true;
     doc["node_id"] = nodeId;
     doc["role"] = nodeRole;
+    doc["timezone"] = timeZone.get();
 
     JsonObject feat = doc.createNestedObject("features");
     feat["multi_node"] = features.multi_node;
@@ -782,9 +2061,7 @@ void WebAPIHandler::handleGetConfig() {
     feat["ota"] = features.ota;
     feat["debug"] = features.debug;
 
-    String json;
-    serializeJson(doc, json);
-    _server->send(200, "application/json", json);
+    sendDocument(doc);
 }
 
 void WebAPIHandler::handlePostConfig() {
@@ -793,13 +2070,19 @@ void WebAPIHandler::handlePostConfig() {
         return;
     }
 
-    StaticJsonDocument<512> doc;
+    ArenaJsonDocument doc(512);
     DeserializationError error = deserializeJson(doc, _server->arg("plain"));
     if (error) {
         _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
         return;
     }
 
+    // Time zone applies immediately; reject it before touching anything else
+    if (doc.containsKey("timezone") && !timeZone.set(doc["timezone"] | "")) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid timezone\"}");
+        return;
+    }
+
     // Update feature flags (only update fields that are present)
     JsonObject feat = doc["features"];
     if (!feat.isNull()) {
@@ -817,9 +2100,10 @@ void WebAPIHandler::handlePostConfig() {
     if (doc.containsKey("role")) nodeRole = doc["role"].as<String>();
 
     // Save to LittleFS
-    StaticJsonDocument<1024> saveDoc;
+    ArenaJsonDocument saveDoc(1024);
     saveDoc["node_id"] = nodeId;
     saveDoc["role"] = nodeRole;
+    saveDoc["timezone"] = timeZone.get();
     JsonObject saveFeat = saveDoc.createNestedObject("features");
     saveFeat["multi_node"] = features.multi_node;
     saveFeat["mqtt"] = features.mqtt;
@@ -850,3 +2134,147 @@ void WebAPIHandler::handlePostSystemRestart() {
     delay(1000);
     ESP.restart();
 }
+
+// ================================================================
+// Firmware updates
+// ================================================================
+
+// Polled while a job runs; the ETag follows the job's status generation
+void WebAPIHandler::handleGetOta() {
+    if (!_wm) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"WiFiManager not available\"}");
+        return;
+    }
+
+    const FirmwareUpdater& updater = _wm->getUpdater();
+    OtaStatus status = updater.getStatus();
+    if (notModified("o", status.generation, updater.isBusy())) return;
+
+    ArenaJsonDocument doc(384);
+    doc["success"] = true;
+    doc["state"] = FirmwareUpdater::stateName(status.state);
+    doc["busy"] = updater.isBusy();
+    doc["progress"] = status.progress;
+    doc["current"] = VERSION;
+    doc["latest"] = status.latest;
+    doc["install"] = status.install;
+    doc["auto_install"] = _wm->getAutoInstall();
+    doc["not_modified"] = status.notModified;   // Last check answered 304
+    if (status.checkedAt) doc["checked_ago_s"] = (millis() - status.checkedAt) / 1000;
+    if (status.state == OTA_FAILED) doc["error"] = status.error;
+    sendDocument(doc);
+}
+
+// {"install": false} only checks; the default installs a newer version
+void WebAPIHandler::handlePostOta() {
+    if (!_wm) {
+        _server->send(500, "application/json", "{\"success\":false,\"message\":\"WiFiManager not available\"}");
+        return;
+    }
+
+    static const BodyField fields[] = {
+        BODY_FIELD_SCALAR("install", BODY_BOOL, bool, false, 0, 1),
+    };
+    bool install = true;
+    if (_server->hasArg("plain") && !parseBody(fields, &install)) return;
+
+    // A slave installs only when the master's rollout orders it, after the
+    // canary and once its valves are closed; checking is still allowed
+    if (install && _nm && _nm->getRole() == NODE_ROLE_SLAVE) {
+        _server->send(409, "application/json", "{\"success\":false,\"message\":\"This node installs through the master's rollout\"}");
+        return;
+    }
+
+    if (!_wm->getUpdater().start(install)) {
+        _server->send(409, "application/json", "{\"success\":false,\"message\":\"Update job already running or not connected\"}");
+        return;
+    }
+    _server->send(202, "application/json", "{\"success\":true,\"message\":\"Update job started\"}");
+}
+
+// Staged rollout over the slaves (master): the plan, each node's progress
+// through it, and why it halted if it did. Not ETag'd: download progress
+// moves without a generation.
+void WebAPIHandler::handleGetRollout() {
+    if (!_nm || _nm->getRole() != NODE_ROLE_MASTER) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Rollouts run on the master\"}");
+        return;
+    }
+
+    const RolloutPlanner& rollout = _nm->getRollout();
+    ArenaJsonDocument doc(2048);
+    doc["success"] = true;
+    doc["state"] = RolloutPlanner::stateName(rollout.getState());
+    doc["target"] = rollout.getTarget();
+    doc["wave"] = rollout.getWave();
+    doc["waves"] = rollout.getWaveCount();
+    if (rollout.getState() == ROLLOUT_HALTED) doc["reason"] = rollout.getReason();
+    doc["master_version"] = VERSION;
+
+    JsonArray nodes = doc.createNestedArray("nodes");
+    for (uint8_t i = 0; i < rollout.getEntryCount(); i++) {
+        const RolloutEntry& entry = rollout.getEntry(i);
+        JsonObject n = nodes.createNestedObject();
+        n["node_id"] = entry.nodeId;
+        n["state"] = RolloutPlanner::nodeStateName(entry.state);
+        if (entry.wave != ROLLOUT_WAVE_NONE) n["wave"] = entry.wave;
+        n["deferred"] = entry.deferred;
+        if (entry.reason[0]) n["reason"] = entry.reason;
+
+        for (uint8_t s = 0; s < _nm->getSlaveCount(); s++) {
+            const NodePeer* peer = _nm->getSlave(s);
+            if (!peer || strcmp(peer->node_id, entry.nodeId) != 0) continue;
+            n["name"] = peer->name;
+            n["version"] = peer->version;
+            if (peer->ota_state == OTA_DOWNLOADING) n["progress"] = peer->ota_progress;
+            break;
+        }
+    }
+
+    sendDocument(doc);
+}
+
+// Rolls out the release the master's last check found. {"canary":"<node_id>"}
+// picks the first node; otherwise it is the first online slave.
+void WebAPIHandler::handlePostRollout() {
+    if (!_nm || _nm->getRole() != NODE_ROLE_MASTER || !_wm) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Rollouts run on the master\"}");
+        return;
+    }
+
+    static const BodyField fields[] = {
+        BODY_FIELD_SCALAR("canary", BODY_STR, char[12], false, 1, 0),
+    };
+    char canary[12] = "";
+    if (_server->hasArg("plain") && !parseBody(fields, canary)) return;
+
+    OtaStatus ota = _wm->getUpdater().getStatus();
+    if (!ota.latest[0]) {
+        _server->send(409, "application/json", "{\"success\":false,\"message\":\"No release known yet; check for updates first\"}");
+        return;
+    }
+    if (_nm->getRollout().isRunning()) {
+        _server->send(409, "application/json", "{\"success\":false,\"message\":\"A rollout is already running\"}");
+        return;
+    }
+    if (!_nm->startRollout(ota.latest, canary)) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Canary must be an online slave that reported an older version\"}");
+        return;
+    }
+    _server->send(202, "application/json", "{\"success\":true,\"message\":\"Rollout started\"}");
+}
+
+// Nodes already installing finish; nothing further is ordered, and the
+// release is not rolled out again automatically
+void WebAPIHandler::handlePostRolloutAbort() {
+    if (!_nm || _nm->getRole() != NODE_ROLE_MASTER) {
+        _server->send(400, "application/json", "{\"success\":false,\"message\":\"Rollouts run on the master\"}");
+        return;
+    }
+    if (!_nm->getRollout().isRunning()) {
+        _server->send(409, "application/json", "{\"success\":false,\"message\":\"No rollout running\"}");
+        return;
+    }
+    _nm->abortRollout();
+    _server->send(200, "application/json", "{\"success\":true,\"message\":\"Rollout halted\"}");
+}
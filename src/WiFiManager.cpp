@@ -2,6 +2,7 @@
 #include "IrrigationController.h"
 #include "HomeAssistantIntegration.h"
 #include "NodeManager.h"
+#include "TimeZone.h"
 
 WiFiManager::WiFiManager(IrrigationController* controller,
                          HomeAssistantIntegration* ha,
@@ -11,6 +12,7 @@ WiFiManager::WiFiManager(IrrigationController* controller,
       _lastReconnectAttempt(0),
       _lastTimeSync(0),
       _lastUpdateCheck(0),
+      _autoInstall(true),
       _reconnectRetries(0),
       _ntpUDP(nullptr),
       _ntpClient(nullptr),
@@ -67,9 +69,8 @@ bool WiFiManager::begin(const char* ssid, const char* password) {
 
             // Initialize NTP client
             _ntpUDP = new WiFiUDP();
-            _ntpClient = new NTPClient(*_ntpUDP, NTP_SERVER,
-                                       TIMEZONE_OFFSET * 3600 + DAYLIGHT_OFFSET,
-                                       NTP_UPDATE_INTERVAL);
+            // Epochs stay in UTC; timeZone converts to local time
+            _ntpClient = new NTPClient(*_ntpUDP, NTP_SERVER, 0, NTP_UPDATE_INTERVAL);
             _ntpClient->begin();
 
             // Start web server for status page
@@ -77,6 +78,7 @@ bool WiFiManager::begin(const char* ssid, const char* password) {
 
             // Check for firmware updates on startup
             DEBUG_PRINTLN("WiFiManager: Checking for firmware updates on startup...");
+            _updater.begin();
             checkForUpdates();
 
             DEBUG_PRINTLN("WiFiManager: Initialized");
@@ -544,7 +546,7 @@ String WiFiManager::scanNetworks() {
 
     int n = WiFi.scanNetworks();
 
-    DynamicJsonDocument doc(2048);
+    ArenaJsonDocument doc(2048);
     JsonArray networks = doc.createNestedArray("networks");
 
     for (int i = 0; i < n; i++) {
@@ -605,6 +607,9 @@ void WiFiManager::setupOTA() {
 void WiFiManager::update() {
     unsigned long currentMillis = millis();
 
+    // Restart once a background install has finished, connected or not
+    _updater.update();
+
     // Handle DNS server and web server in config mode
     if (_configMode) {
         if (_dnsServer) {
@@ -695,10 +700,10 @@ void WiFiManager::syncTime() {
         DEBUG_PRINTF("WiFiManager: Time synced successfully: %lu\n", currentTime);
 
         // Print formatted time for debugging
-        struct tm timeinfo;
-        localtime_r(&currentTime, &timeinfo);
-        DEBUG_PRINTF("WiFiManager: Current time: %02d:%02d:%02d\n",
-                     timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+        LocalTime local;
+        timeZone.toLocal(currentTime, local);
+        DEBUG_PRINTF("WiFiManager: Current time: %02d:%02d:%02d (%s)\n",
+                     local.hour, local.minute, local.second, timeZone.get());
 
         // Call callback if set
         if (_timeUpdateCallback) {
@@ -722,185 +727,14 @@ time_t WiFiManager::getCurrentTime() {
     return 0;
 }
 
+// Starts a background check that installs a newer version if there is one
+// (or only reports it, without auto-install)
 void WiFiManager::checkForUpdates() {
-    if (!isConnected()) {
-        DEBUG_PRINTLN("WiFiManager: Not connected, skipping update check");
-        return;
-    }
-
-    DEBUG_PRINTLN("WiFiManager: Checking for firmware updates...");
-
-    String latestVersion;
-    if (checkGitHubVersion(latestVersion)) {
-        DEBUG_PRINTF("WiFiManager: Latest version: %s, Current: %s\n",
-                     latestVersion.c_str(), VERSION);
-
-        if (latestVersion != String(VERSION)) {
-            DEBUG_PRINTLN("WiFiManager: New version available! Starting update...");
-            performOTA();
-        } else {
-            DEBUG_PRINTLN("WiFiManager: Firmware is up to date");
-        }
-    } else {
-        DEBUG_PRINTLN("WiFiManager: Failed to check for updates");
-    }
-}
-
-bool WiFiManager::checkGitHubVersion(String& latestVersion) {
-    HTTPClient http;
-    WiFiClientSecure client;
-    client.setInsecure();  // Skip cert validation for GitHub
-
-    // Build GitHub URL for version file
-    String url = "https://raw.githubusercontent.com/";
-    url += GITHUB_REPO_OWNER;
-    url += "/";
-    url += GITHUB_REPO_NAME;
-    url += "/main/";
-    url += GITHUB_VERSION_PATH;
-
-    DEBUG_PRINTF("WiFiManager: Checking version at: %s\n", url.c_str());
-
-    http.begin(client, url);
-    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    int httpCode = http.GET();
-
-    if (httpCode == HTTP_CODE_OK) {
-        latestVersion = http.getString();
-        latestVersion.trim();
-        http.end();
-        return true;
-    } else {
-        DEBUG_PRINTF("WiFiManager: HTTP GET failed, error: %s\n",
-                     http.errorToString(httpCode).c_str());
-        http.end();
-        return false;
-    }
-}
-
-void WiFiManager::performOTA() {
-    if (!isConnected()) {
-        DEBUG_PRINTLN("WiFiManager: Not connected, cannot perform OTA");
-        return;
-    }
-
-    // Build GitHub URL for firmware binary
-    String url = "https://raw.githubusercontent.com/";
-    url += GITHUB_REPO_OWNER;
-    url += "/";
-    url += GITHUB_REPO_NAME;
-    url += "/main/";
-    url += GITHUB_FIRMWARE_PATH;
-
-    DEBUG_PRINTF("WiFiManager: Downloading firmware from: %s\n", url.c_str());
-
-    if (downloadFirmware(url)) {
-        DEBUG_PRINTLN("WiFiManager: Firmware updated successfully! Rebooting...");
-        delay(1000);
-        ESP.restart();
-    } else {
-        DEBUG_PRINTLN("WiFiManager: Firmware update failed");
+    if (!_updater.start(_autoInstall)) {
+        DEBUG_PRINTLN("WiFiManager: Update check not started");
     }
 }
 
-bool WiFiManager::downloadFirmware(const String& url) {
-    HTTPClient http;
-    WiFiClientSecure client;
-    client.setInsecure();  // Skip cert validation for GitHub
-
-    http.begin(client, url);
-    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-    http.setTimeout(60000);  // 60s timeout for large file
-
-    DEBUG_PRINTF("WiFiManager: Free heap before download: %d\n", ESP.getFreeHeap());
-
-    int httpCode = http.GET();
-    DEBUG_PRINTF("WiFiManager: HTTP response code: %d\n", httpCode);
-
-    if (httpCode != HTTP_CODE_OK) {
-        DEBUG_PRINTF("WiFiManager: Download failed, HTTP %d: %s\n",
-                     httpCode, http.errorToString(httpCode).c_str());
-        http.end();
-        return false;
-    }
-
-    int contentLength = http.getSize();
-    DEBUG_PRINTF("WiFiManager: Content-Length: %d\n", contentLength);
-
-    if (contentLength <= 0) {
-        DEBUG_PRINTLN("WiFiManager: No Content-Length, cannot determine size");
-        http.end();
-        return false;
-    }
-
-    bool canBegin = Update.begin(contentLength);
-    if (!canBegin) {
-        DEBUG_PRINTF("WiFiManager: Not enough space for OTA (need %d)\n", contentLength);
-        http.end();
-        return false;
-    }
-
-    // Chunked download with progress reporting
-    WiFiClient* stream = http.getStreamPtr();
-    DEBUG_PRINTF("WiFiManager: Starting firmware write, size: %d bytes\n", contentLength);
-
-    uint8_t buf[1024];
-    size_t written = 0;
-    int lastPct = -1;
-    unsigned long lastProgressLog = 0;
-
-    while (written < (size_t)contentLength) {
-        size_t available = stream->available();
-        if (available == 0) {
-            // Wait for data with timeout
-            unsigned long waitStart = millis();
-            while (!stream->available() && (millis() - waitStart < 10000)) {
-                delay(10);
-            }
-            if (!stream->available()) {
-                DEBUG_PRINTLN("WiFiManager: Download stalled — timeout");
-                break;
-            }
-            continue;
-        }
-
-        size_t toRead = (available > sizeof(buf)) ? sizeof(buf) : available;
-        size_t bytesRead = stream->readBytes(buf, toRead);
-        if (bytesRead == 0) break;
-
-        size_t bytesWritten = Update.write(buf, bytesRead);
-        if (bytesWritten != bytesRead) {
-            DEBUG_PRINTF("WiFiManager: Write mismatch: read=%d written=%d\n", bytesRead, bytesWritten);
-            break;
-        }
-        written += bytesWritten;
-
-        int pct = (int)((written * 100) / contentLength);
-        if (pct != lastPct && (pct % 5 == 0 || millis() - lastProgressLog > 3000)) {
-            DEBUG_PRINTF("WiFiManager: OTA progress: %d%% (%d / %d bytes)\n", pct, written, contentLength);
-            lastPct = pct;
-            lastProgressLog = millis();
-        }
-    }
-
-    DEBUG_PRINTF("WiFiManager: Written %d of %d bytes\n", written, contentLength);
-
-    if (Update.end()) {
-        if (Update.isFinished()) {
-            DEBUG_PRINTLN("WiFiManager: Update successfully completed");
-            http.end();
-            return true;
-        } else {
-            DEBUG_PRINTLN("WiFiManager: Update not finished");
-        }
-    } else {
-        DEBUG_PRINTF("WiFiManager: Update error: %s\n", Update.errorString());
-    }
-
-    http.end();
-    return false;
-}
-
 String WiFiManager::getStatusPage() {
     if (!_controller) {
         return "<html><body><h1>Controller not initialized</h1></body></html>";
@@ -1260,11 +1094,10 @@ String WiFiManager::getStatusPage() {
         sprintf(buf, "Remaining: %02lu:%02lu", minutes, seconds);
         page += buf;
     } else if (status.lastIrrigationTime > 0) {
-        struct tm timeinfo;
-        time_t t = status.lastIrrigationTime;
-        localtime_r(&t, &timeinfo);
+        LocalTime local;
+        timeZone.toLocal(status.lastIrrigationTime, local);
         char buf[20];
-        sprintf(buf, "Last: %02d:%02d", timeinfo.tm_hour, timeinfo.tm_min);
+        sprintf(buf, "Last: %02d:%02d", local.hour, local.minute);
         page += buf;
     } else {
         page += "No recent run";
@@ -1276,10 +1109,10 @@ String WiFiManager::getStatusPage() {
     uint8_t nextCh = 0;
     time_t nextTime = _controller->getNextScheduledTime(&nextCh);
     if (nextTime > 0) {
-        struct tm timeinfo;
-        localtime_r(&nextTime, &timeinfo);
+        LocalTime local;
+        timeZone.toLocal(nextTime, local);
         char buf[32];
-        sprintf(buf, "Next: Ch %d @ %02d:%02d", nextCh, timeinfo.tm_hour, timeinfo.tm_min);
+        sprintf(buf, "Next: Ch %d @ %02d:%02d", nextCh, local.hour, local.minute);
         page += buf;
     } else {
         page += "No schedules";
@@ -1303,10 +1136,10 @@ String WiFiManager::getStatusPage() {
     if (_timeSynced && _controller) {
         time_t currentTime = getCurrentTime();
         if (currentTime > 0) {
-            struct tm timeinfo;
-            localtime_r(&currentTime, &timeinfo);
+            LocalTime local;
+            timeZone.toLocal(currentTime, local);
             char timeBuf[20];
-            sprintf(timeBuf, "%02d:%02d:%02d", timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+            sprintf(timeBuf, "%02d:%02d:%02d", local.hour, local.minute, local.second);
             page += timeBuf;
         } else {
             page += "Not synced";
@@ -1359,6 +1192,12 @@ String WiFiManager::getStatusPage() {
                 <label for="scheduleDuration">Duration (minutes)</label>
                 <input type="number" id="scheduleDuration" min="1" max="240" value="30">
 
+                <label for="scheduleCycles">Cycles</label>
+                <input type="number" id="scheduleCycles" min="1" max="6" value="1">
+
+                <label for="scheduleSoak">Soak between cycles (minutes)</label>
+                <input type="number" id="scheduleSoak" min="0" max="120" value="0">
+
                 <span class="day-label">Days</span>
                 <div class="day-picker" id="dayPicker">
                     <button type="button" class="day-btn active" data-day="0">S</button>
@@ -1732,7 +1571,7 @@ String WiFiManager::getStatusPage() {
                         <div style="${skipStyle}"><strong>${formatTime(schedule.hour, schedule.minute)}</strong> - ${schedule.duration} min<br><span style="font-size:11px;opacity:0.7;">${dayText}</span>${skipped ? ' (skipped)' : ''}</div>
                         <div style="display:flex;gap:4px;">
                             ${skipBtn}
-                            <button class="pill-action" onclick="editSchedule(${schedule.id},${schedule.channel},'${formatTime(schedule.hour,schedule.minute)}',${schedule.duration},${wd})" title="Edit">&#9998;</button>
+                            <button class="pill-action" onclick="editSchedule(${schedule.id},${schedule.channel},'${formatTime(schedule.hour,schedule.minute)}',${schedule.duration},${wd},${schedule.cycles || 1},${schedule.soak || 0})" title="Edit">&#9998;</button>
                             <button class="pill-action" onclick="deleteSchedule(${schedule.id})">&times;</button>
                         </div>
                     </div>`;
@@ -1776,6 +1615,10 @@ String WiFiManager::getStatusPage() {
             const duration = document.getElementById('scheduleDuration');
             if (time) time.value = '06:00';
             if (duration) duration.value = 30;
+            const cycles = document.getElementById('scheduleCycles');
+            const soak = document.getElementById('scheduleSoak');
+            if (cycles) cycles.value = 1;
+            if (soak) soak.value = 0;
             setWeekdaysMask(0x7F);
             if (resetMessage) {
                 showScheduleMessage('', false);
@@ -1796,7 +1639,7 @@ String WiFiManager::getStatusPage() {
             msg.innerHTML = text;
         }
 
-        function editSchedule(id, channel, time, duration, weekdays) {
+        function editSchedule(id, channel, time, duration, weekdays, cycles, soak) {
             editingScheduleId = id;
             const select = document.getElementById('channelSelect');
             const timeInput = document.getElementById('scheduleTime');
@@ -1804,6 +1647,10 @@ String WiFiManager::getStatusPage() {
             if (select) select.value = channel;
             if (timeInput) timeInput.value = time;
             if (durationInput) durationInput.value = duration;
+            const cyclesInput = document.getElementById('scheduleCycles');
+            const soakInput = document.getElementById('scheduleSoak');
+            if (cyclesInput) cyclesInput.value = cycles || 1;
+            if (soakInput) soakInput.value = soak || 0;
             setWeekdaysMask(weekdays !== undefined ? weekdays : 0x7F);
             setScheduleForm(true);
         }
@@ -1842,6 +1689,16 @@ String WiFiManager::getStatusPage() {
                 duration: parseInt(duration.value, 10),
                 weekdays: weekdays
             };
+            const cycles = document.getElementById('scheduleCycles');
+            const soak = document.getElementById('scheduleSoak');
+            if (cycles && soak) {
+                payload.cycles = parseInt(cycles.value, 10) || 1;
+                payload.soak = parseInt(soak.value, 10) || 0;
+                if (payload.cycles > 1 && payload.soak < 1) {
+                    showScheduleMessage('Set a soak time when splitting into cycles.', true);
+                    return;
+                }
+            }
 
             if (!payload.channel || payload.duration <= 0) {
                 showScheduleMessage('Channel and duration are required.', true);
@@ -1928,18 +1785,24 @@ String WiFiManager::getStatusPage() {
         String mqttBroker = "";
         uint16_t mqttPort = 1883;
         String mqttUser = "";
+        bool mqttTls = false;
+        String mqttFingerprint = "";
         if (_homeAssistant) {
             mqttBroker = _homeAssistant->getMqttBroker();
             mqttPort = _homeAssistant->getMqttPort();
             mqttUser = _homeAssistant->getMqttUser();
+            mqttTls = _homeAssistant->getMqttTls();
+            mqttFingerprint = _homeAssistant->getMqttFingerprint();
         } else if (LittleFS.exists(MQTT_CREDENTIALS_FILE)) {
             File f = LittleFS.open(MQTT_CREDENTIALS_FILE, "r");
             if (f) {
-                StaticJsonDocument<512> cred;
+                ArenaJsonDocument cred(512);
                 if (!deserializeJson(cred, f)) {
                     mqttBroker = cred["broker"] | "";
                     mqttPort = cred["port"] | 1883;
                     mqttUser = cred["user"] | "";
+                    mqttTls = cred["tls"] | false;
+                    mqttFingerprint = cred["fingerprint"] | "";
                 }
                 f.close();
             }
@@ -1967,6 +1830,18 @@ String WiFiManager::getStatusPage() {
                 <label style="display:block; margin-top:10px;"><strong>Password (optional):</strong></label>
                 <input type="password" id="password" name="password" placeholder="Leave empty if no auth" style="width:100%; padding:8px; margin-top:5px; border:1px solid #0f0; background:#0a0a0a; color:#0f0; font-family:'Courier New';">
 
+                <label style="display:block; margin-top:10px;"><input type="checkbox" id="tls")rawliteral";
+        page += mqttTls ? " checked" : "";
+        page += R"rawliteral(> <strong>Use TLS</strong> (usually port 8883)</label>
+
+                <label style="display:block; margin-top:10px;"><strong>Certificate SHA-256 fingerprint (optional):</strong></label>
+                <input type="text" id="fingerprint" name="fingerprint" value=")rawliteral";
+        page += mqttFingerprint;
+        page += R"rawliteral(" placeholder="Pins the broker certificate" style="width:100%; padding:8px; margin-top:5px; border:1px solid #0f0; background:#0a0a0a; color:#0f0; font-family:'Courier New';">
+
+                <label style="display:block; margin-top:10px;"><strong>CA certificate PEM (optional):</strong></label>
+                <textarea id="ca" name="ca" rows="4" placeholder="-----BEGIN CERTIFICATE----- ... (empty keeps the saved one)" style="width:100%; padding:8px; margin-top:5px; border:1px solid #0f0; background:#0a0a0a; color:#0f0; font-family:'Courier New';"></textarea>
+
                 <div style="margin-top:15px; display:flex; gap:10px; flex-wrap:wrap;">
                     <button type="button" onclick="testMqtt()" style="padding:10px 20px; background:#48bb78; color:#fff; border:none; border-radius:5px; cursor:pointer;">Test Connection</button>
                     <button type="button" onclick="saveMqtt()" style="padding:10px 20px; background:#667eea; color:#fff; border:none; border-radius:5px; cursor:pointer;">Save & Restart</button>
@@ -1982,6 +1857,9 @@ String WiFiManager::getStatusPage() {
             var port = document.getElementById('port').value;
             var user = document.getElementById('user').value;
             var password = document.getElementById('password').value;
+            var tls = document.getElementById('tls').checked ? '1' : '0';
+            var fingerprint = document.getElementById('fingerprint').value;
+            var ca = document.getElementById('ca').value;
 
             var msg = document.getElementById('mqttMessage');
             msg.style.display = 'block';
@@ -1992,7 +1870,8 @@ String WiFiManager::getStatusPage() {
             fetch('/mqtt/test', {
                 method: 'POST',
                 headers: {'Content-Type': 'application/x-www-form-urlencoded'},
-                body: 'broker=' + encodeURIComponent(broker) + '&port=' + port + '&user=' + encodeURIComponent(user) + '&password=' + encodeURIComponent(password)
+                body: 'broker=' + encodeURIComponent(broker) + '&port=' + port + '&user=' + encodeURIComponent(user) + '&password=' + encodeURIComponent(password) +
+                      '&tls=' + tls + '&fingerprint=' + encodeURIComponent(fingerprint) + '&ca=' + encodeURIComponent(ca)
             })
             .then(response => response.json())
             .then(data => {
@@ -2023,6 +1902,8 @@ String WiFiManager::getStatusPage() {
             var port = document.getElementById('port').value;
             var user = document.getElementById('user').value;
             var password = document.getElementById('password').value;
+            var tls = document.getElementById('tls').checked ? '1' : '0';
+            var fingerprint = document.getElementById('fingerprint').value;
 
             var msg = document.getElementById('mqttMessage');
             msg.style.display = 'block';
@@ -2033,7 +1914,9 @@ String WiFiManager::getStatusPage() {
             fetch('/mqtt/save', {
                 method: 'POST',
                 headers: {'Content-Type': 'application/x-www-form-urlencoded'},
-                body: 'broker=' + encodeURIComponent(broker) + '&port=' + port + '&user=' + encodeURIComponent(user) + '&password=' + encodeURIComponent(password)
+                body: 'broker=' + encodeURIComponent(broker) + '&port=' + port + '&user=' + encodeURIComponent(user) + '&password=' + encodeURIComponent(password) +
+                      '&tls=' + tls + '&fingerprint=' + encodeURIComponent(fingerprint) +
+                      '&ca=' + encodeURIComponent(document.getElementById('ca').value)
             })
             .then(response => response.json())
             .then(data => {
@@ -2069,12 +1952,18 @@ String WiFiManager::getStatusPage() {
         </div>
 
         <script>
-        function checkUpdates() {
+        function showSystemMessage(color, html) {
             var msg = document.getElementById('systemMessage');
+            var bg = { ok: 'rgba(0,255,0,0.2)', busy: 'rgba(255,255,0,0.2)', error: 'rgba(255,0,0,0.2)' };
+            var fg = { ok: '#0f0', busy: '#ff0', error: '#f00' };
             msg.style.display = 'block';
-            msg.style.background = 'rgba(255,255,0,0.2)';
-            msg.style.color = '#ff0';
-            msg.innerHTML = 'Checking for updates...';
+            msg.style.background = bg[color];
+            msg.style.color = fg[color];
+            msg.innerHTML = html;
+        }
+
+        function checkUpdates() {
+            showSystemMessage('busy', 'Checking for updates...');
 
             fetch('/system/check-updates', {
                 method: 'POST'
@@ -2082,22 +1971,41 @@ String WiFiManager::getStatusPage() {
             .then(response => response.json())
             .then(data => {
                 if (data.success) {
-                    msg.style.background = 'rgba(0,255,0,0.2)';
-                    msg.style.color = '#0f0';
-                    msg.innerHTML = 'SUCCESS: ' + data.message;
-                    if (data.updating) {
-                        msg.innerHTML += '<br><strong>Device is updating and will restart automatically...</strong>';
-                    }
+                    pollUpdate();
                 } else {
-                    msg.style.background = 'rgba(255,0,0,0.2)';
-                    msg.style.color = '#f00';
-                    msg.innerHTML = 'ERROR: ' + data.message;
+                    showSystemMessage('error', 'ERROR: ' + data.message);
                 }
             })
             .catch(error => {
-                msg.style.background = 'rgba(255,0,0,0.2)';
-                msg.style.color = '#f00';
-                msg.innerHTML = 'ERROR: ' + error;
+                showSystemMessage('error', 'ERROR: ' + error);
+            });
+        }
+
+        // The check and download run on the device in the background
+        function pollUpdate() {
+            fetch('/api/ota')
+            .then(response => response.json())
+            .then(s => {
+                if (s.state === 'checking') {
+                    showSystemMessage('busy', 'Checking for updates...');
+                    setTimeout(pollUpdate, 1000);
+                } else if (s.state === 'downloading') {
+                    showSystemMessage('busy', 'Downloading version ' + s.latest + ': ' + s.progress + '%');
+                    setTimeout(pollUpdate, 1000);
+                } else if (s.state === 'rebooting') {
+                    showSystemMessage('ok', 'SUCCESS: Version ' + s.latest + ' installed' +
+                        '<br><strong>Device is restarting...</strong>');
+                } else if (s.state === 'up_to_date') {
+                    showSystemMessage('ok', 'SUCCESS: Firmware is up to date (v' + s.current + ')');
+                } else if (s.state === 'available') {
+                    showSystemMessage('ok', 'Version ' + s.latest + ' is available' +
+                        (!s.auto_install ? ' (installed by the master\'s rollout)' : ''));
+                } else {
+                    showSystemMessage('error', 'ERROR: ' + (s.error || 'Update check failed'));
+                }
+            })
+            .catch(error => {
+                setTimeout(pollUpdate, 2000);
             });
         }
 
@@ -2219,7 +2127,7 @@ void WiFiManager::startWebServer() {
 
     // API routes registered by WebAPIHandler::begin()
 
-    // System update check
+    // System update check: starts the job and returns; the page follows it on /api/ota
     _webServer->on("/system/check-updates", HTTP_POST, [this]() {
         DEBUG_PRINTLN("WiFiManager: Update check requested via web interface");
 
@@ -2227,24 +2135,11 @@ void WiFiManager::startWebServer() {
             _webServer->send(200, "application/json", "{\"success\":false,\"message\":\"Not connected to WiFi\"}");
             return;
         }
-
-        String latestVersion;
-        if (checkGitHubVersion(latestVersion)) {
-            DEBUG_PRINTF("WiFiManager: Latest version: %s, Current: %s\n", latestVersion.c_str(), VERSION);
-
-            if (latestVersion != String(VERSION)) {
-                _webServer->send(200, "application/json",
-                    "{\"success\":true,\"message\":\"Update found! Version " + latestVersion + " is available. Downloading...\",\"updating\":true}");
-                delay(1000);
-                performOTA();
-            } else {
-                _webServer->send(200, "application/json",
-                    "{\"success\":true,\"message\":\"Firmware is up to date (v" + String(VERSION) + ")\",\"updating\":false}");
-            }
-        } else {
-            _webServer->send(200, "application/json",
-                "{\"success\":false,\"message\":\"Failed to check for updates. Check GitHub repository settings.\"}");
+        if (!_updater.start(_autoInstall)) {
+            _webServer->send(200, "application/json", "{\"success\":false,\"message\":\"An update job is already running\"}");
+            return;
         }
+        _webServer->send(202, "application/json", "{\"success\":true,\"message\":\"Checking for updates...\"}");
     });
 
     _webServer->begin();
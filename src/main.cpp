@@ -10,6 +10,7 @@
  * - NTP time synchronization with RTC fallback
  * - Automatic OTA updates from GitHub
  * - Home Assistant MQTT integration with auto-discovery
+ * - Soil-moisture sensor nodes and closed-loop zones
  * - Non-volatile storage for schedules (LittleFS)
  * - Runtime feature flags from config.json
  */
@@ -24,6 +25,13 @@
 #include "HomeAssistantIntegration.h"
 #include "NodeManager.h"
 #include "WebAPIHandler.h"
+#include "SoilSensor.h"
+#include "PressureMonitor.h"
+#include "AutomationManager.h"
+#include "LatencyStats.h"
+#include "CrashLog.h"
+#include "JsonArena.h"
+#include "TimeZone.h"
 
 // Global objects
 IrrigationController* irrigationController = nullptr;
@@ -31,6 +39,9 @@ DisplayManager* displayManager = nullptr;
 WiFiManager* wifiManager = nullptr;
 HomeAssistantIntegration* homeAssistant = nullptr;
 NodeManager* nodeManager = nullptr;
+SoilSensor* soilSensor = nullptr;
+PressureMonitor* pressureMonitor = nullptr;
+AutomationManager* automation = nullptr;
 
 // Feature flags — multi_node on by default for both boards
 //                  {multi_node, mqtt, web_ui, sensors, battery, ota, debug}
@@ -45,6 +56,18 @@ String nodeRole = DEFAULT_ROLE;
 #endif
 String nodeName = "Slave";  // Human-readable name for pairing
 
+// Local time zone (POSIX TZ, from config)
+TimeZone timeZone;
+
+// loop() busy time (excluding the trailing delay), reported by /api/metrics
+LatencyStats loopLatency;
+
+// Serial tee into RTC RAM, reset reason and core dump (DEBUG_* output)
+CrashLog crashLog;
+
+// Backing store for every JSON document (see JsonArena.h)
+JsonArena jsonArena;
+
 // System status
 unsigned long lastStatusUpdate = 0;
 
@@ -53,6 +76,12 @@ void timeUpdateCallback(time_t currentTime);
 void updateSystemStatus();
 void loadConfiguration();
 void remoteValveHandler(uint8_t channel, bool state, uint16_t duration);
+void remoteStageHandler(uint8_t channel, uint16_t duration, uint16_t delayMs);
+void remoteGroupHandler(uint8_t groupIndex, uint64_t remoteMembers, bool state, uint16_t duration);
+void onGroupAck(uint8_t groupId, bool start, bool confirmed);
+void onRunEnd(uint8_t channel, uint32_t start, uint16_t durationSec, uint8_t reason);
+bool moistureProvider(const char* sensorId, uint8_t probe, float& moisture);
+void onPressureAlert(uint8_t event, uint32_t zones, float pressureKpa);
 void onPairRequest(const char* nodeId, const char* name);
 void onPairResponse(bool accepted);
 String nodeIdToDisplayName(const String& id);
@@ -126,6 +155,12 @@ void setup() {
     DEBUG_PRINTLN("Initializing WiFi Manager...");
     wifiManager = new WiFiManager(irrigationController, homeAssistant);
 
+    // Valve nodes of a multi-node system install only through the master's
+    // staged rollout; their own checks just look
+    if (features.multi_node && nodeRole != "sensor") {
+        wifiManager->setAutoInstall(false);
+    }
+
     // Try to connect with saved credentials or start config portal
     if (!wifiManager->begin()) {
         DEBUG_PRINTLN("WiFiManager: Started in configuration mode");
@@ -150,19 +185,55 @@ void setup() {
 
     // Set time update callback
     wifiManager->setTimeUpdateCallback(timeUpdateCallback);
+    if (homeAssistant) {
+        homeAssistant->setFirmwareUpdater(&wifiManager->getUpdater());
+    }
+
+    // Initialize soil-moisture probes — sensor nodes with the sensors feature
+    if (features.sensors && nodeRole == "sensor") {
+        DEBUG_PRINTLN("Initializing Soil Sensor...");
+        soilSensor = new SoilSensor();
+        if (!soilSensor->begin()) {
+            DEBUG_PRINTLN("WARNING: No soil probes configured");
+        }
+    }
+
+    // Initialize mainline pressure monitoring — valve nodes with the sensors feature
+    if (features.sensors && nodeRole != "sensor") {
+        DEBUG_PRINTLN("Initializing Pressure Monitor...");
+        pressureMonitor = new PressureMonitor(irrigationController);
+        if (pressureMonitor->begin()) {
+            pressureMonitor->setAlertCallback(onPressureAlert);
+            if (homeAssistant) {
+                homeAssistant->setPressureMonitor(pressureMonitor);
+            }
+        } else {
+            DEBUG_PRINTLN("ERROR: PressureMonitor init failed");
+            delete pressureMonitor;
+            pressureMonitor = nullptr;
+        }
+    }
 
     // Initialize NodeManager (UDP + mDNS) — only if multi_node feature enabled
     if (features.multi_node) {
         DEBUG_PRINTLN("Initializing NodeManager (UDP + mDNS)...");
-        uint8_t nmRole = (nodeRole == "master") ? NODE_ROLE_MASTER : NODE_ROLE_SLAVE;
+        uint8_t nmRole = (nodeRole == "master") ? NODE_ROLE_MASTER :
+                         (nodeRole == "sensor") ? NODE_ROLE_SENSOR : NODE_ROLE_SLAVE;
         nodeManager = new NodeManager(irrigationController, nodeId.c_str(),
                                       nmRole, nodeName.c_str());
+        nodeManager->setSoilSensor(soilSensor);
+        nodeManager->setFirmwareUpdater(&wifiManager->getUpdater());
 
         if (nodeManager->begin()) {
+            irrigationController->setRunEndCallback(onRunEnd);
             if (nodeRole == "master") {
                 // Master: set remote valve callback and pairing callback
                 irrigationController->setRemoteValveCallback(remoteValveHandler);
+                irrigationController->setRemoteStageCallback(remoteStageHandler);
+                irrigationController->setRemoteGroupCallback(remoteGroupHandler);
+                irrigationController->setMoistureProvider(moistureProvider);
                 nodeManager->setPairRequestCallback(onPairRequest);
+                nodeManager->setGroupAckCallback(onGroupAck);
                 wifiManager->setNodeManager(nodeManager);
                 if (features.mqtt && homeAssistant) {
                     homeAssistant->setNodeManager(nodeManager);
@@ -172,21 +243,37 @@ void setup() {
                     displayManager->setPairResponseCallback(onPairResponse);
                 }
 #endif
+            } else if (nmRole == NODE_ROLE_SLAVE && homeAssistant) {
+                // Installs wait for the master's canary and for idle valves
+                homeAssistant->setManualInstall(false);
             }
         } else {
             DEBUG_PRINTLN("ERROR: NodeManager init failed");
             delete nodeManager;
             nodeManager = nullptr;
+            wifiManager->setAutoInstall(true);  // No master will order installs
         }
     } else {
         DEBUG_PRINTLN("multi_node feature disabled, skipping NodeManager");
     }
 
+    // Initialize local automation rules — valve nodes only
+    if (nodeRole != "sensor") {
+        DEBUG_PRINTLN("Initializing Automation Manager...");
+        automation = new AutomationManager(irrigationController);
+        automation->setHomeAssistant(homeAssistant);
+        automation->setPressureMonitor(pressureMonitor);
+        automation->begin();
+    }
+
     // Initialize Web API handler (registers /api/* routes on web server)
     if (!wifiManager->isConfigMode() && wifiManager->getWebServer()) {
         WebAPIHandler* webApi = new WebAPIHandler(
             wifiManager->getWebServer(), irrigationController,
             homeAssistant, nodeManager, wifiManager);
+        webApi->setSoilSensor(soilSensor);
+        webApi->setPressureMonitor(pressureMonitor);
+        webApi->setAutomation(automation);
         webApi->begin();
         DEBUG_PRINTLN("WebAPIHandler: API routes registered");
     }
@@ -216,9 +303,15 @@ void setup() {
 }
 
 void loop() {
+    unsigned long loopStart = micros();
+
     // Update all components
     irrigationController->update();
 
+    if (soilSensor) soilSensor->update();
+
+    if (pressureMonitor) pressureMonitor->update();
+
 #if LCD_ROWS > 0
     if (displayManager) displayManager->update();
 #endif
@@ -229,6 +322,8 @@ void loop() {
 
     if (features.multi_node && nodeManager) nodeManager->update();
 
+    if (automation) automation->update();
+
     // Update system status periodically
     unsigned long currentMillis = millis();
     if (currentMillis - lastStatusUpdate >= STATUS_UPDATE_INTERVAL) {
@@ -267,6 +362,9 @@ void loop() {
     }
 #endif
 
+    // Valve timing slips by however long one pass takes
+    loopLatency.record(micros() - loopStart);
+
     // Small delay to prevent watchdog timeout
     delay(10);
 }
@@ -309,6 +407,51 @@ void remoteValveHandler(uint8_t channel, bool state, uint16_t duration) {
     }
 }
 
+void remoteStageHandler(uint8_t channel, uint16_t duration, uint16_t delayMs) {
+    if (!nodeManager) return;
+    nodeManager->sendStart(channel, duration, delayMs);
+}
+
+void remoteGroupHandler(uint8_t groupIndex, uint64_t remoteMembers, bool state, uint16_t duration) {
+    if (!nodeManager) return;
+    nodeManager->sendGroupCommand(groupIndex, remoteMembers, state, duration);
+}
+
+void onGroupAck(uint8_t groupId, bool start, bool confirmed) {
+    DEBUG_PRINTF("Group %d %s %s by all nodes\n", groupId,
+                 start ? "start" : "stop", confirmed ? "confirmed" : "NOT confirmed");
+    if (homeAssistant) {
+        homeAssistant->publishGroupStates();
+    }
+}
+
+void onRunEnd(uint8_t channel, uint32_t start, uint16_t durationSec, uint8_t reason) {
+    if (!nodeManager) return;
+    RunRecord run = {};
+    run.start = start;
+    run.duration_s = durationSec;
+    run.volume_dl = RUN_VOLUME_NONE;  // No flow meter yet
+    run.channel = channel;
+    run.reason = reason;
+    nodeManager->recordRun(run);
+}
+
+bool moistureProvider(const char* sensorId, uint8_t probe, float& moisture) {
+    if (!nodeManager) return false;
+    return nodeManager->getSensorMoisture(sensorId, probe, moisture);
+}
+
+void onPressureAlert(uint8_t event, uint32_t zones, float pressureKpa) {
+    DEBUG_PRINTF("Pressure %s at %.0f kPa (zones 0x%08lX)\n",
+                 event == PRESSURE_EVENT_BURST ? "BURST" : "LEAK",
+                 pressureKpa, (unsigned long)zones);
+    if (homeAssistant) {
+        homeAssistant->publishPressure();
+        homeAssistant->publishChannelStates();
+        homeAssistant->publishStatus();
+    }
+}
+
 void onPairRequest(const char* nodeId, const char* name) {
     DEBUG_PRINTF("Pair request from '%s' (%s)\n", name, nodeId);
 #if LCD_ROWS > 0
@@ -365,6 +508,7 @@ String nodeIdToDisplayName(const String& id) {
 
 void loadConfiguration() {
     DEBUG_PRINTLN("Loading configuration from LittleFS...");
+    timeZone.set(DEFAULT_TIMEZONE);
 
     // Initialize LittleFS (format if needed)
     DEBUG_PRINTLN("Mounting LittleFS...");
@@ -377,6 +521,9 @@ void loadConfiguration() {
         DEBUG_PRINTLN("LittleFS formatted successfully");
     }
 
+    // Save the crashed boot's serial tail before anything else writes to flash
+    crashLog.begin();
+
     // Auto-generate unique node_id from MAC if no config exists
     if (!LittleFS.exists(CONFIG_FILE)) {
         DEBUG_PRINTLN("No configuration file found, using defaults");
@@ -397,7 +544,7 @@ void loadConfiguration() {
         return;
     }
 
-    StaticJsonDocument<1024> doc;
+    ArenaJsonDocument doc(1024);
     DeserializationError error = deserializeJson(doc, file);
     file.close();
 
@@ -424,6 +571,12 @@ void loadConfiguration() {
     const char* explicitName = doc["node_name"] | "";
     nodeName = (strlen(explicitName) > 0) ? String(explicitName) : nodeIdToDisplayName(nodeId);
 
+    // Time zone: keep the default if the stored one does not parse
+    const char* tz = doc["timezone"] | DEFAULT_TIMEZONE;
+    if (!timeZone.set(tz)) {
+        DEBUG_PRINTF("Invalid timezone '%s', using %s\n", tz, DEFAULT_TIMEZONE);
+    }
+
     // Read feature flags
     JsonObject feat = doc["features"];
     if (!feat.isNull()) {
@@ -437,5 +590,6 @@ void loadConfiguration() {
     }
 
     DEBUG_PRINTLN("Configuration loaded successfully");
-    DEBUG_PRINTF("Node: %s, Role: %s, Name: %s\n", nodeId.c_str(), nodeRole.c_str(), nodeName.c_str());
+    DEBUG_PRINTF("Node: %s, Role: %s, Name: %s, TZ: %s\n",
+                 nodeId.c_str(), nodeRole.c_str(), nodeName.c_str(), timeZone.get());
 }
@@ -0,0 +1,149 @@
+// BodySchema: values, defaults, presence, skipped keys and error reports
+//   pio test -e native -f test_body_schema
+
+#include <unity.h>
+#include <string.h>
+#include "BodySchema.h"
+
+struct Body {
+    uint8_t channel;
+    uint16_t duration;
+    int8_t id;
+    bool enabled;
+    char name[8];
+};
+
+static const BodyField FIELDS[] = {
+    BODY_FIELD_INT("channel", Body, channel, true, 1, 8),
+    BODY_FIELD_INT("duration", Body, duration, false, 1, 1440),
+    BODY_FIELD_INT("id", Body, id, false, -1, 15),
+    BODY_FIELD_BOOL("enabled", Body, enabled, false),
+    BODY_FIELD_STR("name", Body, name, false, 1),
+};
+
+static Body body;
+
+static BodyResult parse(const char* json) {
+    memset(&body, 0, sizeof(body));
+    body.duration = 30;
+    body.id = -1;
+    strcpy(body.name, "none");
+    return BodySchema::parse(json, strlen(json), FIELDS, &body);
+}
+
+static void expectError(const char* json, uint8_t status, const char* message) {
+    BodyResult r = parse(json);
+    TEST_ASSERT_EQUAL(status, r.status);
+    char text[64];
+    BodySchema::formatError(r, FIELDS, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING(message, text);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_all_fields(void) {
+    BodyResult r = parse("{\"channel\":3,\"duration\":1440,\"id\":-1,\"enabled\":true,\"name\":\"Lawn\"}");
+    TEST_ASSERT_EQUAL(BODY_OK, r.status);
+    TEST_ASSERT_EQUAL(3, body.channel);
+    TEST_ASSERT_EQUAL(1440, body.duration);
+    TEST_ASSERT_EQUAL(-1, body.id);
+    TEST_ASSERT_TRUE(body.enabled);
+    TEST_ASSERT_EQUAL_STRING("Lawn", body.name);
+    TEST_ASSERT_EQUAL_HEX32(0x1F, r.present);
+}
+
+// Absent and null fields keep the caller's defaults and are not present
+void test_defaults_and_null(void) {
+    BodyResult r = parse(" { \"duration\" : null , \"channel\" : 2 } ");
+    TEST_ASSERT_EQUAL(BODY_OK, r.status);
+    TEST_ASSERT_EQUAL(2, body.channel);
+    TEST_ASSERT_EQUAL(30, body.duration);
+    TEST_ASSERT_EQUAL_STRING("none", body.name);
+    TEST_ASSERT_EQUAL_HEX32(0x01, r.present);
+}
+
+void test_unknown_keys_skipped(void) {
+    BodyResult r = parse("{\"extra\":{\"a\":[1,2,{\"b\":\"}\"}],\"c\":null},\"channel\":1,"
+                         "\"list\":[true,false,-2.5e3],\"x\":\"\\\"\"}");
+    TEST_ASSERT_EQUAL(BODY_OK, r.status);
+    TEST_ASSERT_EQUAL(1, body.channel);
+    TEST_ASSERT_EQUAL_HEX32(0x01, r.present);
+}
+
+void test_string_escapes(void) {
+    BodyResult r = parse("{\"channel\":1,\"name\":\"a\\\"b\\\\c\\u0041\"}");
+    TEST_ASSERT_EQUAL(BODY_OK, r.status);
+    TEST_ASSERT_EQUAL_STRING("a\"b\\cA", body.name);
+}
+
+// 10.0 is an integer; 10.5 and 1e1 are not
+void test_numbers(void) {
+    TEST_ASSERT_EQUAL(BODY_OK, parse("{\"channel\":4.0}").status);
+    TEST_ASSERT_EQUAL(4, body.channel);
+    expectError("{\"channel\":4.5}", BODY_ERR_TYPE, "channel must be an integer");
+    expectError("{\"channel\":1e1}", BODY_ERR_TYPE, "channel must be an integer");
+    expectError("{\"channel\":99999999999999}", BODY_ERR_RANGE, "channel must be 1-8");
+}
+
+void test_errors(void) {
+    expectError("{}", BODY_ERR_MISSING, "channel is required");
+    expectError("{\"channel\":9}", BODY_ERR_RANGE, "channel must be 1-8");
+    expectError("{\"channel\":1,\"id\":-2}", BODY_ERR_RANGE, "id must be -1-15");
+    expectError("{\"channel\":\"1\"}", BODY_ERR_TYPE, "channel must be an integer");
+    expectError("{\"channel\":1,\"enabled\":1}", BODY_ERR_TYPE, "enabled must be true or false");
+    expectError("{\"channel\":1,\"name\":5}", BODY_ERR_TYPE, "name must be a string");
+    expectError("{\"channel\":1,\"name\":\"\"}", BODY_ERR_LENGTH, "name must be 1-7 characters");
+    expectError("{\"channel\":1,\"name\":\"12345678\"}", BODY_ERR_LENGTH, "name must be 1-7 characters");
+}
+
+void test_syntax(void) {
+    expectError("", BODY_ERR_SYNTAX, "Invalid JSON");
+    expectError("[1]", BODY_ERR_SYNTAX, "Invalid JSON");
+    expectError("{\"channel\":1", BODY_ERR_SYNTAX, "Invalid JSON");
+    expectError("{\"channel\":1} x", BODY_ERR_SYNTAX, "Invalid JSON");
+    expectError("{\"channel\":1,}", BODY_ERR_SYNTAX, "Invalid JSON");
+    expectError("{\"channel\" 1}", BODY_ERR_SYNTAX, "Invalid JSON");
+    expectError("{\"x\":[[[[[[[[[1]]]]]]]]],\"channel\":1}", BODY_ERR_SYNTAX, "Invalid JSON");
+}
+
+// The body is not NUL-terminated: parsing stops at the length
+void test_length_bound(void) {
+    const char* json = "{\"channel\":5}garbage";
+    memset(&body, 0, sizeof(body));
+    BodyResult r = BodySchema::parse(json, 13, FIELDS, &body);
+    TEST_ASSERT_EQUAL(BODY_OK, r.status);
+    TEST_ASSERT_EQUAL(5, body.channel);
+}
+
+// One-field bodies straight into a variable
+void test_scalar(void) {
+    static const BodyField ID[] = {
+        BODY_FIELD_SCALAR("id", BODY_INT, uint8_t, true, 0, 15),
+    };
+    static const BodyField NODE[] = {
+        BODY_FIELD_SCALAR("node_id", BODY_STR, char[12], true, 1, 0),
+    };
+    uint8_t id = 0;
+    TEST_ASSERT_EQUAL(BODY_OK, BodySchema::parse("{\"id\":7}", 8, ID, &id).status);
+    TEST_ASSERT_EQUAL(7, id);
+
+    char nodeId[12];
+    const char* json = "{\"node_id\":\"node_a1b2c3\"}";
+    TEST_ASSERT_EQUAL(BODY_OK, BodySchema::parse(json, strlen(json), NODE, nodeId).status);
+    TEST_ASSERT_EQUAL_STRING("node_a1b2c3", nodeId);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_all_fields);
+    RUN_TEST(test_defaults_and_null);
+    RUN_TEST(test_unknown_keys_skipped);
+    RUN_TEST(test_string_escapes);
+    RUN_TEST(test_numbers);
+    RUN_TEST(test_errors);
+    RUN_TEST(test_syntax);
+    RUN_TEST(test_length_bound);
+    RUN_TEST(test_scalar);
+    return UNITY_END();
+}
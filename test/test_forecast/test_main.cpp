@@ -0,0 +1,131 @@
+// 30-day schedule forecast over the time zone code: order, DST and cost
+//   pio test -e native -f test_forecast -v     (-v shows the timings)
+//
+// ForecastCursor is the merge IrrigationController::nextForecastRun() runs:
+// one pending occurrence per schedule, the earliest is emitted and only that
+// schedule advances. Nearly all of its cost is TimeZone::nextLocal().
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include "ForecastMerge.h"
+#include "TimeZone.h"
+
+#define SCHEDULES   16                 // MAX_SCHEDULES
+#define DAYS        30
+#define BENCH_REPS  100
+
+static TimeZone zone;
+static ForecastSlot slots[SCHEDULES];
+static ForecastCursor cursor;
+
+// 2026-03-20 00:00 UTC: the window spans the CET spring-forward on 03-29
+static const time_t START = 1773964800;
+
+static void beginForecast(time_t now, uint16_t days) {
+    cursor.begin(zone, slots, SCHEDULES, now, days);
+}
+
+static bool nextRun(time_t& start, uint8_t& index) {
+    int8_t best = cursor.advance(zone, start);
+    if (best < 0) return false;
+    index = best;
+    return true;
+}
+
+void setUp(void) {
+    TEST_ASSERT_TRUE(zone.set("CET-1CEST,M3.5.0,M10.5.0/3"));
+    // Daily, spread over the day; schedule 2 sits in the 02:00-03:00 gap
+    for (uint8_t i = 0; i < SCHEDULES; i++) {
+        slots[i].hour = (uint8_t)(i * 3 % 24);
+        slots[i].minute = (uint8_t)(i * 7 % 60);
+        slots[i].weekdays = 0x7F;
+    }
+    slots[2].hour = 2;
+    slots[2].minute = 30;
+}
+
+void tearDown(void) {}
+
+void test_runs_in_time_order(void) {
+    beginForecast(START, DAYS);
+    time_t start, last = 0;
+    uint8_t index;
+    uint16_t count = 0;
+    while (nextRun(start, index)) {
+        TEST_ASSERT_TRUE(start > START && start <= cursor.until);
+        TEST_ASSERT_TRUE(start >= last);
+        last = start;
+        count++;
+    }
+    TEST_ASSERT_EQUAL(SCHEDULES * DAYS, count);
+}
+
+// Every run lands on its wall-clock time, except the one skipped by the
+// spring-forward gap, which moves one hour later
+void test_runs_follow_wall_clock(void) {
+    beginForecast(START, DAYS);
+    time_t start;
+    uint8_t index;
+    uint8_t shifted = 0;
+    while (nextRun(start, index)) {
+        LocalTime local;
+        zone.toLocal(start, local);
+        TEST_ASSERT_EQUAL(slots[index].minute, local.minute);
+        if (local.hour != slots[index].hour) {
+            TEST_ASSERT_EQUAL(2, index);
+            TEST_ASSERT_EQUAL(3, local.hour);
+            TEST_ASSERT_EQUAL(29, local.day);
+            shifted++;
+        }
+    }
+    TEST_ASSERT_EQUAL(1, shifted);
+}
+
+// A schedule without weekdays never runs; a copied cursor is a second pass
+void test_unused_slot_and_copy(void) {
+    slots[5].weekdays = 0;
+    beginForecast(START, 2);
+    ForecastCursor pass = cursor;
+
+    time_t start;
+    uint8_t index;
+    uint16_t count = 0;
+    while (nextRun(start, index)) {
+        TEST_ASSERT_NOT_EQUAL(5, index);
+        count++;
+    }
+    TEST_ASSERT_EQUAL((SCHEDULES - 1) * 2, count);
+
+    uint16_t again = 0;
+    while (pass.advance(zone, start) >= 0) again++;
+    TEST_ASSERT_EQUAL(count, again);
+}
+
+void test_forecast_time_30_days(void) {
+    uint32_t runs = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint8_t rep = 0; rep < BENCH_REPS; rep++) {
+        beginForecast(START, DAYS);
+        time_t start;
+        uint8_t index;
+        while (nextRun(start, index)) runs++;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / BENCH_REPS;
+
+    char line[96];
+    snprintf(line, sizeof(line), "%d schedules, %d days: %lu runs, %.3f ms per forecast",
+             SCHEDULES, DAYS, (unsigned long)(runs / BENCH_REPS), ms);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_LESS_THAN(20.0, ms);  // Generous host budget: catches complexity blow-ups
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_runs_in_time_order);
+    RUN_TEST(test_runs_follow_wall_clock);
+    RUN_TEST(test_unused_slot_and_copy);
+    RUN_TEST(test_forecast_time_30_days);
+    return UNITY_END();
+}
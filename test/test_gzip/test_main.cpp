@@ -0,0 +1,149 @@
+// GzipStream output inflated by zlib: round trip, CRC-32 and ISIZE
+//   pio test -e native -f test_gzip          (links -lz)
+//
+// Input goes in pieces of several sizes, as a handler streams a response.
+// zlib's gzip mode checks the trailer itself; the test also reads the
+// trailer directly so a wrong CRC or length names itself.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <zlib.h>
+#include "GzipStream.h"
+
+static GzipStream gz;                  // ~3 KB: keep it off the stack
+static std::string output;
+static size_t largestPiece;
+
+static void sink(void* context, const uint8_t* data, size_t length) {
+    (void)context;
+    output.append((const char*)data, length);
+    if (length > largestPiece) largestPiece = length;
+}
+
+static void compress(const std::string& input, size_t piece) {
+    output.clear();
+    largestPiece = 0;
+    gz.begin(sink, nullptr);
+    for (size_t at = 0; at < input.size(); at += piece) {
+        size_t n = input.size() - at < piece ? input.size() - at : piece;
+        gz.write((const uint8_t*)input.data() + at, n);
+    }
+    gz.finish();
+}
+
+static std::string inflateGzip(const std::string& data, int& status) {
+    z_stream z = {};
+    TEST_ASSERT_EQUAL(Z_OK, inflateInit2(&z, 16 + MAX_WBITS));   // gzip wrapper only
+    z.next_in = (Bytef*)data.data();
+    z.avail_in = (uInt)data.size();
+
+    std::string out;
+    char buffer[4096];
+    do {
+        z.next_out = (Bytef*)buffer;
+        z.avail_out = sizeof(buffer);
+        status = inflate(&z, Z_NO_FLUSH);
+        out.append(buffer, sizeof(buffer) - z.avail_out);
+    } while (status == Z_OK);
+    TEST_ASSERT_EQUAL_UINT32(0, z.avail_in);                     // Nothing after the trailer
+    inflateEnd(&z);
+    return out;
+}
+
+static uint32_t readLe32(const std::string& s, size_t at) {
+    const uint8_t* p = (const uint8_t*)s.data() + at;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void roundTrip(const std::string& input, size_t piece) {
+    compress(input, piece);
+
+    TEST_ASSERT_TRUE(output.size() >= 18);
+    TEST_ASSERT_EQUAL_HEX8(0x1F, (uint8_t)output[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x8B, (uint8_t)output[1]);
+    TEST_ASSERT_EQUAL_HEX8(8, (uint8_t)output[2]);               // Deflate
+    TEST_ASSERT_TRUE(largestPiece <= GZIP_OUT_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(input.size(), gz.getInputBytes());
+    TEST_ASSERT_EQUAL_UINT32(output.size(), gz.getOutputBytes());
+
+    uint32_t crc = crc32(0L, (const Bytef*)input.data(), (uInt)input.size());
+    TEST_ASSERT_EQUAL_HEX32(crc, readLe32(output, output.size() - 8));
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)input.size(), readLe32(output, output.size() - 4));
+
+    int status;
+    std::string back = inflateGzip(output, status);
+    TEST_ASSERT_EQUAL(Z_STREAM_END, status);                     // zlib checked CRC and ISIZE too
+    TEST_ASSERT_EQUAL_UINT32(input.size(), back.size());
+    TEST_ASSERT_TRUE(back == input);
+}
+
+// /api/status-like JSON, far longer than the match window
+static std::string jsonInput() {
+    std::string s = "{\"success\":true,\"channels\":[";
+    char entry[160];
+    for (int i = 0; i < 300; i++) {
+        snprintf(entry, sizeof(entry),
+                 "%s{\"channel\":%d,\"irrigating\":%s,\"remaining\":%d,\"name\":\"Zone %d\",\"soaking\":false}",
+                 i ? "," : "", i % 64 + 1, (i % 3) ? "false" : "true", i * 37 % 3600, i);
+        s += entry;
+    }
+    return s + "]}";
+}
+
+static std::string randomInput(size_t length) {
+    std::string s(length, '\0');
+    uint32_t state = 12345;
+    for (size_t i = 0; i < length; i++) {
+        state = state * 1664525UL + 1013904223UL;
+        s[i] = (char)(state >> 24);
+    }
+    return s;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_empty(void) {
+    roundTrip(std::string(), 1);
+}
+
+void test_json_in_pieces(void) {
+    std::string input = jsonInput();
+    static const size_t pieces[] = { 1, 7, 100, GZIP_WINDOW, GZIP_WINDOW + 1, 5000, input.size() };
+    for (size_t piece : pieces) roundTrip(input, piece);
+
+    char line[80];
+    snprintf(line, sizeof(line), "%u bytes of JSON -> %u gzip",
+             (unsigned)input.size(), (unsigned)output.size());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(output.size() < input.size() / 4);
+}
+
+// Incompressible: literals only, output a little larger than input
+void test_random_bytes(void) {
+    roundTrip(randomInput(10000), 333);
+}
+
+// One byte repeated: maximum-length matches back to back
+void test_long_runs(void) {
+    roundTrip(std::string(20000, 'a'), 4096);
+    roundTrip(std::string(GZIP_MAX_MATCH + 1, 'b') + randomInput(50) + std::string(700, 'b'), 64);
+}
+
+// A second response from the same encoder starts clean
+void test_reuse(void) {
+    roundTrip(jsonInput(), 512);
+    roundTrip("{\"success\":true}", 3);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty);
+    RUN_TEST(test_json_in_pieces);
+    RUN_TEST(test_random_bytes);
+    RUN_TEST(test_long_runs);
+    RUN_TEST(test_reuse);
+    return UNITY_END();
+}
@@ -0,0 +1,274 @@
+// One master-slave link simulated through LinkTiming: traffic, false
+// offlines and detection latency at 0-30% frame loss
+//   pio test -e native -f test_link -v     (-v shows the measurements)
+//
+// The frame schedule mirrors NodeManager::update() for a one-channel
+// slave: the master heartbeats it on its assigned interval from a
+// NODE_HEARTBEAT_MIN tick and checks deadlines after sending; the slave
+// answers every master heartbeat, heartbeats on its own when due and
+// sends status plus OTA status each status round. Every frame heard
+// refreshes the deadline and every slave heartbeat is ACKed with the new
+// interval (whole seconds on the wire). Each frame is lost independently.
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "LinkTiming.h"
+
+#define STEP_MS       100
+#define TRIALS        200                  // Slave failures per detection measurement
+#define WARMUP_MS     (30UL * 60000UL)
+#define SOAK_MS       (7UL * 86400000UL)   // Alive time per false-offline measurement
+
+struct Link {
+    float lossRate;
+    bool active;
+    uint32_t rand;
+
+    // Master
+    LinkStats stats;
+    uint32_t hbInterval;
+    uint32_t hbPrev;
+    uint32_t heardBy;
+    uint32_t lastHbSent;
+    uint32_t lastTick;
+    bool online;
+
+    // Slave
+    bool alive;
+    uint32_t slaveInterval;
+    uint32_t lastHb;
+    uint32_t lastStatus;
+    uint16_t seq;
+
+    // In flight, delivered on the next step
+    bool toMaster[3];
+    uint16_t toMasterSeq[3];
+    uint8_t toMasterCount;
+    bool hbToSlave;
+    uint32_t ackToSlave;                   // Interval in the ACK, 0 = none
+
+    uint32_t frames;
+    uint32_t offlines;
+    uint32_t offlineAt;
+};
+
+static bool delivered(Link& l) {
+    l.rand = l.rand * 1664525UL + 1013904223UL;
+    return ((l.rand >> 8) & 0xFFFF) / 65536.0f >= l.lossRate;
+}
+
+static void init(Link& l, float lossRate, bool active, uint32_t seed) {
+    memset(&l, 0, sizeof(l));
+    l.lossRate = lossRate;
+    l.active = active;
+    l.rand = seed;
+    l.hbInterval = NODE_HEARTBEAT_IDLE;
+    l.hbPrev = NODE_HEARTBEAT_IDLE;
+    l.online = true;
+    l.alive = true;
+    l.slaveInterval = NODE_HEARTBEAT_IDLE;
+    // Random phase between the two loops
+    l.lastTick = 0;
+    l.lastHb = l.lastStatus = (seed % 400) * STEP_MS;
+}
+
+static void slaveSend(Link& l, bool heartbeat) {
+    l.seq++;
+    l.frames++;
+    if (delivered(l) && l.toMasterCount < 3) {
+        l.toMaster[l.toMasterCount] = heartbeat;
+        l.toMasterSeq[l.toMasterCount++] = l.seq;
+    }
+}
+
+static void masterReceive(Link& l, bool heartbeat, uint16_t seq, uint32_t now) {
+    if (!l.online) l.online = true;
+    LinkTiming::trackRx(l.stats, seq);
+    if (heartbeat) {
+        l.hbPrev = l.hbInterval;
+        l.hbInterval = LinkTiming::interval(l.active, l.stats);
+        l.frames++;
+        if (delivered(l)) l.ackToSlave = l.hbInterval;
+    }
+    l.heardBy = now + LinkTiming::deadline(l.hbInterval, l.hbPrev, l.stats);
+}
+
+static void step(Link& l, uint32_t now) {
+    // Deliveries from the previous step
+    for (uint8_t i = 0; i < l.toMasterCount; i++) {
+        masterReceive(l, l.toMaster[i], l.toMasterSeq[i], now);
+    }
+    l.toMasterCount = 0;
+    bool hbIn = l.hbToSlave;
+    uint32_t ackIn = l.ackToSlave;
+    l.hbToSlave = false;
+    l.ackToSlave = 0;
+
+    if (l.alive) {
+        if (ackIn) {
+            uint32_t interval = ackIn / 1000 * 1000;
+            l.slaveInterval = (interval < NODE_HEARTBEAT_MIN) ? NODE_HEARTBEAT_MIN : interval;
+        }
+        if (hbIn) {
+            slaveSend(l, true);
+            l.lastHb = now;
+        }
+        uint32_t hbEvery = (l.active && l.slaveInterval > NODE_HEARTBEAT_FAST) ?
+            NODE_HEARTBEAT_FAST : l.slaveInterval;
+        uint32_t statusEvery = l.active ? NODE_STATUS_FAST : l.slaveInterval;
+        if (now - l.lastHb >= hbEvery) {
+            l.lastHb = now;
+            slaveSend(l, true);
+        }
+        if (now - l.lastStatus >= statusEvery) {
+            l.lastStatus = now;
+            slaveSend(l, false);           // Status, one channel
+            slaveSend(l, false);           // OTA status
+        }
+    }
+
+    if (now - l.lastTick >= NODE_HEARTBEAT_MIN) {
+        l.lastTick = now;
+        if (l.lastHbSent == 0 || now - l.lastHbSent >= l.hbInterval) {
+            l.lastHbSent = now;
+            l.frames++;
+            if (delivered(l)) l.hbToSlave = true;
+        }
+        if (l.online && l.heardBy != 0 && (int32_t)(now - l.heardBy) >= 0) {
+            l.online = false;
+            l.offlines++;
+            l.offlineAt = now;
+        }
+    }
+}
+
+static uint32_t run(Link& l, uint32_t from, uint32_t ms) {
+    uint32_t now = from;
+    for (uint32_t t = 0; t < ms; t += STEP_MS) step(l, now += STEP_MS);
+    return now;
+}
+
+struct Measured {
+    float framesPerMin;
+    float falsePerDay;
+    float meanDetect;      // s
+    float maxDetect;
+    float minDetect;
+};
+
+static Measured measure(float lossRate, bool active) {
+    Measured m = {};
+    Link l;
+
+    // Traffic and false offlines while the slave stays up
+    init(l, lossRate, active, 1);
+    uint32_t now = run(l, 0, WARMUP_MS);
+    uint32_t frames = l.frames;
+    uint32_t offlines = l.offlines;
+    run(l, now, SOAK_MS);
+    m.framesPerMin = (l.frames - frames) / (SOAK_MS / 60000.0f);
+    m.falsePerDay = (l.offlines - offlines) / (SOAK_MS / 86400000.0f);
+
+    // Detection: the slave dies at a random moment after warming up
+    double sum = 0;
+    m.minDetect = 1e9f;
+    for (uint32_t trial = 0; trial < TRIALS; trial++) {
+        init(l, lossRate, active, trial * 7919 + 3);
+        uint32_t dieAt = WARMUP_MS + (trial * 2741UL % 600UL) * STEP_MS;
+        now = run(l, 0, dieAt);
+        l.alive = false;
+        // Already offline by chance: wait for the next time it goes
+        if (!l.online) l.online = true;
+        uint32_t offlines = l.offlines;
+        while (l.offlines == offlines) step(l, now += STEP_MS);
+        float s = (l.offlineAt - dieAt) / 1000.0f;
+        sum += s;
+        if (s > m.maxDetect) m.maxDetect = s;
+        if (s < m.minDetect) m.minDetect = s;
+    }
+    m.meanDetect = sum / TRIALS;
+    return m;
+}
+
+static Measured report(float lossRate, bool active) {
+    Measured m = measure(lossRate, active);
+    char line[128];
+    snprintf(line, sizeof(line),
+             "%-6s %2d%% loss: %5.1f frames/min, %5.2f false offline/day, detected in %3.0f-%3.0f s (mean %3.0f)",
+             active ? "active" : "idle", (int)(lossRate * 100 + 0.5f), m.framesPerMin, m.falsePerDay,
+             m.minDetect, m.maxDetect, m.meanDetect);
+    TEST_MESSAGE(line);
+    return m;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_misses_grow_with_loss(void) {
+    LinkStats link = {};
+    TEST_ASSERT_EQUAL(NODE_TIMEOUT_MISSES, LinkTiming::timeoutMisses(link));
+    link.prev_rx = 80;
+    link.prev_lost = 20;                   // 20%: 0.2^5 < 0.1%
+    TEST_ASSERT_EQUAL(5, LinkTiming::timeoutMisses(link));
+    TEST_ASSERT_EQUAL(NODE_HEARTBEAT_IDLE * 3 / 5, LinkTiming::interval(false, link));
+    link.prev_rx = 10;
+    link.prev_lost = 90;
+    TEST_ASSERT_EQUAL(NODE_TIMEOUT_MAX_MISSES, LinkTiming::timeoutMisses(link));
+    TEST_ASSERT_EQUAL(NODE_HEARTBEAT_MIN, LinkTiming::interval(true, link));
+}
+
+// Gaps count as losses; a restart of the counter does not
+void test_loss_from_sequence_gaps(void) {
+    LinkStats link = {};
+    for (uint16_t seq = 1; seq <= 40; seq += 2) LinkTiming::trackRx(link, seq);
+    TEST_ASSERT_EQUAL(19, link.lost_total);
+    LinkTiming::trackRx(link, 39);         // Late
+    LinkTiming::trackRx(link, 5000);       // Restarted
+    TEST_ASSERT_EQUAL(19, link.lost_total);
+    TEST_ASSERT_EQUAL(21, link.rx_total);
+}
+
+void test_clean_link(void) {
+    Measured idle = report(0.0f, false);
+    Measured active = report(0.0f, true);
+
+    // Idle: master HB, slave reply, ACK, status and OTA status per 40 s
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 7.5f, idle.framesPerMin);
+    TEST_ASSERT_TRUE(idle.falsePerDay == 0);
+    uint32_t idleDeadline = NODE_HEARTBEAT_IDLE * NODE_TIMEOUT_MISSES + NODE_TIMEOUT_MARGIN;
+    TEST_ASSERT_LESS_OR_EQUAL((idleDeadline + NODE_HEARTBEAT_MIN) / 1000.0f, idle.maxDetect);
+
+    TEST_ASSERT_TRUE(active.falsePerDay == 0);
+    uint32_t activeDeadline = NODE_HEARTBEAT_FAST * NODE_TIMEOUT_MISSES + NODE_TIMEOUT_MARGIN;
+    TEST_ASSERT_LESS_OR_EQUAL((activeDeadline + NODE_HEARTBEAT_MIN) / 1000.0f, active.maxDetect);
+}
+
+// Losing frames must neither flap the slave nor slow detection down: the
+// interval shrinks as the miss allowance grows. Only an interval held up
+// by NODE_HEARTBEAT_MIN gets a longer deadline.
+void test_lossy_link(void) {
+    static const float rates[] = { 0.1f, 0.2f, 0.3f };
+    for (uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        for (uint8_t active = 0; active < 2; active++) {
+            Measured m = report(rates[i], active);
+            uint32_t base = active ? NODE_HEARTBEAT_FAST : NODE_HEARTBEAT_IDLE;
+            uint32_t deadline = base * NODE_TIMEOUT_MISSES;
+            if (deadline < NODE_HEARTBEAT_MIN * NODE_TIMEOUT_MAX_MISSES) {
+                deadline = NODE_HEARTBEAT_MIN * NODE_TIMEOUT_MAX_MISSES;
+            }
+            float bound = (deadline + NODE_TIMEOUT_MARGIN + NODE_HEARTBEAT_MIN) / 1000.0f;
+            TEST_ASSERT_LESS_THAN(1.0f, m.falsePerDay);
+            TEST_ASSERT_LESS_OR_EQUAL(bound, m.maxDetect);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_misses_grow_with_loss);
+    RUN_TEST(test_loss_from_sequence_gaps);
+    RUN_TEST(test_clean_link);
+    RUN_TEST(test_lossy_link);
+    return UNITY_END();
+}
@@ -0,0 +1,249 @@
+// The whole firmware built for the host, taking Home Assistant commands
+// through a real broker
+//   mosquitto -p 1883 &
+//   pio test -e native_web -f test_mqtt -v     (-v shows the mqtt_storm.py report)
+//
+// As in test_web, setup() and loop() are main.cpp's on lib/ArduinoShim.
+// The controller connects to the broker on 127.0.0.1:BROKER_PORT; this
+// test plays Home Assistant with its own PubSubClient. Commands are
+// published while loop() is held, so they reach the controller as one
+// burst and are applied in one update() batch, the case where the command
+// queue merges. Skipped when no broker is listening.
+
+#include <unity.h>
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include "Config.h"
+#include "HomeAssistantIntegration.h"
+
+// main.cpp
+void setup();
+void loop();
+extern IrrigationController* irrigationController;
+extern HomeAssistantIntegration* homeAssistant;
+
+#define BROKER_PORT      1883
+#define BURST_SETTLE_MS  200    // Broker to controller socket, loop() held
+#define STORM_RATE       40     // Commands per second
+#define STORM_SECONDS    10
+
+static char fsRoot[] = "/tmp/irrigation_fsXXXXXX";
+static uint16_t httpPort;
+static bool brokerUp;
+
+static WiFiClient haSocket;
+static PubSubClient ha(haSocket);
+static String lastDuration[MAX_CHANNELS + 1];   // Retained .../channel/N/duration
+
+static void writeFile(const char* name, const char* content) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s%s", fsRoot, name);
+    FILE* f = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fputs(content, f);
+    fclose(f);
+}
+
+static void onMessage(char* topic, byte* payload, unsigned int length) {
+    int ch;
+    char suffix[16];
+    String base = String(MQTT_BASE_TOPIC) + "/channel/%d/%15s";
+    if (sscanf(topic, base.c_str(), &ch, suffix) == 2 && strcmp(suffix, "duration") == 0 &&
+        ch >= 1 && ch <= MAX_CHANNELS) {
+        lastDuration[ch] = String((const char*)payload).substring(0, length);
+    }
+}
+
+static bool publish(const String& suffix, const char* payload) {
+    return ha.publish((String(MQTT_BASE_TOPIC) + "/" + suffix).c_str(), payload);
+}
+
+static void command(const char* suffix, const char* payload) {
+    TEST_ASSERT_TRUE(publish(suffix, payload));
+}
+
+// Runs loop() and the test's client for ms
+static void runFor(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        loop();
+        ha.loop();
+        delay(1);
+    }
+}
+
+// Lets a burst reach the controller's socket, then applies it
+static void deliverBurst() {
+    unsigned long start = millis();
+    while (millis() - start < BURST_SETTLE_MS) {
+        ha.loop();
+        delay(1);
+    }
+    runFor(300);
+}
+
+void setUp(void) {
+    if (!brokerUp) TEST_IGNORE_MESSAGE("No MQTT broker on 127.0.0.1:1883 (start mosquitto)");
+}
+
+void tearDown(void) {
+    if (!brokerUp) return;
+    publish("command", "ON");
+    for (uint8_t ch = 1; ch <= 4; ch++) {
+        publish(String("channel/") + String(ch) + "/command", "OFF");
+    }
+    runFor(300);
+}
+
+void test_connects(void) {
+    unsigned long start = millis();
+    while (!homeAssistant->isConnected() && millis() - start < 10000) runFor(50);
+    TEST_ASSERT_TRUE(homeAssistant->isConnected());
+
+    TEST_ASSERT_TRUE(ha.connect("irrigation_test"));
+    TEST_ASSERT_TRUE(ha.subscribe((String(MQTT_BASE_TOPIC) + "/channel/+/duration").c_str()));
+    runFor(300);
+}
+
+// duration/set 10, ON, duration/set 20 must run at 10 and leave 20 set
+void test_duration_not_merged_across_command(void) {
+    homeAssistant->resetCommandStats();
+    lastDuration[1] = String();
+    command("channel/1/duration/set", "10");
+    command("channel/1/command", "ON");
+    command("channel/1/duration/set", "20");
+    deliverBurst();
+
+    const MqttCommandStats& stats = homeAssistant->getCommandStats();
+    TEST_ASSERT_EQUAL_UINT32(3, stats.received);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.coalesced);
+    TEST_ASSERT_TRUE(irrigationController->isChannelIrrigating(1));
+    unsigned long remaining = irrigationController->getChannelRemaining(1);
+    TEST_ASSERT_TRUE(remaining > 9 * 60 && remaining <= 10 * 60);
+    TEST_ASSERT_EQUAL_STRING("20", lastDuration[1].c_str());
+}
+
+// A repeat on a topic keeps the older command's place in the batch
+void test_repeat_merged_in_place(void) {
+    homeAssistant->resetCommandStats();
+    lastDuration[2] = String();
+    command("channel/2/duration/set", "5");
+    command("channel/3/command", "OFF");            // Another channel: no dependency
+    command("channel/2/duration/set", "7");
+    command("channel/2/command", "ON");
+    deliverBurst();
+
+    const MqttCommandStats& stats = homeAssistant->getCommandStats();
+    TEST_ASSERT_EQUAL_UINT32(4, stats.received);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.processed);
+    TEST_ASSERT_EQUAL_STRING("7", lastDuration[2].c_str());
+    unsigned long remaining = irrigationController->getChannelRemaining(2);
+    TEST_ASSERT_TRUE(remaining > 6 * 60 && remaining <= 7 * 60);
+}
+
+// A system switch touches every channel, so nothing merges across it
+void test_not_merged_across_system_command(void) {
+    homeAssistant->resetCommandStats();
+    command("channel/4/command", "ON");
+    command("command", "OFF");
+    command("channel/4/command", "ON");
+    command("command", "ON");
+    deliverBurst();
+
+    const MqttCommandStats& stats = homeAssistant->getCommandStats();
+    TEST_ASSERT_EQUAL_UINT32(0, stats.coalesced);
+    TEST_ASSERT_FALSE(irrigationController->isChannelIrrigating(4));  // Ignored while disabled
+}
+
+void test_storm(void) {
+    if (access("mqtt_storm.py", R_OK) != 0) {
+        TEST_IGNORE_MESSAGE("mqtt_storm.py not found: run from the project directory");
+    }
+
+    char cmd[192];
+    snprintf(cmd, sizeof(cmd),
+             "python3 mqtt_storm.py 127.0.0.1 --port %d --channels 1-4 --rate %d --duration %d "
+             "--http 127.0.0.1:%u 2>&1",
+             BROKER_PORT, STORM_RATE, STORM_SECONDS, httpPort);
+
+    // The storm runs from a second thread while this one runs loop()
+    String report;
+    int status = -1;
+    std::atomic<bool> done(false);
+    std::thread worker([&]() {
+        FILE* p = popen(cmd, "r");
+        if (p) {
+            char line[256];
+            while (fgets(line, sizeof(line), p)) report += line;
+            status = pclose(p);
+        }
+        done = true;
+    });
+    while (!done) runFor(5);
+    worker.join();
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 127) TEST_IGNORE_MESSAGE("python3 not found");
+    if (report.indexOf("paho-mqtt is required") >= 0) TEST_IGNORE_MESSAGE("paho-mqtt not installed");
+
+    int start = 0;
+    while (start < (int)report.length()) {
+        int end = report.indexOf('\n', start);
+        if (end < 0) end = report.length();
+        TEST_MESSAGE(report.substring(start, end).c_str());
+        start = end + 1;
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+                             "mqtt_storm.py failed or saw lost commands");
+    TEST_ASSERT_TRUE(report.indexOf("device received") >= 0);
+}
+
+int main(int argc, char** argv) {
+    {
+        WiFiClient probe;
+        brokerUp = probe.connect("127.0.0.1", BROKER_PORT);
+        probe.stop();
+    }
+
+    // Scratch flash for a master with MQTT and the web UI (for /api/metrics)
+    if (!mkdtemp(fsRoot)) return 1;
+    setenv("SHIM_LITTLEFS_ROOT", fsRoot, 1);
+    writeFile(WIFI_CREDENTIALS_FILE, "{\"ssid\":\"host\",\"password\":\"host\"}");
+    writeFile(CONFIG_FILE,
+              "{\"node_id\":\"node_host\",\"role\":\"master\",\"timezone\":\"UTC0\","
+              "\"features\":{\"multi_node\":false,\"mqtt\":true,\"web_ui\":true}}");
+    char creds[96];
+    snprintf(creds, sizeof(creds), "{\"broker\":\"127.0.0.1\",\"port\":%d}", BROKER_PORT);
+    writeFile(MQTT_CREDENTIALS_FILE, creds);
+
+    char port[8];
+    httpPort = 18000 + getpid() % 1000;
+    snprintf(port, sizeof(port), "%u", httpPort);
+    setenv("SHIM_HTTP_PORT", port, 1);
+
+    ha.setServer("127.0.0.1", BROKER_PORT);
+    ha.setCallback(onMessage);
+
+    setup();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_connects);
+    RUN_TEST(test_duration_not_merged_across_command);
+    RUN_TEST(test_repeat_merged_in_place);
+    RUN_TEST(test_not_merged_across_system_command);
+    RUN_TEST(test_storm);
+    int failures = UNITY_END();
+
+    char cleanup[64];
+    snprintf(cleanup, sizeof(cleanup), "rm -rf %s", fsRoot);
+    system(cleanup);
+    return failures;
+}
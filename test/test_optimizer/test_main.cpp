@@ -0,0 +1,98 @@
+// ScheduleOptimizer on a full 64-zone table: constraints and solve time
+//   pio test -e native -f test_optimizer -v     (-v shows the timings)
+
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include "ScheduleOptimizer.h"
+
+#define BENCH_REPS 100
+
+static ScheduleOptimizer optimizer;
+static uint32_t randState;
+
+static uint32_t nextRandom(uint32_t range) {
+    randState = randState * 1664525UL + 1013904223UL;
+    return (randState >> 8) % range;
+}
+
+// 64 zones over 3 supplies (limits 2, 3, 1), mixed weekday patterns,
+// 5-44 minute runs inside 05:00-20:00
+static void fillTable() {
+    static const uint8_t patterns[4] = { 0x7F, 0x2A, 0x55, 0x41 };
+    optimizer.reset();
+    optimizer.setSupplyLimit(0, 2);
+    optimizer.setSupplyLimit(1, 3);
+    optimizer.setSupplyLimit(2, 1);
+    for (uint8_t i = 0; i < SCHEDULE_OPT_MAX_ZONES; i++) {
+        OptZone z = {};
+        z.channel = i + 1;
+        z.supply = i % 3;
+        z.weekdays = patterns[i % 4];
+        z.durationMinutes = 5 + nextRandom(40);
+        z.windowStart = 300;
+        z.windowEnd = 1200;
+        z.flow = 50 + nextRandom(150);
+        TEST_ASSERT_EQUAL(i, optimizer.addZone(z));
+    }
+}
+
+void setUp(void) {
+    randState = 1;
+    fillTable();
+}
+
+void tearDown(void) {}
+
+void test_places_every_zone(void) {
+    TEST_ASSERT_TRUE(optimizer.solve());
+    TEST_ASSERT_EQUAL(SCHEDULE_OPT_MAX_ZONES, optimizer.getPlacedCount());
+    for (uint8_t i = 0; i < optimizer.getZoneCount(); i++) {
+        const OptZone& z = optimizer.getZone(i);
+        TEST_ASSERT_TRUE(optimizer.isPlaced(i));
+        TEST_ASSERT_TRUE(optimizer.getStart(i) >= z.windowStart);
+        TEST_ASSERT_TRUE(optimizer.getStart(i) + z.durationMinutes <= z.windowEnd);
+    }
+}
+
+// Every minute of every weekday within each supply's concurrency limit
+void test_respects_supply_limits(void) {
+    static const uint8_t limits[3] = { 2, 3, 1 };
+    TEST_ASSERT_TRUE(optimizer.solve());
+    for (uint8_t day = 0; day < 7; day++) {
+        for (uint16_t minute = 0; minute < SCHEDULE_OPT_MINUTES_DAY; minute++) {
+            uint8_t running[3] = { 0, 0, 0 };
+            for (uint8_t i = 0; i < optimizer.getZoneCount(); i++) {
+                const OptZone& z = optimizer.getZone(i);
+                if (!(z.weekdays & (1 << day))) continue;
+                uint16_t start = optimizer.getStart(i);
+                if (start <= minute && minute < start + z.durationMinutes) running[z.supply]++;
+            }
+            for (uint8_t s = 0; s < 3; s++) TEST_ASSERT_TRUE(running[s] <= limits[s]);
+        }
+    }
+}
+
+void test_solve_time_64_zones(void) {
+    bool ok = false;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint8_t rep = 0; rep < BENCH_REPS; rep++) ok = optimizer.solve();
+    auto t1 = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / BENCH_REPS;
+
+    char line[96];
+    snprintf(line, sizeof(line), "64 zones: %.3f ms per solve, window %u-%u, peak %lu",
+             ms, optimizer.getWindowStart(), optimizer.getWindowEnd(),
+             (unsigned long)optimizer.getPeakFlow());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_LESS_THAN(50.0, ms);  // Generous host budget: catches complexity blow-ups
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_places_every_zone);
+    RUN_TEST(test_respects_supply_limits);
+    RUN_TEST(test_solve_time_64_zones);
+    return UNITY_END();
+}
@@ -0,0 +1,182 @@
+// Synthetic pressure traces replayed through PressureDetector
+//   pio test -e native -f test_pressure
+
+#include <unity.h>
+#include "PressureDetector.h"
+
+#define SAMPLE_MS 20                   // 50 Hz block means
+
+static PressureDetector detector;
+static uint32_t now;
+static uint32_t noiseState;
+
+// +-0.5 kPa of repeatable sensor noise
+static float noise() {
+    noiseState = noiseState * 1664525UL + 1013904223UL;
+    return ((noiseState >> 8) & 0xFFFF) / 65535.0f - 0.5f;
+}
+
+// Feeds a linear ramp from `from` to `to` kPa over `ms`; returns the first
+// event and stores when it came in *at
+static uint8_t ramp(float from, float to, uint32_t ms, uint32_t* at = nullptr) {
+    uint32_t steps = ms / SAMPLE_MS;
+    for (uint32_t i = 0; i < steps; i++) {
+        float kPa = from + (to - from) * i / steps;
+        now += SAMPLE_MS;
+        uint8_t event = detector.addSample(kPa + noise(), now);
+        if (event != PRESSURE_EVENT_NONE) {
+            if (at) *at = now;
+            return event;
+        }
+    }
+    return PRESSURE_EVENT_NONE;
+}
+
+static uint8_t hold(float kPa, uint32_t ms) {
+    return ramp(kPa, kPa, ms);
+}
+
+// Idle line, settled on a known static pressure
+static void settleStatic(float kPa) {
+    detector.setStaticBaseline(kPa);
+    detector.setOpenZones(0, now);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(kPa, 120000));
+    detector.takeBaselinesChanged();
+}
+
+void setUp(void) {
+    detector = PressureDetector();
+    now = 1000;
+    noiseState = 12345;
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Static pressure
+// ============================================================================
+
+void test_learns_static_baseline(void) {
+    detector.setOpenZones(0, now);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(400, 10000));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 400.0f, detector.getStaticBaseline());
+    TEST_ASSERT_TRUE(detector.takeBaselinesChanged());
+    TEST_ASSERT_FALSE(detector.takeBaselinesChanged());
+}
+
+// 400 kPa line draining at `rate` kPa/s must alarm once it is
+// PRESSURE_LEAK_DROP down, give or take the filter and the hold
+static void slowDrain(float rate) {
+    settleStatic(400);
+    uint32_t start = now;
+    uint32_t at = 0;
+    uint32_t ms = (uint32_t)(400 / rate * 1000);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_LEAK, ramp(400, 0, ms, &at));
+    float seconds = (at - start) / 1000.0f;
+    TEST_ASSERT_LESS_THAN(PRESSURE_LEAK_DROP / rate + PRESSURE_LEAK_HOLD_MS / 1000.0f + 2.0f, seconds);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_LEAK, detector.getAlarm());
+}
+
+void test_slow_drain_0_2_kpa_per_s(void) { slowDrain(0.2f); }
+void test_slow_drain_0_5_kpa_per_s(void) { slowDrain(0.5f); }
+void test_slow_drain_1_kpa_per_s(void) { slowDrain(1.0f); }
+void test_fast_drain_10_kpa_per_s(void) { slowDrain(10.0f); }
+
+void test_step_drop_raises_leak(void) {
+    settleStatic(400);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_LEAK, hold(360, 5000));
+}
+
+void test_short_dip_is_not_a_leak(void) {
+    settleStatic(400);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(380, 1000));
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(400, 60000));
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, detector.getAlarm());
+}
+
+// Supply falls 10 kPa over 5 hours and comes back: followed, no alarm
+void test_supply_drift_is_followed(void) {
+    settleStatic(400);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, ramp(400, 390, 5UL * 3600000UL));
+    TEST_ASSERT_FLOAT_WITHIN(PRESSURE_DRIFT_BAND, 390.0f, detector.getStaticBaseline());
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, ramp(390, 405, 5UL * 3600000UL));
+    TEST_ASSERT_FLOAT_WITHIN(PRESSURE_DRIFT_BAND, 405.0f, detector.getStaticBaseline());
+}
+
+// A supply step smaller than a leak is accepted once it stops deepening,
+// and leaks are then measured from the new level
+void test_supply_step_reanchors(void) {
+    settleStatic(400);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(392, PRESSURE_SAG_STEADY_MS + 10000));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 392.0f, detector.getStaticBaseline());
+    TEST_ASSERT_TRUE(detector.takeBaselinesChanged());
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_LEAK, hold(372, 5000));
+}
+
+// Hours of a steady line must not ask for the baseline file to be rewritten
+void test_noise_does_not_flag_baseline(void) {
+    settleStatic(400);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(400, 2UL * 3600000UL));
+    TEST_ASSERT_FALSE(detector.takeBaselinesChanged());
+}
+
+void test_acknowledged_leak_accepts_level(void) {
+    settleStatic(400);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_LEAK, hold(350, 5000));
+    detector.clearAlarm();
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 350.0f, detector.getStaticBaseline());
+    TEST_ASSERT_TRUE(detector.takeBaselinesChanged());
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(350, 60000));
+}
+
+// ============================================================================
+// Zones open
+// ============================================================================
+
+void test_burst_while_open(void) {
+    detector.setZoneBaseline(1, 300);
+    detector.setOpenZones(0x01, now);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(300, 10000));
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_BURST, hold(150, 5000));
+    TEST_ASSERT_EQUAL_HEX32(0x01, detector.getAlarmZones());
+}
+
+void test_neighbour_tap_is_not_a_burst(void) {
+    detector.setOpenZones(0x01, now);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(300, 10000));
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(270, 30000));
+}
+
+void test_opening_onto_broken_lateral(void) {
+    detector.setZoneBaseline(2, 300);
+    detector.setOpenZones(0x02, now);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_BURST, hold(120, 5000));
+}
+
+void test_clean_run_learns_zone_baseline(void) {
+    detector.setOpenZones(0x04, now);
+    TEST_ASSERT_EQUAL(PRESSURE_EVENT_NONE, hold(280, 20000));
+    detector.setOpenZones(0, now);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 280.0f, detector.getZoneBaseline(3));
+    TEST_ASSERT_TRUE(detector.takeBaselinesChanged());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_learns_static_baseline);
+    RUN_TEST(test_slow_drain_0_2_kpa_per_s);
+    RUN_TEST(test_slow_drain_0_5_kpa_per_s);
+    RUN_TEST(test_slow_drain_1_kpa_per_s);
+    RUN_TEST(test_fast_drain_10_kpa_per_s);
+    RUN_TEST(test_step_drop_raises_leak);
+    RUN_TEST(test_short_dip_is_not_a_leak);
+    RUN_TEST(test_supply_drift_is_followed);
+    RUN_TEST(test_supply_step_reanchors);
+    RUN_TEST(test_noise_does_not_flag_baseline);
+    RUN_TEST(test_acknowledged_leak_accepts_level);
+    RUN_TEST(test_burst_while_open);
+    RUN_TEST(test_neighbour_tap_is_not_a_burst);
+    RUN_TEST(test_opening_onto_broken_lateral);
+    RUN_TEST(test_clean_run_learns_zone_baseline);
+    return UNITY_END();
+}
@@ -0,0 +1,307 @@
+// RolloutPlanner driven by a simulated fleet
+//   pio test -e native -f test_rollout
+//
+// Each simulated slave follows an install order the way a real one reports
+// it in its heartbeats: job running for a minute, offline for 20 s while
+// it restarts, then back with the new version (or not, per its fault).
+
+#include <unity.h>
+#include <string.h>
+#include "RolloutPlanner.h"
+
+#define STEP_MS     5000               // processRollout() runs on the heartbeat tick
+#define LIMIT_MS    (12UL * 3600000UL)
+
+static const char* const TARGET = "1.1.0";
+static const char* const OLD = "1.0.0";
+
+enum Fault {
+    FAULT_NONE,
+    FAULT_NEVER_STARTS,                // Ignores the order
+    FAULT_STAYS_OLD,                   // Restarts into the old image
+    FAULT_REBOOTS_IN_SOAK,             // Restarts again 5 min after coming back
+    FAULT_CRASHES_IN_SOAK,             // ...and reports a crash
+};
+
+struct SimNode {
+    RolloutNode node;
+    Fault fault;
+    uint8_t phase;                     // 0 idle, 1 downloading, 2 restarting, 3 back
+    uint32_t phaseAt;
+    uint32_t busyFrom;                 // Valve open in [busyFrom, busyUntil)
+    uint32_t busyUntil;
+    uint32_t offlineUntil;
+    uint8_t orders;
+};
+
+static SimNode fleet[ROLLOUT_MAX_NODES];
+static RolloutNode snapshot[ROLLOUT_MAX_NODES];
+static uint8_t fleetSize;
+static RolloutPlanner planner;
+static uint32_t now;
+static uint8_t maxInFlight;
+
+static SimNode& addNode(const char* id, Fault fault = FAULT_NONE, const char* version = OLD) {
+    SimNode& s = fleet[fleetSize++];
+    memset(&s, 0, sizeof(s));
+    strncpy(s.node.nodeId, id, sizeof(s.node.nodeId) - 1);
+    strncpy(s.node.version, version, sizeof(s.node.version) - 1);
+    s.node.online = true;
+    s.fault = fault;
+    return s;
+}
+
+static void tick(SimNode& s) {
+    s.node.online = now >= s.offlineUntil;
+    s.node.busy = now >= s.busyFrom && now < s.busyUntil;
+    if (s.node.online) s.node.valveReportAt = now;
+
+    switch (s.phase) {
+        case 1:
+            s.node.jobRunning = true;
+            if (now - s.phaseAt >= 60000) {
+                s.phase = 2;
+                s.phaseAt = now;
+                s.offlineUntil = now + 20000;
+                s.node.online = false;
+                s.node.version[0] = '\0';
+            }
+            break;
+        case 2:
+            if (now >= s.offlineUntil) {
+                s.node.reboots++;
+                s.node.jobRunning = false;
+                strcpy(s.node.version, s.fault == FAULT_STAYS_OLD ? OLD : TARGET);
+                s.phase = 3;
+                s.phaseAt = now;
+            }
+            break;
+        case 3:
+            if ((s.fault == FAULT_REBOOTS_IN_SOAK || s.fault == FAULT_CRASHES_IN_SOAK) &&
+                now - s.phaseAt == 300000) {
+                s.node.reboots++;
+                if (s.fault == FAULT_CRASHES_IN_SOAK) s.node.crashes++;
+            }
+            break;
+    }
+}
+
+static void takeSnapshot() {
+    for (uint8_t i = 0; i < fleetSize; i++) snapshot[i] = fleet[i].node;
+}
+
+static void stepOnce() {
+    now += STEP_MS;
+    for (uint8_t i = 0; i < fleetSize; i++) tick(fleet[i]);
+    takeSnapshot();
+
+    uint32_t orders = planner.step(snapshot, fleetSize, now);
+    for (uint8_t i = 0; i < fleetSize; i++) {
+        if (!(orders & (1UL << i))) continue;
+        // Never an order for a node that is busy or away
+        TEST_ASSERT_TRUE(snapshot[i].online);
+        TEST_ASSERT_FALSE(snapshot[i].busy);
+        SimNode& s = fleet[i];
+        s.orders++;
+        if (s.fault == FAULT_NEVER_STARTS || s.node.busy) continue;
+        s.phase = 1;
+        s.phaseAt = now;
+    }
+
+    uint8_t inFlight = 0;
+    for (uint8_t i = 0; i < planner.getEntryCount(); i++) {
+        uint8_t state = planner.getEntry(i).state;
+        if (state == ROLLOUT_NODE_ORDERED || state == ROLLOUT_NODE_UPDATING ||
+            state == ROLLOUT_NODE_SOAKING) inFlight++;
+    }
+    if (inFlight > maxInFlight) maxInFlight = inFlight;
+}
+
+static void startRollout(const char* canary = nullptr) {
+    takeSnapshot();
+    TEST_ASSERT_TRUE(planner.start(TARGET, snapshot, fleetSize, canary, now));
+}
+
+static void runToEnd() {
+    while (planner.isRunning() && now < LIMIT_MS) stepOnce();
+    TEST_ASSERT_FALSE(planner.isRunning());
+}
+
+static const RolloutEntry& entry(uint8_t index) {
+    return planner.getEntry(index);
+}
+
+void setUp(void) {
+    planner = RolloutPlanner();
+    fleetSize = 0;
+    now = 1000;
+    maxInFlight = 0;
+}
+
+void tearDown(void) {}
+
+// ============================================================================
+// Scenarios
+// ============================================================================
+
+// Canary, then waves of 2 and 4; one wave in flight at a time
+void test_all_good(void) {
+    const char* ids[] = { "n1", "n2", "n3", "n4", "n5", "n6", "n7" };
+    for (uint8_t i = 0; i < 7; i++) addNode(ids[i]);
+    startRollout();
+    TEST_ASSERT_EQUAL(3, planner.getWaveCount());
+    runToEnd();
+
+    TEST_ASSERT_EQUAL(ROLLOUT_DONE, planner.getState());
+    TEST_ASSERT_EQUAL(0, entry(0).wave);
+    TEST_ASSERT_EQUAL(1, entry(1).wave);
+    TEST_ASSERT_EQUAL(1, entry(2).wave);
+    TEST_ASSERT_EQUAL(2, entry(6).wave);
+    TEST_ASSERT_EQUAL(4, maxInFlight);
+    for (uint8_t i = 0; i < fleetSize; i++) {
+        TEST_ASSERT_EQUAL(ROLLOUT_NODE_DONE, entry(i).state);
+        TEST_ASSERT_EQUAL(1, fleet[i].orders);
+    }
+}
+
+void test_canary_fails(void) {
+    addNode("canary", FAULT_CRASHES_IN_SOAK);
+    addNode("n2");
+    addNode("n3");
+    startRollout();
+    runToEnd();
+
+    TEST_ASSERT_EQUAL(ROLLOUT_HALTED, planner.getState());
+    TEST_ASSERT_EQUAL_STRING("canary: Restarted during the soak", planner.getReason());
+    TEST_ASSERT_EQUAL(ROLLOUT_NODE_FAILED, entry(0).state);
+    // Nothing else was touched
+    TEST_ASSERT_EQUAL(0, fleet[1].orders);
+    TEST_ASSERT_EQUAL(0, fleet[2].orders);
+    TEST_ASSERT_EQUAL(ROLLOUT_NODE_PENDING, entry(1).state);
+}
+
+// The canary stays away past ROLLOUT_OFFLINE_LIMIT: skipped, and the first
+// node of the next wave becomes the canary instead of the wave going ahead
+void test_skipped_canary_is_replaced(void) {
+    addNode("away").offlineUntil = LIMIT_MS;
+    addNode("n2");
+    addNode("n3");
+    addNode("n4");
+    startRollout("away");
+
+    while (planner.isRunning() && entry(0).state != ROLLOUT_NODE_SKIPPED) stepOnce();
+    TEST_ASSERT_TRUE(now >= ROLLOUT_OFFLINE_LIMIT);
+    TEST_ASSERT_EQUAL_STRING("Offline", entry(0).reason);
+
+    stepOnce();
+    TEST_ASSERT_EQUAL(ROLLOUT_CANARY, planner.getState());
+    TEST_ASSERT_EQUAL(0, entry(1).wave);
+    TEST_ASSERT_EQUAL(1, fleet[1].orders);
+    TEST_ASSERT_EQUAL(0, fleet[2].orders);
+
+    runToEnd();
+    TEST_ASSERT_EQUAL(ROLLOUT_DONE, planner.getState());
+    TEST_ASSERT_EQUAL(0, fleet[0].orders);
+    for (uint8_t i = 1; i < fleetSize; i++) TEST_ASSERT_EQUAL(ROLLOUT_NODE_DONE, entry(i).state);
+}
+
+// Busy at its turn: deferred. Busy again right after the order (a schedule
+// opened a valve before the node saw it): back to deferred once
+// ROLLOUT_START_TIMEOUT passes, and ordered again when idle
+void test_busy_node_is_deferred_and_reordered(void) {
+    addNode("canary");
+    SimNode& busy = addNode("busy");
+    addNode("n3");
+    startRollout();
+
+    // Busy from the moment the canary is through until 10 min into wave 1
+    while (planner.getState() == ROLLOUT_CANARY) stepOnce();
+    busy.busyFrom = 0;
+    busy.busyUntil = now + 600000;
+    stepOnce();
+    TEST_ASSERT_TRUE(entry(1).deferred);
+    TEST_ASSERT_EQUAL(ROLLOUT_NODE_PENDING, entry(1).state);
+    TEST_ASSERT_EQUAL(0, busy.orders);
+    TEST_ASSERT_EQUAL(1, fleet[2].orders);
+
+    // Idle: ordered; the valve opens again before it acts on the order
+    while (busy.orders == 0) stepOnce();
+    busy.busyFrom = now;
+    busy.busyUntil = now + ROLLOUT_START_TIMEOUT + 300000;
+    busy.phase = 0;
+    while (entry(1).state == ROLLOUT_NODE_ORDERED) stepOnce();
+    TEST_ASSERT_EQUAL(ROLLOUT_NODE_PENDING, entry(1).state);
+    TEST_ASSERT_TRUE(entry(1).deferred);
+    TEST_ASSERT_TRUE(planner.isRunning());
+
+    runToEnd();
+    TEST_ASSERT_EQUAL(ROLLOUT_DONE, planner.getState());
+    TEST_ASSERT_EQUAL(2, busy.orders);
+    TEST_ASSERT_EQUAL(ROLLOUT_NODE_DONE, entry(1).state);
+}
+
+void test_node_comes_back_on_old_version(void) {
+    addNode("canary");
+    addNode("stale", FAULT_STAYS_OLD);
+    addNode("n3");
+    addNode("n4");
+    startRollout();
+    runToEnd();
+
+    TEST_ASSERT_EQUAL(ROLLOUT_HALTED, planner.getState());
+    TEST_ASSERT_EQUAL_STRING("stale: Came back on the old version", planner.getReason());
+    TEST_ASSERT_EQUAL(ROLLOUT_NODE_DONE, entry(0).state);
+    // n4 is in the next wave: never ordered
+    TEST_ASSERT_EQUAL(0, fleet[3].orders);
+}
+
+// Online and idle, but no job ever shows up
+void test_start_timeout(void) {
+    addNode("deaf", FAULT_NEVER_STARTS);
+    addNode("n2");
+    startRollout();
+    runToEnd();
+
+    TEST_ASSERT_EQUAL(ROLLOUT_HALTED, planner.getState());
+    TEST_ASSERT_EQUAL_STRING("deaf: No install started", planner.getReason());
+    TEST_ASSERT_TRUE(entry(0).since - 1000 >= ROLLOUT_START_TIMEOUT);
+    TEST_ASSERT_EQUAL(0, fleet[1].orders);
+}
+
+void test_node_reboots_during_soak(void) {
+    addNode("canary");
+    addNode("n2");
+    addNode("flaky", FAULT_REBOOTS_IN_SOAK);
+    addNode("n4");
+    startRollout();
+    runToEnd();
+
+    TEST_ASSERT_EQUAL(ROLLOUT_HALTED, planner.getState());
+    TEST_ASSERT_EQUAL_STRING("flaky: Restarted during the soak", planner.getReason());
+    // Its wave partner was already ordered and finishes; the next wave waits
+    TEST_ASSERT_EQUAL(1, fleet[1].orders);
+    TEST_ASSERT_EQUAL(0, fleet[3].orders);
+}
+
+void test_nothing_to_do(void) {
+    addNode("n1", FAULT_NONE, TARGET);
+    addNode("n2", FAULT_NONE, "");
+    takeSnapshot();
+    TEST_ASSERT_TRUE(planner.start(TARGET, snapshot, fleetSize, nullptr, now));
+    TEST_ASSERT_EQUAL(ROLLOUT_DONE, planner.getState());
+    TEST_ASSERT_EQUAL_STRING("Already on the target", entry(0).reason);
+    TEST_ASSERT_EQUAL_STRING("No rollout support", entry(1).reason);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_all_good);
+    RUN_TEST(test_canary_fails);
+    RUN_TEST(test_skipped_canary_is_replaced);
+    RUN_TEST(test_busy_node_is_deferred_and_reordered);
+    RUN_TEST(test_node_comes_back_on_old_version);
+    RUN_TEST(test_start_timeout);
+    RUN_TEST(test_node_reboots_during_soak);
+    RUN_TEST(test_nothing_to_do);
+    return UNITY_END();
+}
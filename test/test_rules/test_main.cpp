@@ -0,0 +1,162 @@
+// RuleEngine: compiled conditions, budgeted passes and per-rule cost
+//   pio test -e native -f test_rules -v     (-v shows the timings)
+
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "RuleEngine.h"
+
+#define BENCH_EVALS 100000
+#define PASS_BUDGET 256                // RULE_TICK_BUDGET
+
+static RuleEngine engine;
+static float inputs[RULE_IN_COUNT];
+static uint8_t fired;
+static RuleAction lastAction;
+
+static float readInput(void* ctx, uint8_t input, float arg) {
+    (void)ctx;
+    if (input == RULE_IN_RUNNING || input == RULE_IN_REMAINING || input == RULE_IN_MOISTURE) {
+        // Per-channel inputs: channel 2 differs from the rest
+        return (arg == 2) ? inputs[input] : 0;
+    }
+    return inputs[input];
+}
+
+static void runAction(void* ctx, const Rule& rule) {
+    (void)ctx;
+    fired++;
+    lastAction = rule.action;
+}
+
+static const char* const conditions[] = {
+    "irrigating",
+    "moisture(2) > 60 && running(2)",
+    "pressure_alarm > 0 || !enabled",
+    "!mqtt && tod == 1080 && weekday != 0",
+    "hour >= 6 && hour < 9 && moisture(2) < 30 && !running(2) && wifi",
+    "(pressure < 150 || pressure > 600) && irrigating && remaining(2) > 5",
+};
+#define CONDITION_COUNT (sizeof(conditions) / sizeof(conditions[0]))
+
+void setUp(void) {
+    engine.clear();
+    engine.setCallbacks(readInput, runAction, nullptr);
+    for (uint8_t i = 0; i < RULE_IN_COUNT; i++) inputs[i] = 0;
+    fired = 0;
+    memset(&lastAction, 0, sizeof(lastAction));
+}
+
+void tearDown(void) {}
+
+static void runPass() {
+    engine.markDirty();
+    while (engine.isPending()) engine.run(PASS_BUDGET);
+}
+
+void test_compile_errors_leave_table_alone(void) {
+    char error[RULE_ERROR_LEN];
+    TEST_ASSERT_EQUAL(-1, engine.addRule("bad", "moisture(2) >", "stop 2", true, error));
+    TEST_ASSERT_EQUAL(-1, engine.addRule("bad", "bogus > 1", "stop 2", true, error));
+    TEST_ASSERT_EQUAL(-1, engine.addRule("bad", "wifi", "explode", true, error));
+    TEST_ASSERT_EQUAL(0, engine.getRuleCount());
+}
+
+// Fires on the false-to-true edge only
+void test_fires_on_edge(void) {
+    char error[RULE_ERROR_LEN];
+    TEST_ASSERT_EQUAL(0, engine.addRule("wet", "moisture(2) > 60 && running(2)", "stop 2", true, error));
+
+    inputs[RULE_IN_MOISTURE] = 70;
+    runPass();
+    TEST_ASSERT_EQUAL(0, fired);
+
+    inputs[RULE_IN_RUNNING] = 1;
+    runPass();
+    TEST_ASSERT_EQUAL(1, fired);
+    TEST_ASSERT_EQUAL(RULE_ACT_STOP, lastAction.op);
+    TEST_ASSERT_EQUAL(2, lastAction.target);
+
+    runPass();
+    TEST_ASSERT_EQUAL(1, fired);
+
+    inputs[RULE_IN_RUNNING] = 0;
+    runPass();
+    inputs[RULE_IN_RUNNING] = 1;
+    runPass();
+    TEST_ASSERT_EQUAL(2, fired);
+}
+
+void test_unknown_input_compares_false(void) {
+    char error[RULE_ERROR_LEN];
+    TEST_ASSERT_EQUAL(0, engine.addRule("low", "pressure < 150", "stop", true, error));
+    TEST_ASSERT_EQUAL(1, engine.addRule("high", "pressure >= 150", "stop", true, error));
+    inputs[RULE_IN_PRESSURE] = NAN;
+    float result;
+    TEST_ASSERT_TRUE(engine.evaluate(0, result));
+    TEST_ASSERT_TRUE(result == 0);
+    TEST_ASSERT_TRUE(engine.evaluate(1, result));
+    TEST_ASSERT_TRUE(result == 0);
+}
+
+// A full table whose pass needs more than one budget resumes where it stopped
+void test_pass_split_across_budgets(void) {
+    char error[RULE_ERROR_LEN];
+    for (uint8_t i = 0; i < RULE_MAX_RULES; i++) {
+        const char* when = conditions[CONDITION_COUNT - 1];
+        TEST_ASSERT_EQUAL(i, engine.addRule("r", when, "stop", true, error));
+    }
+    engine.markDirty();
+    uint8_t calls = 0;
+    while (engine.isPending()) {
+        TEST_ASSERT_TRUE(engine.run(32) <= 32);
+        calls++;
+    }
+    TEST_ASSERT_TRUE(calls > 1);
+    TEST_ASSERT_TRUE(engine.getDeferrals() > 0);
+    for (uint8_t i = 0; i < RULE_MAX_RULES; i++) {
+        TEST_ASSERT_EQUAL(1, engine.getRule(i)->evaluations);
+    }
+}
+
+// Per-rule cost: code size, instructions and time per evaluation
+void test_evaluation_cost_per_rule(void) {
+    char error[RULE_ERROR_LEN];
+    inputs[RULE_IN_HOUR] = 7;
+    inputs[RULE_IN_MOISTURE] = 20;
+    inputs[RULE_IN_WIFI] = 1;
+    inputs[RULE_IN_ENABLED] = 1;
+    inputs[RULE_IN_IRRIGATING] = 1;
+    inputs[RULE_IN_PRESSURE] = 120;
+    inputs[RULE_IN_REMAINING] = 10;
+
+    for (uint8_t i = 0; i < CONDITION_COUNT; i++) {
+        TEST_ASSERT_EQUAL(i, engine.addRule("r", conditions[i], "stop", true, error));
+
+        float result = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < BENCH_EVALS; n++) engine.evaluate(i, result);
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_EVALS;
+
+        const Rule* rule = engine.getRule(i);
+        char line[160];
+        snprintf(line, sizeof(line), "%2u bytes, %2u steps, %6.1f ns: %s",
+                 rule->codeLen, rule->lastSteps, ns, conditions[i]);
+        TEST_MESSAGE(line);
+        TEST_ASSERT_TRUE(rule->lastSteps <= rule->codeLen);
+        TEST_ASSERT_LESS_THAN(5000.0, ns);  // Generous host budget: catches complexity blow-ups
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_compile_errors_leave_table_alone);
+    RUN_TEST(test_fires_on_edge);
+    RUN_TEST(test_unknown_input_compares_false);
+    RUN_TEST(test_pass_split_across_budgets);
+    RUN_TEST(test_evaluation_cost_per_rule);
+    return UNITY_END();
+}
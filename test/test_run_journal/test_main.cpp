@@ -0,0 +1,135 @@
+// RunJournal ring (slave) and RunHistory ordering (master)
+//   pio test -e native -f test_run_journal
+
+#include <unity.h>
+#include <string.h>
+#include "RunJournal.h"
+
+static RunJournal journal;
+static RunHistory history;
+
+static RunRecord run(uint32_t start, uint8_t channel = 1) {
+    RunRecord r = {};
+    r.start = start;
+    r.duration_s = 600;
+    r.volume_dl = RUN_VOLUME_NONE;
+    r.channel = channel;
+    r.reason = RUN_END_COMPLETE;
+    return r;
+}
+
+// Records oldest first with consecutive sequence numbers from first
+static void expectSeqs(uint16_t first, uint8_t count) {
+    TEST_ASSERT_EQUAL(count, journal.getCount());
+    for (uint8_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)(first + i), journal.at(i).seq);
+        TEST_ASSERT_EQUAL_UINT32(1000 + (uint16_t)(first + i), journal.at(i).start);
+    }
+}
+
+static void appendRuns(uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        journal.append(run(1000 + journal.getNextSeq()));
+    }
+}
+
+void setUp(void) {
+    journal.clear();
+    history.clear();
+}
+
+void tearDown(void) {}
+
+void test_append_and_ack(void) {
+    appendRuns(5);
+    expectSeqs(1, 5);
+    TEST_ASSERT_EQUAL(3, journal.acknowledge(3));
+    expectSeqs(4, 2);
+    TEST_ASSERT_EQUAL(0, journal.acknowledge(2));   // Stale ACK
+    TEST_ASSERT_EQUAL(2, journal.acknowledge(9));   // Past the newest
+    TEST_ASSERT_EQUAL(0, journal.getCount());
+    TEST_ASSERT_EQUAL_UINT16(6, journal.getNextSeq());
+}
+
+// Full: the oldest is overwritten, the ring keeps its order across the end
+void test_ring_wraps(void) {
+    appendRuns(RUN_JOURNAL_SIZE + 10);
+    TEST_ASSERT_EQUAL_UINT32(10, journal.getOverwritten());
+    expectSeqs(11, RUN_JOURNAL_SIZE);
+
+    // Acknowledge past the physical end of the array, then refill
+    TEST_ASSERT_EQUAL(RUN_JOURNAL_SIZE - 4, journal.acknowledge(RUN_JOURNAL_SIZE + 6));
+    expectSeqs(RUN_JOURNAL_SIZE + 7, 4);
+    appendRuns(RUN_JOURNAL_SIZE - 4);
+    expectSeqs(RUN_JOURNAL_SIZE + 7, RUN_JOURNAL_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(10, journal.getOverwritten());
+
+    appendRuns(1);
+    TEST_ASSERT_EQUAL_UINT32(11, journal.getOverwritten());
+    expectSeqs(RUN_JOURNAL_SIZE + 8, RUN_JOURNAL_SIZE);
+}
+
+// Sequence numbers wrap at 16 bits; ACKs are judged by signed distance
+void test_sequence_wraps(void) {
+    RunRecord none = {};
+    journal.restore(&none, 0, 65530);
+    appendRuns(10);
+    TEST_ASSERT_EQUAL_UINT16(65530, journal.at(0).seq);
+    TEST_ASSERT_EQUAL_UINT16(3, journal.at(9).seq);
+    TEST_ASSERT_EQUAL(0, journal.acknowledge(65529));
+    TEST_ASSERT_EQUAL(8, journal.acknowledge(1));
+    TEST_ASSERT_EQUAL_UINT16(2, journal.at(0).seq);
+    TEST_ASSERT_EQUAL(2, journal.getCount());
+}
+
+// More records than fit: the newest are kept
+void test_restore(void) {
+    RunRecord saved[RUN_JOURNAL_SIZE + 3];
+    for (uint8_t i = 0; i < RUN_JOURNAL_SIZE + 3; i++) {
+        saved[i] = run(1000 + 100 + i);
+        saved[i].seq = 100 + i;
+    }
+    journal.restore(saved, RUN_JOURNAL_SIZE + 3, 100 + RUN_JOURNAL_SIZE + 3);
+    expectSeqs(103, RUN_JOURNAL_SIZE);
+    TEST_ASSERT_EQUAL_UINT16(100 + RUN_JOURNAL_SIZE + 3, journal.append(run(0)));
+}
+
+void test_history_sorted(void) {
+    static const uint32_t starts[] = { 500, 100, 300, 300, 50, 700 };
+    for (uint32_t s : starts) TEST_ASSERT_TRUE(history.insert(run(s, (uint8_t)(s / 100))));
+    TEST_ASSERT_EQUAL(6, history.getCount());
+    for (uint8_t i = 1; i < history.getCount(); i++) {
+        TEST_ASSERT_TRUE(history.at(i - 1).start <= history.at(i).start);
+    }
+    TEST_ASSERT_EQUAL_UINT32(50, history.at(0).start);
+}
+
+// Full: the oldest is evicted, a run older than all of it is dropped
+void test_history_full(void) {
+    for (uint32_t i = 0; i < RUN_HISTORY_SIZE; i++) history.insert(run(1000 + i * 10));
+    uint32_t generation = history.getGeneration();
+
+    TEST_ASSERT_FALSE(history.insert(run(5)));
+    TEST_ASSERT_EQUAL_UINT32(generation, history.getGeneration());
+
+    TEST_ASSERT_TRUE(history.insert(run(1005)));                  // Between the two oldest
+    TEST_ASSERT_EQUAL(RUN_HISTORY_SIZE, history.getCount());
+    TEST_ASSERT_EQUAL_UINT32(1005, history.at(0).start);
+    TEST_ASSERT_EQUAL_UINT32(1010, history.at(1).start);
+    TEST_ASSERT_TRUE(history.getGeneration() != generation);
+
+    TEST_ASSERT_TRUE(history.insert(run(999999)));
+    TEST_ASSERT_EQUAL_UINT32(1010, history.at(0).start);
+    TEST_ASSERT_EQUAL_UINT32(999999, history.at(RUN_HISTORY_SIZE - 1).start);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_append_and_ack);
+    RUN_TEST(test_ring_wraps);
+    RUN_TEST(test_sequence_wraps);
+    RUN_TEST(test_restore);
+    RUN_TEST(test_history_sorted);
+    RUN_TEST(test_history_full);
+    return UNITY_END();
+}
@@ -0,0 +1,184 @@
+// The whole firmware built for the host and put under dashboard load
+//   pio test -e native_web -v     (-v shows the load_test.py report)
+//
+// setup() and loop() are main.cpp's, running on lib/ArduinoShim: the web
+// server is a socket on 127.0.0.1:SHIM_HTTP_PORT and LittleFS a scratch
+// directory seeded with WiFi credentials and a config.json for a master.
+// Requests come from a second thread (load_test.py, or a raw socket here)
+// while this one runs loop() as the board would, so handler time, loop()
+// latency and the heap figures in /api/metrics are measured the same way.
+// Host numbers say nothing absolute about the ESP32; they catch handlers
+// that block the loop, leak or fail under concurrent polling.
+
+#include <unity.h>
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include "Config.h"
+
+// main.cpp
+void setup();
+void loop();
+
+#define LOAD_CLIENTS     4
+#define LOAD_SECONDS     15
+#define LOAD_EDIT_EVERY  5      // s between schedule edits per client
+
+static char fsRoot[] = "/tmp/irrigation_fsXXXXXX";
+static uint16_t httpPort;
+
+static void writeFile(const char* name, const char* content) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s%s", fsRoot, name);
+    FILE* f = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(f);
+    fputs(content, f);
+    fclose(f);
+}
+
+// Runs work on a second thread and loop() on this one until it is done
+static void whileLooping(std::function<void()> work) {
+    std::atomic<bool> done(false);
+    std::thread worker([&]() {
+        work();
+        done = true;
+    });
+    while (!done) loop();
+    worker.join();
+}
+
+// One request over a raw socket; returns the status code, 0 on no answer
+static int httpRequest(const char* request, String& head, String& body) {
+    int status = 0;
+    whileLooping([&]() {
+        WiFiClient client;
+        client.setTimeout(5000);
+        if (!client.connect("127.0.0.1", httpPort)) return;
+        client.write((const uint8_t*)request, strlen(request));
+        String response;
+        unsigned long start = millis();
+        while (millis() - start < 5000) {
+            uint8_t buf[512];
+            int n = client.read(buf, sizeof(buf));
+            if (n > 0) {
+                response.concat((const char*)buf, n);
+            } else if (!client.connected()) {
+                break;
+            } else {
+                delay(1);
+            }
+        }
+        int split = response.indexOf("\r\n\r\n");
+        if (split < 0) return;
+        head = response.substring(0, split);
+        body = response.substring(split + 4);
+        status = head.substring(9, 12).toInt();
+    });
+    return status;
+}
+
+static String headerValue(const String& head, const char* name) {
+    String key = String("\r\n") + name + ": ";
+    int at = head.indexOf(key);
+    if (at < 0) return String();
+    int end = head.indexOf("\r\n", at + key.length());
+    return head.substring(at + key.length(), end < 0 ? head.length() : end);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_metrics_answer(void) {
+    String head, body;
+    int status = httpRequest("GET /api/metrics HTTP/1.1\r\nHost: test\r\n\r\n", head, body);
+    TEST_ASSERT_EQUAL(200, status);
+    TEST_ASSERT_TRUE(headerValue(head, "Content-Type").startsWith("application/json"));
+    TEST_ASSERT_TRUE(body.indexOf("\"loop\"") >= 0);
+    TEST_ASSERT_TRUE(body.indexOf("\"heap\"") >= 0);
+}
+
+void test_etag_revalidation(void) {
+    String head, body;
+    int status = httpRequest("GET /api/channels/status HTTP/1.1\r\nHost: test\r\n\r\n", head, body);
+    TEST_ASSERT_EQUAL(200, status);
+    String etag = headerValue(head, "ETag");
+    TEST_ASSERT_TRUE(etag.length() > 0);
+
+    String request = "GET /api/channels/status HTTP/1.1\r\nHost: test\r\nIf-None-Match: " + etag + "\r\n\r\n";
+    status = httpRequest(request.c_str(), head, body);
+    TEST_ASSERT_EQUAL(304, status);
+    TEST_ASSERT_EQUAL(0, body.length());
+}
+
+void test_load_test(void) {
+    if (access("load_test.py", R_OK) != 0) {
+        TEST_IGNORE_MESSAGE("load_test.py not found: run from the project directory");
+    }
+
+    char command[160];
+    snprintf(command, sizeof(command),
+             "python3 load_test.py 127.0.0.1:%u --clients %d --duration %d --edit-every %d 2>&1",
+             httpPort, LOAD_CLIENTS, LOAD_SECONDS, LOAD_EDIT_EVERY);
+
+    String report;
+    int status = -1;
+    whileLooping([&]() {
+        FILE* p = popen(command, "r");
+        if (!p) return;
+        char line[256];
+        while (fgets(line, sizeof(line), p)) report += line;
+        status = pclose(p);
+    });
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+        TEST_IGNORE_MESSAGE("python3 not found");
+    }
+
+    // One TEST_MESSAGE per line keeps the report readable under pio -v
+    int start = 0;
+    while (start < (int)report.length()) {
+        int end = report.indexOf('\n', start);
+        if (end < 0) end = report.length();
+        TEST_MESSAGE(report.substring(start, end).c_str());
+        start = end + 1;
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+                             "load_test.py failed or saw failed requests");
+    TEST_ASSERT_TRUE(report.indexOf("device handler") >= 0);
+}
+
+int main(int argc, char** argv) {
+    // Scratch flash for a master with the web UI and no MQTT
+    if (!mkdtemp(fsRoot)) return 1;
+    setenv("SHIM_LITTLEFS_ROOT", fsRoot, 1);
+    writeFile(WIFI_CREDENTIALS_FILE, "{\"ssid\":\"host\",\"password\":\"host\"}");
+    writeFile(CONFIG_FILE,
+              "{\"node_id\":\"node_host\",\"role\":\"master\",\"timezone\":\"UTC0\","
+              "\"features\":{\"multi_node\":true,\"mqtt\":false,\"web_ui\":true}}");
+
+    char port[8];
+    httpPort = 18000 + getpid() % 1000;
+    snprintf(port, sizeof(port), "%u", httpPort);
+    setenv("SHIM_HTTP_PORT", port, 1);
+
+    setup();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_metrics_answer);
+    RUN_TEST(test_etag_revalidation);
+    RUN_TEST(test_load_test);
+    int failures = UNITY_END();
+
+    char cleanup[64];
+    snprintf(cleanup, sizeof(cleanup), "rm -rf %s", fsRoot);
+    system(cleanup);
+    return failures;
+}